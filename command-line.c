@@ -29,15 +29,22 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <glib/gi18n.h>
+#include <cairo.h>
 
 #include <gds-render/command-line.h>
 #include <gds-render/gds-utils/gds-parser.h>
 #include <gds-render/layer/layer-settings.h>
 #include <gds-render/output-renderers/cairo-renderer.h>
 #include <gds-render/output-renderers/latex-renderer.h>
+#include <gds-render/output-renderers/raster-renderer.h>
+#include <gds-render/output-renderers/tiled-pdf-renderer.h>
+#include <gds-render/output-renderers/native-pdf-renderer.h>
 #include <gds-render/output-renderers/external-renderer.h>
 #include <gds-render/gds-utils/gds-tree-checker.h>
+#include <gds-render/gds-utils/gds-statistics.h>
+#include <gds-render/geometric/density-map.h>
 
 static int string_array_count(char **string_array)
 {
@@ -52,10 +59,190 @@ static int string_array_count(char **string_array)
 	return count;
 }
 
+/**
+ * @brief Check if an output file name contains a layer placeholder
+ *
+ * Escaped percent signs (`%%`) are skipped. `%%L` is a literal `%L`.
+ *
+ * @param output_file Output file name
+ * @return TRUE if one file has to be written per layer
+ */
+static gboolean output_file_is_per_layer(const char *output_file)
+{
+	const char *c;
+
+	for (c = output_file; *c; c++) {
+		if (c[0] != '%' || !c[1])
+			continue;
+		if (c[1] == 'L' || c[1] == 'N')
+			return TRUE;
+		if (c[1] == '%')
+			c++;
+	}
+
+	return FALSE;
+}
+
+/**
+ * @brief Replace the layer placeholders of an output file name
+ *
+ * `%L` is replaced by the layer number, `%N` by the layer name and `%%` by `%`.
+ * Path separators inside the layer name are replaced by underscores.
+ *
+ * @param output_file Output file name containing placeholders
+ * @param linfo Layer
+ * @return Output file name of the layer. Free with g_free()
+ */
+static gchar *expand_layer_placeholders(const char *output_file, const struct layer_info *linfo)
+{
+	GString *name;
+	const char *c;
+	gchar *layer_name;
+
+	name = g_string_new(NULL);
+	for (c = output_file; *c; c++) {
+		if (c[0] != '%' || !c[1]) {
+			g_string_append_c(name, *c);
+			continue;
+		}
+
+		switch (c[1]) {
+		case 'L':
+			g_string_append_printf(name, "%d", linfo->layer);
+			break;
+		case 'N':
+			if (linfo->name && linfo->name[0]) {
+				layer_name = g_strdelimit(g_strdup(linfo->name), "/", '_');
+				g_string_append(name, layer_name);
+				g_free(layer_name);
+			} else {
+				g_string_append_printf(name, "%d", linfo->layer);
+			}
+			break;
+		case '%':
+			g_string_append_c(name, '%');
+			break;
+		default:
+			g_string_append_c(name, '%');
+			continue;
+		}
+		c++;
+	}
+
+	return g_string_free(name, FALSE);
+}
+
+/**
+ * @brief Check if a renderer id names one of the pdf, svg or tikz renderers
+ * @param renderer_name Renderer id
+ * @return TRUE if the renderer can write per layer output files
+ */
+static gboolean renderer_is_vector_renderer(const char *renderer_name)
+{
+	return (!strcmp(renderer_name, "pdf") || !strcmp(renderer_name, "svg") ||
+		!strcmp(renderer_name, "tikz")) ? TRUE : FALSE;
+}
+
+/**
+ * @brief Create a pdf, svg or tikz renderer
+ * @param renderer_name Renderer id
+ * @param tex_layers TeX OCR layers
+ * @param tex_standalone Standalone TeX
+ * @return New renderer or NULL if \p renderer_name is not a pdf, svg or tikz renderer
+ */
+static GdsOutputRenderer *create_vector_renderer(const char *renderer_name, gboolean tex_layers,
+						  gboolean tex_standalone)
+{
+	if (!strcmp(renderer_name, "tikz"))
+		return GDS_RENDER_OUTPUT_RENDERER(latex_renderer_new_with_options(tex_layers, tex_standalone));
+	else if (!strcmp(renderer_name, "pdf"))
+		return GDS_RENDER_OUTPUT_RENDERER(cairo_renderer_new_pdf());
+	else if (!strcmp(renderer_name, "svg"))
+		return GDS_RENDER_OUTPUT_RENDERER(cairo_renderer_new_svg());
+
+	return NULL;
+}
+
+/**
+ * @brief Create one renderer per rendered layer
+ *
+ * Each renderer gets its own layer settings containing only its layer.
+ *
+ * @param renderer_name Renderer id. Only pdf, svg and tikz are supported
+ * @param output_file Output file name with layer placeholders
+ * @param tex_layers TeX OCR layers
+ * @param tex_standalone Standalone TeX
+ * @param merge_shapes Merge shapes
+ * @param simplify_tolerance Simplification tolerance
+ * @param renderer_list List to append the renderers to
+ * @param layer_settings Layer settings of all layers
+ * @return 0 if successful
+ */
+static int create_per_layer_renderers(const char *renderer_name,
+				      const char *output_file,
+				      gboolean tex_layers,
+				      gboolean tex_standalone,
+				      gboolean merge_shapes,
+				      double simplify_tolerance,
+				      GList **renderer_list,
+				      LayerSettings *layer_settings)
+{
+	GList *info_list;
+	struct layer_info *linfo;
+	GHashTable *file_names;
+	LayerSettings *single_layer;
+	GdsOutputRenderer *output_renderer;
+	gchar *file_name;
+	int ret = 0;
+
+	if (!renderer_is_vector_renderer(renderer_name)) {
+		fprintf(stderr, _("Renderer %s does not support per layer output files\n"), renderer_name);
+		return -1;
+	}
+
+	file_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	for (info_list = layer_settings_get_layer_info_list(layer_settings); info_list != NULL;
+	     info_list = g_list_next(info_list)) {
+		linfo = (struct layer_info *)info_list->data;
+		if (!linfo->render)
+			continue;
+
+		file_name = expand_layer_placeholders(output_file, linfo);
+		if (g_hash_table_contains(file_names, file_name)) {
+			fprintf(stderr, _("Layer %d would overwrite output file %s\n"), linfo->layer, file_name);
+			g_free(file_name);
+			ret = -1;
+			break;
+		}
+		g_hash_table_add(file_names, file_name);
+
+		single_layer = layer_settings_new();
+		layer_settings_append_layer_info(single_layer, linfo);
+
+		output_renderer = create_vector_renderer(renderer_name, tex_layers, tex_standalone);
+		gds_output_renderer_set_output_file(output_renderer, file_name);
+		gds_output_renderer_set_layer_settings(output_renderer, single_layer);
+		gds_output_renderer_set_merge_shapes(output_renderer, merge_shapes);
+		gds_output_renderer_set_simplify_tolerance(output_renderer, simplify_tolerance);
+		*renderer_list = g_list_append(*renderer_list, output_renderer);
+
+		g_object_unref(single_layer);
+	}
+
+	g_hash_table_destroy(file_names);
+
+	return ret;
+}
+
 static int create_renderers(char **renderers,
 			    char **output_file_names,
 			    gboolean tex_layers,
 			    gboolean tex_standalone,
+			    gboolean merge_shapes,
+			    double simplify_tolerance,
+			    double dpi,
+			    const struct tiled_pdf_params *page_params,
 			    const struct external_renderer_params *ext_params,
 			    GList **renderer_list,
 			    LayerSettings *layer_settings)
@@ -92,13 +279,25 @@ static int create_renderers(char **renderers,
 		if (!current_out_file || !current_out_file[0])
 			continue;
 
-		if (!strcmp(current_renderer, "tikz")) {
-			output_renderer = GDS_RENDER_OUTPUT_RENDERER(latex_renderer_new_with_options(tex_layers,
-												     tex_standalone));
-		} else if (!strcmp(current_renderer, "pdf")) {
-			output_renderer = GDS_RENDER_OUTPUT_RENDERER(cairo_renderer_new_pdf());
-		} else if (!strcmp(current_renderer, "svg")) {
-			output_renderer = GDS_RENDER_OUTPUT_RENDERER(cairo_renderer_new_svg());
+		if (output_file_is_per_layer(current_out_file)) {
+			if (create_per_layer_renderers(current_renderer, current_out_file, tex_layers, tex_standalone,
+						       merge_shapes, simplify_tolerance, renderer_list, layer_settings))
+				return -1;
+			continue;
+		}
+
+		if (renderer_is_vector_renderer(current_renderer)) {
+			output_renderer = create_vector_renderer(current_renderer, tex_layers, tex_standalone);
+		} else if (!strcmp(current_renderer, "png")) {
+			output_renderer = GDS_RENDER_OUTPUT_RENDERER(raster_renderer_new_png(dpi));
+		} else if (!strcmp(current_renderer, "tiles")) {
+			output_renderer = GDS_RENDER_OUTPUT_RENDERER(raster_renderer_new_tile_pyramid(dpi));
+		} else if (!strcmp(current_renderer, "pdf-native")) {
+			output_renderer = GDS_RENDER_OUTPUT_RENDERER(native_pdf_renderer_new());
+		} else if (!strcmp(current_renderer, "pdf-tiled")) {
+			output_renderer = GDS_RENDER_OUTPUT_RENDERER(tiled_pdf_renderer_new(page_params->page_width,
+											    page_params->page_height,
+											    page_params->plot_scale));
 		} else if (!strcmp(current_renderer, "ext")) {
 			if (!ext_params->so_path) {
 				fprintf(stderr, _("Please specify shared object for external renderer. Will ignore this renderer.\n"));
@@ -113,6 +312,8 @@ static int create_renderers(char **renderers,
 
 		gds_output_renderer_set_output_file(output_renderer, current_out_file);
 		gds_output_renderer_set_layer_settings(output_renderer, layer_settings);
+		gds_output_renderer_set_merge_shapes(output_renderer, merge_shapes);
+		gds_output_renderer_set_simplify_tolerance(output_renderer, simplify_tolerance);
 		*renderer_list = g_list_append(*renderer_list, output_renderer);
 	}
 
@@ -135,6 +336,35 @@ static struct gds_cell *find_gds_cell_in_lib(struct gds_library *lib, const char
 	return return_cell;
 }
 
+/**
+ * @brief Parse a GDS file and find a cell in its first library
+ * @param gds_name GDS file
+ * @param cell_name Name of the cell
+ * @param[out] libs Parsed libraries. Has to be freed with clear_lib_list(), even if no cell is found
+ * @return Cell or NULL if the file cannot be parsed or the cell does not exist
+ */
+static struct gds_cell *load_gds_cell(const char *gds_name, const char *cell_name, GList **libs)
+{
+	struct gds_library *first_lib;
+	struct gds_cell *cell;
+
+	*libs = NULL;
+	if (parse_gds_from_file(gds_name, libs) || !*libs)
+		return NULL;
+
+	first_lib = (struct gds_library *)(*libs)->data;
+	if (!first_lib) {
+		fprintf(stderr, _("No library in library list. This should not happen.\n"));
+		return NULL;
+	}
+
+	cell = find_gds_cell_in_lib(first_lib, cell_name);
+	if (!cell)
+		printf(_("Couldn't find cell in first library!\n"));
+
+	return cell;
+}
+
 int command_line_convert_gds(const char *gds_name,
 			      const char *cell_name,
 			      char **renderers,
@@ -143,6 +373,10 @@ int command_line_convert_gds(const char *gds_name,
 			      struct external_renderer_params *ext_param,
 			      gboolean tex_standalone,
 			      gboolean tex_layers,
+			      gboolean merge_shapes,
+			      double simplify_tolerance,
+			      double dpi,
+			      const struct tiled_pdf_params *page_params,
 			      double scale)
 {
 	int ret = -1;
@@ -150,10 +384,8 @@ int command_line_convert_gds(const char *gds_name,
 	int res;
 	GList *renderer_list = NULL;
 	GList *list_iter;
-	struct gds_library *first_lib;
 	struct gds_cell *toplevel_cell = NULL;
 	LayerSettings *layer_sett;
-	GdsOutputRenderer *current_renderer;
 
 	/* Check if parameters are valid */
 	if (!gds_name || !cell_name || !output_file_names || !layer_file || !renderers) {
@@ -166,40 +398,19 @@ int command_line_convert_gds(const char *gds_name,
 	layer_settings_load_from_csv(layer_sett, layer_file);
 
 	/* Create renderers */
-	if (create_renderers(renderers, output_file_names, tex_layers, tex_standalone,
-			     ext_param, &renderer_list, layer_sett))
-		goto ret_destroy_layer_mapping;
-
-
-	/* Load GDS */
-	clear_lib_list(&libs);
-	res = parse_gds_from_file(gds_name, &libs);
-	if (res)
-		goto ret_destroy_library_list;
-
-	/* find_cell in first library. */
-	if (!libs)
+	if (create_renderers(renderers, output_file_names, tex_layers, tex_standalone, merge_shapes,
+			     simplify_tolerance, dpi, page_params, ext_param, &renderer_list, layer_sett))
 		goto ret_clear_renderers;
 
-	first_lib = (struct gds_library *)libs->data;
-	if (!first_lib) {
-		fprintf(stderr, _("No library in library list. This should not happen.\n"));
-		/* This is safe. Library destruction can handle an empty list element */
+	/* Load GDS and find cell in first library */
+	toplevel_cell = load_gds_cell(gds_name, cell_name, &libs);
+	if (!toplevel_cell)
 		goto ret_destroy_library_list;
-	}
-
-	/* Find cell in first library */
-	toplevel_cell = find_gds_cell_in_lib(first_lib, cell_name);
-
-	if (!toplevel_cell) {
-		printf(_("Couldn't find cell in first library!\n"));
-		goto ret_destroy_library_list;
-	}
 
 	/* Check if cell passes vital checks */
 	res = gds_tree_check_reference_loops(toplevel_cell->parent_library);
 	if (res < 0) {
-		fprintf(stderr, _("Checking library %s failed.\n"), first_lib->name);
+		fprintf(stderr, _("Checking library %s failed.\n"), toplevel_cell->parent_library->name);
 		goto ret_destroy_library_list;
 	} else if (res > 0) {
 		fprintf(stderr, _("%d reference loops found.\n"), res);
@@ -218,20 +429,207 @@ int command_line_convert_gds(const char *gds_name,
 	 * Deal with it.
 	 */
 
-	/* Execute all rendererer instances */
-	for (list_iter = renderer_list; list_iter; list_iter = list_iter->next) {
-		current_renderer = GDS_RENDER_OUTPUT_RENDERER(list_iter->data);
-		gds_output_renderer_render_output(current_renderer, toplevel_cell, scale);
-	}
+	/* Execute all rendererer instances. Compatible renderers share a single flattened scene */
+	ret = gds_output_renderer_render_output_list(renderer_list, toplevel_cell, scale);
 
 ret_destroy_library_list:
 	clear_lib_list(&libs);
 ret_clear_renderers:
 	for (list_iter = renderer_list; list_iter; list_iter = list_iter->next)
 		g_object_unref(list_iter->data);
-ret_destroy_layer_mapping:
 	g_object_unref(layer_sett);
 	return ret;
 }
 
+int command_line_estimate_gds(const char *gds_name, const char *cell_name)
+{
+	int ret = -1;
+	GList *libs = NULL;
+	struct gds_cell *toplevel_cell;
+	struct gds_cell_statistics stats;
+	const struct gds_layer_statistics *lstat;
+	char count[24];
+	char vertex_count[24];
+	guint i;
+
+	if (!gds_name || !cell_name) {
+		printf(_("Probably missing argument. Check --help option\n"));
+		return -2;
+	}
+
+	toplevel_cell = load_gds_cell(gds_name, cell_name, &libs);
+	if (!toplevel_cell)
+		goto ret_destroy_library_list;
+
+	if (gds_statistics_calculate(toplevel_cell, &stats)) {
+		fprintf(stderr, _("Cell is affected by reference loop. Abort!\n"));
+		gds_statistics_free(&stats);
+		goto ret_destroy_library_list;
+	}
+
+	/* 64 bit format macros cannot be used inside translated strings */
+	printf(_("Cell: %s\n"), toplevel_cell->name);
+	g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT, stats.primitive_count);
+	printf(_("Primitives: %s\n"), count);
+	g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT, stats.vertex_count);
+	printf(_("Vertices: %s\n"), count);
+	g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT, stats.instance_count);
+	printf(_("Instances: %s\n"), count);
+	for (i = 0; i < stats.layers->len; i++) {
+		lstat = &g_array_index(stats.layers, struct gds_layer_statistics, i);
+		g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT, lstat->primitive_count);
+		g_snprintf(vertex_count, sizeof(vertex_count), "%" G_GUINT64_FORMAT, lstat->vertex_count);
+		printf(_("Layer %d: %s primitives, %s vertices\n"), lstat->layer, count, vertex_count);
+	}
+
+	gds_statistics_free(&stats);
+	ret = 0;
+
+ret_destroy_library_list:
+	clear_lib_list(&libs);
+	return ret;
+}
+
+/**
+ * @brief Write density maps to a CSV file
+ *
+ * Each line contains the layer, row, column, the tile extent in database units and the coverage.
+ *
+ * @param maps List of #density_map
+ * @param output_file Output file
+ * @return 0 if successful
+ */
+static int write_density_maps_csv(GList *maps, const char *output_file)
+{
+	FILE *csv;
+	GList *iter;
+	struct density_map *map;
+	double tile_width, tile_height;
+	unsigned int r, c;
+
+	csv = fopen(output_file, "w");
+	if (!csv) {
+		fprintf(stderr, _("Could not open output file %s\n"), output_file);
+		return -1;
+	}
+
+	fprintf(csv, "layer,row,column,x_min,y_min,x_max,y_max,coverage\n");
+	for (iter = maps; iter != NULL; iter = g_list_next(iter)) {
+		map = (struct density_map *)iter->data;
+		tile_width = (map->extent.vectors.upper_right.x - map->extent.vectors.lower_left.x) / map->columns;
+		tile_height = (map->extent.vectors.upper_right.y - map->extent.vectors.lower_left.y) / map->rows;
+		for (r = 0; r < map->rows; r++) {
+			for (c = 0; c < map->columns; c++) {
+				fprintf(csv, "%d,%u,%u,%lf,%lf,%lf,%lf,%lf\n", map->layer, r, c,
+					map->extent.vectors.lower_left.x + c * tile_width,
+					map->extent.vectors.upper_right.y - (r + 1) * tile_height,
+					map->extent.vectors.lower_left.x + (c + 1) * tile_width,
+					map->extent.vectors.upper_right.y - r * tile_height,
+					map->coverage[r * map->columns + c]);
+			}
+		}
+	}
+
+	fclose(csv);
+	return 0;
+}
+
+/**
+ * @brief Write each density map as grayscale PNG
+ *
+ * Each tile is one pixel. The layer number is appended to the file name: map.png becomes map_<layer>.png
+ *
+ * @param maps List of #density_map
+ * @param output_file Output file
+ * @return 0 if successful
+ */
+static int write_density_maps_png(GList *maps, const char *output_file)
+{
+	GList *iter;
+	struct density_map *map;
+	cairo_surface_t *surface;
+	unsigned char *data;
+	gchar *stem;
+	gchar *file_name;
+	int stride;
+	unsigned int r, c;
+	int ret = 0;
+
+	stem = g_strndup(output_file, strlen(output_file) - strlen(".png"));
+
+	for (iter = maps; iter != NULL; iter = g_list_next(iter)) {
+		map = (struct density_map *)iter->data;
+		surface = cairo_image_surface_create(CAIRO_FORMAT_A8, (int)map->columns, (int)map->rows);
+		if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+			cairo_surface_destroy(surface);
+			ret = -1;
+			break;
+		}
+
+		cairo_surface_flush(surface);
+		data = cairo_image_surface_get_data(surface);
+		stride = cairo_image_surface_get_stride(surface);
+		for (r = 0; r < map->rows; r++) {
+			for (c = 0; c < map->columns; c++)
+				data[r * stride + c] = (unsigned char)(map->coverage[r * map->columns + c] * 255.0 + 0.5);
+		}
+		cairo_surface_mark_dirty(surface);
+
+		file_name = g_strdup_printf("%s_%d.png", stem, map->layer);
+		if (cairo_surface_write_to_png(surface, file_name) != CAIRO_STATUS_SUCCESS) {
+			fprintf(stderr, _("Could not write %s\n"), file_name);
+			ret = -1;
+		}
+		g_free(file_name);
+		cairo_surface_destroy(surface);
+	}
+
+	g_free(stem);
+	return ret;
+}
+
+int command_line_density_map(const char *gds_name, const char *cell_name, const char *output_file,
+			     unsigned int columns, unsigned int rows)
+{
+	int ret = -1;
+	GList *libs = NULL;
+	GList *maps = NULL;
+	int res;
+	struct gds_cell *toplevel_cell;
+
+	if (!gds_name || !cell_name || !output_file) {
+		printf(_("Probably missing argument. Check --help option\n"));
+		return -2;
+	}
+
+	if (columns == 0 || rows == 0) {
+		fprintf(stderr, _("Density map size must not be zero\n"));
+		return -2;
+	}
+
+	toplevel_cell = load_gds_cell(gds_name, cell_name, &libs);
+	if (!toplevel_cell)
+		goto ret_destroy_library_list;
+
+	res = density_map_calculate_for_cell(toplevel_cell, columns, rows, 0, &maps);
+	if (res == -2) {
+		fprintf(stderr, _("Cell is affected by reference loop. Abort!\n"));
+		goto ret_destroy_library_list;
+	} else if (res) {
+		fprintf(stderr, _("Invalid density map parameters. Abort!\n"));
+		goto ret_destroy_library_list;
+	}
+
+	if (g_str_has_suffix(output_file, ".png"))
+		ret = write_density_maps_png(maps, output_file);
+	else
+		ret = write_density_maps_csv(maps, output_file);
+
+	g_list_free_full(maps, (GDestroyNotify)density_map_free);
+
+ret_destroy_library_list:
+	clear_lib_list(&libs);
+	return ret;
+}
+
 /** @} */
@@ -34,6 +34,7 @@
 #include <gds-render/gds-render-gui.h>
 #include <gds-render/gds-utils/gds-parser.h>
 #include <gds-render/gds-utils/gds-tree-checker.h>
+#include <gds-render/gds-utils/gds-statistics.h>
 #include <gds-render/layer/layer-selector.h>
 #include <gds-render/widgets/activity-bar.h>
 #include <gds-render/cell-selector/lib-cell-renderer.h>
@@ -48,6 +49,7 @@ enum cell_store_columns {
 	CELL_SEL_LIBRARY = 0,
 	CELL_SEL_CELL,
 	CELL_SEL_CELL_ERROR_STATE, /**< Used for cell color and selectability */
+	CELL_SEL_INSTANCE_COUNT, /**< @brief Placements of the cell in the top cells as string. Empty for libraries */
 	CELL_SEL_COLUMN_COUNT /**< @brief Not a column. Used to determine count of columns */
 };
 
@@ -219,10 +221,11 @@ int gds_render_gui_setup_cell_selector(GdsRenderGui *self)
 {
 	GtkCellRenderer *render_cell;
 	GtkCellRenderer *render_lib;
+	GtkCellRenderer *render_count;
 	GtkTreeViewColumn *column;
 
 	self->cell_tree_store = gtk_tree_store_new(CELL_SEL_COLUMN_COUNT, G_TYPE_POINTER,
-					 G_TYPE_POINTER, G_TYPE_UINT);
+					 G_TYPE_POINTER, G_TYPE_UINT, G_TYPE_STRING);
 
 	/* Searching */
 	self->cell_filter = GTK_TREE_MODEL_FILTER(
@@ -246,6 +249,12 @@ int gds_render_gui_setup_cell_selector(GdsRenderGui *self)
 							  "error-level", CELL_SEL_CELL_ERROR_STATE, NULL);
 	gtk_tree_view_append_column(self->cell_tree_view, column);
 
+	render_count = gtk_cell_renderer_text_new();
+	g_object_set(render_count, "xalign", 1.0, NULL);
+	column = gtk_tree_view_column_new_with_attributes(_("Instances"), render_count, "text",
+							  CELL_SEL_INSTANCE_COUNT, NULL);
+	gtk_tree_view_append_column(self->cell_tree_view, column);
+
 	/* Callback for selection
 	 * This prevents selecting a library
 	 */
@@ -277,6 +286,7 @@ static void on_load_gds(gpointer button, gpointer user)
 	int gds_result;
 	char *filename;
 	unsigned int cell_error_level;
+	gchar *instance_count;
 
 	self = RENDERER_GUI(user);
 	if (!self)
@@ -330,6 +340,7 @@ static void on_load_gds(gpointer button, gpointer user)
 		/* Check this library. This might take a while */
 		(void)gds_tree_check_cell_references(gds_lib);
 		(void)gds_tree_check_reference_loops(gds_lib);
+		(void)gds_tree_check_instance_counts(gds_lib, NULL);
 
 		for (cell = gds_lib->cells; cell != NULL; cell = cell->next) {
 			gds_c = (struct gds_cell *)cell->data;
@@ -344,12 +355,17 @@ static void on_load_gds(gpointer button, gpointer user)
 			if (gds_c->checks.affected_by_reference_loop)
 				cell_error_level |= LIB_CELL_RENDERER_ERROR_ERR;
 
+			instance_count = g_strdup_printf("%" G_GUINT64_FORMAT,
+							 (guint64)gds_c->checks.instance_count);
+
 			/* Add cell to tree store model */
 			gtk_tree_store_set(self->cell_tree_store, &celliter,
 					   CELL_SEL_CELL, gds_c,
 					   CELL_SEL_CELL_ERROR_STATE, cell_error_level,
 					   CELL_SEL_LIBRARY, gds_c->parent_library,
+					   CELL_SEL_INSTANCE_COUNT, instance_count,
 					   -1);
+			g_free(instance_count);
 		} /* for cells */
 	} /* for libraries */
 
@@ -440,6 +456,7 @@ static void on_convert_clicked(gpointer button, gpointer user)
 	struct render_settings *sett;
 	LayerSettings *layer_settings;
 	GdsOutputRenderer *render_engine;
+	struct gds_cell_statistics cell_stats;
 
 	self = RENDERER_GUI(user);
 
@@ -482,6 +499,10 @@ static void on_convert_clicked(gpointer button, gpointer user)
 	renderer_settings_dialog_set_database_unit_scale(settings, cell_to_render->parent_library->unit_in_meters);
 	renderer_settings_dialog_set_cell_height(settings, height);
 	renderer_settings_dialog_set_cell_width(settings, width);
+	if (!gds_statistics_calculate(cell_to_render, &cell_stats)) {
+		renderer_settings_dialog_set_statistics(settings, &cell_stats);
+		gds_statistics_free(&cell_stats);
+	}
 	g_object_set(G_OBJECT(settings), "cell-name", cell_to_render->name, NULL);
 
 	res = gtk_dialog_run(GTK_DIALOG(settings));
@@ -43,6 +43,7 @@
 #include <glib/gi18n.h>
 
 #include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-topology.h>
 
 /**
  * @brief Default units assumed for library.
@@ -276,6 +277,7 @@ static GList *append_library(GList *curr_list, struct gds_library **library_ptr)
 		lib->name[0] = 0;
 		lib->unit_in_meters = GDS_DEFAULT_UNITS; // Default. Will be overwritten
 		lib->cell_names = NULL;
+		lib->topology = NULL;
 	} else
 		return NULL;
 	if (library_ptr)
@@ -300,7 +302,8 @@ static __attribute__((warn_unused_result)) GList *prepend_graphics(GList *curr_l
 	if (gfx) {
 		gfx->datatype = 0;
 		gfx->layer = 0;
-		gfx->vertices = NULL;
+		gfx->vertex_array = NULL;
+		gfx->vertex_count = 0;
 		gfx->width_absolute = 0;
 		gfx->gfx_type = type;
 		gfx->path_render_type = PATH_FLUSH;
@@ -314,23 +317,37 @@ static __attribute__((warn_unused_result)) GList *prepend_graphics(GList *curr_l
 }
 
 /**
- * @brief Appends vertext List
- * @param curr_list List containing gds_point elements. May be NULL.
- * @param x x-coordinate of new point
- * @param y y-coordinate of new point
- * @return new Pointer to List.
+ * @brief Append the points of an XY record to a graphics object
+ * @param gfx Graphics object
+ * @param workbuff Data of the XY record
+ * @param count Number of points in \p workbuff
+ * @return 0 if successful, -1 if memory allocation failed
  */
-static GList *append_vertex(GList *curr_list, int x, int y)
+static int append_vertices(struct gds_graphics *gfx, const char *workbuff, size_t count)
 {
+	struct gds_point *vertices;
 	struct gds_point *vertex;
+	size_t i;
 
-	vertex = (struct gds_point *)malloc(sizeof(struct gds_point));
-	if (vertex) {
-		vertex->x = x;
-		vertex->y = y;
-	} else
-		return NULL;
-	return g_list_append(curr_list, vertex);
+	if (count == 0)
+		return 0;
+
+	vertices = (struct gds_point *)realloc(gfx->vertex_array,
+					       (gfx->vertex_count + count) * sizeof(struct gds_point));
+	if (!vertices)
+		return -1;
+
+	for (i = 0; i < count; i++) {
+		vertex = &vertices[gfx->vertex_count + i];
+		vertex->x = gds_convert_signed_int(&workbuff[i*8]);
+		vertex->y = gds_convert_signed_int(&workbuff[i*8+4]);
+		GDS_INF("\t\tSet coordinate: %d/%d\n", vertex->x, vertex->y);
+	}
+
+	gfx->vertex_array = vertices;
+	gfx->vertex_count += count;
+
+	return 0;
 }
 
 /**
@@ -353,6 +370,7 @@ static GList *append_cell(GList *curr_list, struct gds_cell **cell_ptr)
 		cell->parent_library = NULL;
 		cell->checks.unresolved_child_count = GDS_CELL_CHECK_NOT_RUN;
 		cell->checks.affected_by_reference_loop = GDS_CELL_CHECK_NOT_RUN;
+		cell->checks.instance_count = 0ULL;
 	} else
 		return NULL;
 	/* return cell */
@@ -518,6 +536,9 @@ static void scan_library_references(gpointer library_list_item, gpointer user)
 
 	GDS_INF("Scanning Library: %s\n", lib->name);
 	g_list_foreach(lib->cells, scan_cell_reference_dependencies, lib);
+
+	/* References changed. Topology has to be recalculated */
+	gds_topology_invalidate(lib);
 }
 
 /**
@@ -951,13 +972,10 @@ int parse_gds_from_file(const char *filename, GList **library_list)
 				GDS_INF("\t\tSet origin to: %d/%d\n", current_s_reference->origin.x,
 				       current_s_reference->origin.y);
 			} else if (current_graphics) {
-				for (i = 0; i < read/8; i++) {
-					x = gds_convert_signed_int(&workbuff[i*8]);
-					y = gds_convert_signed_int(&workbuff[i*8+4]);
-					current_graphics->vertices =
-							append_vertex(current_graphics->vertices, x, y);
-					GDS_INF("\t\tSet coordinate: %d/%d\n", x, y);
-
+				if (append_vertices(current_graphics, workbuff, (size_t)read / 8)) {
+					GDS_ERROR("Memory allocation failed");
+					run = -4;
+					break;
 				}
 			} else if (current_a_reference) {
 				for (i = 0; i < 3; i++) {
@@ -1092,16 +1110,6 @@ static void delete_cell_inst_element(struct gds_cell_instance *cell_inst)
 		free(cell_inst);
 }
 
-/**
- * @brief delete_vertex
- * @param vertex
- */
-static void delete_vertex(struct gds_point *vertex)
-{
-	if (vertex)
-		free(vertex);
-}
-
 /**
  * @brief delete_graphics_obj
  * @param gfx
@@ -1111,7 +1119,8 @@ static void delete_graphics_obj(struct gds_graphics *gfx)
 	if (!gfx)
 		return;
 
-	g_list_free_full(gfx->vertices, (GDestroyNotify)delete_vertex);
+	if (gfx->vertex_array)
+		free(gfx->vertex_array);
 	free(gfx);
 }
 
@@ -1138,6 +1147,7 @@ static void delete_library_element(struct gds_library *lib)
 	if (!lib)
 		return;
 
+	gds_topology_invalidate(lib);
 	g_list_free(lib->cell_names);
 	g_list_free_full(lib->cells, (GDestroyNotify)delete_cell_element);
 	free(lib);
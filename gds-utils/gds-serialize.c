@@ -0,0 +1,363 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-serialize.c
+ * @brief Binary image of a cell hierarchy for other processes
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The image consists of a header followed by the cells in bottom-up order. Each cell is followed by
+ * its graphics (each followed by its vertices) and its instances. Instances reference cells by their
+ * index in the image. Only cells stored before the referencing cell may be referenced, so an image
+ * cannot contain reference loops.
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gds-render/gds-utils/gds-serialize.h>
+#include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-topology.h>
+
+/** @brief Magic number at the start of an image */
+#define SERIALIZE_MAGIC (0x53534447U)
+
+/** @brief Version of the image format */
+#define SERIALIZE_VERSION (1U)
+
+/** @brief Database unit of cells without a library. Same as the default of the parser */
+#define SERIALIZE_DEFAULT_UNITS (10E-9)
+
+struct serialized_header {
+	guint32 magic; /**< @brief Must be @ref SERIALIZE_MAGIC */
+	guint32 version; /**< @brief Must be @ref SERIALIZE_VERSION */
+	guint32 cell_count; /**< @brief Number of cells. The last one is the top cell */
+	double unit_in_meters; /**< @brief Database unit of the library */
+	char lib_name[CELL_NAME_MAX]; /**< @brief Name of the library */
+};
+
+struct serialized_cell {
+	char name[CELL_NAME_MAX]; /**< @brief Cell name */
+	guint32 gfx_count; /**< @brief Number of following graphics */
+	guint32 instance_count; /**< @brief Number of following instances */
+};
+
+struct serialized_gfx {
+	gint32 gfx_type; /**< @brief #graphics_type */
+	gint32 path_render_type; /**< @brief #path_type */
+	gint32 width_absolute; /**< @brief Path width */
+	gint16 layer; /**< @brief Layer */
+	gint16 datatype; /**< @brief Data type */
+	guint32 vertex_count; /**< @brief Number of following #gds_point elements */
+};
+
+struct serialized_instance {
+	guint32 cell_index; /**< @brief Index of the referenced cell in the image */
+	gint32 flipped; /**< @brief Mirrored on x-axis before rotation */
+	struct gds_point origin; /**< @brief Origin */
+	double angle; /**< @brief Rotation in degrees */
+	double magnification; /**< @brief Magnification */
+};
+
+/**
+ * @brief Collect the cells below \p cell in bottom-up order without a library
+ * @param cell Cell
+ * @param state Maps cells to 1 (in progress) or 2 (done)
+ * @param cells Output array
+ * @return 0 if successful, -2 if a reference loop was found
+ */
+static int collect_cells(struct gds_cell *cell, GHashTable *state, GPtrArray *cells)
+{
+	GList *iter;
+	struct gds_cell_instance *inst;
+	int ret;
+
+	switch (GPOINTER_TO_INT(g_hash_table_lookup(state, cell))) {
+	case 1:
+		return -2;
+	case 2:
+		return 0;
+	default:
+		break;
+	}
+
+	g_hash_table_insert(state, cell, GINT_TO_POINTER(1));
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+		ret = collect_cells(inst->cell_ref, state, cells);
+		if (ret)
+			return ret;
+	}
+	g_hash_table_insert(state, cell, GINT_TO_POINTER(2));
+	g_ptr_array_add(cells, cell);
+
+	return 0;
+}
+
+int gds_serialize_cell(struct gds_cell *cell, GByteArray *data)
+{
+	GPtrArray *cells;
+	GHashTable *index;
+	GHashTable *state;
+	GList *iter;
+	struct gds_cell *c;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+	struct serialized_header header;
+	struct serialized_cell scell;
+	struct serialized_gfx sgfx;
+	struct serialized_instance sinst;
+	gpointer value;
+	guint i;
+	int ret = 0;
+
+	if (!cell || !data)
+		return -1;
+
+	if (cell->parent_library) {
+		cells = gds_topology_get_reachable_cells(cell->parent_library, cell);
+		if (!cells)
+			return -2;
+	} else {
+		cells = g_ptr_array_new();
+		state = g_hash_table_new(g_direct_hash, g_direct_equal);
+		ret = collect_cells(cell, state, cells);
+		g_hash_table_destroy(state);
+		if (ret) {
+			g_ptr_array_free(cells, TRUE);
+			return ret;
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = SERIALIZE_MAGIC;
+	header.version = SERIALIZE_VERSION;
+	header.cell_count = cells->len;
+	header.unit_in_meters = (cell->parent_library ? cell->parent_library->unit_in_meters : SERIALIZE_DEFAULT_UNITS);
+	if (cell->parent_library)
+		strncpy(header.lib_name, cell->parent_library->name, CELL_NAME_MAX - 1);
+	g_byte_array_append(data, (const guint8 *)&header, sizeof(header));
+
+	index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	for (i = 0; i < cells->len; i++) {
+		c = (struct gds_cell *)g_ptr_array_index(cells, i);
+		g_hash_table_insert(index, c, GUINT_TO_POINTER(i));
+
+		memset(&scell, 0, sizeof(scell));
+		strncpy(scell.name, c->name, CELL_NAME_MAX - 1);
+		scell.gfx_count = g_list_length(c->graphic_objs);
+		scell.instance_count = 0;
+		for (iter = c->child_cells; iter != NULL; iter = g_list_next(iter)) {
+			if (((struct gds_cell_instance *)iter->data)->cell_ref)
+				scell.instance_count++;
+		}
+		g_byte_array_append(data, (const guint8 *)&scell, sizeof(scell));
+
+		for (iter = c->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+			gfx = (struct gds_graphics *)iter->data;
+			memset(&sgfx, 0, sizeof(sgfx));
+			sgfx.gfx_type = (gint32)gfx->gfx_type;
+			sgfx.path_render_type = (gint32)gfx->path_render_type;
+			sgfx.width_absolute = gfx->width_absolute;
+			sgfx.layer = gfx->layer;
+			sgfx.datatype = gfx->datatype;
+
+			sgfx.vertex_count = (guint32)gfx->vertex_count;
+			g_byte_array_append(data, (const guint8 *)&sgfx, sizeof(sgfx));
+			g_byte_array_append(data, (const guint8 *)gfx->vertex_array,
+					    (guint)(gfx->vertex_count * sizeof(struct gds_point)));
+		}
+
+		for (iter = c->child_cells; iter != NULL; iter = g_list_next(iter)) {
+			inst = (struct gds_cell_instance *)iter->data;
+			if (!inst->cell_ref)
+				continue;
+
+			/* Bottom-up order: The referenced cell is already in the image */
+			g_hash_table_lookup_extended(index, inst->cell_ref, NULL, &value);
+			memset(&sinst, 0, sizeof(sinst));
+			sinst.cell_index = GPOINTER_TO_UINT(value);
+			sinst.flipped = inst->flipped;
+			sinst.origin = inst->origin;
+			sinst.angle = inst->angle;
+			sinst.magnification = inst->magnification;
+			g_byte_array_append(data, (const guint8 *)&sinst, sizeof(sinst));
+		}
+	}
+
+	g_hash_table_destroy(index);
+	g_ptr_array_free(cells, TRUE);
+
+	return 0;
+}
+
+/**
+ * @brief Read from an image
+ * @param data Image
+ * @param length Length of the image
+ * @param[in,out] offset Read position. Advanced by \p size
+ * @param out Destination. May be NULL to skip the data
+ * @param size Number of bytes to read
+ * @return TRUE if successful, FALSE if the image is too short
+ */
+static gboolean read_bytes(const guint8 *data, size_t length, size_t *offset, void *out, size_t size)
+{
+	if (size > length - *offset)
+		return FALSE;
+
+	if (out)
+		memcpy(out, &data[*offset], size);
+	*offset += size;
+
+	return TRUE;
+}
+
+/**
+ * @brief Free a library that is not part of a library list
+ * @param lib Library
+ */
+static void free_library(struct gds_library *lib)
+{
+	GList *list;
+
+	list = g_list_append(NULL, lib);
+	clear_lib_list(&list);
+}
+
+struct gds_library *gds_deserialize_library(const void *data, size_t length, struct gds_cell **top_cell)
+{
+	const guint8 *bytes = (const guint8 *)data;
+	struct serialized_header header;
+	struct serialized_cell scell;
+	struct serialized_gfx sgfx;
+	struct serialized_instance sinst;
+	struct gds_library *lib;
+	struct gds_cell **cells;
+	struct gds_cell *cell;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+	size_t offset = 0;
+	guint32 i, j;
+
+	if (!bytes || !top_cell)
+		return NULL;
+
+	if (!read_bytes(bytes, length, &offset, &header, sizeof(header)))
+		return NULL;
+	if (header.magic != SERIALIZE_MAGIC || header.version != SERIALIZE_VERSION || header.cell_count == 0)
+		return NULL;
+
+	lib = (struct gds_library *)malloc(sizeof(struct gds_library));
+	if (!lib)
+		return NULL;
+	memset(lib, 0, sizeof(struct gds_library));
+	memcpy(lib->name, header.lib_name, CELL_NAME_MAX);
+	lib->name[CELL_NAME_MAX - 1] = 0;
+	lib->unit_in_meters = header.unit_in_meters;
+
+	/* The image may be truncated. Do not trust the cell count for the allocation */
+	cells = (struct gds_cell **)g_malloc0_n(MIN(header.cell_count, length / sizeof(scell) + 1),
+						sizeof(struct gds_cell *));
+
+	for (i = 0; i < header.cell_count; i++) {
+		if (!read_bytes(bytes, length, &offset, &scell, sizeof(scell)))
+			goto err_free;
+
+		cell = (struct gds_cell *)malloc(sizeof(struct gds_cell));
+		if (!cell)
+			goto err_free;
+		memset(cell, 0, sizeof(struct gds_cell));
+		memcpy(cell->name, scell.name, CELL_NAME_MAX);
+		cell->name[CELL_NAME_MAX - 1] = 0;
+		cell->parent_library = lib;
+		/* The image is loop free and fully resolved */
+		cell->checks.unresolved_child_count = 0;
+		cell->checks.affected_by_reference_loop = 0;
+		lib->cells = g_list_append(lib->cells, cell);
+		lib->cell_names = g_list_append(lib->cell_names, cell->name);
+		cells[i] = cell;
+
+		for (j = 0; j < scell.gfx_count; j++) {
+			if (!read_bytes(bytes, length, &offset, &sgfx, sizeof(sgfx)))
+				goto err_free;
+			if (sgfx.vertex_count > (length - offset) / sizeof(struct gds_point))
+				goto err_free;
+
+			gfx = (struct gds_graphics *)malloc(sizeof(struct gds_graphics));
+			if (!gfx)
+				goto err_free;
+			memset(gfx, 0, sizeof(struct gds_graphics));
+			gfx->gfx_type = (enum graphics_type)sgfx.gfx_type;
+			gfx->path_render_type = (enum path_type)sgfx.path_render_type;
+			gfx->width_absolute = sgfx.width_absolute;
+			gfx->layer = sgfx.layer;
+			gfx->datatype = sgfx.datatype;
+			cell->graphic_objs = g_list_prepend(cell->graphic_objs, gfx);
+
+			if (sgfx.vertex_count == 0)
+				continue;
+
+			gfx->vertex_array = (struct gds_point *)malloc(sgfx.vertex_count * sizeof(struct gds_point));
+			if (!gfx->vertex_array)
+				goto err_free;
+			gfx->vertex_count = sgfx.vertex_count;
+			read_bytes(bytes, length, &offset, gfx->vertex_array, sgfx.vertex_count * sizeof(struct gds_point));
+		}
+		cell->graphic_objs = g_list_reverse(cell->graphic_objs);
+
+		for (j = 0; j < scell.instance_count; j++) {
+			if (!read_bytes(bytes, length, &offset, &sinst, sizeof(sinst)))
+				goto err_free;
+			if (sinst.cell_index >= i)
+				goto err_free;
+
+			inst = (struct gds_cell_instance *)malloc(sizeof(struct gds_cell_instance));
+			if (!inst)
+				goto err_free;
+			inst->cell_ref = cells[sinst.cell_index];
+			memcpy(inst->ref_name, inst->cell_ref->name, CELL_NAME_MAX);
+			inst->origin = sinst.origin;
+			inst->flipped = sinst.flipped;
+			inst->angle = sinst.angle;
+			inst->magnification = sinst.magnification;
+			cell->child_cells = g_list_prepend(cell->child_cells, inst);
+		}
+		cell->child_cells = g_list_reverse(cell->child_cells);
+	}
+
+	*top_cell = cells[header.cell_count - 1];
+	g_free(cells);
+
+	return lib;
+
+err_free:
+	g_free(cells);
+	free_library(lib);
+	return NULL;
+}
+
+/** @} */
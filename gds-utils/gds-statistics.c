@@ -0,0 +1,263 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-statistics.c
+ * @brief Estimate the rendering cost of a cell
+ *
+ * The statistics are calculated in the bottom-up order of gds_topology_get_reachable_cells().
+ * The result of each cell is stored and reused for every further instance of this cell.
+ * Multiple instances of the same cell inside a parent are merged before the child's layer statistics
+ * are added to the parent.
+ *
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#include <gds-render/gds-utils/gds-statistics.h>
+#include <gds-render/gds-utils/gds-topology.h>
+
+static guint64 saturating_add(guint64 a, guint64 b)
+{
+	return (a > G_MAXUINT64 - b ? G_MAXUINT64 : a + b);
+}
+
+static guint64 saturating_mul(guint64 a, guint64 b)
+{
+	if (a != 0 && b > G_MAXUINT64 / a)
+		return G_MAXUINT64;
+
+	return a * b;
+}
+
+static gint compare_layer_statistics(gconstpointer a, gconstpointer b)
+{
+	const struct gds_layer_statistics *la = (const struct gds_layer_statistics *)a;
+	const struct gds_layer_statistics *lb = (const struct gds_layer_statistics *)b;
+
+	return (la->layer > lb->layer) - (la->layer < lb->layer);
+}
+
+static struct gds_cell_statistics *cell_statistics_new(void)
+{
+	struct gds_cell_statistics *stats;
+
+	stats = g_new(struct gds_cell_statistics, 1);
+	stats->primitive_count = 0ULL;
+	stats->vertex_count = 0ULL;
+	stats->instance_count = 0ULL;
+	stats->layers = g_array_new(FALSE, FALSE, sizeof(struct gds_layer_statistics));
+
+	return stats;
+}
+
+static void cell_statistics_destroy(gpointer data)
+{
+	struct gds_cell_statistics *stats = (struct gds_cell_statistics *)data;
+
+	if (!stats)
+		return;
+
+	gds_statistics_free(stats);
+	g_free(stats);
+}
+
+/**
+ * @brief Add the statistics of a child cell multiple times to the layer table of the parent
+ * @param layer_table Layer table of the parent. Maps layer numbers to #gds_layer_statistics
+ * @param child Statistics of the child
+ * @param multiplicity Number of instances of the child
+ */
+static void add_child_layers(GHashTable *layer_table, const struct gds_cell_statistics *child, guint64 multiplicity)
+{
+	const struct gds_layer_statistics *src;
+	struct gds_layer_statistics *dest;
+	guint i;
+
+	for (i = 0; i < child->layers->len; i++) {
+		src = &g_array_index(child->layers, struct gds_layer_statistics, i);
+		dest = (struct gds_layer_statistics *)g_hash_table_lookup(layer_table, GINT_TO_POINTER(src->layer));
+		if (!dest) {
+			dest = g_new0(struct gds_layer_statistics, 1);
+			dest->layer = src->layer;
+			g_hash_table_insert(layer_table, GINT_TO_POINTER(src->layer), dest);
+		}
+		dest->primitive_count = saturating_add(dest->primitive_count,
+						       saturating_mul(src->primitive_count, multiplicity));
+		dest->vertex_count = saturating_add(dest->vertex_count,
+						    saturating_mul(src->vertex_count, multiplicity));
+	}
+}
+
+/**
+ * @brief Calculate the statistics of a cell and store them in the memoization table
+ *
+ * All sub cells of \p cell must already be stored in \p memo.
+ *
+ * @param cell Cell
+ * @param memo Table of already calculated cells
+ * @return Statistics of the cell or NULL if a sub cell has not been calculated
+ */
+static const struct gds_cell_statistics *calculate_cell(struct gds_cell *cell, GHashTable *memo)
+{
+	gpointer value;
+	struct gds_cell_statistics *stats;
+	const struct gds_cell_statistics *child_stats;
+	GHashTable *child_multiplicity;
+	GHashTable *layer_table;
+	GHashTableIter iter;
+	gpointer key;
+	GList *list_iter;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	struct gds_layer_statistics *lstat;
+	guint64 vertices;
+	guint64 count;
+
+	/* Count instances of each child cell */
+	child_multiplicity = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (list_iter = cell->child_cells; list_iter != NULL; list_iter = g_list_next(list_iter)) {
+		inst = (struct gds_cell_instance *)list_iter->data;
+		if (!inst || !inst->cell_ref)
+			continue;
+		count = GPOINTER_TO_UINT(g_hash_table_lookup(child_multiplicity, inst->cell_ref));
+		g_hash_table_insert(child_multiplicity, inst->cell_ref, GUINT_TO_POINTER(count + 1));
+	}
+
+	stats = cell_statistics_new();
+	layer_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	/* Own graphics */
+	for (list_iter = cell->graphic_objs; list_iter != NULL; list_iter = g_list_next(list_iter)) {
+		gfx = (struct gds_graphics *)list_iter->data;
+		vertices = gfx->vertex_count;
+
+		lstat = (struct gds_layer_statistics *)g_hash_table_lookup(layer_table, GINT_TO_POINTER(gfx->layer));
+		if (!lstat) {
+			lstat = g_new0(struct gds_layer_statistics, 1);
+			lstat->layer = gfx->layer;
+			g_hash_table_insert(layer_table, GINT_TO_POINTER(lstat->layer), lstat);
+		}
+		lstat->primitive_count++;
+		lstat->vertex_count += vertices;
+		stats->primitive_count++;
+		stats->vertex_count += vertices;
+	}
+
+	/* Child cells */
+	g_hash_table_iter_init(&iter, child_multiplicity);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		child_stats = (const struct gds_cell_statistics *)g_hash_table_lookup(memo, key);
+		if (!child_stats) {
+			g_hash_table_destroy(layer_table);
+			g_hash_table_destroy(child_multiplicity);
+			cell_statistics_destroy(stats);
+			return NULL;
+		}
+
+		count = GPOINTER_TO_UINT(value);
+		stats->primitive_count = saturating_add(stats->primitive_count,
+							saturating_mul(child_stats->primitive_count, count));
+		stats->vertex_count = saturating_add(stats->vertex_count,
+						     saturating_mul(child_stats->vertex_count, count));
+		stats->instance_count = saturating_add(stats->instance_count,
+						       saturating_mul(saturating_add(child_stats->instance_count, 1),
+								      count));
+		add_child_layers(layer_table, child_stats, count);
+	}
+
+	/* Convert layer table to sorted array */
+	g_hash_table_iter_init(&iter, layer_table);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		g_array_append_vals(stats->layers, value, 1);
+	g_array_sort(stats->layers, compare_layer_statistics);
+
+	g_hash_table_destroy(layer_table);
+	g_hash_table_destroy(child_multiplicity);
+
+	g_hash_table_insert(memo, cell, stats);
+
+	return stats;
+}
+
+int gds_statistics_calculate(struct gds_cell *cell, struct gds_cell_statistics *stats)
+{
+	GHashTable *memo;
+	GPtrArray *cells;
+	const struct gds_cell_statistics *result = NULL;
+	guint i;
+	int ret = 0;
+
+	if (!cell || !stats || !cell->parent_library)
+		return -1;
+
+	/* Sub cells precede their parents. This keeps the stack depth independent of the hierarchy depth */
+	cells = gds_topology_get_reachable_cells(cell->parent_library, cell);
+	if (!cells) {
+		stats->primitive_count = 0ULL;
+		stats->vertex_count = 0ULL;
+		stats->instance_count = 0ULL;
+		stats->layers = g_array_new(FALSE, FALSE, sizeof(struct gds_layer_statistics));
+		return -2;
+	}
+
+	memo = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, cell_statistics_destroy);
+
+	for (i = 0; i < cells->len; i++) {
+		result = calculate_cell((struct gds_cell *)g_ptr_array_index(cells, i), memo);
+		if (!result)
+			break;
+	}
+
+	if (!result) {
+		ret = -2;
+		stats->primitive_count = 0ULL;
+		stats->vertex_count = 0ULL;
+		stats->instance_count = 0ULL;
+		stats->layers = g_array_new(FALSE, FALSE, sizeof(struct gds_layer_statistics));
+	} else {
+		stats->primitive_count = result->primitive_count;
+		stats->vertex_count = result->vertex_count;
+		stats->instance_count = result->instance_count;
+		stats->layers = g_array_sized_new(FALSE, FALSE, sizeof(struct gds_layer_statistics),
+						  result->layers->len);
+		g_array_append_vals(stats->layers, result->layers->data, result->layers->len);
+	}
+
+	g_hash_table_destroy(memo);
+	g_ptr_array_free(cells, TRUE);
+
+	return ret;
+}
+
+void gds_statistics_free(struct gds_cell_statistics *stats)
+{
+	if (!stats)
+		return;
+
+	if (stats->layers)
+		g_array_free(stats->layers, TRUE);
+	stats->layers = NULL;
+}
+
+/** @} */
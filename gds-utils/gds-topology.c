@@ -0,0 +1,267 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-topology.c
+ * @brief Cached topological order of the cells of a library
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The order is calculated with Kahn's algorithm on the reversed references: A cell is emitted as soon
+ * as all cells it references have been emitted. Cells that are never emitted are affected by a loop.
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#include <gds-render/gds-utils/gds-topology.h>
+
+/** @brief Protects gds_library::topology of all libraries */
+static GMutex topology_lock;
+
+/**
+ * @brief Entry of the depth first search stack
+ */
+struct reachable_frame {
+	struct gds_cell *cell; /**< @brief Cell */
+	GList *next_child; /**< @brief Next child instance to process */
+};
+
+static void topology_free(struct gds_library_topology *topo)
+{
+	if (!topo)
+		return;
+
+	g_ptr_array_free(topo->bottom_up, TRUE);
+	g_list_free(topo->top_cells);
+	g_hash_table_destroy(topo->depth);
+	g_free(topo);
+}
+
+static struct gds_library_topology *topology_calculate(struct gds_library *lib)
+{
+	struct gds_library_topology *topo;
+	GHashTable *index;
+	GPtrArray *cells;
+	GList *iter;
+	GList *child_iter;
+	struct gds_cell *cell;
+	struct gds_cell_instance *inst;
+	guint *remaining;
+	guint *parent_start;
+	guint *parents;
+	guint *fill;
+	int *depth;
+	guint cell_count;
+	guint edge_count = 0;
+	guint head;
+	guint i, p, c;
+	gpointer value;
+
+	topo = g_new(struct gds_library_topology, 1);
+	topo->top_cells = NULL;
+	topo->depth = g_hash_table_new(g_direct_hash, g_direct_equal);
+	topo->has_loops = FALSE;
+
+	cells = g_ptr_array_new();
+	index = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter)) {
+		if (!iter->data || g_hash_table_contains(index, iter->data))
+			continue;
+		g_hash_table_insert(index, iter->data, GUINT_TO_POINTER(cells->len));
+		g_ptr_array_add(cells, iter->data);
+	}
+	cell_count = cells->len;
+
+	/* Count the references of each cell and the parents of each cell */
+	remaining = g_new0(guint, cell_count + 1);
+	parent_start = g_new0(guint, cell_count + 2);
+	for (i = 0; i < cell_count; i++) {
+		cell = (struct gds_cell *)g_ptr_array_index(cells, i);
+		for (child_iter = cell->child_cells; child_iter != NULL; child_iter = g_list_next(child_iter)) {
+			inst = (struct gds_cell_instance *)child_iter->data;
+			if (!inst || !inst->cell_ref ||
+			    !g_hash_table_lookup_extended(index, inst->cell_ref, NULL, &value))
+				continue;
+			remaining[i]++;
+			parent_start[GPOINTER_TO_UINT(value) + 1]++;
+			edge_count++;
+		}
+	}
+
+	/* Store the parents of all cells in one array */
+	for (i = 0; i < cell_count; i++)
+		parent_start[i + 1] += parent_start[i];
+	parents = g_new(guint, edge_count + 1);
+	fill = g_new(guint, cell_count + 1);
+	for (i = 0; i < cell_count; i++)
+		fill[i] = parent_start[i];
+	for (i = 0; i < cell_count; i++) {
+		cell = (struct gds_cell *)g_ptr_array_index(cells, i);
+		for (child_iter = cell->child_cells; child_iter != NULL; child_iter = g_list_next(child_iter)) {
+			inst = (struct gds_cell_instance *)child_iter->data;
+			if (!inst || !inst->cell_ref ||
+			    !g_hash_table_lookup_extended(index, inst->cell_ref, NULL, &value))
+				continue;
+			parents[fill[GPOINTER_TO_UINT(value)]++] = i;
+		}
+	}
+
+	/* Emit leaf cells first. The emitted cells are used as queue */
+	topo->bottom_up = g_ptr_array_sized_new(cell_count);
+	for (i = 0; i < cell_count; i++) {
+		if (remaining[i] == 0)
+			g_ptr_array_add(topo->bottom_up, GUINT_TO_POINTER(i));
+	}
+
+	for (head = 0; head < topo->bottom_up->len; head++) {
+		c = GPOINTER_TO_UINT(g_ptr_array_index(topo->bottom_up, head));
+		for (p = parent_start[c]; p < parent_start[c + 1]; p++) {
+			if (--remaining[parents[p]] == 0)
+				g_ptr_array_add(topo->bottom_up, GUINT_TO_POINTER(parents[p]));
+		}
+	}
+
+	topo->has_loops = (topo->bottom_up->len != cell_count);
+
+	/* Propagate the depth from the top cells downwards */
+	depth = g_new0(int, cell_count + 1);
+	for (head = topo->bottom_up->len; head > 0; head--) {
+		c = GPOINTER_TO_UINT(g_ptr_array_index(topo->bottom_up, head - 1));
+		for (p = parent_start[c]; p < parent_start[c + 1]; p++) {
+			/* Parents affected by a loop have no depth */
+			if (remaining[parents[p]] == 0)
+				depth[c] = MAX(depth[c], depth[parents[p]] + 1);
+		}
+	}
+
+	/* Convert indices to cells */
+	for (head = 0; head < topo->bottom_up->len; head++) {
+		c = GPOINTER_TO_UINT(g_ptr_array_index(topo->bottom_up, head));
+		g_ptr_array_index(topo->bottom_up, head) = g_ptr_array_index(cells, c);
+		g_hash_table_insert(topo->depth, g_ptr_array_index(cells, c), GINT_TO_POINTER(depth[c]));
+	}
+
+	for (i = cell_count; i > 0; i--) {
+		if (parent_start[i] == parent_start[i - 1])
+			topo->top_cells = g_list_prepend(topo->top_cells, g_ptr_array_index(cells, i - 1));
+	}
+
+	g_free(depth);
+	g_free(fill);
+	g_free(parents);
+	g_free(parent_start);
+	g_free(remaining);
+	g_hash_table_destroy(index);
+	g_ptr_array_free(cells, TRUE);
+
+	return topo;
+}
+
+const struct gds_library_topology *gds_topology_get(struct gds_library *lib)
+{
+	struct gds_library_topology *topo;
+
+	if (!lib)
+		return NULL;
+
+	g_mutex_lock(&topology_lock);
+	if (!lib->topology)
+		lib->topology = topology_calculate(lib);
+	topo = lib->topology;
+	g_mutex_unlock(&topology_lock);
+
+	return topo;
+}
+
+void gds_topology_invalidate(struct gds_library *lib)
+{
+	if (!lib)
+		return;
+
+	g_mutex_lock(&topology_lock);
+	topology_free(lib->topology);
+	lib->topology = NULL;
+	g_mutex_unlock(&topology_lock);
+}
+
+int gds_topology_get_cell_depth(struct gds_library *lib, const struct gds_cell *cell)
+{
+	const struct gds_library_topology *topo;
+	gpointer value;
+
+	topo = gds_topology_get(lib);
+	if (!topo || !cell)
+		return -1;
+
+	if (!g_hash_table_lookup_extended(topo->depth, cell, NULL, &value))
+		return -1;
+
+	return GPOINTER_TO_INT(value);
+}
+
+GPtrArray *gds_topology_get_reachable_cells(struct gds_library *lib, struct gds_cell *top_cell)
+{
+	GPtrArray *result;
+	GArray *stack;
+	GHashTable *visited;
+	struct reachable_frame frame;
+	struct reachable_frame *top;
+	struct gds_cell_instance *inst;
+
+	if (gds_topology_get_cell_depth(lib, top_cell) < 0)
+		return NULL;
+
+	result = g_ptr_array_new();
+	visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+	stack = g_array_new(FALSE, FALSE, sizeof(struct reachable_frame));
+
+	frame.cell = top_cell;
+	frame.next_child = top_cell->child_cells;
+	g_array_append_val(stack, frame);
+	g_hash_table_add(visited, top_cell);
+
+	/* Post order of a depth first search. Loop free, as the top cell is not affected by a loop */
+	while (stack->len > 0) {
+		top = &g_array_index(stack, struct reachable_frame, stack->len - 1);
+		if (!top->next_child) {
+			g_ptr_array_add(result, top->cell);
+			g_array_set_size(stack, stack->len - 1);
+			continue;
+		}
+
+		inst = (struct gds_cell_instance *)top->next_child->data;
+		top->next_child = g_list_next(top->next_child);
+		if (!inst || !inst->cell_ref || g_hash_table_contains(visited, inst->cell_ref))
+			continue;
+
+		g_hash_table_add(visited, inst->cell_ref);
+		frame.cell = inst->cell_ref;
+		frame.next_child = inst->cell_ref->child_cells;
+		g_array_append_val(stack, frame);
+	}
+
+	g_array_free(stack, TRUE);
+	g_hash_table_destroy(visited);
+
+	return result;
+}
+
+/** @} */
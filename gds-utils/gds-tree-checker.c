@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <glib/gi18n.h>
 #include <gds-render/gds-utils/gds-tree-checker.h>
+#include <gds-render/gds-utils/gds-topology.h>
 
 int gds_tree_check_cell_references(struct gds_library *lib)
 {
@@ -85,127 +86,277 @@ int gds_tree_check_cell_references(struct gds_library *lib)
 }
 
 /**
- * @brief Check if list contains a cell
- * @param list GList to check. May be a null pointer
- * @param cell Cell to check for
- * @return 0 if cell is not in list. 1 if cell is in list
+ * @brief Node of the reference graph used by the strongly connected component search
  */
-static int gds_tree_check_list_contains_cell(GList *list, struct gds_cell *cell)
-{
-	GList *iter;
-
-	for (iter = list; iter != NULL; iter = g_list_next(iter)) {
-		if ((struct gds_cell *)iter->data == cell)
-			return 1;
-	}
+struct tree_check_node {
+	struct gds_cell *cell; /**< @brief Cell */
+	int index; /**< @brief Discovery index. -1 if not yet visited */
+	int lowlink; /**< @brief Smallest discovery index reachable from this node inside the DFS subtree */
+	GList *next_child; /**< @brief Next child instance to process */
+	gboolean on_stack; /**< @brief Node is on the component stack */
+	gboolean affected; /**< @brief Node is part of or reaches a reference loop */
+};
 
-	return 0;
+/**
+ * @brief Get the node of a cell. Create it if it does not exist yet
+ *
+ * The node index is stored in the checker internal marker of the cell.
+ *
+ * @param nodes Array of #tree_check_node
+ * @param cell Cell
+ * @return Node index
+ */
+static guint gds_tree_check_get_node(GArray *nodes, struct gds_cell *cell)
+{
+	struct tree_check_node node;
+	int marker = cell->checks._internal.marker;
+
+	/* The marker is only trusted if it points back to this cell */
+	if (marker >= 0 && (guint)marker < nodes->len &&
+	    g_array_index(nodes, struct tree_check_node, marker).cell == cell)
+		return (guint)marker;
+
+	node.cell = cell;
+	node.index = -1;
+	node.lowlink = -1;
+	node.next_child = NULL;
+	node.on_stack = FALSE;
+	node.affected = FALSE;
+	g_array_append_val(nodes, node);
+	cell->checks._internal.marker = (int)(nodes->len - 1);
+
+	return nodes->len - 1;
 }
 
 /**
- * @brief This function follows down the reference list of a cell and marks each visited subcell and detects loops
- * @param cell_to_check The cell to check for reference loops
- * @param visited_cells Pointer to list head. May be zero.
- * @return 0 if no loops exist; error in processing: <0; loop found: >0
+ * @brief Find all cells affected by reference loops starting at a single root cell
+ *
+ * This is an iterative version of Tarjan's algorithm for strongly connected components.
+ * A component containing more than one cell or a cell referencing itself is a loop.
+ * A cell is affected if it is part of a loop or references an affected cell.
+ *
+ * @param nodes Array of #tree_check_node
+ * @param root Index of the root node
+ * @param counter Discovery index counter
+ * @param call_stack Working array of node indices representing the DFS path
+ * @param component_stack Working array of node indices for the component search
+ * @return 0 if successful, negative in case of a broken cell instance
  */
-static int gds_tree_check_iterate_ref_and_check(struct gds_cell *cell_to_check, GList **visited_cells)
+static int gds_tree_check_strong_connect(GArray *nodes, guint root, int *counter, GArray *call_stack,
+					 GArray *component_stack)
 {
-	GList *ref_iter;
+	struct tree_check_node *node;
+	struct tree_check_node *child;
+	struct tree_check_node *member;
 	struct gds_cell_instance *ref;
-	struct gds_cell *sub_cell;
-	int res;
-
-	if (!cell_to_check)
-		return -1;
+	guint node_idx;
+	guint child_idx;
+	guint member_idx;
+	guint i;
+	gboolean affected;
+
+	g_array_append_val(call_stack, root);
+
+	while (call_stack->len > 0) {
+		node_idx = g_array_index(call_stack, guint, call_stack->len - 1);
+		node = &g_array_index(nodes, struct tree_check_node, node_idx);
+
+		/* First visit of this node */
+		if (node->index < 0) {
+			node->index = *counter;
+			node->lowlink = *counter;
+			(*counter)++;
+			node->next_child = node->cell->child_cells;
+			node->on_stack = TRUE;
+			g_array_append_val(component_stack, node_idx);
+		}
 
-	/* Check if this cell is already contained in visited cells. This indicates a loop */
-	if (gds_tree_check_list_contains_cell(*visited_cells, cell_to_check))
-		return 1;
+		/* Process the next resolved child */
+		if (node->next_child) {
+			ref = (struct gds_cell_instance *)node->next_child->data;
+			node->next_child = g_list_next(node->next_child);
 
-	/* Add cell to visited cell list */
-	*visited_cells = g_list_append(*visited_cells, (gpointer)cell_to_check);
+			if (!ref)
+				return -3;
 
-	/* Mark references and process sub cells */
-	for (ref_iter = cell_to_check->child_cells; ref_iter != NULL; ref_iter = g_list_next(ref_iter)) {
-		ref = (struct gds_cell_instance *)ref_iter->data;
+			/* If cell is not resolved, ignore. No harm there */
+			if (!ref->cell_ref)
+				continue;
 
-		if (!ref)
-			return -1;
+			/* May reallocate the node array */
+			child_idx = gds_tree_check_get_node(nodes, ref->cell_ref);
+			node = &g_array_index(nodes, struct tree_check_node, node_idx);
+			child = &g_array_index(nodes, struct tree_check_node, child_idx);
+
+			if (child->index < 0) {
+				g_array_append_val(call_stack, child_idx);
+			} else if (child->on_stack) {
+				/* The child reaches this node. Both are part of a loop */
+				node->lowlink = MIN(node->lowlink, child->index);
+				node->affected = TRUE;
+			} else {
+				node->affected |= child->affected;
+			}
+			continue;
+		}
 
-		sub_cell = ref->cell_ref;
+		/* All children done. Close the component if this node is its root */
+		if (node->lowlink == node->index) {
+			affected = FALSE;
+			for (i = component_stack->len; i > 0; i--) {
+				member_idx = g_array_index(component_stack, guint, i - 1);
+				affected |= g_array_index(nodes, struct tree_check_node, member_idx).affected;
+				if (member_idx == node_idx)
+					break;
+			}
 
-		/* If cell is not resolved, ignore. No harm there */
-		if (!sub_cell)
-			continue;
+			do {
+				member_idx = g_array_index(component_stack, guint, component_stack->len - 1);
+				g_array_set_size(component_stack, component_stack->len - 1);
+				member = &g_array_index(nodes, struct tree_check_node, member_idx);
+				member->on_stack = FALSE;
+				member->affected = affected;
+			} while (member_idx != node_idx);
+		}
 
-		res = gds_tree_check_iterate_ref_and_check(sub_cell, visited_cells);
-		if (res < 0) {
-			/* Error. return. */
-			return -3;
-		} else if (res > 0) {
-			/* Loop in subcell found. Propagate to top */
-			return 1;
+		/* Return to the parent */
+		g_array_set_size(call_stack, call_stack->len - 1);
+		if (call_stack->len > 0) {
+			child = node;
+			node = &g_array_index(nodes, struct tree_check_node,
+					      g_array_index(call_stack, guint, call_stack->len - 1));
+			node->lowlink = MIN(node->lowlink, child->lowlink);
+			node->affected |= child->affected;
 		}
 	}
 
-	/* Remove cell from visted cells */
-	*visited_cells = g_list_remove(*visited_cells, cell_to_check);
-
-	/* No error found in this chain */
 	return 0;
 }
 
 int gds_tree_check_reference_loops(struct gds_library *lib)
 {
-	int res;
+	int res = 0;
 	int loop_count = 0;
+	int counter = 0;
 	GList *cell_iter;
 	struct gds_cell *cell_to_check;
-	GList *visited_cells = NULL;
-
+	struct tree_check_node *node;
+	GArray *nodes;
+	GArray *call_stack;
+	GArray *component_stack;
+	guint idx;
 
 	if (!lib)
 		return -1;
 
+	/* A broken cell reference will be counted fatal in this case */
 	for (cell_iter = lib->cells; cell_iter != NULL; cell_iter = g_list_next(cell_iter)) {
-		cell_to_check = (struct gds_cell *)cell_iter->data;
-
-		/* A broken cell reference will be counted fatal in this case */
-		if (!cell_to_check)
+		if (!cell_iter->data)
 			return -2;
+	}
 
-		/* iterate through references and check if loop exists */
-		res = gds_tree_check_iterate_ref_and_check(cell_to_check, &visited_cells);
-
-		if (visited_cells) {
-			/*
-			 * If  cell contains no loop, print error when list not empty.
-			 * In case of a loop, it is completely normal that the list is not empty,
-			 * due to the instant return from gds_tree_check_iterate_ref_and_check()
-			 */
-			if (res == 0)
-				fprintf(stderr,
-					_("Visited cell list should be empty. This is a bug. Please report this.\n"));
-			g_list_free(visited_cells);
-			visited_cells = NULL;
-		}
+	nodes = g_array_new(FALSE, FALSE, sizeof(struct tree_check_node));
+	call_stack = g_array_new(FALSE, FALSE, sizeof(guint));
+	component_stack = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	/* Invalidate old markers. Otherwise they might point to a valid node by accident */
+	for (cell_iter = lib->cells; cell_iter != NULL; cell_iter = g_list_next(cell_iter))
+		((struct gds_cell *)cell_iter->data)->checks._internal.marker = -1;
+
+	/* Every cell and reference is processed exactly once */
+	for (cell_iter = lib->cells; cell_iter != NULL; cell_iter = g_list_next(cell_iter)) {
+		cell_to_check = (struct gds_cell *)cell_iter->data;
+		idx = gds_tree_check_get_node(nodes, cell_to_check);
+		if (g_array_index(nodes, struct tree_check_node, idx).index >= 0)
+			continue;
+
+		res = gds_tree_check_strong_connect(nodes, idx, &counter, call_stack, component_stack);
+		if (res < 0)
+			goto free_arrays;
+	}
 
-		if (res < 0) {
-			/* Error */
-			return res;
-		} else if (res > 0) {
+	for (cell_iter = lib->cells; cell_iter != NULL; cell_iter = g_list_next(cell_iter)) {
+		cell_to_check = (struct gds_cell *)cell_iter->data;
+		node = &g_array_index(nodes, struct tree_check_node,
+				      gds_tree_check_get_node(nodes, cell_to_check));
+		if (node->affected) {
 			/* Loop found: increment loop count and flag cell */
 			cell_to_check->checks.affected_by_reference_loop = 1;
 			loop_count++;
-		} else if (res == 0) {
+		} else {
 			/* No error found for this cell */
 			cell_to_check->checks.affected_by_reference_loop = 0;
 		}
+	}
+
+	res = loop_count;
 
+free_arrays:
+	g_array_free(component_stack, TRUE);
+	g_array_free(call_stack, TRUE);
+	g_array_free(nodes, TRUE);
+
+	return res;
+}
+
+int gds_tree_check_instance_counts(struct gds_library *lib, struct gds_cell *top_cell)
+{
+	const struct gds_library_topology *topo;
+	GPtrArray *cells;
+	GList *iter;
+	struct gds_cell *cell;
+	struct gds_cell_instance *inst;
+	guint64 count;
+	guint i;
+
+	if (!lib)
+		return -1;
+
+	topo = gds_topology_get(lib);
+
+	if (top_cell) {
+		cells = gds_topology_get_reachable_cells(lib, top_cell);
+		if (!cells)
+			return -2;
+	} else {
+		cells = g_ptr_array_sized_new(topo->bottom_up->len);
+		for (i = 0; i < topo->bottom_up->len; i++)
+			g_ptr_array_add(cells, g_ptr_array_index(topo->bottom_up, i));
 	}
 
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter)) {
+		if (iter->data)
+			((struct gds_cell *)iter->data)->checks.instance_count = 0ULL;
+	}
+
+	if (top_cell) {
+		top_cell->checks.instance_count = 1ULL;
+	} else {
+		for (iter = topo->top_cells; iter != NULL; iter = g_list_next(iter))
+			((struct gds_cell *)iter->data)->checks.instance_count = 1ULL;
+	}
 
-	return loop_count;
+	/* Parents come before their children in reverse bottom-up order */
+	for (i = cells->len; i > 0; i--) {
+		cell = (struct gds_cell *)g_ptr_array_index(cells, i - 1);
+		count = cell->checks.instance_count;
+		if (count == 0ULL)
+			continue;
+
+		for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+			inst = (struct gds_cell_instance *)iter->data;
+			if (!inst || !inst->cell_ref)
+				continue;
+			if (inst->cell_ref->checks.instance_count > G_MAXUINT64 - count)
+				inst->cell_ref->checks.instance_count = G_MAXUINT64;
+			else
+				inst->cell_ref->checks.instance_count += count;
+		}
+	}
+
+	g_ptr_array_free(cells, TRUE);
+
+	return 0;
 }
 
 /** @} */
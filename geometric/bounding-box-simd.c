@@ -0,0 +1,263 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bounding-box-simd.c
+ * @brief Bounding box calculation of integer point arrays using SIMD instructions
+ *
+ * A #gds_point consists of two 32 bit integers. An array of points is therefore
+ * an interleaved array x0, y0, x1, y1, ... The kernels calculate the minimum and maximum
+ * of all even and all odd elements at once and reduce the lanes at the end.
+ *
+ * The kernel is selected once at runtime depending on the features of the executing CPU.
+ *
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <stdint.h>
+#include <float.h>
+
+#include <gds-render/geometric/bounding-box.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BOUNDING_BOX_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define BOUNDING_BOX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+G_STATIC_ASSERT(sizeof(struct gds_point) == 2 * sizeof(int32_t));
+
+/**
+ * @brief Kernel function calculating the integer bounding box of points
+ * @param points Points
+ * @param count Point count. Has to be greater than 0
+ * @param[out] res Result: min x, min y, max x, max y
+ */
+typedef void (*int_min_max_func_t)(const struct gds_point *points, size_t count, int32_t *res);
+
+static void int_min_max_scalar(const struct gds_point *points, size_t count, int32_t *res)
+{
+	int32_t xmin = INT32_MAX, ymin = INT32_MAX, xmax = INT32_MIN, ymax = INT32_MIN;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		xmin = MIN(xmin, points[i].x);
+		ymin = MIN(ymin, points[i].y);
+		xmax = MAX(xmax, points[i].x);
+		ymax = MAX(ymax, points[i].y);
+	}
+
+	res[0] = xmin;
+	res[1] = ymin;
+	res[2] = xmax;
+	res[3] = ymax;
+}
+
+/**
+ * @brief Merge a partial scalar result into a result array
+ * @param res Result array to update
+ * @param part Partial result
+ */
+static void int_min_max_merge(int32_t *res, const int32_t *part)
+{
+	res[0] = MIN(res[0], part[0]);
+	res[1] = MIN(res[1], part[1]);
+	res[2] = MAX(res[2], part[2]);
+	res[3] = MAX(res[3], part[3]);
+}
+
+#ifdef BOUNDING_BOX_SIMD_X86
+
+/**
+ * @brief Reduce interleaved (x, y, x, y) minimum and maximum vectors
+ * @param vmin Minimum vector
+ * @param vmax Maximum vector
+ * @param[out] res Result: min x, min y, max x, max y
+ */
+__attribute__((target("sse4.1")))
+static inline void int_min_max_reduce_sse41(__m128i vmin, __m128i vmax, int32_t *res)
+{
+	vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+	vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	res[0] = _mm_cvtsi128_si32(vmin);
+	res[1] = _mm_extract_epi32(vmin, 1);
+	res[2] = _mm_cvtsi128_si32(vmax);
+	res[3] = _mm_extract_epi32(vmax, 1);
+}
+
+__attribute__((target("sse4.1")))
+static void int_min_max_sse41(const struct gds_point *points, size_t count, int32_t *res)
+{
+	__m128i vmin0 = _mm_set1_epi32(INT32_MAX);
+	__m128i vmax0 = _mm_set1_epi32(INT32_MIN);
+	__m128i vmin1 = vmin0;
+	__m128i vmax1 = vmax0;
+	__m128i a, b;
+	int32_t tail[4];
+	size_t i;
+
+	/* Two independent accumulators, two points per register */
+	for (i = 0; i + 4 <= count; i += 4) {
+		a = _mm_loadu_si128((const __m128i *)&points[i]);
+		b = _mm_loadu_si128((const __m128i *)&points[i + 2]);
+		vmin0 = _mm_min_epi32(vmin0, a);
+		vmax0 = _mm_max_epi32(vmax0, a);
+		vmin1 = _mm_min_epi32(vmin1, b);
+		vmax1 = _mm_max_epi32(vmax1, b);
+	}
+
+	int_min_max_reduce_sse41(_mm_min_epi32(vmin0, vmin1), _mm_max_epi32(vmax0, vmax1), res);
+
+	if (i < count) {
+		int_min_max_scalar(&points[i], count - i, tail);
+		int_min_max_merge(res, tail);
+	}
+}
+
+__attribute__((target("avx2")))
+static void int_min_max_avx2(const struct gds_point *points, size_t count, int32_t *res)
+{
+	__m256i vmin0 = _mm256_set1_epi32(INT32_MAX);
+	__m256i vmax0 = _mm256_set1_epi32(INT32_MIN);
+	__m256i vmin1 = vmin0;
+	__m256i vmax1 = vmax0;
+	__m256i a, b;
+	__m128i min128, max128;
+	int32_t tail[4];
+	size_t i;
+
+	/* Two independent accumulators, four points per register */
+	for (i = 0; i + 8 <= count; i += 8) {
+		a = _mm256_loadu_si256((const __m256i *)&points[i]);
+		b = _mm256_loadu_si256((const __m256i *)&points[i + 4]);
+		vmin0 = _mm256_min_epi32(vmin0, a);
+		vmax0 = _mm256_max_epi32(vmax0, a);
+		vmin1 = _mm256_min_epi32(vmin1, b);
+		vmax1 = _mm256_max_epi32(vmax1, b);
+	}
+
+	vmin0 = _mm256_min_epi32(vmin0, vmin1);
+	vmax0 = _mm256_max_epi32(vmax0, vmax1);
+	min128 = _mm_min_epi32(_mm256_castsi256_si128(vmin0), _mm256_extracti128_si256(vmin0, 1));
+	max128 = _mm_max_epi32(_mm256_castsi256_si128(vmax0), _mm256_extracti128_si256(vmax0, 1));
+	int_min_max_reduce_sse41(min128, max128, res);
+
+	if (i < count) {
+		int_min_max_scalar(&points[i], count - i, tail);
+		int_min_max_merge(res, tail);
+	}
+}
+
+#endif /* BOUNDING_BOX_SIMD_X86 */
+
+#ifdef BOUNDING_BOX_SIMD_NEON
+
+static void int_min_max_neon(const struct gds_point *points, size_t count, int32_t *res)
+{
+	int32x4_t vmin0 = vdupq_n_s32(INT32_MAX);
+	int32x4_t vmax0 = vdupq_n_s32(INT32_MIN);
+	int32x4_t vmin1 = vmin0;
+	int32x4_t vmax1 = vmax0;
+	int32x4_t a, b;
+	int32x2_t min64, max64;
+	int32_t tail[4];
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		a = vld1q_s32((const int32_t *)&points[i]);
+		b = vld1q_s32((const int32_t *)&points[i + 2]);
+		vmin0 = vminq_s32(vmin0, a);
+		vmax0 = vmaxq_s32(vmax0, a);
+		vmin1 = vminq_s32(vmin1, b);
+		vmax1 = vmaxq_s32(vmax1, b);
+	}
+
+	vmin0 = vminq_s32(vmin0, vmin1);
+	vmax0 = vmaxq_s32(vmax0, vmax1);
+	min64 = vmin_s32(vget_low_s32(vmin0), vget_high_s32(vmin0));
+	max64 = vmax_s32(vget_low_s32(vmax0), vget_high_s32(vmax0));
+
+	res[0] = vget_lane_s32(min64, 0);
+	res[1] = vget_lane_s32(min64, 1);
+	res[2] = vget_lane_s32(max64, 0);
+	res[3] = vget_lane_s32(max64, 1);
+
+	if (i < count) {
+		int_min_max_scalar(&points[i], count - i, tail);
+		int_min_max_merge(res, tail);
+	}
+}
+
+#endif /* BOUNDING_BOX_SIMD_NEON */
+
+/**
+ * @brief Select the best kernel for the executing CPU
+ * @return Kernel function
+ */
+static int_min_max_func_t int_min_max_select_kernel(void)
+{
+#if defined(BOUNDING_BOX_SIMD_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return int_min_max_avx2;
+	if (__builtin_cpu_supports("sse4.1"))
+		return int_min_max_sse41;
+#elif defined(BOUNDING_BOX_SIMD_NEON)
+	return int_min_max_neon;
+#endif
+	return int_min_max_scalar;
+}
+
+void bounding_box_calculate_from_int_points(const struct gds_point *points, size_t count, union bounding_box *box)
+{
+	static gsize kernel_init = 0;
+	static int_min_max_func_t kernel;
+	int32_t res[4];
+
+	if (!box)
+		return;
+
+	if (!points || count == 0) {
+		bounding_box_prepare_empty(box);
+		return;
+	}
+
+	if (g_once_init_enter(&kernel_init)) {
+		kernel = int_min_max_select_kernel();
+		g_once_init_leave(&kernel_init, 1);
+	}
+
+	kernel(points, count, res);
+
+	box->vectors.lower_left.x = (double)res[0];
+	box->vectors.lower_left.y = (double)res[1];
+	box->vectors.upper_right.x = (double)res[2];
+	box->vectors.upper_right.y = (double)res[3];
+}
+
+/** @} */
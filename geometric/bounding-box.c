@@ -206,24 +206,17 @@ void bounding_box_get_all_points(struct vector_2d *points, union bounding_box *b
 
 void bounding_box_apply_transform(double scale, double rotation_deg, bool flip_at_x, union bounding_box *box)
 {
-	int i;
-	struct vector_2d input_points[4];
+	struct vector_2d points[4];
+	struct affine_2d mat;
 
 	if (!box)
 		return;
 
-	bounding_box_get_all_points(input_points, box);
+	bounding_box_get_all_points(points, box);
 
-	/* Reset box */
-	bounding_box_prepare_empty(box);
-
-	for (i = 0; i < 4; i++) {
-		input_points[i].y *= (flip_at_x ? -1 : 1);
-		vector_2d_rotate(&input_points[i], rotation_deg * M_PI / 180.0);
-		vector_2d_scale(&input_points[i], scale);
-
-		bounding_box_update_with_point(box, NULL, &input_points[i]);
-	}
+	affine_2d_init_transform(&mat, scale, rotation_deg, flip_at_x, 0.0, 0.0);
+	vector_2d_array_transform(&mat, points, points, 4);
+	vector_2d_array_min_max(points, 4, &box->vectors.lower_left, &box->vectors.upper_right);
 }
 
 /** @} */
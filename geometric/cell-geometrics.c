@@ -26,18 +26,16 @@
 #include <math.h>
 
 #include <gds-render/geometric/cell-geometrics.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/layer-lookup.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/gds-utils/gds-topology.h>
 
 /**
  * @addtogroup geometric
  * @{
  */
 
-static void convert_gds_point_to_2d_vector(struct gds_point *pt, struct vector_2d *vector)
-{
-	vector->x = pt->x;
-	vector->y = pt->y;
-}
-
 /**
  * @brief Update the given bounding box with the bounding box of a graphics element.
  * @param box box to update
@@ -53,19 +51,11 @@ static void update_box_with_gfx(union bounding_box *box, struct gds_graphics *gf
 	case GRAPHIC_BOX:
 		/* Expected fallthrough */
 	case GRAPHIC_POLYGON:
-		bounding_box_calculate_from_polygon(gfx->vertices,
-							(conv_generic_to_vector_2d_t)&convert_gds_point_to_2d_vector,
-							&current_box);
+		bounding_box_calculate_from_int_points(gfx->vertex_array, gfx->vertex_count, &current_box);
 		break;
 	case GRAPHIC_PATH:
-		/*
-		 * This is not implemented correctly.
-		 * Please be aware if paths are the outmost elements of your cell.
-		 * You might end up with a completely wrong calculated cell size.
-		 */
-		bounding_box_update_with_path(gfx->vertices, gfx->width_absolute,
-							(conv_generic_to_vector_2d_t)&convert_gds_point_to_2d_vector,
-							&current_box);
+		/* Exact box of the outline including caps and joins */
+		path_outline_calculate_bounding_box(gfx, &current_box);
 		break;
 	default:
 		/* Unknown graphics object. */
@@ -77,44 +67,158 @@ static void update_box_with_gfx(union bounding_box *box, struct gds_graphics *gf
 	bounding_box_update_with_box(box, &current_box);
 }
 
-void calculate_cell_bounding_box(union bounding_box *box, struct gds_cell *cell)
+/**
+ * @brief Calculate the bounding box of a cell from its graphics and the boxes of its sub cells
+ * @param boxes Boxes of all sub cells of \p cell
+ * @param cell Cell
+ * @param enabled Lookup table indexed by (guint16)layer. Only graphics on enabled layers are included.
+ *		  NULL includes all layers
+ * @return Box of the cell
+ */
+static union bounding_box *calculate_cell_box_from_children(GHashTable *boxes, struct gds_cell *cell,
+							     const guint8 *enabled)
 {
-	GList *gfx_list;
 	struct gds_graphics *gfx;
+	GList *gfx_list;
 	GList *sub_cell_list;
 	struct gds_cell_instance *sub_cell;
 	union bounding_box temp_box;
+	union bounding_box *cell_box;
+	struct cell_transform trans;
 
-	if (!box || !cell)
-		return;
+	cell_box = g_new(union bounding_box, 1);
+	bounding_box_prepare_empty(cell_box);
 
 	/* Update box with graphic elements */
 	for (gfx_list = cell->graphic_objs; gfx_list != NULL; gfx_list = gfx_list->next) {
 		gfx = (struct gds_graphics *)gfx_list->data;
-		update_box_with_gfx(box, gfx);
+		if (LAYER_LUT_ENABLED(enabled, gfx->layer))
+			update_box_with_gfx(cell_box, gfx);
 	}
 
-	/* Update bounding box with boxes of subcells */
-	for (sub_cell_list = cell->child_cells; sub_cell_list != NULL;
-						sub_cell_list = sub_cell_list->next) {
+	/* Update bounding box with boxes of subcells. These are already calculated */
+	for (sub_cell_list = cell->child_cells; sub_cell_list != NULL; sub_cell_list = sub_cell_list->next) {
 		sub_cell = (struct gds_cell_instance *)sub_cell_list->data;
-		bounding_box_prepare_empty(&temp_box);
-		/* Recursion Woohoo!!  This dies if your GDS is faulty and contains a reference loop */
-		calculate_cell_bounding_box(&temp_box, sub_cell->cell_ref);
+		if (!sub_cell->cell_ref)
+			continue;
+		temp_box = *(union bounding_box *)g_hash_table_lookup(boxes, sub_cell->cell_ref);
 
-		/* Apply transformations */
-		bounding_box_apply_transform(ABS(sub_cell->magnification), sub_cell->angle,
-					     sub_cell->flipped, &temp_box);
+		/* Transforming an empty box would turn it into a huge one */
+		if (temp_box.vectors.lower_left.x > temp_box.vectors.upper_right.x)
+			continue;
 
-		/* Move bounding box to origin */
-		temp_box.vectors.lower_left.x += sub_cell->origin.x;
-		temp_box.vectors.upper_right.x += sub_cell->origin.x;
-		temp_box.vectors.lower_left.y += sub_cell->origin.y;
-		temp_box.vectors.upper_right.y += sub_cell->origin.y;
+		/* Apply transformation. Exact for manhattan instances */
+		cell_transform_init_from_instance(&trans, sub_cell);
+		cell_transform_apply_to_box(&trans, &temp_box);
 
 		/* update the parent's box */
-		bounding_box_update_with_box(box, &temp_box);
+		bounding_box_update_with_box(cell_box, &temp_box);
+	}
+
+	return cell_box;
+}
+
+/**
+ * @brief Calculate the bounding boxes of a cell and its sub cells by recursion
+ *
+ * Only used for cells without a library. This dies if the GDS is faulty and contains a reference loop.
+ *
+ * @param boxes Boxes of the cells already calculated
+ * @param cell Cell
+ * @param enabled Lookup table of the included layers. NULL includes all layers
+ */
+static void calculate_cell_bounding_boxes_recursive(GHashTable *boxes, struct gds_cell *cell,
+						    const guint8 *enabled)
+{
+	GList *sub_cell_list;
+	struct gds_cell_instance *sub_cell;
+
+	if (g_hash_table_contains(boxes, cell))
+		return;
+
+	for (sub_cell_list = cell->child_cells; sub_cell_list != NULL; sub_cell_list = sub_cell_list->next) {
+		sub_cell = (struct gds_cell_instance *)sub_cell_list->data;
+		if (sub_cell->cell_ref)
+			calculate_cell_bounding_boxes_recursive(boxes, sub_cell->cell_ref, enabled);
+	}
+
+	g_hash_table_insert(boxes, cell, calculate_cell_box_from_children(boxes, cell, enabled));
+}
+
+/**
+ * @brief Calculate the bounding boxes of a cell and its sub cells
+ * @param cell Toplevel cell
+ * @param enabled Lookup table of the included layers. NULL includes all layers
+ * @return Boxes or NULL in case of a reference loop
+ */
+static GHashTable *calculate_boxes(struct gds_cell *cell, const guint8 *enabled)
+{
+	struct gds_cell *current;
+	GPtrArray *cells;
+	GHashTable *boxes;
+	guint i;
+
+	boxes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	if (!cell->parent_library) {
+		calculate_cell_bounding_boxes_recursive(boxes, cell, enabled);
+		return boxes;
+	}
+
+	/* Cells affected by a reference loop have no bounding box */
+	cells = gds_topology_get_reachable_cells(cell->parent_library, cell);
+	if (!cells) {
+		g_hash_table_destroy(boxes);
+		return NULL;
+	}
+
+	/* Every sub cell is calculated only once, regardless of its instance count */
+	for (i = 0; i < cells->len; i++) {
+		current = (struct gds_cell *)g_ptr_array_index(cells, i);
+		g_hash_table_insert(boxes, current, calculate_cell_box_from_children(boxes, current, enabled));
 	}
+
+	g_ptr_array_free(cells, TRUE);
+
+	return boxes;
+}
+
+GHashTable *calculate_cell_bounding_boxes(struct gds_cell *cell)
+{
+	if (!cell)
+		return NULL;
+
+	return calculate_boxes(cell, NULL);
+}
+
+GHashTable *calculate_cell_bounding_boxes_for_layers(struct gds_cell *cell, const int *layers, size_t layer_count)
+{
+	GHashTable *boxes;
+	guint8 *enabled;
+
+	if (!cell)
+		return NULL;
+
+	enabled = layer_lut_new(layers, layer_count);
+	boxes = calculate_boxes(cell, enabled);
+	g_free(enabled);
+
+	return boxes;
+}
+
+void calculate_cell_bounding_box(union bounding_box *box, struct gds_cell *cell)
+{
+	GHashTable *boxes;
+
+	if (!box || !cell)
+		return;
+
+	boxes = calculate_cell_bounding_boxes(cell);
+	if (!boxes)
+		return;
+
+	bounding_box_update_with_box(box, (union bounding_box *)g_hash_table_lookup(boxes, cell));
+	g_hash_table_destroy(boxes);
 }
 
 /** @} */
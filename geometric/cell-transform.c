@@ -0,0 +1,251 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cell-transform.c
+ * @brief Exact transformations of cell instances
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <math.h>
+
+#include <gds-render/geometric/cell-transform.h>
+
+/** @brief Maximum deviation of an angle from a multiple of 90 degrees to be treated as manhattan */
+#define MANHATTAN_ANGLE_EPSILON (1E-9)
+
+/** @brief Maximum deviation of a magnification from 1 to be treated as manhattan */
+#define MANHATTAN_MAG_EPSILON (1E-12)
+
+/** @brief Sine of the quarter turns 0 to 3 */
+static const int quarter_sin[4] = {0, 1, 0, -1};
+
+/** @brief Cosine of the quarter turns 0 to 3 */
+static const int quarter_cos[4] = {1, 0, -1, 0};
+
+/**
+ * @brief Apply the linear part (flip and rotation) of a manhattan transformation
+ * @param trans Transformation
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param[out] x_out Resulting x coordinate
+ * @param[out] y_out Resulting y coordinate
+ */
+static inline void manhattan_apply_linear(const struct manhattan_transform *trans, int64_t x, int64_t y,
+					  int64_t *x_out, int64_t *y_out)
+{
+	if (trans->flipped)
+		y = -y;
+
+	switch (trans->quarter_turns) {
+	case 1:
+		*x_out = -y;
+		*y_out = x;
+		break;
+	case 2:
+		*x_out = -x;
+		*y_out = -y;
+		break;
+	case 3:
+		*x_out = y;
+		*y_out = -x;
+		break;
+	default:
+		*x_out = x;
+		*y_out = y;
+		break;
+	}
+}
+
+/**
+ * @brief Calculate the double precision matrix of a manhattan transformation
+ * @param mat Matrix to fill
+ * @param trans Manhattan transformation
+ */
+static void manhattan_to_matrix(struct affine_2d *mat, const struct manhattan_transform *trans)
+{
+	int flip = (trans->flipped ? -1 : 1);
+
+	mat->xx = (double)quarter_cos[trans->quarter_turns];
+	mat->yx = (double)quarter_sin[trans->quarter_turns];
+	mat->xy = (double)(-quarter_sin[trans->quarter_turns] * flip);
+	mat->yy = (double)(quarter_cos[trans->quarter_turns] * flip);
+	mat->x0 = (double)trans->x0;
+	mat->y0 = (double)trans->y0;
+}
+
+void cell_transform_init_identity(struct cell_transform *trans)
+{
+	if (!trans)
+		return;
+
+	trans->manhattan = true;
+	trans->mt.x0 = 0;
+	trans->mt.y0 = 0;
+	trans->mt.quarter_turns = 0;
+	trans->mt.flipped = false;
+	affine_2d_init_identity(&trans->matrix);
+}
+
+void cell_transform_init_from_instance(struct cell_transform *trans, const struct gds_cell_instance *inst)
+{
+	long quarters;
+
+	if (!trans || !inst)
+		return;
+
+	quarters = lround(inst->angle / 90.0);
+
+	if (fabs(inst->magnification - 1.0) < MANHATTAN_MAG_EPSILON &&
+	    fabs(inst->angle - 90.0 * (double)quarters) < MANHATTAN_ANGLE_EPSILON) {
+		trans->manhattan = true;
+		trans->mt.quarter_turns = (unsigned int)(((quarters % 4) + 4) % 4);
+		trans->mt.flipped = (inst->flipped ? true : false);
+		trans->mt.x0 = inst->origin.x;
+		trans->mt.y0 = inst->origin.y;
+		manhattan_to_matrix(&trans->matrix, &trans->mt);
+	} else {
+		trans->manhattan = false;
+		affine_2d_init_transform(&trans->matrix, inst->magnification, inst->angle,
+					 (inst->flipped ? true : false),
+					 (double)inst->origin.x, (double)inst->origin.y);
+	}
+}
+
+void cell_transform_compose(struct cell_transform *res, const struct cell_transform *outer,
+			    const struct cell_transform *inner)
+{
+	struct manhattan_transform mt;
+	unsigned int inner_turns;
+
+	if (!res || !outer || !inner)
+		return;
+
+	if (outer->manhattan && inner->manhattan) {
+		/* Mirroring reverses the direction of the inner rotation */
+		inner_turns = (outer->mt.flipped ? (4 - inner->mt.quarter_turns) : inner->mt.quarter_turns);
+		mt.quarter_turns = (outer->mt.quarter_turns + inner_turns) % 4;
+		mt.flipped = (outer->mt.flipped != inner->mt.flipped);
+		manhattan_apply_linear(&outer->mt, inner->mt.x0, inner->mt.y0, &mt.x0, &mt.y0);
+		mt.x0 += outer->mt.x0;
+		mt.y0 += outer->mt.y0;
+
+		res->manhattan = true;
+		res->mt = mt;
+		manhattan_to_matrix(&res->matrix, &mt);
+	} else {
+		affine_2d_multiply(&res->matrix, &outer->matrix, &inner->matrix);
+		res->manhattan = false;
+	}
+}
+
+void cell_transform_apply_to_point(const struct cell_transform *trans, const struct gds_point *in,
+				   struct vector_2d *out)
+{
+	int64_t x, y;
+
+	if (!trans || !in || !out)
+		return;
+
+	if (trans->manhattan) {
+		manhattan_apply_linear(&trans->mt, in->x, in->y, &x, &y);
+		out->x = (double)(x + trans->mt.x0);
+		out->y = (double)(y + trans->mt.y0);
+	} else {
+		out->x = (double)in->x;
+		out->y = (double)in->y;
+		affine_2d_apply(&trans->matrix, out);
+	}
+}
+
+void cell_transform_apply_to_box(const struct cell_transform *trans, union bounding_box *box)
+{
+	struct vector_2d points[4];
+	double x, y;
+	int i;
+
+	if (!trans || !box)
+		return;
+
+	/* Empty boxes stay empty */
+	if (box->vectors.lower_left.x > box->vectors.upper_right.x ||
+	    box->vectors.lower_left.y > box->vectors.upper_right.y)
+		return;
+
+	bounding_box_get_all_points(points, box);
+
+	if (!trans->manhattan) {
+		vector_2d_array_transform(&trans->matrix, points, points, 4);
+		vector_2d_array_min_max(points, 4, &box->vectors.lower_left, &box->vectors.upper_right);
+		return;
+	}
+
+	bounding_box_prepare_empty(box);
+
+	for (i = 0; i < 4; i++) {
+		/* Swapping and negating is exact for doubles, too */
+		x = points[i].x;
+		y = (trans->mt.flipped ? -points[i].y : points[i].y);
+		switch (trans->mt.quarter_turns) {
+		case 1:
+			points[i].x = -y;
+			points[i].y = x;
+			break;
+		case 2:
+			points[i].x = -x;
+			points[i].y = -y;
+			break;
+		case 3:
+			points[i].x = y;
+			points[i].y = -x;
+			break;
+		default:
+			points[i].x = x;
+			points[i].y = y;
+			break;
+		}
+		points[i].x += (double)trans->mt.x0;
+		points[i].y += (double)trans->mt.y0;
+
+		bounding_box_update_with_point(box, NULL, &points[i]);
+	}
+}
+
+void manhattan_transform_apply_to_points(const struct manhattan_transform *trans, const struct gds_point *in,
+					 struct gds_point *out, size_t count)
+{
+	size_t i;
+	int64_t x, y;
+
+	if (!trans || !in || !out)
+		return;
+
+	for (i = 0; i < count; i++) {
+		manhattan_apply_linear(trans, in[i].x, in[i].y, &x, &y);
+		out[i].x = (int)(x + trans->x0);
+		out[i].y = (int)(y + trans->y0);
+	}
+}
+
+/** @} */
@@ -0,0 +1,611 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file density-map.c
+ * @brief Per layer coverage of a raster of tiles
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The covered area is accumulated geometrically. Nothing is rasterized. Rectilinear shapes
+ * are merged and split into rectangles, which are binned into the tiles they overlap.
+ * Paths and all other polygons are clipped to the tiles. In tiles containing such pieces,
+ * the union of all pieces and rectangles is calculated by sweeping over the tile.
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <math.h>
+
+#include <gds-render/geometric/density-map.h>
+#include <gds-render/geometric/polygon-union.h>
+#include <gds-render/geometric/rectangle-decomposition.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/geometric/scanline.h>
+
+/** @brief Slabs of the union sweep narrower than this fraction of the tile width are skipped */
+#define SWEEP_EPSILON (1E-9)
+
+/**
+ * @brief Raster geometry and accumulated area of a layer
+ */
+struct tile_grid {
+	union bounding_box extent; /**< @brief Area covered by the raster */
+	unsigned int columns; /**< @brief Number of tiles in x direction */
+	unsigned int rows; /**< @brief Number of tiles in y direction */
+	double tile_width; /**< @brief Width of a tile */
+	double tile_height; /**< @brief Height of a tile */
+	double *area; /**< @brief Covered area per tile. Row 0 is the bottom row */
+	GArray **edges; /**< @brief #coverage_edge of the clipped pieces per tile. NULL if the tile has no pieces */
+	guint piece_count; /**< @brief Number of pieces added to all tiles */
+};
+
+/**
+ * @brief Non vertical edge of a piece clipped to a tile. The edge points in positive x direction
+ */
+struct coverage_edge {
+	double x0; /**< @brief Start x */
+	double y0; /**< @brief Start y */
+	double x1; /**< @brief End x. Greater than coverage_edge::x0 */
+	double y1; /**< @brief End y */
+	int dir; /**< @brief Winding contribution: +1 or -1 */
+	guint piece; /**< @brief Index of the piece this edge belongs to */
+};
+
+/**
+ * @brief Edge crossing a slab of the union sweep
+ */
+struct slab_edge {
+	const struct coverage_edge *edge; /**< @brief Edge */
+	double ya; /**< @brief y at the left side of the slab */
+	double yb; /**< @brief y at the right side of the slab */
+};
+
+/**
+ * @brief Job for calculating the density map of a single layer
+ */
+struct density_job {
+	const struct flat_layer *layer; /**< @brief Layer */
+	const union bounding_box *extent; /**< @brief Area covered by the raster */
+	unsigned int columns; /**< @brief Number of tiles in x direction */
+	unsigned int rows; /**< @brief Number of tiles in y direction */
+	struct density_map *result; /**< @brief Calculated map */
+};
+
+/**
+ * @brief Get the range of tiles overlapped by an interval
+ * @param lo Lower end of the interval
+ * @param hi Upper end of the interval
+ * @param origin Start of the raster
+ * @param size Tile size
+ * @param count Tile count
+ * @param[out] first First tile
+ * @param[out] last Last tile
+ * @return FALSE if the interval is outside the raster
+ */
+static gboolean tile_range(double lo, double hi, double origin, double size, unsigned int count,
+			   unsigned int *first, unsigned int *last)
+{
+	double f = floor((lo - origin) / size);
+	double l = ceil((hi - origin) / size) - 1.0;
+
+	if (l < 0.0 || f >= (double)count || hi <= lo)
+		return FALSE;
+
+	*first = (f < 0.0 ? 0U : (unsigned int)f);
+	*last = (l >= (double)count ? count - 1 : (unsigned int)l);
+
+	return TRUE;
+}
+
+/**
+ * @brief Add a piece of a shape to the edge list of a tile
+ * @param grid Raster
+ * @param tile Index of the tile
+ * @param v Vertices of the closed piece
+ * @param count Vertex count
+ */
+static void add_piece(struct tile_grid *grid, guint tile, const struct vector_2d *v, size_t count)
+{
+	struct coverage_edge edge;
+	const struct vector_2d *a;
+	const struct vector_2d *b;
+	size_t i;
+
+	if (!grid->edges[tile])
+		grid->edges[tile] = g_array_new(FALSE, FALSE, sizeof(struct coverage_edge));
+
+	edge.piece = grid->piece_count++;
+	for (i = 0; i < count; i++) {
+		a = &v[i];
+		b = &v[(i + 1) % count];
+
+		/* Vertical edges do not bound any slab */
+		if (a->x == b->x)
+			continue;
+
+		edge.dir = (a->x < b->x ? 1 : -1);
+		if (edge.dir < 0) {
+			const struct vector_2d *swap = a;
+
+			a = b;
+			b = swap;
+		}
+		edge.x0 = a->x;
+		edge.y0 = a->y;
+		edge.x1 = b->x;
+		edge.y1 = b->y;
+		g_array_append_val(grid->edges[tile], edge);
+	}
+}
+
+/**
+ * @brief Add a rectangle to the tiles it overlaps
+ *
+ * Tiles without pieces accumulate the area directly. The rectangles are disjoint.
+ * In all other tiles, the clipped rectangle is added as a piece.
+ *
+ * @param grid Raster
+ * @param rect Rectangle
+ */
+static void add_rectangle(struct tile_grid *grid, const union bounding_box *rect)
+{
+	unsigned int c0, c1, r0, r1, c, r;
+	double tx0, ty0, w, h;
+	struct vector_2d corners[4];
+
+	if (!tile_range(rect->vectors.lower_left.x, rect->vectors.upper_right.x, grid->extent.vectors.lower_left.x,
+			grid->tile_width, grid->columns, &c0, &c1))
+		return;
+	if (!tile_range(rect->vectors.lower_left.y, rect->vectors.upper_right.y, grid->extent.vectors.lower_left.y,
+			grid->tile_height, grid->rows, &r0, &r1))
+		return;
+
+	for (r = r0; r <= r1; r++) {
+		ty0 = grid->extent.vectors.lower_left.y + grid->tile_height * r;
+		h = MIN(rect->vectors.upper_right.y, ty0 + grid->tile_height) - MAX(rect->vectors.lower_left.y, ty0);
+		if (h <= 0.0)
+			continue;
+		for (c = c0; c <= c1; c++) {
+			tx0 = grid->extent.vectors.lower_left.x + grid->tile_width * c;
+			w = MIN(rect->vectors.upper_right.x, tx0 + grid->tile_width) -
+				MAX(rect->vectors.lower_left.x, tx0);
+			if (w <= 0.0)
+				continue;
+
+			if (!grid->edges[r * grid->columns + c]) {
+				grid->area[r * grid->columns + c] += w * h;
+				continue;
+			}
+
+			corners[0].x = MAX(rect->vectors.lower_left.x, tx0);
+			corners[0].y = MAX(rect->vectors.lower_left.y, ty0);
+			corners[1].x = corners[0].x + w;
+			corners[1].y = corners[0].y;
+			corners[2].x = corners[1].x;
+			corners[2].y = corners[0].y + h;
+			corners[3].x = corners[0].x;
+			corners[3].y = corners[2].y;
+			add_piece(grid, r * grid->columns + c, corners, 4);
+		}
+	}
+}
+
+/**
+ * @brief Clip a polygon against one side of an axis parallel line
+ * @param in Array of #vector_2d
+ * @param[out] out Array of #vector_2d. Is cleared first
+ * @param vertical TRUE to clip against a line x = \p pos, FALSE for y = \p pos
+ * @param pos Position of the line
+ * @param keep_greater Keep the part with coordinates larger than \p pos
+ */
+static void clip_polygon(const GArray *in, GArray *out, gboolean vertical, double pos, gboolean keep_greater)
+{
+	const struct vector_2d *a;
+	const struct vector_2d *b;
+	struct vector_2d cut;
+	double da, db;
+	guint i;
+
+	g_array_set_size(out, 0);
+
+	for (i = 0; i < in->len; i++) {
+		a = &g_array_index(in, struct vector_2d, i);
+		b = &g_array_index(in, struct vector_2d, (i + 1) % in->len);
+		da = (vertical ? a->x : a->y) - pos;
+		db = (vertical ? b->x : b->y) - pos;
+		if (!keep_greater) {
+			da = -da;
+			db = -db;
+		}
+
+		if (da >= 0.0)
+			g_array_append_val(out, *a);
+
+		if ((da >= 0.0) != (db >= 0.0)) {
+			cut.x = a->x + (b->x - a->x) * da / (da - db);
+			cut.y = a->y + (b->y - a->y) * da / (da - db);
+			if (vertical)
+				cut.x = pos;
+			else
+				cut.y = pos;
+			g_array_append_val(out, cut);
+		}
+	}
+}
+
+static gint compare_edge_x0(gconstpointer a, gconstpointer b)
+{
+	const struct coverage_edge *ea = (const struct coverage_edge *)a;
+	const struct coverage_edge *eb = (const struct coverage_edge *)b;
+
+	return (ea->x0 > eb->x0) - (ea->x0 < eb->x0);
+}
+
+static gint compare_slab_edge(gconstpointer a, gconstpointer b)
+{
+	const struct slab_edge *ea = (const struct slab_edge *)a;
+	const struct slab_edge *eb = (const struct slab_edge *)b;
+
+	if (ea->ya != eb->ya)
+		return (ea->ya > eb->ya) - (ea->ya < eb->ya);
+
+	return (ea->yb > eb->yb) - (ea->yb < eb->yb);
+}
+
+static double edge_y(const struct coverage_edge *edge, double x)
+{
+	return edge->y0 + (edge->y1 - edge->y0) * (x - edge->x0) / (edge->x1 - edge->x0);
+}
+
+/**
+ * @brief Calculate the area of a slab covered by at least one piece
+ *
+ * No edges cross inside the slab. The covered parts are trapezoids between neighbouring edges.
+ *
+ * @param active Edges crossing the slab sorted by their y coordinates
+ * @param winding Winding number of each piece. All zero on entry and on return
+ * @param width Width of the slab
+ * @return Covered area
+ */
+static double slab_area(const GArray *active, int *winding, double width)
+{
+	const struct slab_edge *prev = NULL;
+	const struct slab_edge *cur;
+	double area = 0.0;
+	guint covered = 0;
+	guint i;
+	int old;
+
+	for (i = 0; i < active->len; i++) {
+		cur = &g_array_index(active, struct slab_edge, i);
+		if (prev && covered > 0)
+			area += ((cur->ya - prev->ya) + (cur->yb - prev->yb)) / 2.0 * width;
+
+		old = winding[cur->edge->piece];
+		winding[cur->edge->piece] += cur->edge->dir;
+		if (old == 0 && winding[cur->edge->piece] != 0)
+			covered++;
+		else if (old != 0 && winding[cur->edge->piece] == 0)
+			covered--;
+		prev = cur;
+	}
+
+	return area;
+}
+
+/**
+ * @brief Calculate the area of the union of the pieces of a tile
+ *
+ * The tile is swept in x direction. Slabs are bounded by the vertex positions and by the crossings of
+ * edges. The first crossing inside a slab is always between edges that are neighbours at its left side.
+ *
+ * @param edges Array of #coverage_edge. Is sorted
+ * @param winding Winding number of each piece. All zero
+ * @param eps Minimum slab width
+ * @return Covered area
+ */
+static double union_area(GArray *edges, int *winding, double eps)
+{
+	GArray *xs;
+	GArray *active;
+	struct slab_edge *se;
+	struct slab_edge entry;
+	const struct coverage_edge *edge;
+	double xa, xb, xend, da, db, xc;
+	double area = 0.0;
+	guint i, k, keep;
+	guint next_edge = 0;
+
+	g_array_sort(edges, compare_edge_x0);
+	xs = g_array_sized_new(FALSE, FALSE, sizeof(double), edges->len * 2);
+	for (i = 0; i < edges->len; i++) {
+		edge = &g_array_index(edges, struct coverage_edge, i);
+		g_array_append_val(xs, edge->x0);
+		g_array_append_val(xs, edge->x1);
+	}
+	g_array_sort(xs, scanline_compare_double);
+
+	active = g_array_new(FALSE, FALSE, sizeof(struct slab_edge));
+	for (k = 0; k + 1 < xs->len; k++) {
+		xa = g_array_index(xs, double, k);
+		xend = g_array_index(xs, double, k + 1);
+		if (xend - xa <= eps)
+			continue;
+
+		/* Drop edges ending left of the slab and add the ones starting at it */
+		for (i = 0, keep = 0; i < active->len; i++) {
+			se = &g_array_index(active, struct slab_edge, i);
+			if (se->edge->x1 > xa)
+				g_array_index(active, struct slab_edge, keep++) = *se;
+		}
+		g_array_set_size(active, keep);
+		while (next_edge < edges->len && g_array_index(edges, struct coverage_edge, next_edge).x0 <= xa) {
+			entry.edge = &g_array_index(edges, struct coverage_edge, next_edge++);
+			if (entry.edge->x1 > xa)
+				g_array_append_val(active, entry);
+		}
+
+		while (xend - xa > eps) {
+			for (i = 0; i < active->len; i++) {
+				se = &g_array_index(active, struct slab_edge, i);
+				se->ya = edge_y(se->edge, xa);
+				se->yb = edge_y(se->edge, xend);
+			}
+			g_array_sort(active, compare_slab_edge);
+
+			/* Stop the slab at the first crossing */
+			xb = xend;
+			for (i = 0; i + 1 < active->len; i++) {
+				se = &g_array_index(active, struct slab_edge, i);
+				db = se[0].yb - se[1].yb;
+				if (db <= 0.0)
+					continue;
+				da = se[1].ya - se[0].ya;
+				xc = xa + (xend - xa) * da / (da + db);
+				if (xc - xa > eps && xc < xb)
+					xb = xc;
+			}
+			if (xb != xend) {
+				for (i = 0; i < active->len; i++) {
+					se = &g_array_index(active, struct slab_edge, i);
+					se->yb = edge_y(se->edge, xb);
+				}
+			}
+
+			area += slab_area(active, winding, xb - xa);
+			xa = xb;
+		}
+	}
+
+	g_array_free(active, TRUE);
+	g_array_free(xs, TRUE);
+
+	return area;
+}
+
+/**
+ * @brief Clip an arbitrary polygon to the tiles it overlaps and add the pieces
+ * @param grid Raster
+ * @param v Vertices
+ * @param count Vertex count
+ * @param buffers Three working arrays of #vector_2d
+ */
+static void add_polygon(struct tile_grid *grid, const struct vector_2d *v, size_t count, GArray **buffers)
+{
+	union bounding_box box;
+	unsigned int c0, c1, r0, r1, c, r;
+	double tx0, ty0;
+
+	if (count < 3)
+		return;
+
+	vector_2d_array_min_max(v, count, &box.vectors.lower_left, &box.vectors.upper_right);
+
+	if (!tile_range(box.vectors.lower_left.x, box.vectors.upper_right.x, grid->extent.vectors.lower_left.x,
+			grid->tile_width, grid->columns, &c0, &c1))
+		return;
+	if (!tile_range(box.vectors.lower_left.y, box.vectors.upper_right.y, grid->extent.vectors.lower_left.y,
+			grid->tile_height, grid->rows, &r0, &r1))
+		return;
+
+	for (r = r0; r <= r1; r++) {
+		ty0 = grid->extent.vectors.lower_left.y + grid->tile_height * r;
+
+		/* Clip to the row first. The result is reused for all columns */
+		g_array_set_size(buffers[0], 0);
+		g_array_append_vals(buffers[0], v, count);
+		clip_polygon(buffers[0], buffers[1], FALSE, ty0, TRUE);
+		clip_polygon(buffers[1], buffers[0], FALSE, ty0 + grid->tile_height, FALSE);
+		if (buffers[0]->len < 3)
+			continue;
+
+		for (c = c0; c <= c1; c++) {
+			tx0 = grid->extent.vectors.lower_left.x + grid->tile_width * c;
+			clip_polygon(buffers[0], buffers[1], TRUE, tx0, TRUE);
+			clip_polygon(buffers[1], buffers[2], TRUE, tx0 + grid->tile_width, FALSE);
+			if (buffers[2]->len >= 3)
+				add_piece(grid, r * grid->columns + c, (const struct vector_2d *)buffers[2]->data,
+					  buffers[2]->len);
+		}
+	}
+}
+
+struct density_map *density_map_calculate_layer(const struct flat_layer *layer, const union bounding_box *extent,
+						unsigned int columns, unsigned int rows)
+{
+	struct tile_grid grid;
+	struct flat_layer merged;
+	const struct flat_layer *source = layer;
+	const struct flat_primitive *prim;
+	const struct vector_2d *v;
+	struct density_map *map;
+	GArray *rects;
+	GArray *outline;
+	GArray *buffers[3];
+	int *winding;
+	double tile_area;
+	guint i, r, c;
+
+	if (!layer || !extent || columns == 0 || rows == 0)
+		return NULL;
+
+	grid.extent = *extent;
+	grid.columns = columns;
+	grid.rows = rows;
+	grid.tile_width = (extent->vectors.upper_right.x - extent->vectors.lower_left.x) / columns;
+	grid.tile_height = (extent->vectors.upper_right.y - extent->vectors.lower_left.y) / rows;
+	if (!(grid.tile_width > 0.0) || !(grid.tile_height > 0.0))
+		return NULL;
+
+	grid.area = g_new0(double, (gsize)columns * rows);
+	grid.edges = g_new0(GArray *, (gsize)columns * rows);
+	grid.piece_count = 0;
+
+	/* Merge overlapping rectilinear shapes. Their rectangles do not overlap afterwards */
+	merged.primitives = NULL;
+	merged.vertices = NULL;
+	if (polygon_union_merge_layer(layer, &merged) == 0)
+		source = &merged;
+
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	for (i = 0; i < 3; i++)
+		buffers[i] = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+
+	/* Pieces of paths and other polygons first. The rectangles have to know which tiles contain pieces */
+	for (i = 0; i < source->primitives->len; i++) {
+		prim = &g_array_index(source->primitives, struct flat_primitive, i);
+		v = &g_array_index(source->vertices, struct vector_2d, prim->first_vertex);
+
+		if (prim->gfx_type == GRAPHIC_PATH) {
+			g_array_set_size(outline, 0);
+			if (!path_outline_calculate_from_vectors(v, prim->vertex_count, prim->width,
+								 prim->path_render_type, outline))
+				add_polygon(&grid, (const struct vector_2d *)outline->data, outline->len, buffers);
+			continue;
+		}
+
+		if (rectangle_decomposition_calculate(v, prim->vertex_count, rects) != 0)
+			add_polygon(&grid, v, prim->vertex_count, buffers);
+	}
+
+	for (r = 0; r < rects->len; r++)
+		add_rectangle(&grid, &g_array_index(rects, union bounding_box, r));
+
+	winding = g_new0(int, grid.piece_count + 1);
+	for (i = 0; i < columns * rows; i++) {
+		if (!grid.edges[i])
+			continue;
+		grid.area[i] += union_area(grid.edges[i], winding, grid.tile_width * SWEEP_EPSILON);
+		g_array_free(grid.edges[i], TRUE);
+	}
+	g_free(winding);
+
+	for (i = 0; i < 3; i++)
+		g_array_free(buffers[i], TRUE);
+	g_array_free(outline, TRUE);
+	g_array_free(rects, TRUE);
+	if (source == &merged) {
+		g_array_free(merged.primitives, TRUE);
+		g_array_free(merged.vertices, TRUE);
+	}
+
+	map = g_new(struct density_map, 1);
+	map->layer = layer->layer;
+	map->columns = columns;
+	map->rows = rows;
+	map->extent = *extent;
+	map->coverage = g_new(double, (gsize)columns * rows);
+
+	/* Flip the rows. Row 0 of the map is the top row */
+	tile_area = grid.tile_width * grid.tile_height;
+	for (r = 0; r < rows; r++) {
+		for (c = 0; c < columns; c++)
+			map->coverage[(rows - 1 - r) * columns + c] = MIN(grid.area[r * columns + c] / tile_area, 1.0);
+	}
+
+	g_free(grid.edges);
+	g_free(grid.area);
+
+	return map;
+}
+
+static void density_job_run(gpointer data, gpointer user_data)
+{
+	struct density_job *job = (struct density_job *)data;
+
+	(void)user_data;
+
+	job->result = density_map_calculate_layer(job->layer, job->extent, job->columns, job->rows);
+}
+
+int density_map_calculate_for_cell(struct gds_cell *cell, unsigned int columns, unsigned int rows,
+				   unsigned int thread_count, GList **maps)
+{
+	struct flat_scene *scene;
+	struct density_job *jobs;
+	GThreadPool *pool;
+	guint i;
+
+	if (!cell || !maps || columns == 0 || rows == 0)
+		return -1;
+
+	if (thread_count == 0)
+		thread_count = g_get_num_processors();
+
+	scene = hierarchy_flatten_cell(cell, NULL, 0, thread_count);
+	if (!scene)
+		return -2;
+
+	jobs = g_new0(struct density_job, scene->layers->len + 1);
+	pool = g_thread_pool_new(density_job_run, NULL, (gint)thread_count, FALSE, NULL);
+	for (i = 0; i < scene->layers->len; i++) {
+		jobs[i].layer = &g_array_index(scene->layers, struct flat_layer, i);
+		jobs[i].extent = &scene->box;
+		jobs[i].columns = columns;
+		jobs[i].rows = rows;
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* Layers of the scene are sorted. Keep this order */
+	for (i = 0; i < scene->layers->len; i++) {
+		if (jobs[i].result)
+			*maps = g_list_append(*maps, jobs[i].result);
+	}
+
+	g_free(jobs);
+	flat_scene_free(scene);
+
+	return 0;
+}
+
+void density_map_free(struct density_map *map)
+{
+	if (!map)
+		return;
+
+	g_free(map->coverage);
+	g_free(map);
+}
+
+/** @} */
@@ -0,0 +1,770 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hierarchy-flattener.c
+ * @brief Flatten a cell hierarchy into per-layer primitive buffers
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The instance tree is processed by a pool of worker threads. Each task renders its part of
+ * the tree into its own per-layer buffers. Subtrees containing at least @ref FLATTEN_SPLIT_THRESHOLD
+ * primitives are handed to new tasks. If a task has flattened @ref FLATTEN_SPLIT_THRESHOLD primitives
+ * inline, the remaining siblings are handed to a new task, too.
+ *
+ * After all tasks have finished, the buffers are concatenated layer by layer in task tree preorder.
+ * The concatenation of the different layers runs in parallel.
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <gds-render/geometric/hierarchy-flattener.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/layer-lookup.h>
+
+/** @brief Minimum number of primitives of a subtree to be processed in a separate task */
+#define FLATTEN_SPLIT_THRESHOLD (4096)
+
+/**
+ * @brief Data shared between all tasks of a flattening run
+ */
+struct flatten_context {
+	GHashTable *cell_counts; /**< @brief Flattened primitive count (guint64 *) of each cell */
+	guint8 *layer_enabled; /**< @brief Lookup table indexed by (guint16)layer. NULL: All layers enabled */
+	GThreadPool *pool; /**< @brief Worker threads */
+	gint pending; /**< @brief Number of tasks not yet finished */
+	gboolean finished; /**< @brief All tasks finished. Protected by flatten_context::lock */
+	GMutex lock; /**< @brief Lock for flatten_context::finished */
+	GCond done; /**< @brief Signalled, when all tasks have finished */
+};
+
+/** @brief Magic number at the start of a serialized scene */
+#define FLAT_SCENE_MAGIC (0x4e435346U)
+
+/**
+ * @brief Header of a serialized scene
+ */
+struct serialized_scene {
+	guint32 magic; /**< @brief Must be @ref FLAT_SCENE_MAGIC */
+	guint32 layer_count; /**< @brief Number of following layers */
+	union bounding_box box; /**< @brief Bounding box of the scene */
+	guint64 primitive_count; /**< @brief Total number of primitives */
+	guint64 vertex_count; /**< @brief Total number of vertices */
+};
+
+/**
+ * @brief Header of a serialized layer
+ *
+ * The header is followed by the #flat_primitive and the #vector_2d elements of the layer.
+ */
+struct serialized_layer {
+	gint32 layer; /**< @brief Layer number */
+	guint32 reserved; /**< @brief Unused */
+	guint64 primitive_count; /**< @brief Number of primitives */
+	guint64 vertex_count; /**< @brief Number of vertices */
+};
+
+/**
+ * @brief A part of the instance tree processed by a single worker
+ */
+struct flatten_task {
+	struct flatten_context *ctx; /**< @brief Shared context */
+	struct gds_cell *cell; /**< @brief Cell to process */
+	GList *first_child; /**< @brief First instance of flatten_task::cell to process */
+	gboolean include_gfx; /**< @brief Also process the graphics of flatten_task::cell */
+	struct cell_transform trans; /**< @brief Transformation of flatten_task::cell */
+	GHashTable *layers; /**< @brief Local #flat_layer buffers indexed by layer number */
+	GPtrArray *sub_tasks; /**< @brief Tasks spawned by this task in spawn order */
+	union bounding_box box; /**< @brief Bounding box of the primitives of this task */
+};
+
+/**
+ * @brief Concatenation job of a single layer
+ */
+struct concat_job {
+	struct flat_layer *dest; /**< @brief Layer of the scene to fill */
+	GPtrArray *tasks; /**< @brief All tasks in preorder */
+};
+
+static struct flat_layer *flat_layer_new(int layer)
+{
+	struct flat_layer *lay;
+
+	lay = g_new(struct flat_layer, 1);
+	lay->layer = layer;
+	lay->primitives = g_array_new(FALSE, FALSE, sizeof(struct flat_primitive));
+	lay->vertices = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+
+	return lay;
+}
+
+static void flat_layer_free(gpointer data)
+{
+	struct flat_layer *lay = (struct flat_layer *)data;
+
+	if (!lay)
+		return;
+
+	g_array_free(lay->primitives, TRUE);
+	g_array_free(lay->vertices, TRUE);
+	g_free(lay);
+}
+
+/**
+ * @brief Calculate the number of primitives of a cell including all sub cells
+ *
+ * The results are memoized in \p counts.
+ *
+ * @param cell Cell
+ * @param counts Memoization table
+ * @param[out] loop_found Set to TRUE if a reference loop is detected
+ * @return Number of primitives
+ */
+static guint64 count_flat_primitives(struct gds_cell *cell, GHashTable *counts, gboolean *loop_found)
+{
+	gpointer value;
+	guint64 *count;
+	guint64 sum;
+	GList *iter;
+	struct gds_cell_instance *inst;
+
+	if (g_hash_table_lookup_extended(counts, cell, NULL, &value)) {
+		/* Cell is currently being counted further up the stack */
+		if (!value) {
+			*loop_found = TRUE;
+			return 0;
+		}
+		return *(guint64 *)value;
+	}
+
+	/* Mark cell as in progress */
+	g_hash_table_insert(counts, cell, NULL);
+
+	sum = g_list_length(cell->graphic_objs);
+	for (iter = cell->child_cells; iter != NULL && !*loop_found; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (inst->cell_ref)
+			sum += count_flat_primitives(inst->cell_ref, counts, loop_found);
+	}
+
+	count = g_new(guint64, 1);
+	*count = sum;
+	g_hash_table_insert(counts, cell, count);
+
+	return sum;
+}
+
+static guint64 lookup_count(struct flatten_context *ctx, struct gds_cell *cell)
+{
+	guint64 *count;
+
+	count = (guint64 *)g_hash_table_lookup(ctx->cell_counts, cell);
+
+	return (count ? *count : 0ULL);
+}
+
+/**
+ * @brief Get the scaling factor of a transformation
+ * @param trans Transformation
+ * @return Factor lengths are scaled with
+ */
+static double transform_get_scale(const struct cell_transform *trans)
+{
+	if (trans->manhattan)
+		return 1.0;
+
+	return sqrt(fabs(trans->matrix.xx * trans->matrix.yy - trans->matrix.xy * trans->matrix.yx));
+}
+
+/**
+ * @brief Transform a vertex, append it to a layer and update the task's bounding box
+ * @param task Task
+ * @param lay Layer buffer of the task
+ * @param trans Transformation
+ * @param pt Vertex
+ * @param half_width Half of the path width. 0 for polygons
+ */
+static inline void emit_vertex(struct flatten_task *task, struct flat_layer *lay, const struct cell_transform *trans,
+			       const struct gds_point *pt, double half_width)
+{
+	struct vector_2d vec;
+
+	cell_transform_apply_to_point(trans, pt, &vec);
+	g_array_append_val(lay->vertices, vec);
+
+	task->box.vectors.lower_left.x = MIN(task->box.vectors.lower_left.x, vec.x - half_width);
+	task->box.vectors.lower_left.y = MIN(task->box.vectors.lower_left.y, vec.y - half_width);
+	task->box.vectors.upper_right.x = MAX(task->box.vectors.upper_right.x, vec.x + half_width);
+	task->box.vectors.upper_right.y = MAX(task->box.vectors.upper_right.y, vec.y + half_width);
+}
+
+/**
+ * @brief Transform the graphics of a cell and append them to the task's buffers
+ * @param task Task
+ * @param cell Cell
+ * @param trans Transformation of the cell
+ */
+static void emit_cell_graphics(struct flatten_task *task, struct gds_cell *cell, const struct cell_transform *trans)
+{
+	GList *gfx_iter;
+	struct gds_graphics *gfx;
+	struct flat_layer *lay;
+	struct flat_primitive prim;
+	double half_width;
+	size_t i;
+	const guint8 *enabled = task->ctx->layer_enabled;
+
+	for (gfx_iter = cell->graphic_objs; gfx_iter != NULL; gfx_iter = g_list_next(gfx_iter)) {
+		gfx = (struct gds_graphics *)gfx_iter->data;
+
+		if (!LAYER_LUT_ENABLED(enabled, gfx->layer))
+			continue;
+
+		lay = (struct flat_layer *)g_hash_table_lookup(task->layers, GINT_TO_POINTER((int)gfx->layer));
+		if (!lay) {
+			lay = flat_layer_new((int)gfx->layer);
+			g_hash_table_insert(task->layers, GINT_TO_POINTER((int)gfx->layer), lay);
+		}
+
+		prim.gfx_type = gfx->gfx_type;
+		prim.path_render_type = gfx->path_render_type;
+		prim.width = 0.0;
+		prim.first_vertex = lay->vertices->len;
+		prim.vertex_count = 0;
+		half_width = 0.0;
+
+		if (gfx->gfx_type == GRAPHIC_PATH) {
+			prim.width = (double)gfx->width_absolute * transform_get_scale(trans);
+			half_width = fabs(prim.width) / 2.0;
+		}
+
+		for (i = 0; i < gfx->vertex_count; i++)
+			emit_vertex(task, lay, trans, &gfx->vertex_array[i], half_width);
+		prim.vertex_count = gfx->vertex_count;
+
+		g_array_append_val(lay->primitives, prim);
+	}
+}
+
+/**
+ * @brief Flatten a cell and all its sub cells in the current thread
+ * @param task Task to append the primitives to
+ * @param cell Cell
+ * @param trans Transformation of the cell
+ */
+static void flatten_inline(struct flatten_task *task, struct gds_cell *cell, const struct cell_transform *trans)
+{
+	GList *iter;
+	struct gds_cell_instance *inst;
+	struct cell_transform inst_trans;
+
+	emit_cell_graphics(task, cell, trans);
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+
+		cell_transform_init_from_instance(&inst_trans, inst);
+		cell_transform_compose(&inst_trans, trans, &inst_trans);
+		flatten_inline(task, inst->cell_ref, &inst_trans);
+	}
+}
+
+static struct flatten_task *flatten_task_new(struct flatten_context *ctx, struct gds_cell *cell,
+					     GList *first_child, gboolean include_gfx,
+					     const struct cell_transform *trans)
+{
+	struct flatten_task *task;
+
+	task = g_new(struct flatten_task, 1);
+	task->ctx = ctx;
+	task->cell = cell;
+	task->first_child = first_child;
+	task->include_gfx = include_gfx;
+	task->trans = *trans;
+	task->layers = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, flat_layer_free);
+	task->sub_tasks = g_ptr_array_new();
+	bounding_box_prepare_empty(&task->box);
+
+	return task;
+}
+
+static void flatten_task_free(struct flatten_task *task)
+{
+	g_hash_table_destroy(task->layers);
+	g_ptr_array_free(task->sub_tasks, TRUE);
+	g_free(task);
+}
+
+/**
+ * @brief Create a sub task and queue it for processing
+ * @param parent Task spawning the new task. Only accessed by the thread running \p parent
+ * @param cell Cell of the new task
+ * @param first_child First instance to process
+ * @param include_gfx Process the graphics of \p cell
+ * @param trans Transformation of \p cell
+ */
+static void flatten_task_spawn(struct flatten_task *parent, struct gds_cell *cell, GList *first_child,
+			       gboolean include_gfx, const struct cell_transform *trans)
+{
+	struct flatten_task *task;
+
+	task = flatten_task_new(parent->ctx, cell, first_child, include_gfx, trans);
+	g_ptr_array_add(parent->sub_tasks, task);
+
+	g_atomic_int_inc(&parent->ctx->pending);
+	g_thread_pool_push(parent->ctx->pool, task, NULL);
+}
+
+/**
+ * @brief Worker function of the thread pool
+ * @param data Task to process
+ * @param user_data Unused
+ */
+static void flatten_task_run(gpointer data, gpointer user_data)
+{
+	struct flatten_task *task = (struct flatten_task *)data;
+	struct flatten_context *ctx = task->ctx;
+	GList *iter;
+	struct gds_cell_instance *inst;
+	struct cell_transform inst_trans;
+	guint64 count;
+	guint64 work = 0ULL;
+
+	(void)user_data;
+
+	if (task->include_gfx) {
+		emit_cell_graphics(task, task->cell, &task->trans);
+		work += g_list_length(task->cell->graphic_objs);
+	}
+
+	for (iter = task->first_child; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+
+		if (work >= FLATTEN_SPLIT_THRESHOLD) {
+			/* Hand the remaining siblings to a new task */
+			flatten_task_spawn(task, task->cell, iter, FALSE, &task->trans);
+			break;
+		}
+
+		cell_transform_init_from_instance(&inst_trans, inst);
+		cell_transform_compose(&inst_trans, &task->trans, &inst_trans);
+
+		count = lookup_count(ctx, inst->cell_ref);
+		if (count >= FLATTEN_SPLIT_THRESHOLD) {
+			flatten_task_spawn(task, inst->cell_ref, inst->cell_ref->child_cells, TRUE, &inst_trans);
+		} else {
+			flatten_inline(task, inst->cell_ref, &inst_trans);
+			work += count;
+		}
+	}
+
+	if (g_atomic_int_dec_and_test(&ctx->pending)) {
+		g_mutex_lock(&ctx->lock);
+		ctx->finished = TRUE;
+		g_cond_signal(&ctx->done);
+		g_mutex_unlock(&ctx->lock);
+	}
+}
+
+/**
+ * @brief Collect a task and its sub tasks in preorder
+ * @param task Task
+ * @param list Array to append the tasks to
+ */
+static void collect_tasks_preorder(struct flatten_task *task, GPtrArray *list)
+{
+	guint i;
+
+	g_ptr_array_add(list, task);
+	for (i = 0; i < task->sub_tasks->len; i++)
+		collect_tasks_preorder((struct flatten_task *)g_ptr_array_index(task->sub_tasks, i), list);
+}
+
+/**
+ * @brief Concatenate the buffers of all tasks for a single layer
+ * @param data #concat_job
+ * @param user_data Unused
+ */
+static void concat_layer(gpointer data, gpointer user_data)
+{
+	struct concat_job *job = (struct concat_job *)data;
+	struct flat_layer *dest = job->dest;
+	struct flat_layer *src;
+	struct flat_primitive *prim;
+	struct flatten_task *task;
+	guint prim_count = 0;
+	guint vertex_count = 0;
+	guint prim_pos;
+	guint vertex_pos;
+	guint i;
+	guint j;
+
+	(void)user_data;
+
+	/* Allocate the complete layer at once */
+	for (i = 0; i < job->tasks->len; i++) {
+		task = (struct flatten_task *)g_ptr_array_index(job->tasks, i);
+		src = (struct flat_layer *)g_hash_table_lookup(task->layers, GINT_TO_POINTER(dest->layer));
+		if (!src)
+			continue;
+		prim_count += src->primitives->len;
+		vertex_count += src->vertices->len;
+	}
+
+	g_array_set_size(dest->primitives, prim_count);
+	g_array_set_size(dest->vertices, vertex_count);
+
+	prim_pos = 0;
+	vertex_pos = 0;
+	for (i = 0; i < job->tasks->len; i++) {
+		task = (struct flatten_task *)g_ptr_array_index(job->tasks, i);
+		src = (struct flat_layer *)g_hash_table_lookup(task->layers, GINT_TO_POINTER(dest->layer));
+		if (!src)
+			continue;
+
+		memcpy(&g_array_index(dest->vertices, struct vector_2d, vertex_pos),
+		       src->vertices->data, src->vertices->len * sizeof(struct vector_2d));
+
+		for (j = 0; j < src->primitives->len; j++) {
+			prim = &g_array_index(dest->primitives, struct flat_primitive, prim_pos + j);
+			*prim = g_array_index(src->primitives, struct flat_primitive, j);
+			prim->first_vertex += vertex_pos;
+		}
+
+		prim_pos += src->primitives->len;
+		vertex_pos += src->vertices->len;
+	}
+}
+
+static gint compare_layer_numbers(gconstpointer a, gconstpointer b)
+{
+	int la = GPOINTER_TO_INT(*(gconstpointer *)a);
+	int lb = GPOINTER_TO_INT(*(gconstpointer *)b);
+
+	return (la > lb) - (la < lb);
+}
+
+/**
+ * @brief Concatenate the buffers of all tasks into the scene
+ * @param scene Scene to fill
+ * @param root Root task
+ * @param thread_count Number of worker threads
+ */
+static void build_scene(struct flat_scene *scene, struct flatten_task *root, unsigned int thread_count)
+{
+	GPtrArray *tasks;
+	GPtrArray *layer_numbers;
+	GHashTable *layer_set;
+	GHashTableIter hiter;
+	gpointer key;
+	struct flatten_task *task;
+	struct concat_job *jobs;
+	struct flat_layer *lay;
+	GThreadPool *pool;
+	guint i;
+
+	tasks = g_ptr_array_new();
+	collect_tasks_preorder(root, tasks);
+
+	/* Collect all used layers */
+	layer_set = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (i = 0; i < tasks->len; i++) {
+		task = (struct flatten_task *)g_ptr_array_index(tasks, i);
+		bounding_box_update_with_box(&scene->box, &task->box);
+		g_hash_table_iter_init(&hiter, task->layers);
+		while (g_hash_table_iter_next(&hiter, &key, NULL))
+			g_hash_table_insert(layer_set, key, key);
+	}
+
+	layer_numbers = g_ptr_array_new();
+	g_hash_table_iter_init(&hiter, layer_set);
+	while (g_hash_table_iter_next(&hiter, &key, NULL))
+		g_ptr_array_add(layer_numbers, key);
+	g_ptr_array_sort(layer_numbers, compare_layer_numbers);
+	g_hash_table_destroy(layer_set);
+
+	g_array_set_size(scene->layers, layer_numbers->len);
+	jobs = g_new(struct concat_job, layer_numbers->len);
+
+	pool = g_thread_pool_new(concat_layer, NULL, (gint)thread_count, FALSE, NULL);
+	for (i = 0; i < layer_numbers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		lay->layer = GPOINTER_TO_INT(g_ptr_array_index(layer_numbers, i));
+		lay->primitives = g_array_new(FALSE, FALSE, sizeof(struct flat_primitive));
+		lay->vertices = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+		jobs[i].dest = lay;
+		jobs[i].tasks = tasks;
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	/* Wait for all jobs to finish */
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		scene->primitive_count += lay->primitives->len;
+		scene->vertex_count += lay->vertices->len;
+	}
+
+	for (i = 0; i < tasks->len; i++)
+		flatten_task_free((struct flatten_task *)g_ptr_array_index(tasks, i));
+
+	g_free(jobs);
+	g_ptr_array_free(layer_numbers, TRUE);
+	g_ptr_array_free(tasks, TRUE);
+}
+
+struct flat_scene *hierarchy_flatten_cell(struct gds_cell *cell, const int *layers, size_t layer_count,
+					  unsigned int thread_count)
+{
+	struct flatten_context ctx;
+	struct flatten_task *root;
+	struct flat_scene *scene;
+	struct cell_transform identity;
+	gboolean loop_found = FALSE;
+
+	if (!cell)
+		return NULL;
+
+	if (thread_count == 0)
+		thread_count = g_get_num_processors();
+
+	ctx.cell_counts = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	count_flat_primitives(cell, ctx.cell_counts, &loop_found);
+	if (loop_found) {
+		g_hash_table_destroy(ctx.cell_counts);
+		return NULL;
+	}
+
+	ctx.layer_enabled = layer_lut_new(layers, layer_count);
+
+	g_mutex_init(&ctx.lock);
+	g_cond_init(&ctx.done);
+	ctx.finished = FALSE;
+	ctx.pending = 1;
+	ctx.pool = g_thread_pool_new(flatten_task_run, NULL, (gint)thread_count, FALSE, NULL);
+
+	cell_transform_init_identity(&identity);
+	root = flatten_task_new(&ctx, cell, cell->child_cells, TRUE, &identity);
+	g_thread_pool_push(ctx.pool, root, NULL);
+
+	g_mutex_lock(&ctx.lock);
+	while (!ctx.finished)
+		g_cond_wait(&ctx.done, &ctx.lock);
+	g_mutex_unlock(&ctx.lock);
+
+	g_thread_pool_free(ctx.pool, FALSE, TRUE);
+	g_cond_clear(&ctx.done);
+	g_mutex_clear(&ctx.lock);
+
+	scene = g_new(struct flat_scene, 1);
+	scene->layers = g_array_new(FALSE, FALSE, sizeof(struct flat_layer));
+	bounding_box_prepare_empty(&scene->box);
+	scene->primitive_count = 0ULL;
+	scene->vertex_count = 0ULL;
+
+	build_scene(scene, root, thread_count);
+
+	g_free(ctx.layer_enabled);
+	g_hash_table_destroy(ctx.cell_counts);
+
+	return scene;
+}
+
+const struct flat_layer *flat_scene_get_layer(const struct flat_scene *scene, int layer)
+{
+	const struct flat_layer *lay;
+	guint low;
+	guint high;
+	guint mid;
+
+	if (!scene)
+		return NULL;
+
+	low = 0;
+	high = scene->layers->len;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		lay = &g_array_index(scene->layers, struct flat_layer, mid);
+		if (lay->layer == layer)
+			return lay;
+		else if (lay->layer < layer)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return NULL;
+}
+
+void flat_scene_free(struct flat_scene *scene)
+{
+	struct flat_layer *lay;
+	guint i;
+
+	if (!scene)
+		return;
+
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		g_array_free(lay->primitives, TRUE);
+		g_array_free(lay->vertices, TRUE);
+	}
+
+	g_array_free(scene->layers, TRUE);
+	g_free(scene);
+}
+
+/**
+ * @brief Check if a layer number is contained in a list of layers
+ * @param layers Array of layer numbers. NULL contains all layers
+ * @param layer_count Number of entries in \p layers
+ * @param layer Layer number
+ * @return TRUE if \p layer is contained
+ */
+static gboolean layer_selected(const int *layers, size_t layer_count, int layer)
+{
+	size_t i;
+
+	if (!layers)
+		return TRUE;
+
+	for (i = 0; i < layer_count; i++) {
+		if (layers[i] == layer)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+int flat_scene_serialize(const struct flat_scene *scene, const int *layers, size_t layer_count,
+			 GByteArray *data)
+{
+	struct serialized_scene header;
+	struct serialized_layer slayer;
+	const struct flat_layer *lay;
+	guint header_pos;
+	guint i;
+
+	if (!scene || !data)
+		return -1;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = FLAT_SCENE_MAGIC;
+	header.box = scene->box;
+	header_pos = data->len;
+	g_byte_array_append(data, (const guint8 *)&header, sizeof(header));
+
+	/* The arrays are copied as they are. The image is only read by the same executable */
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		if (!layer_selected(layers, layer_count, lay->layer))
+			continue;
+
+		memset(&slayer, 0, sizeof(slayer));
+		slayer.layer = lay->layer;
+		slayer.primitive_count = lay->primitives->len;
+		slayer.vertex_count = lay->vertices->len;
+		g_byte_array_append(data, (const guint8 *)&slayer, sizeof(slayer));
+		g_byte_array_append(data, (const guint8 *)lay->primitives->data,
+				    lay->primitives->len * sizeof(struct flat_primitive));
+		g_byte_array_append(data, (const guint8 *)lay->vertices->data,
+				    lay->vertices->len * sizeof(struct vector_2d));
+
+		header.layer_count++;
+		header.primitive_count += lay->primitives->len;
+		header.vertex_count += lay->vertices->len;
+	}
+
+	/* Patch the counts of the written layers into the header */
+	memcpy(&data->data[header_pos], &header, sizeof(header));
+
+	return 0;
+}
+
+struct flat_scene *flat_scene_deserialize(const guint8 *data, size_t length)
+{
+	struct serialized_scene header;
+	struct serialized_layer slayer;
+	struct flat_scene *scene;
+	struct flat_layer lay;
+	const struct flat_primitive *prim;
+	size_t offset;
+	guint i, j;
+
+	if (!data || length < sizeof(header))
+		return NULL;
+
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != FLAT_SCENE_MAGIC)
+		return NULL;
+	offset = sizeof(header);
+
+	scene = g_new(struct flat_scene, 1);
+	scene->layers = g_array_new(FALSE, FALSE, sizeof(struct flat_layer));
+	scene->box = header.box;
+	scene->primitive_count = header.primitive_count;
+	scene->vertex_count = header.vertex_count;
+
+	for (i = 0; i < header.layer_count; i++) {
+		if (length - offset < sizeof(slayer))
+			goto ret_invalid;
+		memcpy(&slayer, &data[offset], sizeof(slayer));
+		offset += sizeof(slayer);
+
+		if (slayer.primitive_count > (length - offset) / sizeof(struct flat_primitive) ||
+		    slayer.vertex_count > (length - offset - slayer.primitive_count * sizeof(struct flat_primitive)) /
+					  sizeof(struct vector_2d))
+			goto ret_invalid;
+
+		lay.layer = slayer.layer;
+		lay.primitives = g_array_sized_new(FALSE, FALSE, sizeof(struct flat_primitive),
+						   (guint)slayer.primitive_count);
+		lay.vertices = g_array_sized_new(FALSE, FALSE, sizeof(struct vector_2d), (guint)slayer.vertex_count);
+		g_array_append_vals(lay.primitives, &data[offset], (guint)slayer.primitive_count);
+		offset += slayer.primitive_count * sizeof(struct flat_primitive);
+		g_array_append_vals(lay.vertices, &data[offset], (guint)slayer.vertex_count);
+		offset += slayer.vertex_count * sizeof(struct vector_2d);
+		g_array_append_val(scene->layers, lay);
+
+		/* Primitives must not reference vertices outside of their layer */
+		for (j = 0; j < lay.primitives->len; j++) {
+			prim = &g_array_index(lay.primitives, struct flat_primitive, j);
+			if (prim->first_vertex > lay.vertices->len ||
+			    prim->vertex_count > lay.vertices->len - prim->first_vertex)
+				goto ret_invalid;
+		}
+	}
+
+	return scene;
+
+ret_invalid:
+	flat_scene_free(scene);
+	return NULL;
+}
+
+/** @} */
@@ -0,0 +1,52 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file layer-lookup.c
+ * @brief Lookup table of enabled GDS layers
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <stdint.h>
+
+#include <gds-render/geometric/layer-lookup.h>
+
+guint8 *layer_lut_new(const int *layers, size_t layer_count)
+{
+	guint8 *lut;
+	size_t i;
+
+	if (!layers)
+		return NULL;
+
+	lut = g_new0(guint8, LAYER_LUT_SIZE);
+	for (i = 0; i < layer_count; i++) {
+		if (layers[i] >= INT16_MIN && layers[i] <= INT16_MAX)
+			lut[(guint16)(int16_t)layers[i]] = 1;
+	}
+
+	return lut;
+}
+
+/** @} */
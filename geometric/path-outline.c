@@ -0,0 +1,537 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file path-outline.c
+ * @brief Conversion of paths to polygon outlines
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <math.h>
+
+#include <gds-render/geometric/path-outline.h>
+
+/** @brief Maximum deviation of the approximated round caps from the real circle in database units */
+#define ARC_TOLERANCE (0.25)
+
+/** @brief Minimum number of segments of a half circle */
+#define ARC_MIN_SEGMENTS (4U)
+
+/** @brief Maximum number of segments of a half circle */
+#define ARC_MAX_SEGMENTS (64U)
+
+/** @brief Number of paths processed by a single job when building the cache */
+#define CACHE_JOB_SIZE (256U)
+
+/** @brief Joins with a cross product of the normals below this value are treated as straight */
+#define JOIN_EPSILON (1E-12)
+
+struct path_outline_cache {
+	GHashTable *outlines; /**< @brief Maps graphics objects to outlines (GArray of #vector_2d). NULL: no area */
+	GMutex lock; /**< @brief Lock for path_outline_cache::outlines */
+};
+
+/**
+ * @brief Job for building the cache
+ */
+struct outline_job {
+	const struct gds_graphics **paths; /**< @brief All paths */
+	GArray **results; /**< @brief Result array with one entry per path */
+	guint start; /**< @brief First path of this job */
+	guint end; /**< @brief End of this job (exclusive) */
+};
+
+static inline void append_point(GArray *outline, double x, double y)
+{
+	struct vector_2d pt;
+
+	pt.x = x;
+	pt.y = y;
+	g_array_append_val(outline, pt);
+}
+
+/**
+ * @brief Calculate the number of segments a half circle is approximated with
+ * @param radius Radius
+ * @return Segment count
+ */
+static unsigned int arc_segment_count(double radius)
+{
+	double step;
+	unsigned int segments;
+
+	if (radius <= ARC_TOLERANCE)
+		return ARC_MIN_SEGMENTS;
+
+	step = 2.0 * acos(1.0 - ARC_TOLERANCE / radius);
+	segments = (unsigned int)ceil(M_PI / step);
+
+	return CLAMP(segments, ARC_MIN_SEGMENTS, ARC_MAX_SEGMENTS);
+}
+
+/**
+ * @brief Append the inner points of a clockwise half circle
+ *
+ * The start and end point of the arc are not appended.
+ *
+ * @param outline Outline to append to
+ * @param center Center of the circle
+ * @param radius Radius
+ * @param start_angle Angle of the start point in radians
+ */
+static void append_half_arc(GArray *outline, const struct vector_2d *center, double radius, double start_angle)
+{
+	unsigned int segments;
+	unsigned int i;
+	double angle;
+
+	segments = arc_segment_count(radius);
+	for (i = 1; i < segments; i++) {
+		angle = start_angle - M_PI * (double)i / (double)segments;
+		append_point(outline, center->x + radius * cos(angle), center->y + radius * sin(angle));
+	}
+}
+
+/**
+ * @brief Append the outline points of a join on the left side of the traversal direction
+ * @param outline Outline to append to
+ * @param p Vertex of the center line
+ * @param n1 Left normal of the incoming segment
+ * @param n2 Left normal of the outgoing segment
+ * @param h Half path width
+ */
+static void append_join(GArray *outline, const struct vector_2d *p, const struct vector_2d *n1,
+			const struct vector_2d *n2, double h)
+{
+	double cross;
+	double denom;
+	double mx, my;
+
+	cross = n1->x * n2->y - n1->y * n2->x;
+
+	if (cross > JOIN_EPSILON) {
+		/*
+		 * Left turn: This is the inner side of the join. Going over the center point
+		 * keeps the outline correct for short segments.
+		 */
+		append_point(outline, p->x + n1->x * h, p->y + n1->y * h);
+		append_point(outline, p->x, p->y);
+		append_point(outline, p->x + n2->x * h, p->y + n2->y * h);
+		return;
+	}
+
+	/* Outer side. Miter vector (n1 + n2) / (1 + n1 * n2) has length 1 / cos(angle / 2) */
+	denom = 1.0 + n1->x * n2->x + n1->y * n2->y;
+	if (denom > JOIN_EPSILON) {
+		mx = (n1->x + n2->x) / denom;
+		my = (n1->y + n2->y) / denom;
+		if (mx * mx + my * my <= PATH_OUTLINE_MITER_LIMIT * PATH_OUTLINE_MITER_LIMIT) {
+			append_point(outline, p->x + mx * h, p->y + my * h);
+			return;
+		}
+	}
+
+	/* Bevel */
+	append_point(outline, p->x + n1->x * h, p->y + n1->y * h);
+	append_point(outline, p->x + n2->x * h, p->y + n2->y * h);
+}
+
+/**
+ * @brief Outline of a path consisting of a single point
+ * @param p Point
+ * @param h Half path width
+ * @param caps Line caps
+ * @param outline Outline to append to
+ * @return 0 if successful, -1 if the path has no area
+ */
+static int outline_single_point(const struct vector_2d *p, double h, enum path_type caps, GArray *outline)
+{
+	switch (caps) {
+	case PATH_ROUNDED:
+		append_point(outline, p->x, p->y + h);
+		append_half_arc(outline, p, h, M_PI / 2.0);
+		append_point(outline, p->x, p->y - h);
+		append_half_arc(outline, p, h, -M_PI / 2.0);
+		return 0;
+	case PATH_SQUARED:
+		append_point(outline, p->x - h, p->y + h);
+		append_point(outline, p->x + h, p->y + h);
+		append_point(outline, p->x + h, p->y - h);
+		append_point(outline, p->x - h, p->y - h);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * @brief Append the center line of a path without width
+ * @param pts Center line
+ * @param n Number of points
+ * @param outline Outline to append to
+ * @return @ref PATH_OUTLINE_HAIRLINE if successful, -1 if the center line is a single point
+ */
+static int hairline_from_unique_points(const struct vector_2d *pts, size_t n, GArray *outline)
+{
+	if (n < 2)
+		return -1;
+
+	g_array_append_vals(outline, pts, (guint)n);
+
+	return PATH_OUTLINE_HAIRLINE;
+}
+
+/**
+ * @brief Calculate the outline of a path without consecutive duplicate points
+ * @param pts Center line
+ * @param n Number of points. Has to be greater than 0
+ * @param h Half path width
+ * @param caps Line caps
+ * @param outline Outline to append to
+ * @return 0 if successful, -1 if the path has no area
+ */
+static int outline_from_unique_points(const struct vector_2d *pts, size_t n, double h, enum path_type caps,
+				      GArray *outline)
+{
+	struct vector_2d *dirs;
+	struct vector_2d *normals;
+	struct vector_2d start, end;
+	struct vector_2d neg1, neg2;
+	size_t i;
+	double ext_start, ext_end;
+	double len;
+
+	if (n == 1)
+		return outline_single_point(&pts[0], h, caps, outline);
+
+	dirs = g_new(struct vector_2d, n - 1);
+	normals = g_new(struct vector_2d, n - 1);
+	for (i = 0; i < n - 1; i++) {
+		dirs[i].x = pts[i + 1].x - pts[i].x;
+		dirs[i].y = pts[i + 1].y - pts[i].y;
+		len = vector_2d_abs(&dirs[i]);
+		dirs[i].x /= len;
+		dirs[i].y /= len;
+		normals[i].x = -dirs[i].y;
+		normals[i].y = dirs[i].x;
+	}
+
+	ext_start = (caps == PATH_SQUARED ? h : 0.0);
+	ext_end = ext_start;
+
+	start.x = pts[0].x - dirs[0].x * ext_start;
+	start.y = pts[0].y - dirs[0].y * ext_start;
+	end.x = pts[n - 1].x + dirs[n - 2].x * ext_end;
+	end.y = pts[n - 1].y + dirs[n - 2].y * ext_end;
+
+	/* Left side */
+	append_point(outline, start.x + normals[0].x * h, start.y + normals[0].y * h);
+	for (i = 1; i < n - 1; i++)
+		append_join(outline, &pts[i], &normals[i - 1], &normals[i], h);
+	append_point(outline, end.x + normals[n - 2].x * h, end.y + normals[n - 2].y * h);
+
+	/* End cap */
+	if (caps == PATH_ROUNDED)
+		append_half_arc(outline, &pts[n - 1], h, atan2(normals[n - 2].y, normals[n - 2].x));
+
+	/* Right side in reverse direction. The left normal of the reversed path is the negated normal */
+	append_point(outline, end.x - normals[n - 2].x * h, end.y - normals[n - 2].y * h);
+	for (i = n - 2; i >= 1; i--) {
+		neg1.x = -normals[i].x;
+		neg1.y = -normals[i].y;
+		neg2.x = -normals[i - 1].x;
+		neg2.y = -normals[i - 1].y;
+		append_join(outline, &pts[i], &neg1, &neg2, h);
+	}
+	append_point(outline, start.x - normals[0].x * h, start.y - normals[0].y * h);
+
+	/* Start cap */
+	if (caps == PATH_ROUNDED)
+		append_half_arc(outline, &pts[0], h, atan2(-normals[0].y, -normals[0].x));
+
+	g_free(normals);
+	g_free(dirs);
+
+	return 0;
+}
+
+int path_outline_calculate(const struct gds_point *vertices, size_t count, double width, enum path_type caps,
+			   GArray *outline)
+{
+	struct vector_2d *pts;
+	size_t n = 0;
+	size_t i;
+	double h = fabs(width) / 2.0;
+	int ret;
+
+	if (!vertices || !count || !outline)
+		return -1;
+
+	/* Remove consecutive duplicates */
+	pts = g_new(struct vector_2d, count);
+	for (i = 0; i < count; i++) {
+		if (n > 0 && pts[n - 1].x == (double)vertices[i].x && pts[n - 1].y == (double)vertices[i].y)
+			continue;
+		pts[n].x = (double)vertices[i].x;
+		pts[n].y = (double)vertices[i].y;
+		n++;
+	}
+
+	if (h == 0.0)
+		ret = hairline_from_unique_points(pts, n, outline);
+	else
+		ret = outline_from_unique_points(pts, n, h, caps, outline);
+	g_free(pts);
+
+	return ret;
+}
+
+int path_outline_calculate_from_vectors(const struct vector_2d *vertices, size_t count, double width,
+					enum path_type caps, GArray *outline)
+{
+	struct vector_2d *pts;
+	size_t n = 0;
+	size_t i;
+	double h = fabs(width) / 2.0;
+	int ret;
+
+	if (!vertices || !count || !outline)
+		return -1;
+
+	/* Remove consecutive duplicates */
+	pts = g_new(struct vector_2d, count);
+	for (i = 0; i < count; i++) {
+		if (n > 0 && pts[n - 1].x == vertices[i].x && pts[n - 1].y == vertices[i].y)
+			continue;
+		pts[n] = vertices[i];
+		n++;
+	}
+
+	if (h == 0.0)
+		ret = hairline_from_unique_points(pts, n, outline);
+	else
+		ret = outline_from_unique_points(pts, n, h, caps, outline);
+	g_free(pts);
+
+	return ret;
+}
+
+int path_outline_calculate_from_gfx(const struct gds_graphics *gfx, GArray *outline)
+{
+	if (!gfx || gfx->gfx_type != GRAPHIC_PATH || !outline)
+		return -1;
+
+	return path_outline_calculate(gfx->vertex_array, gfx->vertex_count, (double)gfx->width_absolute,
+				      gfx->path_render_type, outline);
+}
+
+void path_outline_calculate_bounding_box(const struct gds_graphics *gfx, union bounding_box *box)
+{
+	GArray *outline;
+
+	if (!box)
+		return;
+
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	path_outline_calculate_from_gfx(gfx, outline);
+	vector_2d_array_min_max((const struct vector_2d *)outline->data, outline->len,
+				&box->vectors.lower_left, &box->vectors.upper_right);
+	g_array_free(outline, TRUE);
+}
+
+/**
+ * @brief Calculate an outline into a newly allocated array
+ * @param gfx Path
+ * @return Outline or NULL if the path has no area and no center line
+ */
+static GArray *outline_new_from_gfx(const struct gds_graphics *gfx)
+{
+	GArray *outline;
+
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	if (path_outline_calculate_from_gfx(gfx, outline) < 0) {
+		g_array_free(outline, TRUE);
+		return NULL;
+	}
+
+	return outline;
+}
+
+static void outline_free(gpointer data)
+{
+	if (data)
+		g_array_free((GArray *)data, TRUE);
+}
+
+struct path_outline_cache *path_outline_cache_new(void)
+{
+	struct path_outline_cache *cache;
+
+	cache = g_new(struct path_outline_cache, 1);
+	cache->outlines = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, outline_free);
+	g_mutex_init(&cache->lock);
+
+	return cache;
+}
+
+void path_outline_cache_free(struct path_outline_cache *cache)
+{
+	if (!cache)
+		return;
+
+	g_hash_table_destroy(cache->outlines);
+	g_mutex_clear(&cache->lock);
+	g_free(cache);
+}
+
+/**
+ * @brief Collect all paths of a cell and its sub cells
+ * @param cell Cell
+ * @param visited Set of already visited cells
+ * @param paths Array to append the paths to
+ * @param cache Cache. Paths already in the cache are skipped
+ */
+static void collect_paths(struct gds_cell *cell, GHashTable *visited, GPtrArray *paths,
+			  struct path_outline_cache *cache)
+{
+	GList *iter;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+
+	if (g_hash_table_contains(visited, cell))
+		return;
+	g_hash_table_insert(visited, cell, cell);
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		if (gfx->gfx_type == GRAPHIC_PATH && !g_hash_table_contains(cache->outlines, gfx))
+			g_ptr_array_add(paths, gfx);
+	}
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (inst->cell_ref)
+			collect_paths(inst->cell_ref, visited, paths, cache);
+	}
+}
+
+static void outline_job_run(gpointer data, gpointer user_data)
+{
+	struct outline_job *job = (struct outline_job *)data;
+	guint i;
+
+	(void)user_data;
+
+	for (i = job->start; i < job->end; i++)
+		job->results[i] = outline_new_from_gfx(job->paths[i]);
+}
+
+int path_outline_cache_build_for_cell(struct path_outline_cache *cache, struct gds_cell *cell,
+				      unsigned int thread_count)
+{
+	GHashTable *visited;
+	GPtrArray *paths;
+	GArray **results;
+	struct outline_job *jobs;
+	guint job_count;
+	guint i;
+	GThreadPool *pool;
+
+	if (!cache || !cell)
+		return -1;
+
+	if (thread_count == 0)
+		thread_count = g_get_num_processors();
+
+	visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+	paths = g_ptr_array_new();
+
+	g_mutex_lock(&cache->lock);
+	collect_paths(cell, visited, paths, cache);
+	g_mutex_unlock(&cache->lock);
+	g_hash_table_destroy(visited);
+
+	results = g_new0(GArray *, paths->len + 1);
+	job_count = (paths->len + CACHE_JOB_SIZE - 1) / CACHE_JOB_SIZE;
+	jobs = g_new(struct outline_job, job_count + 1);
+
+	pool = g_thread_pool_new(outline_job_run, NULL, (gint)thread_count, FALSE, NULL);
+	for (i = 0; i < job_count; i++) {
+		jobs[i].paths = (const struct gds_graphics **)paths->pdata;
+		jobs[i].results = results;
+		jobs[i].start = i * CACHE_JOB_SIZE;
+		jobs[i].end = MIN((i + 1) * CACHE_JOB_SIZE, paths->len);
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	g_mutex_lock(&cache->lock);
+	for (i = 0; i < paths->len; i++) {
+		if (g_hash_table_contains(cache->outlines, g_ptr_array_index(paths, i)))
+			outline_free(results[i]);
+		else
+			g_hash_table_insert(cache->outlines, g_ptr_array_index(paths, i), results[i]);
+	}
+	g_mutex_unlock(&cache->lock);
+
+	i = paths->len;
+	g_free(jobs);
+	g_free(results);
+	g_ptr_array_free(paths, TRUE);
+
+	return (int)i;
+}
+
+const GArray *path_outline_cache_lookup(struct path_outline_cache *cache, const struct gds_graphics *gfx)
+{
+	gpointer value;
+	GArray *outline;
+
+	if (!cache || !gfx || gfx->gfx_type != GRAPHIC_PATH)
+		return NULL;
+
+	g_mutex_lock(&cache->lock);
+	if (g_hash_table_lookup_extended(cache->outlines, gfx, NULL, &value)) {
+		g_mutex_unlock(&cache->lock);
+		return (const GArray *)value;
+	}
+	g_mutex_unlock(&cache->lock);
+
+	/* Calculate outside of the lock */
+	outline = outline_new_from_gfx(gfx);
+
+	g_mutex_lock(&cache->lock);
+	if (g_hash_table_lookup_extended(cache->outlines, gfx, NULL, &value)) {
+		/* Another thread was faster */
+		outline_free(outline);
+		outline = (GArray *)value;
+	} else {
+		g_hash_table_insert(cache->outlines, (gpointer)gfx, outline);
+	}
+	g_mutex_unlock(&cache->lock);
+
+	return outline;
+}
+
+/** @} */
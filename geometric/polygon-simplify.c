@@ -0,0 +1,271 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file polygon-simplify.c
+ * @brief Tolerance based simplification of polygons and paths
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <math.h>
+
+#include <gds-render/geometric/polygon-simplify.h>
+
+/**
+ * @brief Range of vertices still to be processed
+ */
+struct simplify_range {
+	size_t first; /**< @brief First vertex. Is kept */
+	size_t last; /**< @brief Last vertex. Is kept */
+};
+
+/**
+ * @brief Job for simplifying a single layer of a scene
+ */
+struct simplify_job {
+	struct flat_layer *layer; /**< @brief Layer */
+	double tolerance; /**< @brief Maximum deviation */
+	guint64 removed; /**< @brief Number of removed vertices */
+};
+
+/**
+ * @brief Squared distance of a point to a line segment
+ * @param p Point
+ * @param a Start of segment
+ * @param b End of segment
+ * @return Squared distance
+ */
+static double segment_distance_squared(const struct vector_2d *p, const struct vector_2d *a,
+				       const struct vector_2d *b)
+{
+	double dx = b->x - a->x;
+	double dy = b->y - a->y;
+	double len_sq = dx * dx + dy * dy;
+	double t;
+	double px, py;
+
+	if (len_sq == 0.0) {
+		px = p->x - a->x;
+		py = p->y - a->y;
+		return px * px + py * py;
+	}
+
+	t = ((p->x - a->x) * dx + (p->y - a->y) * dy) / len_sq;
+	t = CLAMP(t, 0.0, 1.0);
+	px = p->x - (a->x + t * dx);
+	py = p->y - (a->y + t * dy);
+
+	return px * px + py * py;
+}
+
+/**
+ * @brief Mark the vertices to keep between two fixed vertices
+ *
+ * The recursion of the Douglas-Peucker algorithm is replaced by an explicit stack.
+ *
+ * @param v Vertices
+ * @param first First vertex
+ * @param last Last vertex
+ * @param tol_sq Squared tolerance
+ * @param keep Array of flags. Kept vertices are set to TRUE
+ * @param stack Working stack of #simplify_range
+ */
+static void douglas_peucker(const struct vector_2d *v, size_t first, size_t last, double tol_sq, gboolean *keep,
+			    GArray *stack)
+{
+	struct simplify_range range;
+	struct simplify_range sub;
+	size_t i;
+	size_t max_idx;
+	double max_dist;
+	double dist;
+
+	keep[first] = TRUE;
+	keep[last] = TRUE;
+
+	range.first = first;
+	range.last = last;
+	g_array_set_size(stack, 0);
+	g_array_append_val(stack, range);
+
+	while (stack->len > 0) {
+		range = g_array_index(stack, struct simplify_range, stack->len - 1);
+		g_array_set_size(stack, stack->len - 1);
+
+		if (range.last <= range.first + 1)
+			continue;
+
+		max_dist = -1.0;
+		max_idx = range.first;
+		for (i = range.first + 1; i < range.last; i++) {
+			dist = segment_distance_squared(&v[i], &v[range.first], &v[range.last]);
+			if (dist > max_dist) {
+				max_dist = dist;
+				max_idx = i;
+			}
+		}
+
+		if (max_dist <= tol_sq)
+			continue;
+
+		keep[max_idx] = TRUE;
+		sub.first = range.first;
+		sub.last = max_idx;
+		g_array_append_val(stack, sub);
+		sub.first = max_idx;
+		sub.last = range.last;
+		g_array_append_val(stack, sub);
+	}
+}
+
+size_t polygon_simplify(const struct vector_2d *in, size_t count, double tolerance, gboolean closed,
+			struct vector_2d *out)
+{
+	struct vector_2d *v;
+	gboolean *keep;
+	GArray *stack;
+	size_t n = count;
+	size_t far_idx = 0;
+	size_t i;
+	size_t out_count = 0;
+	double far_dist = -1.0;
+	double dist;
+
+	if (!in || !out || count == 0)
+		return 0;
+
+	/* Remove closing vertex */
+	if (closed && n > 1 && in[n - 1].x == in[0].x && in[n - 1].y == in[0].y)
+		n--;
+
+	if (tolerance <= 0.0 || n <= (closed ? 3U : 2U))
+		goto copy_unchanged;
+
+	/* Closed shapes are processed as open line returning to the first vertex */
+	v = g_new(struct vector_2d, n + 1);
+	for (i = 0; i < n; i++)
+		v[i] = in[i];
+	v[n] = in[0];
+
+	keep = g_new0(gboolean, n + 1);
+	stack = g_array_new(FALSE, FALSE, sizeof(struct simplify_range));
+
+	if (closed) {
+		/* Split at the vertex farthest away from the first one */
+		for (i = 1; i < n; i++) {
+			dist = segment_distance_squared(&v[i], &v[0], &v[0]);
+			if (dist > far_dist) {
+				far_dist = dist;
+				far_idx = i;
+			}
+		}
+		douglas_peucker(v, 0, far_idx, tolerance * tolerance, keep, stack);
+		douglas_peucker(v, far_idx, n, tolerance * tolerance, keep, stack);
+	} else {
+		douglas_peucker(v, 0, n - 1, tolerance * tolerance, keep, stack);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (keep[i])
+			out[out_count++] = v[i];
+	}
+
+	g_array_free(stack, TRUE);
+	g_free(keep);
+	g_free(v);
+
+	if (out_count >= (closed ? 3U : 2U))
+		return out_count;
+
+copy_unchanged:
+	for (i = 0; i < n; i++)
+		out[i] = in[i];
+
+	return n;
+}
+
+static void simplify_job_run(gpointer data, gpointer user_data)
+{
+	struct simplify_job *job = (struct simplify_job *)data;
+	struct flat_layer *lay = job->layer;
+	struct flat_primitive *prim;
+	GArray *vertices;
+	guint i;
+	size_t count;
+
+	(void)user_data;
+
+	vertices = g_array_sized_new(FALSE, FALSE, sizeof(struct vector_2d), lay->vertices->len);
+	job->removed = 0ULL;
+
+	for (i = 0; i < lay->primitives->len; i++) {
+		prim = &g_array_index(lay->primitives, struct flat_primitive, i);
+
+		g_array_set_size(vertices, vertices->len + prim->vertex_count);
+		count = polygon_simplify(&g_array_index(lay->vertices, struct vector_2d, prim->first_vertex),
+					 prim->vertex_count, job->tolerance, prim->gfx_type != GRAPHIC_PATH,
+					 &g_array_index(vertices, struct vector_2d, vertices->len - prim->vertex_count));
+		g_array_set_size(vertices, vertices->len - prim->vertex_count + count);
+
+		job->removed += prim->vertex_count - count;
+		prim->first_vertex = vertices->len - count;
+		prim->vertex_count = count;
+	}
+
+	g_array_free(lay->vertices, TRUE);
+	lay->vertices = vertices;
+}
+
+guint64 polygon_simplify_scene(struct flat_scene *scene, double tolerance, unsigned int thread_count)
+{
+	struct simplify_job *jobs;
+	GThreadPool *pool;
+	guint64 removed = 0ULL;
+	guint i;
+
+	if (!scene || tolerance <= 0.0)
+		return 0ULL;
+
+	if (thread_count == 0)
+		thread_count = g_get_num_processors();
+
+	jobs = g_new0(struct simplify_job, scene->layers->len + 1);
+	pool = g_thread_pool_new(simplify_job_run, NULL, (gint)thread_count, FALSE, NULL);
+	for (i = 0; i < scene->layers->len; i++) {
+		jobs[i].layer = &g_array_index(scene->layers, struct flat_layer, i);
+		jobs[i].tolerance = tolerance;
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	for (i = 0; i < scene->layers->len; i++)
+		removed += jobs[i].removed;
+
+	scene->vertex_count = (scene->vertex_count > removed ? scene->vertex_count - removed : 0ULL);
+	g_free(jobs);
+
+	return removed;
+}
+
+/** @} */
@@ -0,0 +1,917 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file polygon-union.c
+ * @brief Union of overlapping shapes of a flattened layer
+ *
+ * The union is calculated in three steps:
+ *  1. A scanline sweeps over the vertical edges of all rectilinear shapes from bottom to top.
+ *     Between two consecutive y coordinates, the covered x intervals are calculated using the
+ *     nonzero winding rule. Consecutive bands with identical intervals are combined to slabs.
+ *  2. The boundary of the covered area is extracted from the slabs and traced into closed contours.
+ *     Outer contours are counter-clockwise, holes clockwise.
+ *  3. Each hole is connected to the contour below it by a zero width cut.
+ *
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gds-render/geometric/polygon-union.h>
+#include <gds-render/geometric/rectangle-decomposition.h>
+#include <gds-render/geometric/scanline.h>
+
+/**
+ * @brief Horizontal band with constant coverage
+ */
+struct slab {
+	double y0; /**< @brief Lower end */
+	double y1; /**< @brief Upper end */
+	guint first_interval; /**< @brief Index of the first #scanline_interval */
+	guint interval_count; /**< @brief Number of intervals */
+};
+
+/**
+ * @brief Covered area represented as slabs
+ */
+struct slab_set {
+	GArray *slabs; /**< @brief Array of #slab sorted by ascending y */
+	GArray *intervals; /**< @brief Array of #scanline_interval referenced by the slabs */
+};
+
+/**
+ * @brief Directed edge of the boundary of the covered area. The covered area is on the left
+ */
+struct boundary_edge {
+	struct vector_2d start; /**< @brief Start point */
+	struct vector_2d end; /**< @brief End point */
+	gboolean used; /**< @brief Edge has been added to a contour */
+};
+
+/**
+ * @brief Reference from a horizontal contour edge with covered area above to its contour
+ */
+struct edge_ref {
+	double y; /**< @brief y coordinate of the edge */
+	guint loop; /**< @brief Index of the contour */
+};
+
+/**
+ * @brief Hole to be connected to the surrounding contour
+ */
+struct hole {
+	guint loop; /**< @brief Index of the contour */
+	double y; /**< @brief y coordinate of the lowest edge with covered area below */
+	double x_left; /**< @brief Left end of this edge */
+	double x_right; /**< @brief Right end of this edge */
+};
+
+/**
+ * @brief Job for merging a single layer of a scene
+ */
+struct merge_job {
+	struct flat_layer *layer; /**< @brief Layer to merge */
+	struct flat_layer result; /**< @brief Merged layer */
+	int status; /**< @brief Return value of polygon_union_merge_layer() */
+};
+
+static gint compare_point(const struct vector_2d *a, const struct vector_2d *b)
+{
+	if (a->x != b->x)
+		return (a->x > b->x ? 1 : -1);
+	return (a->y > b->y) - (a->y < b->y);
+}
+
+static gint compare_boundary_edge(gconstpointer a, gconstpointer b)
+{
+	return compare_point(&((const struct boundary_edge *)a)->start, &((const struct boundary_edge *)b)->start);
+}
+
+static gint compare_edge_ref(gconstpointer a, gconstpointer b)
+{
+	return scanline_compare_double(&((const struct edge_ref *)a)->y, &((const struct edge_ref *)b)->y);
+}
+
+static gint compare_hole_descending(gconstpointer a, gconstpointer b)
+{
+	return scanline_compare_double(&((const struct hole *)b)->y, &((const struct hole *)a)->y);
+}
+
+static double signed_area(const struct vector_2d *v, size_t count)
+{
+	double area = 0.0;
+	size_t i;
+	const struct vector_2d *next;
+
+	for (i = 0; i < count; i++) {
+		next = &v[(i + 1) % count];
+		area += v[i].x * next->y - next->x * v[i].y;
+	}
+
+	return area / 2.0;
+}
+
+/**
+ * @brief Add the vertical edges of a rectilinear shape to the sweep
+ * @param edges Array of #scanline_edge
+ * @param v Vertices
+ * @param count Vertex count
+ * @param orientation +1 for counter-clockwise shapes, -1 for clockwise shapes
+ */
+static void add_sweep_edges(GArray *edges, const struct vector_2d *v, size_t count, int orientation)
+{
+	size_t i;
+	const struct vector_2d *next;
+	struct scanline_edge edge;
+
+	for (i = 0; i < count; i++) {
+		next = &v[(i + 1) % count];
+		if (v[i].x != next->x || v[i].y == next->y)
+			continue;
+
+		edge.pos = v[i].x;
+		edge.low = MIN(v[i].y, next->y);
+		edge.high = MAX(v[i].y, next->y);
+		/* Normalize all shapes to the same orientation. Otherwise overlaps could cancel out */
+		edge.dir = (next->y > v[i].y ? 1 : -1) * orientation;
+		g_array_append_val(edges, edge);
+	}
+}
+
+static gboolean intervals_equal(const struct scanline_interval *a, guint count_a,
+				const struct scanline_interval *b, guint count_b)
+{
+	guint i;
+
+	if (count_a != count_b)
+		return FALSE;
+
+	for (i = 0; i < count_a; i++) {
+		if (a[i].low != b[i].low || a[i].high != b[i].high)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * @brief Sweep over the vertical edges and build the slabs of the covered area
+ * @param set Slab set to fill
+ * @param edges Array of #scanline_edge. It is sorted by this function
+ */
+static void slab_set_build(struct slab_set *set, GArray *edges)
+{
+	GArray *ys;
+	GArray *active;
+	GArray *current;
+	struct slab *last;
+	struct slab new_slab;
+	guint band;
+	guint next_edge = 0;
+	double y;
+
+	set->slabs = g_array_new(FALSE, FALSE, sizeof(struct slab));
+	set->intervals = g_array_new(FALSE, FALSE, sizeof(struct scanline_interval));
+
+	ys = scanline_prepare(edges);
+	active = g_array_new(FALSE, FALSE, sizeof(struct scanline_edge));
+	current = g_array_new(FALSE, FALSE, sizeof(struct scanline_interval));
+
+	for (band = 0; band + 1 < ys->len; band++) {
+		y = g_array_index(ys, double, band);
+		if (scanline_update_active(edges, &next_edge, active, y))
+			scanline_compute_intervals(active, current);
+
+		if (current->len == 0)
+			continue;
+
+		/* Extend the previous slab if the coverage did not change */
+		if (set->slabs->len > 0) {
+			last = &g_array_index(set->slabs, struct slab, set->slabs->len - 1);
+			if (last->y1 == y &&
+			    intervals_equal(&g_array_index(set->intervals, struct scanline_interval, last->first_interval),
+					    last->interval_count, (const struct scanline_interval *)current->data,
+					    current->len)) {
+				last->y1 = g_array_index(ys, double, band + 1);
+				continue;
+			}
+		}
+
+		new_slab.y0 = y;
+		new_slab.y1 = g_array_index(ys, double, band + 1);
+		new_slab.first_interval = set->intervals->len;
+		new_slab.interval_count = current->len;
+		g_array_append_vals(set->intervals, current->data, current->len);
+		g_array_append_val(set->slabs, new_slab);
+	}
+
+	g_array_free(current, TRUE);
+	g_array_free(active, TRUE);
+	g_array_free(ys, TRUE);
+}
+
+static void slab_set_free(struct slab_set *set)
+{
+	g_array_free(set->slabs, TRUE);
+	g_array_free(set->intervals, TRUE);
+}
+
+static inline const struct slab *slab_set_get(const struct slab_set *set, guint idx)
+{
+	return &g_array_index(set->slabs, struct slab, idx);
+}
+
+static inline const struct scanline_interval *slab_get_intervals(const struct slab_set *set, const struct slab *slab)
+{
+	return &g_array_index(set->intervals, struct scanline_interval, slab->first_interval);
+}
+
+/**
+ * @brief Check if a slab covers an x coordinate
+ * @param set Slab set
+ * @param slab Slab
+ * @param x x coordinate
+ * @return 1 if \p x is strictly inside a covered interval, -1 if it is on the border of an interval, else 0
+ */
+static int slab_covers(const struct slab_set *set, const struct slab *slab, double x)
+{
+	const struct scanline_interval *ivals = slab_get_intervals(set, slab);
+	guint low = 0;
+	guint high = slab->interval_count;
+	guint mid;
+
+	/* Find first interval ending at or right of x */
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (ivals[mid].high < x)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low == slab->interval_count || ivals[low].low > x)
+		return 0;
+	if (ivals[low].low == x || ivals[low].high == x)
+		return -1;
+
+	return 1;
+}
+
+static void add_boundary_edge(GArray *edges, double x0, double y0, double x1, double y1)
+{
+	struct boundary_edge edge;
+
+	edge.start.x = x0;
+	edge.start.y = y0;
+	edge.end.x = x1;
+	edge.end.y = y1;
+	edge.used = FALSE;
+	g_array_append_val(edges, edge);
+}
+
+static gboolean intervals_cover(const struct scanline_interval *ivals, guint count, double x)
+{
+	guint i;
+
+	for (i = 0; i < count; i++) {
+		if (ivals[i].low <= x && x <= ivals[i].high)
+			return TRUE;
+		if (ivals[i].low > x)
+			break;
+	}
+
+	return FALSE;
+}
+
+/**
+ * @brief Emit the horizontal boundary edges between two sets of intervals
+ *
+ * A horizontal edge exists where exactly one side is covered.
+ *
+ * @param edges Array of #boundary_edge
+ * @param y y coordinate of the border
+ * @param below Intervals below the border
+ * @param count_below Number of intervals below
+ * @param above Intervals above the border
+ * @param count_above Number of intervals above
+ */
+static void emit_horizontal_edges(GArray *edges, double y, const struct scanline_interval *below, guint count_below,
+				  const struct scanline_interval *above, guint count_above)
+{
+	double *xs;
+	guint count = 0;
+	guint i, j;
+	double mid;
+	int state;
+	int run_state = 0;
+	double run_start = 0.0, run_end = 0.0;
+
+	xs = g_new(double, 2 * (count_below + count_above) + 1);
+	for (i = 0; i < count_below; i++) {
+		xs[count++] = below[i].low;
+		xs[count++] = below[i].high;
+	}
+	for (i = 0; i < count_above; i++) {
+		xs[count++] = above[i].low;
+		xs[count++] = above[i].high;
+	}
+	qsort(xs, count, sizeof(double), (int (*)(const void *, const void *))scanline_compare_double);
+	for (i = 0, j = 0; i < count; i++) {
+		if (j == 0 || xs[j - 1] != xs[i])
+			xs[j++] = xs[i];
+	}
+	count = j;
+
+	for (i = 0; i + 1 < count; i++) {
+		mid = (xs[i] + xs[i + 1]) / 2.0;
+		/* +1: covered above only, -1: covered below only */
+		state = (int)intervals_cover(above, count_above, mid) - (int)intervals_cover(below, count_below, mid);
+
+		if (state == run_state && run_end == xs[i]) {
+			run_end = xs[i + 1];
+			continue;
+		}
+
+		if (run_state > 0)
+			add_boundary_edge(edges, run_start, y, run_end, y);
+		else if (run_state < 0)
+			add_boundary_edge(edges, run_end, y, run_start, y);
+
+		run_state = state;
+		run_start = xs[i];
+		run_end = xs[i + 1];
+	}
+
+	if (run_state > 0)
+		add_boundary_edge(edges, run_start, y, run_end, y);
+	else if (run_state < 0)
+		add_boundary_edge(edges, run_end, y, run_start, y);
+
+	g_free(xs);
+}
+
+/**
+ * @brief Extract the directed boundary edges of the covered area
+ * @param set Slabs
+ * @param edges Array of #boundary_edge to fill
+ */
+static void collect_boundary_edges(const struct slab_set *set, GArray *edges)
+{
+	const struct slab *slab;
+	const struct slab *prev = NULL;
+	const struct scanline_interval *ivals;
+	guint i, k;
+
+	for (i = 0; i < set->slabs->len; i++) {
+		slab = slab_set_get(set, i);
+		ivals = slab_get_intervals(set, slab);
+
+		/* Left edges point down, right edges point up */
+		for (k = 0; k < slab->interval_count; k++) {
+			add_boundary_edge(edges, ivals[k].low, slab->y1, ivals[k].low, slab->y0);
+			add_boundary_edge(edges, ivals[k].high, slab->y0, ivals[k].high, slab->y1);
+		}
+
+		/* Border to the slab below */
+		if (prev && prev->y1 == slab->y0) {
+			emit_horizontal_edges(edges, slab->y0, slab_get_intervals(set, prev), prev->interval_count,
+					      ivals, slab->interval_count);
+		} else {
+			if (prev)
+				emit_horizontal_edges(edges, prev->y1, slab_get_intervals(set, prev),
+						      prev->interval_count, NULL, 0);
+			emit_horizontal_edges(edges, slab->y0, NULL, 0, ivals, slab->interval_count);
+		}
+
+		prev = slab;
+	}
+
+	if (prev)
+		emit_horizontal_edges(edges, prev->y1, slab_get_intervals(set, prev), prev->interval_count, NULL, 0);
+}
+
+/**
+ * @brief Select the next boundary edge of a contour
+ *
+ * If multiple unused edges start at the end point of the current edge, the leftmost turn is taken.
+ * This separates shapes that only touch at a corner.
+ *
+ * @param edges Sorted boundary edges
+ * @param count Number of edges
+ * @param current Current edge
+ * @return Index of the next edge or -1 if no unused edge is left
+ */
+static gssize select_next_edge(struct boundary_edge *edges, guint count, const struct boundary_edge *current)
+{
+	guint low = 0, high = count, mid;
+	gssize best = -1;
+	double best_cross = 0.0;
+	double cross;
+	struct vector_2d dir_in, dir_out;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (compare_point(&edges[mid].start, &current->end) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	dir_in.x = current->end.x - current->start.x;
+	dir_in.y = current->end.y - current->start.y;
+
+	for (; low < count && compare_point(&edges[low].start, &current->end) == 0; low++) {
+		if (edges[low].used)
+			continue;
+		dir_out.x = edges[low].end.x - edges[low].start.x;
+		dir_out.y = edges[low].end.y - edges[low].start.y;
+		cross = (dir_in.x * dir_out.y - dir_in.y * dir_out.x) /
+				(vector_2d_abs(&dir_in) * vector_2d_abs(&dir_out));
+		if (best < 0 || cross > best_cross) {
+			best = (gssize)low;
+			best_cross = cross;
+		}
+	}
+
+	return best;
+}
+
+static gboolean points_collinear(const struct vector_2d *a, const struct vector_2d *b, const struct vector_2d *c)
+{
+	return (a->x == b->x && b->x == c->x) || (a->y == b->y && b->y == c->y);
+}
+
+/**
+ * @brief Remove points in the middle of straight contour segments
+ * @param loop Contour
+ */
+static void loop_remove_collinear(GArray *loop)
+{
+	struct vector_2d *v = (struct vector_2d *)loop->data;
+	guint count = 0;
+	guint i;
+
+	for (i = 0; i < loop->len; i++) {
+		while (count >= 2 && points_collinear(&v[count - 2], &v[count - 1], &v[i]))
+			count--;
+		v[count++] = v[i];
+	}
+
+	/* Wrap around */
+	while (count >= 3 && points_collinear(&v[count - 2], &v[count - 1], &v[0]))
+		count--;
+	i = 0;
+	while (count - i >= 3 && points_collinear(&v[count - 1], &v[i], &v[i + 1]))
+		i++;
+	if (i > 0)
+		memmove(v, &v[i], (count - i) * sizeof(struct vector_2d));
+
+	g_array_set_size(loop, count - i);
+}
+
+/**
+ * @brief Trace the boundary edges into closed contours
+ * @param edges Boundary edges. Is sorted by this function
+ * @return Array of contours (GArray of #vector_2d) or NULL in case of an error
+ */
+static GPtrArray *trace_loops(GArray *edges)
+{
+	GPtrArray *loops;
+	GArray *loop;
+	struct boundary_edge *e;
+	gssize cur, next;
+	guint i;
+
+	g_array_sort(edges, compare_boundary_edge);
+	e = (struct boundary_edge *)edges->data;
+	loops = g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+
+	for (i = 0; i < edges->len; i++) {
+		if (e[i].used)
+			continue;
+
+		loop = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+		g_ptr_array_add(loops, loop);
+		cur = (gssize)i;
+
+		while (1) {
+			e[cur].used = TRUE;
+			g_array_append_val(loop, e[cur].start);
+			next = select_next_edge(e, edges->len, &e[cur]);
+			if (next < 0)
+				break;
+			cur = next;
+		}
+
+		/* Contour has to be closed */
+		if (compare_point(&e[cur].end, &e[i].start) != 0) {
+			g_ptr_array_free(loops, TRUE);
+			return NULL;
+		}
+
+		loop_remove_collinear(loop);
+	}
+
+	return loops;
+}
+
+/**
+ * @brief Find the y coordinate a cut starting at the bottom of a hole ends
+ *
+ * The cut goes straight down through the covered area until the next boundary.
+ *
+ * @param set Slabs
+ * @param x x coordinate of the cut
+ * @param y y coordinate of the bottom edge of the hole
+ * @param[out] y_target y coordinate of the boundary
+ * @return 0 if successful. -1 if the cut would run along a vertical boundary
+ */
+static int find_cut_target(const struct slab_set *set, double x, double y, double *y_target)
+{
+	guint low = 0, high = set->slabs->len, mid;
+	guint k;
+	int status;
+
+	/* Slab directly below the hole */
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (slab_set_get(set, mid)->y1 < y)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low == set->slabs->len || slab_set_get(set, low)->y1 != y)
+		return -1;
+
+	k = low;
+	if (slab_covers(set, slab_set_get(set, k), x) != 1)
+		return -1;
+
+	while (k > 0 && slab_set_get(set, k - 1)->y1 == slab_set_get(set, k)->y0) {
+		status = slab_covers(set, slab_set_get(set, k - 1), x);
+		if (status < 0)
+			return -1;
+		if (status == 0)
+			break;
+		k--;
+	}
+
+	*y_target = slab_set_get(set, k)->y0;
+
+	return 0;
+}
+
+/**
+ * @brief Find a horizontal edge of a contour
+ * @param loop Contour
+ * @param y y coordinate of the edge
+ * @param x x coordinate, that has to be inside the edge
+ * @param positive_x TRUE: Edge has to point in positive x direction
+ * @param[out] idx Index of the start point of the edge
+ * @return TRUE if found
+ */
+static gboolean loop_find_horizontal_edge(const GArray *loop, double y, double x, gboolean positive_x, guint *idx)
+{
+	const struct vector_2d *v = (const struct vector_2d *)loop->data;
+	const struct vector_2d *next;
+	guint i;
+
+	for (i = 0; i < loop->len; i++) {
+		next = &v[(i + 1) % loop->len];
+		if (v[i].y != y || next->y != y)
+			continue;
+		if (positive_x && v[i].x < x && x < next->x) {
+			*idx = i;
+			return TRUE;
+		}
+		if (!positive_x && next->x < x && x < v[i].x) {
+			*idx = i;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static guint loop_find_root(guint *parent, guint idx)
+{
+	while (parent[idx] != idx) {
+		parent[idx] = parent[parent[idx]];
+		idx = parent[idx];
+	}
+
+	return idx;
+}
+
+/**
+ * @brief Insert a hole into a contour
+ * @param target Contour to insert into
+ * @param target_idx Start index of the edge the cut ends on
+ * @param hole Hole
+ * @param hole_idx Start index of the edge the cut starts on
+ * @param x x coordinate of the cut
+ * @param y_hole y coordinate of the cut's start
+ * @param y_target y coordinate of the cut's end
+ */
+static void splice_hole(GArray *target, guint target_idx, const GArray *hole, guint hole_idx, double x,
+			double y_hole, double y_target)
+{
+	GArray *insert;
+	struct vector_2d pt;
+	guint i;
+
+	insert = g_array_sized_new(FALSE, FALSE, sizeof(struct vector_2d), hole->len + 4);
+
+	pt.x = x;
+	pt.y = y_target;
+	g_array_append_val(insert, pt);
+	pt.y = y_hole;
+	g_array_append_val(insert, pt);
+	for (i = 1; i <= hole->len; i++)
+		g_array_append_val(insert, g_array_index(hole, struct vector_2d, (hole_idx + i) % hole->len));
+	g_array_append_val(insert, pt);
+	pt.y = y_target;
+	g_array_append_val(insert, pt);
+
+	g_array_insert_vals(target, target_idx + 1, insert->data, insert->len);
+	g_array_free(insert, TRUE);
+}
+
+/**
+ * @brief Connect all holes to their surrounding contours
+ *
+ * Holes are processed from top to bottom. A cut always ends on a contour below the hole.
+ * This contour is either an outer contour or a hole that is processed later.
+ *
+ * @param loops Contours
+ * @param set Slabs
+ * @param[out] parent Contour each contour has been merged into. Index of itself if it has not been merged
+ * @return 0 if successful
+ */
+static int connect_holes(GPtrArray *loops, const struct slab_set *set, guint *parent)
+{
+	static const double cut_positions[] = {0.5, 0.25, 0.75, 0.125, 0.375, 0.625, 0.875};
+	GArray *holes;
+	GArray *refs;
+	GArray *loop;
+	const struct vector_2d *v;
+	const struct vector_2d *next;
+	struct hole hole;
+	struct edge_ref ref;
+	struct hole *h;
+	guint i, j, k;
+	guint root, hole_idx;
+	guint target_root = 0, target_idx = 0;
+	double x = 0.0, y_target = 0.0;
+	gboolean found;
+	int ret = 0;
+
+	holes = g_array_new(FALSE, FALSE, sizeof(struct hole));
+	refs = g_array_new(FALSE, FALSE, sizeof(struct edge_ref));
+
+	for (i = 0; i < loops->len; i++) {
+		parent[i] = i;
+		loop = (GArray *)g_ptr_array_index(loops, i);
+		v = (const struct vector_2d *)loop->data;
+
+		hole.loop = i;
+		hole.y = G_MAXDOUBLE;
+		for (j = 0; j < loop->len; j++) {
+			next = &v[(j + 1) % loop->len];
+			if (v[j].y != next->y)
+				continue;
+
+			if (next->x > v[j].x) {
+				/* Covered area above */
+				ref.y = v[j].y;
+				ref.loop = i;
+				g_array_append_val(refs, ref);
+			} else if (v[j].y < hole.y) {
+				/* Covered area below */
+				hole.y = v[j].y;
+				hole.x_left = next->x;
+				hole.x_right = v[j].x;
+			}
+		}
+
+		if (signed_area(v, loop->len) < 0.0)
+			g_array_append_val(holes, hole);
+	}
+
+	g_array_sort(holes, compare_hole_descending);
+	g_array_sort(refs, compare_edge_ref);
+
+	for (i = 0; i < holes->len && !ret; i++) {
+		h = &g_array_index(holes, struct hole, i);
+		if (h->y == G_MAXDOUBLE) {
+			ret = -1;
+			break;
+		}
+
+		found = FALSE;
+		for (k = 0; k < G_N_ELEMENTS(cut_positions) && !found; k++) {
+			x = h->x_left + (h->x_right - h->x_left) * cut_positions[k];
+			found = (find_cut_target(set, x, h->y, &y_target) == 0);
+		}
+		if (!found) {
+			ret = -1;
+			break;
+		}
+
+		/* Find the contour the cut ends on */
+		for (j = 0; j < refs->len && g_array_index(refs, struct edge_ref, j).y < y_target; j++)
+			;
+		found = FALSE;
+		for (; j < refs->len && g_array_index(refs, struct edge_ref, j).y == y_target && !found; j++) {
+			target_root = loop_find_root(parent, g_array_index(refs, struct edge_ref, j).loop);
+			found = loop_find_horizontal_edge((GArray *)g_ptr_array_index(loops, target_root), y_target, x,
+							  TRUE, &target_idx);
+		}
+
+		root = loop_find_root(parent, h->loop);
+		if (!found || target_root == root ||
+		    !loop_find_horizontal_edge((GArray *)g_ptr_array_index(loops, root), h->y, x, FALSE, &hole_idx)) {
+			ret = -1;
+			break;
+		}
+
+		splice_hole((GArray *)g_ptr_array_index(loops, target_root), target_idx,
+			    (GArray *)g_ptr_array_index(loops, root), hole_idx, x, h->y, y_target);
+		parent[root] = target_root;
+	}
+
+	g_array_free(refs, TRUE);
+	g_array_free(holes, TRUE);
+
+	return ret;
+}
+
+static void append_primitive(struct flat_layer *out, const struct flat_primitive *prim, const struct vector_2d *v)
+{
+	struct flat_primitive copy = *prim;
+
+	copy.first_vertex = out->vertices->len;
+	g_array_append_vals(out->vertices, v, prim->vertex_count);
+	g_array_append_val(out->primitives, copy);
+}
+
+int polygon_union_merge_layer(const struct flat_layer *in, struct flat_layer *out)
+{
+	GArray *sweep_edges;
+	GArray *boundary;
+	GArray *keep;
+	GPtrArray *loops = NULL;
+	GArray *loop;
+	guint *parent = NULL;
+	struct slab_set slabs;
+	const struct flat_primitive *prim;
+	struct flat_primitive merged;
+	const struct vector_2d *v;
+	double area;
+	guint i;
+	int ret = 0;
+
+	if (!in || !out)
+		return -1;
+
+	sweep_edges = g_array_new(FALSE, FALSE, sizeof(struct scanline_edge));
+	keep = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	for (i = 0; i < in->primitives->len; i++) {
+		prim = &g_array_index(in->primitives, struct flat_primitive, i);
+		v = &g_array_index(in->vertices, struct vector_2d, prim->first_vertex);
+
+		if (prim->gfx_type == GRAPHIC_PATH || !rectangle_decomposition_is_rectilinear(v, prim->vertex_count)) {
+			g_array_append_val(keep, i);
+			continue;
+		}
+
+		/* Shapes without area are dropped */
+		area = signed_area(v, prim->vertex_count);
+		if (area != 0.0)
+			add_sweep_edges(sweep_edges, v, prim->vertex_count, (area > 0.0 ? 1 : -1));
+	}
+
+	slab_set_build(&slabs, sweep_edges);
+	boundary = g_array_new(FALSE, FALSE, sizeof(struct boundary_edge));
+	collect_boundary_edges(&slabs, boundary);
+
+	loops = trace_loops(boundary);
+	if (!loops) {
+		ret = -2;
+		goto free_slabs;
+	}
+
+	parent = g_new(guint, loops->len + 1);
+	if (connect_holes(loops, &slabs, parent)) {
+		ret = -3;
+		goto free_slabs;
+	}
+
+	out->layer = in->layer;
+	out->primitives = g_array_new(FALSE, FALSE, sizeof(struct flat_primitive));
+	out->vertices = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+
+	for (i = 0; i < keep->len; i++) {
+		prim = &g_array_index(in->primitives, struct flat_primitive, g_array_index(keep, guint, i));
+		append_primitive(out, prim, &g_array_index(in->vertices, struct vector_2d, prim->first_vertex));
+	}
+
+	merged.gfx_type = GRAPHIC_POLYGON;
+	merged.path_render_type = PATH_FLUSH;
+	merged.width = 0.0;
+	for (i = 0; i < loops->len; i++) {
+		if (parent[i] != i)
+			continue;
+		loop = (GArray *)g_ptr_array_index(loops, i);
+		if (loop->len < 3)
+			continue;
+		merged.vertex_count = loop->len;
+		append_primitive(out, &merged, (const struct vector_2d *)loop->data);
+	}
+
+free_slabs:
+	g_free(parent);
+	if (loops)
+		g_ptr_array_free(loops, TRUE);
+	g_array_free(boundary, TRUE);
+	slab_set_free(&slabs);
+	g_array_free(keep, TRUE);
+	g_array_free(sweep_edges, TRUE);
+
+	return ret;
+}
+
+static void merge_job_run(gpointer data, gpointer user_data)
+{
+	struct merge_job *job = (struct merge_job *)data;
+
+	(void)user_data;
+
+	job->status = polygon_union_merge_layer(job->layer, &job->result);
+}
+
+int polygon_union_merge_scene(struct flat_scene *scene, unsigned int thread_count)
+{
+	struct merge_job *jobs;
+	struct flat_layer *lay;
+	GThreadPool *pool;
+	guint i;
+
+	if (!scene)
+		return -1;
+
+	if (thread_count == 0)
+		thread_count = g_get_num_processors();
+
+	jobs = g_new0(struct merge_job, scene->layers->len + 1);
+	pool = g_thread_pool_new(merge_job_run, NULL, (gint)thread_count, FALSE, NULL);
+	for (i = 0; i < scene->layers->len; i++) {
+		jobs[i].layer = &g_array_index(scene->layers, struct flat_layer, i);
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	scene->primitive_count = 0ULL;
+	scene->vertex_count = 0ULL;
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = jobs[i].layer;
+		if (jobs[i].status == 0) {
+			g_array_free(lay->primitives, TRUE);
+			g_array_free(lay->vertices, TRUE);
+			lay->primitives = jobs[i].result.primitives;
+			lay->vertices = jobs[i].result.vertices;
+		}
+		scene->primitive_count += lay->primitives->len;
+		scene->vertex_count += lay->vertices->len;
+	}
+
+	g_free(jobs);
+
+	return 0;
+}
+
+/** @} */
@@ -0,0 +1,235 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file rectangle-decomposition.c
+ * @brief Decomposition of rectilinear polygons into rectangles
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The polygon is swept in one direction. Between two consecutive edge coordinates the covered
+ * intervals are constant. An interval that continues unchanged into the next band extends the
+ * rectangle it belongs to instead of starting a new one.
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <gds-render/geometric/rectangle-decomposition.h>
+#include <gds-render/geometric/scanline.h>
+
+/**
+ * @brief Rectangle that is still extended by the sweep
+ */
+struct open_rect {
+	double low; /**< @brief Lower end across the sweep direction */
+	double high; /**< @brief Upper end across the sweep direction */
+	double start; /**< @brief Start along the sweep direction */
+};
+
+gboolean rectangle_decomposition_is_rectilinear(const struct vector_2d *v, size_t count)
+{
+	size_t i;
+	const struct vector_2d *next;
+
+	if (!v || count < 3)
+		return FALSE;
+
+	for (i = 0; i < count; i++) {
+		next = &v[(i + 1) % count];
+		if (v[i].x != next->x && v[i].y != next->y)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * @brief Emit a finished rectangle
+ * @param rects Array of #bounding_box
+ * @param rect Open rectangle
+ * @param end End along the sweep direction
+ * @param transpose The sweep runs along the x axis
+ */
+static void close_rect(GArray *rects, const struct open_rect *rect, double end, gboolean transpose)
+{
+	union bounding_box box;
+
+	if (transpose) {
+		box.vectors.lower_left.x = rect->start;
+		box.vectors.lower_left.y = rect->low;
+		box.vectors.upper_right.x = end;
+		box.vectors.upper_right.y = rect->high;
+	} else {
+		box.vectors.lower_left.x = rect->low;
+		box.vectors.lower_left.y = rect->start;
+		box.vectors.upper_right.x = rect->high;
+		box.vectors.upper_right.y = end;
+	}
+
+	g_array_append_val(rects, box);
+}
+
+/**
+ * @brief Sweep over a rectilinear polygon and emit its rectangles
+ * @param v Vertices
+ * @param count Vertex count
+ * @param transpose Sweep along the x axis instead of the y axis
+ * @param[out] rects Array of #bounding_box
+ */
+static void decompose(const struct vector_2d *v, size_t count, gboolean transpose, GArray *rects)
+{
+	GArray *edges;
+	GArray *coords;
+	GArray *active;
+	GArray *intervals;
+	GArray *open;
+	GArray *next_open;
+	GArray *swap;
+	struct scanline_edge edge;
+	const struct open_rect *rect;
+	const struct scanline_interval *ival;
+	struct open_rect new_rect;
+	const struct vector_2d *next;
+	double a_pos, a_sweep, b_pos, b_sweep;
+	double s;
+	size_t i;
+	guint j, band, o;
+	guint next_edge = 0;
+
+	edges = g_array_new(FALSE, FALSE, sizeof(struct scanline_edge));
+	for (i = 0; i < count; i++) {
+		next = &v[(i + 1) % count];
+		a_pos = (transpose ? v[i].y : v[i].x);
+		a_sweep = (transpose ? v[i].x : v[i].y);
+		b_pos = (transpose ? next->y : next->x);
+		b_sweep = (transpose ? next->x : next->y);
+		if (a_pos != b_pos || a_sweep == b_sweep)
+			continue;
+
+		edge.pos = a_pos;
+		edge.low = MIN(a_sweep, b_sweep);
+		edge.high = MAX(a_sweep, b_sweep);
+		edge.dir = (b_sweep > a_sweep ? 1 : -1);
+		g_array_append_val(edges, edge);
+	}
+
+	coords = scanline_prepare(edges);
+	active = g_array_new(FALSE, FALSE, sizeof(struct scanline_edge));
+	intervals = g_array_new(FALSE, FALSE, sizeof(struct scanline_interval));
+	open = g_array_new(FALSE, FALSE, sizeof(struct open_rect));
+	next_open = g_array_new(FALSE, FALSE, sizeof(struct open_rect));
+
+	for (band = 0; band + 1 < coords->len; band++) {
+		s = g_array_index(coords, double, band);
+		if (!scanline_update_active(edges, &next_edge, active, s))
+			continue;
+
+		scanline_compute_intervals(active, intervals);
+
+		/* Both lists are sorted. Continue equal intervals, close the others */
+		g_array_set_size(next_open, 0);
+		for (o = 0, j = 0; o < open->len || j < intervals->len;) {
+			rect = (o < open->len ? &g_array_index(open, struct open_rect, o) : NULL);
+			ival = (j < intervals->len ? &g_array_index(intervals, struct scanline_interval, j) : NULL);
+
+			if (rect && ival && rect->low == ival->low && rect->high == ival->high) {
+				g_array_append_val(next_open, *rect);
+				o++;
+				j++;
+			} else if (rect && (!ival || rect->low <= ival->low)) {
+				close_rect(rects, rect, s, transpose);
+				o++;
+			} else {
+				new_rect.low = ival->low;
+				new_rect.high = ival->high;
+				new_rect.start = s;
+				g_array_append_val(next_open, new_rect);
+				j++;
+			}
+		}
+
+		swap = open;
+		open = next_open;
+		next_open = swap;
+	}
+
+	if (coords->len > 0) {
+		s = g_array_index(coords, double, coords->len - 1);
+		for (o = 0; o < open->len; o++)
+			close_rect(rects, &g_array_index(open, struct open_rect, o), s, transpose);
+	}
+
+	g_array_free(next_open, TRUE);
+	g_array_free(open, TRUE);
+	g_array_free(intervals, TRUE);
+	g_array_free(active, TRUE);
+	g_array_free(coords, TRUE);
+	g_array_free(edges, TRUE);
+}
+
+int rectangle_decomposition_calculate(const struct vector_2d *v, size_t count, GArray *rects)
+{
+	GArray *transposed;
+	guint start;
+
+	if (!rects || !rectangle_decomposition_is_rectilinear(v, count))
+		return -1;
+
+	start = rects->len;
+	decompose(v, count, FALSE, rects);
+
+	/* A single rectangle cannot be improved */
+	if (rects->len - start <= 1)
+		return 0;
+
+	transposed = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+	decompose(v, count, TRUE, transposed);
+	if (transposed->len < rects->len - start) {
+		g_array_set_size(rects, start);
+		g_array_append_vals(rects, transposed->data, transposed->len);
+	}
+	g_array_free(transposed, TRUE);
+
+	return 0;
+}
+
+int rectangle_decomposition_calculate_from_gfx(const struct gds_graphics *gfx, GArray *rects)
+{
+	struct vector_2d *points;
+	size_t idx;
+	int ret;
+
+	if (!gfx || !rects || (gfx->gfx_type != GRAPHIC_BOX && gfx->gfx_type != GRAPHIC_POLYGON))
+		return -1;
+
+	points = g_new(struct vector_2d, gfx->vertex_count + 1);
+	for (idx = 0; idx < gfx->vertex_count; idx++) {
+		points[idx].x = (double)gfx->vertex_array[idx].x;
+		points[idx].y = (double)gfx->vertex_array[idx].y;
+	}
+
+	ret = rectangle_decomposition_calculate(points, gfx->vertex_count, rects);
+	g_free(points);
+
+	return ret;
+}
+
+/** @} */
@@ -0,0 +1,138 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file scanline.c
+ * @brief Sweep over the axis parallel edges of rectilinear shapes
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#include <gds-render/geometric/scanline.h>
+
+gint scanline_compare_double(gconstpointer a, gconstpointer b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+
+	return (da > db) - (da < db);
+}
+
+static gint compare_edge_low(gconstpointer a, gconstpointer b)
+{
+	return scanline_compare_double(&((const struct scanline_edge *)a)->low,
+				       &((const struct scanline_edge *)b)->low);
+}
+
+static gint compare_edge_pos(gconstpointer a, gconstpointer b)
+{
+	return scanline_compare_double(&((const struct scanline_edge *)a)->pos,
+				       &((const struct scanline_edge *)b)->pos);
+}
+
+GArray *scanline_prepare(GArray *edges)
+{
+	GArray *coords;
+	const struct scanline_edge *e;
+	double s;
+	guint i, j;
+
+	coords = g_array_sized_new(FALSE, FALSE, sizeof(double), edges->len * 2);
+	for (i = 0; i < edges->len; i++) {
+		e = &g_array_index(edges, struct scanline_edge, i);
+		g_array_append_val(coords, e->low);
+		g_array_append_val(coords, e->high);
+	}
+	g_array_sort(coords, scanline_compare_double);
+	for (i = 0, j = 0; i < coords->len; i++) {
+		s = g_array_index(coords, double, i);
+		if (j == 0 || g_array_index(coords, double, j - 1) != s)
+			g_array_index(coords, double, j++) = s;
+	}
+	g_array_set_size(coords, j);
+
+	g_array_sort(edges, compare_edge_low);
+
+	return coords;
+}
+
+gboolean scanline_update_active(const GArray *edges, guint *next_edge, GArray *active, double s)
+{
+	const struct scanline_edge *e;
+	gboolean changed = FALSE;
+	guint i, j;
+
+	/* Remove edges ending at this band */
+	for (i = 0, j = 0; i < active->len; i++) {
+		e = &g_array_index(active, struct scanline_edge, i);
+		if (e->high > s)
+			g_array_index(active, struct scanline_edge, j++) = *e;
+	}
+	if (j != active->len) {
+		g_array_set_size(active, j);
+		changed = TRUE;
+	}
+
+	/* Add edges starting at this band */
+	for (; *next_edge < edges->len; (*next_edge)++) {
+		e = &g_array_index(edges, struct scanline_edge, *next_edge);
+		if (e->low > s)
+			break;
+		g_array_append_val(active, *e);
+		changed = TRUE;
+	}
+
+	if (changed)
+		g_array_sort(active, compare_edge_pos);
+
+	return changed;
+}
+
+void scanline_compute_intervals(const GArray *active, GArray *intervals)
+{
+	const struct scanline_edge *edges = (const struct scanline_edge *)active->data;
+	struct scanline_interval ival;
+	guint i = 0;
+	int winding = 0;
+	int before;
+	double pos;
+
+	g_array_set_size(intervals, 0);
+	ival.low = 0.0;
+
+	while (i < active->len) {
+		pos = edges[i].pos;
+		before = winding;
+		for (; i < active->len && edges[i].pos == pos; i++)
+			winding += edges[i].dir;
+
+		if (before == 0 && winding != 0) {
+			ival.low = pos;
+		} else if (before != 0 && winding == 0) {
+			ival.high = pos;
+			g_array_append_val(intervals, ival);
+		}
+	}
+}
+
+/** @} */
@@ -30,6 +30,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <float.h>
 
 #include <gds-render/geometric/vector-operations.h>
 
@@ -147,4 +148,145 @@ void vector_2d_add(struct vector_2d *res, struct vector_2d *a, struct vector_2d
 	}
 }
 
+void affine_2d_init_identity(struct affine_2d *mat)
+{
+	if (!mat)
+		return;
+
+	mat->xx = 1.0;
+	mat->yx = 0.0;
+	mat->xy = 0.0;
+	mat->yy = 1.0;
+	mat->x0 = 0.0;
+	mat->y0 = 0.0;
+}
+
+void affine_2d_init_transform(struct affine_2d *mat, double scale, double rotation_deg, bool flip_at_x,
+			      double x0, double y0)
+{
+	double sin_val, cos_val;
+	double flip = (flip_at_x ? -1.0 : 1.0);
+
+	if (!mat)
+		return;
+
+	sin_val = sin(DEG2RAD(rotation_deg));
+	cos_val = cos(DEG2RAD(rotation_deg));
+
+	mat->xx = scale * cos_val;
+	mat->yx = scale * sin_val;
+	mat->xy = -scale * sin_val * flip;
+	mat->yy = scale * cos_val * flip;
+	mat->x0 = x0;
+	mat->y0 = y0;
+}
+
+void affine_2d_multiply(struct affine_2d *res, const struct affine_2d *a, const struct affine_2d *b)
+{
+	struct affine_2d temp;
+
+	if (!res || !a || !b)
+		return;
+
+	temp.xx = a->xx * b->xx + a->xy * b->yx;
+	temp.yx = a->yx * b->xx + a->yy * b->yx;
+	temp.xy = a->xx * b->xy + a->xy * b->yy;
+	temp.yy = a->yx * b->xy + a->yy * b->yy;
+	temp.x0 = a->xx * b->x0 + a->xy * b->y0 + a->x0;
+	temp.y0 = a->yx * b->x0 + a->yy * b->y0 + a->y0;
+
+	*res = temp;
+}
+
+void affine_2d_apply(const struct affine_2d *mat, struct vector_2d *vec)
+{
+	double x;
+
+	if (!mat || !vec)
+		return;
+
+	x = vec->x;
+	vec->x = mat->xx * x + mat->xy * vec->y + mat->x0;
+	vec->y = mat->yx * x + mat->yy * vec->y + mat->y0;
+}
+
+/*
+ * The array functions below are written as simple loops over independent elements,
+ * so the compiler is able to vectorize them.
+ */
+
+void vector_2d_array_transform(const struct affine_2d *mat, const struct vector_2d *in, struct vector_2d *out,
+			       size_t count)
+{
+	double xx, yx, xy, yy, x0, y0;
+	double x, y;
+	size_t i;
+
+	if (!mat || !in || !out)
+		return;
+
+	xx = mat->xx;
+	yx = mat->yx;
+	xy = mat->xy;
+	yy = mat->yy;
+	x0 = mat->x0;
+	y0 = mat->y0;
+
+	for (i = 0; i < count; i++) {
+		x = in[i].x;
+		y = in[i].y;
+		out[i].x = xx * x + xy * y + x0;
+		out[i].y = yx * x + yy * y + y0;
+	}
+}
+
+void vector_2d_array_min_max(const struct vector_2d *vecs, size_t count, struct vector_2d *min,
+			     struct vector_2d *max)
+{
+	double xmin = DBL_MAX, ymin = DBL_MAX, xmax = -DBL_MAX, ymax = -DBL_MAX;
+	size_t i;
+
+	if (!min || !max)
+		return;
+
+	for (i = 0; vecs && i < count; i++) {
+		xmin = (vecs[i].x < xmin ? vecs[i].x : xmin);
+		ymin = (vecs[i].y < ymin ? vecs[i].y : ymin);
+		xmax = (vecs[i].x > xmax ? vecs[i].x : xmax);
+		ymax = (vecs[i].y > ymax ? vecs[i].y : ymax);
+	}
+
+	min->x = xmin;
+	min->y = ymin;
+	max->x = xmax;
+	max->y = ymax;
+}
+
+void vector_2d_array_normalize(struct vector_2d *vecs, size_t count)
+{
+	double len;
+	size_t i;
+
+	if (!vecs)
+		return;
+
+	for (i = 0; i < count; i++) {
+		len = sqrt(vecs[i].x * vecs[i].x + vecs[i].y * vecs[i].y);
+		vecs[i].x = vecs[i].x / len;
+		vecs[i].y = vecs[i].y / len;
+	}
+}
+
+void vector_2d_array_cross_product(const struct vector_2d *a, const struct vector_2d *b, double *res,
+				   size_t count)
+{
+	size_t i;
+
+	if (!a || !b || !res)
+		return;
+
+	for (i = 0; i < count; i++)
+		res[i] = a[i].x * b[i].y - a[i].y * b[i].x;
+}
+
 /** @} */
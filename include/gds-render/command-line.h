@@ -48,6 +48,26 @@ struct external_renderer_params {
 	char *cli_params;
 };
 
+/**
+ * @brief Page parameters of the tiled PDF renderer
+ */
+struct tiled_pdf_params {
+	/**
+	 * @brief Page width in mm
+	 */
+	double page_width;
+
+	/**
+	 * @brief Page height in mm
+	 */
+	double page_height;
+
+	/**
+	 * @brief Length on paper per length in the layout. 0 uses the render scale
+	 */
+	double plot_scale;
+};
+
 /**
  * @brief Convert GDS according to command line parameters
  * @param gds_name Path to GDS File
@@ -58,6 +78,10 @@ struct external_renderer_params {
  * @param ext_param Settings for external library renderer
  * @param tex_standalone Standalone TeX
  * @param tex_layers TeX OCR layers
+ * @param merge_shapes Flatten the cell and merge overlapping shapes of each layer
+ * @param simplify_tolerance Maximum deviation of simplified shapes in output units. 0 disables simplification
+ * @param dpi Resolution of raster outputs in pixels per inch
+ * @param page_params Page parameters of tiled PDF output
  * @param scale Scale value
  * @return Error code, 0 if successful
  */
@@ -69,8 +93,36 @@ int command_line_convert_gds(const char *gds_name,
 			     struct external_renderer_params *ext_param,
 			     gboolean tex_standalone,
 			     gboolean tex_layers,
+			     gboolean merge_shapes,
+			     double simplify_tolerance,
+			     double dpi,
+			     const struct tiled_pdf_params *page_params,
 			     double scale);
 
+/**
+ * @brief Print the estimated rendering cost of a cell without rendering it
+ * @param gds_name Path to GDS File
+ * @param cell_name Cell name
+ * @return Error code, 0 if successful
+ */
+int command_line_estimate_gds(const char *gds_name, const char *cell_name);
+
+/**
+ * @brief Calculate the per layer coverage of a cell on a raster of tiles
+ *
+ * If \p output_file ends with .png, a grayscale image with one pixel per tile is written for each layer.
+ * Otherwise, the coverage of all layers is written to \p output_file as CSV.
+ *
+ * @param gds_name Path to GDS File
+ * @param cell_name Cell name
+ * @param output_file Output file
+ * @param columns Number of tiles in x direction
+ * @param rows Number of tiles in y direction
+ * @return Error code, 0 if successful
+ */
+int command_line_density_map(const char *gds_name, const char *cell_name, const char *output_file,
+			     unsigned int columns, unsigned int rows);
+
 #endif /* _COMMAND_LINE_H_ */
 
 /** @} */
@@ -0,0 +1,63 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-serialize.h
+ * @brief Binary image of a cell hierarchy for other processes (Header)
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#ifndef _GDS_SERIALIZE_H_
+#define _GDS_SERIALIZE_H_
+
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+/**
+ * @brief Serialize a cell and all cells it references
+ *
+ * The image uses the native byte order and structure layout. It is only meant to be read by
+ * the same build of this program, e.g. by a worker process.
+ *
+ * @param cell Top cell
+ * @param[out] data The image is appended to this array
+ * @return 0 if successful, -1 in case of invalid parameters, -2 if \p cell is affected by a reference loop
+ */
+int gds_serialize_cell(struct gds_cell *cell, GByteArray *data);
+
+/**
+ * @brief Rebuild a cell hierarchy from its image
+ *
+ * The library contains all cells of the image. All references are resolved.
+ *
+ * @param data Image created by gds_serialize_cell()
+ * @param length Length of \p data in bytes
+ * @param[out] top_cell The top cell of the image
+ * @return New library or NULL if the image is invalid. Free with clear_lib_list()
+ */
+struct gds_library *gds_deserialize_library(const void *data, size_t length, struct gds_cell **top_cell);
+
+#endif /* _GDS_SERIALIZE_H_ */
+
+/** @} */
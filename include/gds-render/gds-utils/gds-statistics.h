@@ -0,0 +1,78 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-statistics.h
+ * @brief Estimate the rendering cost of a cell (Header)
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#ifndef _GDS_STATISTICS_H_
+#define _GDS_STATISTICS_H_
+
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+/**
+ * @brief Flattened counts of a single layer
+ */
+struct gds_layer_statistics {
+	int layer; /**< @brief Layer number */
+	guint64 primitive_count; /**< @brief Number of graphics objects on this layer */
+	guint64 vertex_count; /**< @brief Number of vertices on this layer */
+};
+
+/**
+ * @brief Flattened counts of a cell including all of its sub cells
+ *
+ * All counts saturate at G_MAXUINT64.
+ */
+struct gds_cell_statistics {
+	guint64 primitive_count; /**< @brief Number of graphics objects */
+	guint64 vertex_count; /**< @brief Number of vertices */
+	guint64 instance_count; /**< @brief Number of cell instances */
+	GArray *layers; /**< @brief Array of #gds_layer_statistics sorted by ascending layer number */
+};
+
+/**
+ * @brief Calculate the flattened statistics of a cell
+ *
+ * The statistics of every unique cell are only calculated once.
+ * Instances without a resolved cell reference are ignored.
+ *
+ * @param cell Cell. Must be part of a library
+ * @param[out] stats Statistics. Must be freed with gds_statistics_free()
+ * @return 0 if successful, -1 if \p cell is invalid, -2 if it is affected by a reference loop
+ */
+int gds_statistics_calculate(struct gds_cell *cell, struct gds_cell_statistics *stats);
+
+/**
+ * @brief Free the contents of a statistics struct
+ * @param stats Statistics
+ */
+void gds_statistics_free(struct gds_cell_statistics *stats);
+
+#endif /* _GDS_STATISTICS_H_ */
+
+/** @} */
@@ -0,0 +1,93 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gds-topology.h
+ * @brief Cached topological order of the cells of a library (Header)
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup GDS-Utilities
+ * @{
+ */
+
+#ifndef _GDS_TOPOLOGY_H_
+#define _GDS_TOPOLOGY_H_
+
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+/**
+ * @brief Cell hierarchy of a library
+ *
+ * Only resolved references between cells of the same library are considered.
+ * Cells that are part of or reference a reference loop cannot be ordered. They are
+ * not contained in gds_library_topology::bottom_up.
+ */
+struct gds_library_topology {
+	GPtrArray *bottom_up; /**< @brief Cells ordered such that each cell follows all cells it references */
+	GList *top_cells; /**< @brief Cells not referenced by any other cell of the library */
+	GHashTable *depth; /**< @brief Internal. Use gds_topology_get_cell_depth() */
+	gboolean has_loops; /**< @brief The library contains reference loops */
+};
+
+/**
+ * @brief Get the topology of a library
+ *
+ * The topology is calculated on first use and cached in gds_library::topology.
+ *
+ * @param lib Library
+ * @return Topology or NULL if \p lib is NULL. Valid until gds_topology_invalidate() is called
+ */
+const struct gds_library_topology *gds_topology_get(struct gds_library *lib);
+
+/**
+ * @brief Invalidate the cached topology of a library
+ *
+ * This has to be called whenever cells or references of the library are modified.
+ *
+ * @param lib Library
+ */
+void gds_topology_invalidate(struct gds_library *lib);
+
+/**
+ * @brief Get the depth of a cell in the hierarchy
+ *
+ * The depth is the length of the longest reference chain from a top cell to this cell.
+ * Top cells have depth 0.
+ *
+ * @param lib Library
+ * @param cell Cell
+ * @return Depth or -1 if the cell is not part of the library or affected by a reference loop
+ */
+int gds_topology_get_cell_depth(struct gds_library *lib, const struct gds_cell *cell);
+
+/**
+ * @brief Get all cells reachable from a cell
+ * @param lib Library containing \p top_cell
+ * @param top_cell Cell to start from
+ * @return Array of #gds_cell in bottom-up order. \p top_cell is the last element.
+ *	   NULL if \p top_cell is affected by a reference loop. Free with g_ptr_array_free()
+ */
+GPtrArray *gds_topology_get_reachable_cells(struct gds_library *lib, struct gds_cell *top_cell);
+
+#endif /* _GDS_TOPOLOGY_H_ */
+
+/** @} */
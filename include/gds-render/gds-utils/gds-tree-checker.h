@@ -50,12 +50,31 @@ int gds_tree_check_cell_references(struct gds_library *lib);
 
 /**
  * @brief gds_tree_check_reference_loops checks if the given library contains reference loops
+ *
+ * A cell is flagged if it is part of a loop or references a cell that is. All cells and references
+ * are visited once, so the run time is linear in the size of the library.
+ *
  * @param lib GDS library
  * @return negative if an error occured, zero if there are no reference loops, else a positive number representing the number
  *         of affected cells
  */
 int gds_tree_check_reference_loops(struct gds_library *lib);
 
+/**
+ * @brief Count how often each cell is placed in the flattened top cell
+ *
+ * The counts are stored in gds_cell_checks::instance_count of all cells in \p lib.
+ * They are calculated in a single pass over the cells in top-down order: each cell passes its own
+ * count to every cell it instantiates. The counts saturate at G_MAXUINT64.
+ *
+ * @param lib GDS library
+ * @param top_cell Top cell to count from. It has a count of 1. If NULL, the counts of all top cells
+ *		   of the library (cells that are not instantiated) are added up
+ * @return 0 if successful, negative if an error occured or \p top_cell is affected by a reference loop.
+ *	   References made by cells affected by a loop are not counted.
+ */
+int gds_tree_check_instance_counts(struct gds_library *lib, struct gds_cell *top_cell);
+
 #endif /* _GDS_TREE_CHECKER_H_ */
 
 /** @} */
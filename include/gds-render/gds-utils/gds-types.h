@@ -32,6 +32,7 @@
 #define __GDS_TYPES_H__
 
 #include <stdint.h>
+#include <stddef.h>
 #include <glib.h>
 
 #define CELL_NAME_MAX (100) /**< @brief Maximum length of a gds_cell::name or a gds_library::name */
@@ -71,6 +72,7 @@ struct gds_point {
 struct gds_cell_checks {
 	int unresolved_child_count; /**< @brief Number of unresolved cell instances inside this cell. Default: @ref GDS_CELL_CHECK_NOT_RUN */
 	int affected_by_reference_loop; /**< @brief 1 if the cell is affected by a reference loop and therefore not renderable. Default: @ref GDS_CELL_CHECK_NOT_RUN*/
+	uint64_t instance_count; /**< @brief Number of placements of this cell in the flattened top cell(s). Set by gds_tree_check_instance_counts() */
 	/**
 	 * @brief For the internal use of the checker.
 	 * @warning Do not use this structure and its contents!
@@ -97,7 +99,8 @@ struct gds_time_field {
  */
 struct gds_graphics {
 	enum graphics_type gfx_type; /**< \brief Type of graphic */
-	GList *vertices; /**< @brief List of #gds_point */
+	struct gds_point *vertex_array; /**< @brief Vertices. Allocated with malloc(). May be NULL if there are none */
+	size_t vertex_count; /**< @brief Number of points in gds_graphics::vertex_array */
 	enum path_type path_render_type; /**< @brief Line cap */
 	int width_absolute; /**< @brief Width. Not used for objects other than paths */
 	int16_t layer; /**< @brief Layer the graphic object is on */
@@ -129,6 +132,8 @@ struct gds_cell {
 	struct gds_cell_checks checks; /**< @brief Checking results */
 };
 
+struct gds_library_topology;
+
 /**
  * @brief GDS Toplevel library
  */
@@ -139,6 +144,7 @@ struct gds_library {
 	double unit_in_meters;  /**< Length of a database unit in meters */
 	GList *cells; /**< List of #gds_cell that contains all cells in this library*/
 	GList *cell_names /**< List of strings that contains all cell names */;
+	struct gds_library_topology *topology; /**< @brief Cached cell hierarchy. NULL if not calculated. Use gds_topology_get() */
 };
 
 /** @} */
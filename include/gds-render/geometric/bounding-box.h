@@ -34,6 +34,9 @@
 #include <glib.h>
 #include <gds-render/geometric/vector-operations.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+struct gds_point;
 
 /**
  * @brief Union describing a bounding box
@@ -83,6 +86,19 @@ typedef void (*conv_generic_to_vector_2d_t)(void *, struct vector_2d *);
  */
 void bounding_box_calculate_from_polygon(GList *vertices, conv_generic_to_vector_2d_t conv_func, union bounding_box *box);
 
+/**
+ * @brief Calculate bounding box of a contiguous array of integer points
+ *
+ * The minimum and maximum are calculated on integers using the widest SIMD instruction set
+ * supported by the executing CPU (AVX2, SSE4.1 or NEON). The selection is done at runtime.
+ *
+ * @param points Array of points
+ * @param count Number of points
+ * @param box Box to write to. This box is not updated! All previous data is discarded.
+ *	      If \p count is 0, the box is prepared empty.
+ */
+void bounding_box_calculate_from_int_points(const struct gds_point *points, size_t count, union bounding_box *box);
+
 /**
  * @brief Update an exisitng bounding box with another one.
  * @param destination Target box to update
@@ -49,6 +49,32 @@
  */
 void calculate_cell_bounding_box(union bounding_box *box, struct gds_cell *cell);
 
+/**
+ * @brief Calculate the bounding boxes of a cell and all of its sub cells
+ *
+ * Each box is given in the coordinates of its own cell. Every cell is only calculated once,
+ * regardless of its instance count.
+ *
+ * @param cell Toplevel cell
+ * @return Hash table mapping each #gds_cell to its #bounding_box. NULL if \p cell is affected by a
+ *	   reference loop. Free with g_hash_table_destroy()
+ */
+GHashTable *calculate_cell_bounding_boxes(struct gds_cell *cell);
+
+/**
+ * @brief Calculate the bounding boxes of a cell and all of its sub cells, restricted to some layers
+ *
+ * Same as calculate_cell_bounding_boxes(), but only graphics on the given layers are included.
+ * Cells without any graphics on these layers have an empty box (see bounding_box_prepare_empty()).
+ *
+ * @param cell Toplevel cell
+ * @param layers Array of layer numbers to include. NULL includes all layers
+ * @param layer_count Number of entries in \p layers
+ * @return Hash table mapping each #gds_cell to its #bounding_box. NULL if \p cell is affected by a
+ *	   reference loop. Free with g_hash_table_destroy()
+ */
+GHashTable *calculate_cell_bounding_boxes_for_layers(struct gds_cell *cell, const int *layers, size_t layer_count);
+
 #endif /* _CELL_GEOMETRICS_H_ */
 
 /** @} */
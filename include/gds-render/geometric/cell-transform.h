@@ -0,0 +1,131 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cell-transform.h
+ * @brief Exact transformations of cell instances
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _CELL_TRANSFORM_H_
+#define _CELL_TRANSFORM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/bounding-box.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+/**
+ * @brief Integer transformation of a cell instance with a multiple of 90 degrees rotation and unity magnification
+ *
+ * A point \f$ \vec{P_i} \f$ is transformed by:
+ *
+ * \f$ \vec{P_o} = R\left(q \cdot 90^\circ\right) \cdot \begin{pmatrix} 1 & 0 \\ 0 & -1^{m} \end{pmatrix} \cdot \vec{P_i} + \vec{t} \f$
+ *
+ * Only swapping, negating and adding of integers is needed to apply this transformation.
+ * Composition of these transformations is exact.
+ */
+struct manhattan_transform {
+	int64_t x0; /**< @brief Translation in x direction */
+	int64_t y0; /**< @brief Translation in y direction */
+	unsigned int quarter_turns; /**< @brief Counter clockwise rotation in multiples of 90 degrees (0 to 3) */
+	bool flipped; /**< @brief Mirror on x-axis before rotation */
+};
+
+/**
+ * @brief Transformation of a cell instance
+ *
+ * If the transformation consists of a multiple of 90 degrees rotation and a magnification of 1,
+ * cell_transform::manhattan is set and the integer representation cell_transform::mt is valid.
+ * The double precision matrix cell_transform::matrix is always valid.
+ */
+struct cell_transform {
+	bool manhattan; /**< @brief True if cell_transform::mt is valid */
+	struct manhattan_transform mt; /**< @brief Integer representation of the transformation */
+	struct affine_2d matrix; /**< @brief Double precision fallback. Always valid */
+};
+
+/**
+ * @brief Initialize a transformation to identity
+ * @param trans Transformation
+ */
+void cell_transform_init_identity(struct cell_transform *trans);
+
+/**
+ * @brief Initialize a transformation from a cell instance
+ * @param trans Transformation
+ * @param inst Cell instance
+ */
+void cell_transform_init_from_instance(struct cell_transform *trans, const struct gds_cell_instance *inst);
+
+/**
+ * @brief Compose two transformations
+ *
+ * The resulting transformation applies \p inner first and \p outer afterwards.
+ * If both transformations are manhattan transformations, the result is exact.
+ * \p res may point to \p outer or \p inner.
+ *
+ * @param res Resulting transformation
+ * @param outer Transformation of the parent
+ * @param inner Transformation of the child instance
+ */
+void cell_transform_compose(struct cell_transform *res, const struct cell_transform *outer,
+			    const struct cell_transform *inner);
+
+/**
+ * @brief Transform a point
+ * @param trans Transformation
+ * @param in Input point
+ * @param out Transformed point
+ */
+void cell_transform_apply_to_point(const struct cell_transform *trans, const struct gds_point *in,
+				   struct vector_2d *out);
+
+/**
+ * @brief Transform a bounding box
+ *
+ * For manhattan transformations the result is exact.
+ * Otherwise, the box of the transformed corner points is returned.
+ *
+ * @param trans Transformation
+ * @param box Box to transform in place
+ */
+void cell_transform_apply_to_box(const struct cell_transform *trans, union bounding_box *box);
+
+/**
+ * @brief Transform an array of points with a manhattan transformation
+ * @param trans Transformation
+ * @param in Input points
+ * @param out Output points. May be the same array as \p in
+ * @param count Number of points
+ * @note The results have to fit into the coordinate range of a #gds_point.
+ */
+void manhattan_transform_apply_to_points(const struct manhattan_transform *trans, const struct gds_point *in,
+					 struct gds_point *out, size_t count);
+
+#endif /* _CELL_TRANSFORM_H_ */
+
+/** @} */
@@ -0,0 +1,95 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file density-map.h
+ * @brief Per layer coverage of a raster of tiles
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _DENSITY_MAP_H_
+#define _DENSITY_MAP_H_
+
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/bounding-box.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+
+/**
+ * @brief Covered fraction of each tile of a raster for a single layer
+ */
+struct density_map {
+	int layer; /**< @brief Layer number */
+	unsigned int columns; /**< @brief Number of tiles in x direction */
+	unsigned int rows; /**< @brief Number of tiles in y direction */
+	union bounding_box extent; /**< @brief Area covered by the raster */
+	/**
+	 * @brief Covered fraction between 0 and 1 of each tile
+	 *
+	 * The tile in column c and row r is stored at index r * columns + c. Row 0 is the top row.
+	 */
+	double *coverage;
+};
+
+/**
+ * @brief Calculate the density map of a single flattened layer
+ *
+ * Overlapping rectilinear shapes are merged first and binned as rectangles.
+ * Other polygons and paths are clipped to the tiles. The area of tiles containing such pieces
+ * is the area of the union of all shapes, so overlapping shapes are only counted once.
+ *
+ * @param layer Flattened layer
+ * @param extent Area covered by the raster
+ * @param columns Number of tiles in x direction
+ * @param rows Number of tiles in y direction
+ * @return Density map or NULL in case of invalid parameters. Free with density_map_free()
+ */
+struct density_map *density_map_calculate_layer(const struct flat_layer *layer, const union bounding_box *extent,
+						unsigned int columns, unsigned int rows);
+
+/**
+ * @brief Calculate the density maps of all layers of a cell
+ *
+ * The cell is flattened and the layers are processed in parallel.
+ * The raster covers the bounding box of the cell.
+ *
+ * @param cell Cell
+ * @param columns Number of tiles in x direction
+ * @param rows Number of tiles in y direction
+ * @param thread_count Number of worker threads. 0 uses the number of processors
+ * @param[out] maps List of #density_map sorted by ascending layer number
+ * @return 0 if successful. -1 in case of invalid parameters, -2 if the cell is affected by a reference loop
+ */
+int density_map_calculate_for_cell(struct gds_cell *cell, unsigned int columns, unsigned int rows,
+				   unsigned int thread_count, GList **maps);
+
+/**
+ * @brief Free a density map
+ * @param map Density map. May be NULL
+ */
+void density_map_free(struct density_map *map);
+
+#endif /* _DENSITY_MAP_H_ */
+
+/** @} */
@@ -0,0 +1,127 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hierarchy-flattener.h
+ * @brief Flatten a cell hierarchy into per-layer primitive buffers
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _HIERARCHY_FLATTENER_H_
+#define _HIERARCHY_FLATTENER_H_
+
+#include <stddef.h>
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/bounding-box.h>
+
+/**
+ * @brief A graphics object transformed into the coordinate system of the flattened cell
+ */
+struct flat_primitive {
+	enum graphics_type gfx_type; /**< @brief Type of the graphics object */
+	enum path_type path_render_type; /**< @brief Line cap. Only used for paths */
+	double width; /**< @brief Transformed width. Only used for paths */
+	size_t first_vertex; /**< @brief Index of the first vertex in flat_layer::vertices */
+	size_t vertex_count; /**< @brief Number of vertices */
+};
+
+/**
+ * @brief All primitives of a single layer
+ */
+struct flat_layer {
+	int layer; /**< @brief Layer number */
+	GArray *primitives; /**< @brief Array of #flat_primitive */
+	GArray *vertices; /**< @brief Array of #vector_2d. Vertices of all primitives in this layer */
+};
+
+/**
+ * @brief A flattened cell hierarchy
+ */
+struct flat_scene {
+	GArray *layers; /**< @brief Array of #flat_layer sorted by ascending layer number */
+	union bounding_box box; /**< @brief Bounding box of all primitives. Paths are enlarged by their width */
+	guint64 primitive_count; /**< @brief Total number of primitives */
+	guint64 vertex_count; /**< @brief Total number of vertices */
+};
+
+/**
+ * @brief Flatten a cell and all of its sub cells
+ *
+ * The instance tree is split into tasks at large subtrees. The tasks are processed
+ * in parallel. The order of the primitives inside a layer does not depend on the scheduling
+ * of the tasks. Instances without a resolved cell reference are skipped.
+ *
+ * @param cell Cell to flatten
+ * @param layers Array of layer numbers to include. NULL includes all layers
+ * @param layer_count Number of entries in \p layers
+ * @param thread_count Number of worker threads. 0 uses the number of processors
+ * @return Flattened scene or NULL if \p cell is NULL or affected by a reference loop
+ */
+struct flat_scene *hierarchy_flatten_cell(struct gds_cell *cell, const int *layers, size_t layer_count,
+					  unsigned int thread_count);
+
+/**
+ * @brief Get a single layer of a flattened scene
+ * @param scene Scene
+ * @param layer Layer number
+ * @return Layer or NULL if the scene does not contain any primitives on this layer
+ */
+const struct flat_layer *flat_scene_get_layer(const struct flat_scene *scene, int layer);
+
+/**
+ * @brief Free a flattened scene
+ * @param scene Scene to free. May be NULL
+ */
+void flat_scene_free(struct flat_scene *scene);
+
+/**
+ * @brief Append a binary image of a flattened scene to \p data
+ *
+ * The image is meant to pass a scene to another process of the same executable.
+ * It is not a portable file format.
+ *
+ * Only the layers listed in \p layers are written. The bounding box of the image is the one of the whole scene.
+ *
+ * @param scene Scene
+ * @param layers Array of layer numbers to include. NULL includes all layers
+ * @param layer_count Number of entries in \p layers
+ * @param data Byte array the image is appended to
+ * @return 0 if successful
+ */
+int flat_scene_serialize(const struct flat_scene *scene, const int *layers, size_t layer_count,
+			 GByteArray *data);
+
+/**
+ * @brief Rebuild a flattened scene from an image created by flat_scene_serialize()
+ * @param data Image
+ * @param length Length of \p data
+ * @return Scene or NULL if the image is invalid. Free with flat_scene_free()
+ */
+struct flat_scene *flat_scene_deserialize(const guint8 *data, size_t length);
+
+#endif /* _HIERARCHY_FLATTENER_H_ */
+
+/** @} */
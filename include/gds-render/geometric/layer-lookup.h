@@ -0,0 +1,63 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file layer-lookup.h
+ * @brief Lookup table of enabled GDS layers
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * Internal helper shared by the bounding box calculation and the hierarchy flattener.
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _LAYER_LOOKUP_H_
+#define _LAYER_LOOKUP_H_
+
+#include <stddef.h>
+#include <glib.h>
+
+/** @brief Size of the layer lookup table. Covers the whole int16_t range */
+#define LAYER_LUT_SIZE (65536)
+
+/**
+ * @brief Check if a layer is enabled in a lookup table
+ * @param lut Lookup table created by layer_lut_new(). NULL enables all layers
+ * @param layer GDS layer number
+ */
+#define LAYER_LUT_ENABLED(lut, layer) (!(lut) || (lut)[(guint16)(layer)])
+
+/**
+ * @brief Create a lookup table of the enabled layers
+ *
+ * The table is indexed by the layer number cast to guint16. Layer numbers outside of the int16_t range
+ * are ignored.
+ *
+ * @param layers Enabled layer numbers. NULL enables all layers
+ * @param layer_count Number of \p layers
+ * @return Lookup table of @ref LAYER_LUT_SIZE entries or NULL if \p layers is NULL. Free with g_free()
+ */
+guint8 *layer_lut_new(const int *layers, size_t layer_count);
+
+#endif /* _LAYER_LOOKUP_H_ */
+
+/** @} */
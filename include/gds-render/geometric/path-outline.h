@@ -0,0 +1,150 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file path-outline.h
+ * @brief Conversion of paths to polygon outlines
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _PATH_OUTLINE_H_
+#define _PATH_OUTLINE_H_
+
+#include <stddef.h>
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/bounding-box.h>
+
+/**
+ * @brief Maximum ratio of miter length to half path width. Sharper joins are beveled
+ */
+#define PATH_OUTLINE_MITER_LIMIT (10.0)
+
+/**
+ * @brief Return value of the outline calculation for paths without width
+ *
+ * GDS paths with a width of 0 are drawn as hairlines. Instead of an outline, the center line is returned.
+ * It is an open polyline that has to be stroked with the thinnest line of the output device.
+ */
+#define PATH_OUTLINE_HAIRLINE (1)
+
+/**
+ * @brief Calculate the outline polygon of a path
+ *
+ * The outline consists of the left side of the path, the end cap, the right side in reverse direction
+ * and the start cap. Joins are mitered. If the miter is longer than @ref PATH_OUTLINE_MITER_LIMIT
+ * times half the path width, the join is beveled. The outline may intersect itself at sharp joins;
+ * it has to be filled using the nonzero winding rule.
+ *
+ * @param vertices Center line of the path
+ * @param count Number of vertices
+ * @param width Width of the path
+ * @param caps Line caps
+ * @param[out] outline Array of #vector_2d the closed outline is appended to
+ * @return 0 if successful. @ref PATH_OUTLINE_HAIRLINE if \p width is 0 and the center line has been appended
+ *	   instead. -1 if the path does not cover any area. In this case nothing is appended.
+ */
+int path_outline_calculate(const struct gds_point *vertices, size_t count, double width, enum path_type caps,
+			   GArray *outline);
+
+/**
+ * @brief Calculate the outline polygon of a path given in floating point coordinates
+ *
+ * This is used for paths that have already been transformed, e.g. by the hierarchy flattener.
+ *
+ * @param vertices Center line of the path
+ * @param count Number of vertices
+ * @param width Width of the path
+ * @param caps Line caps
+ * @param[out] outline Array of #vector_2d the closed outline is appended to
+ * @return 0 if successful. @ref PATH_OUTLINE_HAIRLINE if \p width is 0 and the center line has been appended
+ *	   instead. -1 if the path does not cover any area. In this case nothing is appended.
+ */
+int path_outline_calculate_from_vectors(const struct vector_2d *vertices, size_t count, double width,
+					enum path_type caps, GArray *outline);
+
+/**
+ * @brief Calculate the outline polygon of a graphics object of type GRAPHIC_PATH
+ * @param gfx Path
+ * @param[out] outline Array of #vector_2d the closed outline is appended to
+ * @return 0 if successful, @ref PATH_OUTLINE_HAIRLINE for the center line of a path without width,
+ *	   negative if \p gfx is not a path or does not cover any area
+ */
+int path_outline_calculate_from_gfx(const struct gds_graphics *gfx, GArray *outline);
+
+/**
+ * @brief Calculate the exact bounding box of a path
+ * @param gfx Path
+ * @param[out] box Bounding box. Box of the center line for paths without width.
+ *		    Prepared empty if the path does not cover any area
+ */
+void path_outline_calculate_bounding_box(const struct gds_graphics *gfx, union bounding_box *box);
+
+/**
+ * @brief Cache of path outlines of graphics objects
+ */
+struct path_outline_cache;
+
+/**
+ * @brief Create a new, empty outline cache
+ * @return Cache
+ */
+struct path_outline_cache *path_outline_cache_new(void);
+
+/**
+ * @brief Free an outline cache and all outlines stored in it
+ * @param cache Cache. May be NULL
+ */
+void path_outline_cache_free(struct path_outline_cache *cache);
+
+/**
+ * @brief Calculate the outlines of all paths in a cell and its sub cells in parallel
+ *
+ * Each unique cell is only visited once.
+ *
+ * @param cache Cache
+ * @param cell Top cell
+ * @param thread_count Number of worker threads. 0 uses the number of processors
+ * @return Number of calculated outlines or negative in case of an error
+ */
+int path_outline_cache_build_for_cell(struct path_outline_cache *cache, struct gds_cell *cell,
+				      unsigned int thread_count);
+
+/**
+ * @brief Get the outline of a path
+ *
+ * If the outline is not yet stored in the cache, it is calculated. This function is thread safe.
+ *
+ * @param cache Cache
+ * @param gfx Path
+ * @return Array of #vector_2d or NULL if \p gfx is not a path or does not cover any area.
+ *	   For paths with a width of 0, the array is the center line (see @ref PATH_OUTLINE_HAIRLINE).
+ *	   The array is owned by the cache.
+ */
+const GArray *path_outline_cache_lookup(struct path_outline_cache *cache, const struct gds_graphics *gfx);
+
+#endif /* _PATH_OUTLINE_H_ */
+
+/** @} */
@@ -0,0 +1,71 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file polygon-simplify.h
+ * @brief Tolerance based simplification of polygons and paths
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _POLYGON_SIMPLIFY_H_
+#define _POLYGON_SIMPLIFY_H_
+
+#include <stddef.h>
+#include <glib.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+
+/**
+ * @brief Simplify a vertex array using the Douglas-Peucker algorithm
+ *
+ * Vertices are removed as long as the simplified line does not deviate more than
+ * \p tolerance from the original one. A closing vertex equal to the first one is removed for closed shapes.
+ * Closed shapes keep at least 3 vertices, open lines at least 2. If this is not possible,
+ * the vertices are copied unchanged.
+ *
+ * @param in Input vertices
+ * @param count Number of input vertices
+ * @param tolerance Maximum deviation
+ * @param closed TRUE if \p in is a closed polygon, FALSE for open lines like paths
+ * @param[out] out Output vertices. Must be able to hold \p count vertices. May not overlap \p in.
+ * @return Number of output vertices
+ */
+size_t polygon_simplify(const struct vector_2d *in, size_t count, double tolerance, gboolean closed,
+			struct vector_2d *out);
+
+/**
+ * @brief Simplify all primitives of a flattened scene
+ *
+ * Layers are processed in parallel. The vertex counts of the scene are updated.
+ *
+ * @param scene Scene
+ * @param tolerance Maximum deviation in database units
+ * @param thread_count Number of worker threads. 0 uses the number of processors
+ * @return Number of removed vertices
+ */
+guint64 polygon_simplify_scene(struct flat_scene *scene, double tolerance, unsigned int thread_count);
+
+#endif /* _POLYGON_SIMPLIFY_H_ */
+
+/** @} */
@@ -0,0 +1,65 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file polygon-union.h
+ * @brief Union of overlapping shapes of a flattened layer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _POLYGON_UNION_H_
+#define _POLYGON_UNION_H_
+
+#include <glib.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+
+/**
+ * @brief Merge all overlapping and abutting rectilinear shapes of a layer
+ *
+ * Boxes and polygons consisting only of horizontal and vertical edges are combined into
+ * the minimum number of contours. Holes are connected to their surrounding contour by a zero width
+ * cut, so each resulting polygon can be filled on its own using the nonzero winding rule.
+ * Paths and all other polygons are copied unchanged.
+ *
+ * @param in Layer to merge
+ * @param[out] out Merged layer. New arrays are allocated for flat_layer::primitives and flat_layer::vertices
+ * @return 0 if successful. Negative in case of an error. \p out is not touched in this case.
+ */
+int polygon_union_merge_layer(const struct flat_layer *in, struct flat_layer *out);
+
+/**
+ * @brief Merge the shapes of all layers of a scene
+ *
+ * The layers are processed in parallel. A layer that cannot be merged is kept unchanged.
+ * The primitive and vertex counts of the scene are updated.
+ *
+ * @param scene Scene to merge
+ * @param thread_count Number of worker threads. 0 uses the number of processors
+ * @return 0 if successful
+ */
+int polygon_union_merge_scene(struct flat_scene *scene, unsigned int thread_count);
+
+#endif /* _POLYGON_UNION_H_ */
+
+/** @} */
@@ -0,0 +1,72 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file rectangle-decomposition.h
+ * @brief Decomposition of rectilinear polygons into rectangles
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _RECTANGLE_DECOMPOSITION_H_
+#define _RECTANGLE_DECOMPOSITION_H_
+
+#include <stddef.h>
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/bounding-box.h>
+
+/**
+ * @brief Check if all edges of a closed polygon are horizontal or vertical
+ * @param v Vertices
+ * @param count Vertex count
+ * @return TRUE if the polygon is rectilinear
+ */
+gboolean rectangle_decomposition_is_rectilinear(const struct vector_2d *v, size_t count);
+
+/**
+ * @brief Split a rectilinear polygon into rectangles
+ *
+ * The area covered by the polygon using the nonzero winding rule is cut into horizontal
+ * and vertical bands. Bands of equal extent are combined. The direction resulting in fewer
+ * rectangles is used. The rectangles do not overlap.
+ *
+ * @param v Vertices of the closed polygon
+ * @param count Vertex count
+ * @param[out] rects Array of #bounding_box the rectangles are appended to
+ * @return 0 if successful. -1 if the polygon is not rectilinear. Nothing is appended in this case.
+ */
+int rectangle_decomposition_calculate(const struct vector_2d *v, size_t count, GArray *rects);
+
+/**
+ * @brief Split a graphics object of type GRAPHIC_BOX or GRAPHIC_POLYGON into rectangles
+ * @param gfx Graphics object
+ * @param[out] rects Array of #bounding_box the rectangles are appended to
+ * @return 0 if successful. -1 if the object is no rectilinear polygon. Nothing is appended in this case.
+ */
+int rectangle_decomposition_calculate_from_gfx(const struct gds_graphics *gfx, GArray *rects);
+
+#endif /* _RECTANGLE_DECOMPOSITION_H_ */
+
+/** @} */
@@ -0,0 +1,91 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file scanline.h
+ * @brief Sweep over the axis parallel edges of rectilinear shapes
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * Internal helpers shared by the rectangle decomposition and the polygon union.
+ */
+
+/**
+ * @addtogroup geometric
+ * @{
+ */
+
+#ifndef _SCANLINE_H_
+#define _SCANLINE_H_
+
+#include <glib.h>
+
+/**
+ * @brief Edge perpendicular to the sweep direction
+ */
+struct scanline_edge {
+	double pos; /**< @brief Position across the sweep direction */
+	double low; /**< @brief Lower end along the sweep direction */
+	double high; /**< @brief Upper end along the sweep direction */
+	int dir; /**< @brief Winding contribution: +1 or -1 */
+};
+
+/**
+ * @brief Covered interval across the sweep direction
+ */
+struct scanline_interval {
+	double low; /**< @brief Start */
+	double high; /**< @brief End */
+};
+
+/**
+ * @brief Compare two doubles. Can be used with g_array_sort()
+ */
+gint scanline_compare_double(gconstpointer a, gconstpointer b);
+
+/**
+ * @brief Prepare the edges for the sweep
+ * @param edges Array of #scanline_edge. It is sorted by the lower end
+ * @return Array of the sorted unique coordinates along the sweep direction. Free with g_array_free()
+ */
+GArray *scanline_prepare(GArray *edges);
+
+/**
+ * @brief Update the edges crossing the band starting at \p s
+ * @param edges Prepared array of #scanline_edge
+ * @param[in,out] next_edge Index of the first edge in \p edges that was not added yet
+ * @param active Array of #scanline_edge crossing the band. Kept sorted by position
+ * @param s Start of the band
+ * @return TRUE if \p active changed
+ */
+gboolean scanline_update_active(const GArray *edges, guint *next_edge, GArray *active, double s);
+
+/**
+ * @brief Calculate the covered intervals of a band using the nonzero winding rule
+ *
+ * All edges at the same position are summed up first. This merges abutting shapes and
+ * removes zero width cuts.
+ *
+ * @param active Edges crossing the band sorted by position
+ * @param[out] intervals Array of #scanline_interval. Is cleared first
+ */
+void scanline_compute_intervals(const GArray *active, GArray *intervals);
+
+#endif /* _SCANLINE_H_ */
+
+/** @} */
@@ -33,12 +33,30 @@
 #define _VECTOR_OPERATIONS_H_
 
 #include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 struct vector_2d {
     double x;
     double y;
 };
 
+/**
+ * @brief 2D affine transformation matrix
+ *
+ * A point \f$ (x, y) \f$ is transformed to
+ * \f$ (x_x \cdot x + x_y \cdot y + x_0, y_x \cdot x + y_y \cdot y + y_0) \f$.
+ * The member order is the same as in cairo's matrix.
+ */
+struct affine_2d {
+	double xx;
+	double yx;
+	double xy;
+	double yy;
+	double x0;
+	double y0;
+};
+
 #define DEG2RAD(a) ((a)*M_PI/180.0)
 
 double vector_2d_scalar_multipy(struct vector_2d *a, struct vector_2d *b);
@@ -53,6 +71,89 @@ double vector_2d_calculate_angle_between(struct vector_2d *a, struct vector_2d *
 void vector_2d_subtract(struct vector_2d *res, struct vector_2d *a, struct vector_2d *b);
 void vector_2d_add(struct vector_2d *res, struct vector_2d *a, struct vector_2d *b);
 
+/**
+ * @brief Set matrix to identity
+ * @param mat Matrix
+ */
+void affine_2d_init_identity(struct affine_2d *mat);
+
+/**
+ * @brief Initialize matrix with a GDS instance transformation
+ *
+ * The resulting matrix first flips the input on the x-axis (if \p flip_at_x is set), rotates
+ * it by \p rotation_deg, scales it by \p scale and finally translates it by (\p x0 | \p y0).
+ *
+ * @param mat Matrix to initialize
+ * @param scale Scaling factor
+ * @param rotation_deg Counter clockwise rotation in degrees
+ * @param flip_at_x Flip on x-axis before rotating
+ * @param x0 X translation
+ * @param y0 Y translation
+ */
+void affine_2d_init_transform(struct affine_2d *mat, double scale, double rotation_deg, bool flip_at_x,
+			      double x0, double y0);
+
+/**
+ * @brief Multiply two matrices: \p res = \p a * \p b
+ *
+ * The resulting matrix applies \p b first and \p a afterwards. \p res may point to \p a or \p b.
+ * @param res Result
+ * @param a Outer transformation
+ * @param b Inner transformation
+ */
+void affine_2d_multiply(struct affine_2d *res, const struct affine_2d *a, const struct affine_2d *b);
+
+/**
+ * @brief Transform a vector in place
+ * @param mat Matrix
+ * @param vec Vector to transform
+ */
+void affine_2d_apply(const struct affine_2d *mat, struct vector_2d *vec);
+
+/**
+ * @brief Transform an array of vectors
+ *
+ * The sine and cosine of the transformation are contained in the matrix.
+ * Therefore, they are not recalculated for every vector.
+ *
+ * @param mat Matrix
+ * @param in Input vectors
+ * @param out Output vectors. May be the same array as \p in
+ * @param count Number of vectors
+ */
+void vector_2d_array_transform(const struct affine_2d *mat, const struct vector_2d *in, struct vector_2d *out,
+			       size_t count);
+
+/**
+ * @brief Calculate the component wise minimum and maximum of an array of vectors
+ *
+ * If \p count is 0, \p min is set to DBL_MAX and \p max to -DBL_MAX.
+ *
+ * @param vecs Vectors
+ * @param count Number of vectors
+ * @param[out] min Minimum
+ * @param[out] max Maximum
+ */
+void vector_2d_array_min_max(const struct vector_2d *vecs, size_t count, struct vector_2d *min,
+			     struct vector_2d *max);
+
+/**
+ * @brief Normalize an array of vectors in place
+ * @param vecs Vectors
+ * @param count Number of vectors
+ */
+void vector_2d_array_normalize(struct vector_2d *vecs, size_t count);
+
+/**
+ * @brief Calculate the z component of the cross products \p a[i] x \p b[i]
+ * @param a First operands
+ * @param b Second operands
+ * @param[out] res Results
+ * @param count Number of vectors
+ */
+void vector_2d_array_cross_product(const struct vector_2d *a, const struct vector_2d *b, double *res,
+				   size_t count);
+
 #endif /* _VECTOR_OPERATIONS_H_ */
 
 /** @} */
@@ -27,6 +27,7 @@
 #include <gds-render/gds-utils/gds-types.h>
 #include <gds-render/output-renderers/gds-output-renderer.h>
 #include <glib-object.h>
+#include <cairo.h>
 
 G_BEGIN_DECLS
 
@@ -40,6 +41,9 @@ G_DECLARE_FINAL_TYPE(CairoRenderer, cairo_renderer, GDS_RENDER, CAIRO_RENDERER,
 
 #define MAX_LAYERS (300) /**< \brief Maximum layer count the output renderer can process. Typically GDS only specifies up to 255 layers.*/
 
+#define CAIRO_RENDERER_WORKER_ARG "--render-worker" /**< @brief Only command line argument of a render worker process */
+#define CAIRO_RENDERER_WORKER_FD (3) /**< @brief File descriptor of the socket to the parent in a render worker process */
+
 /**
  * @brief Create new CairoRenderer for SVG output
  * @return New object
@@ -53,6 +57,36 @@ CairoRenderer *cairo_renderer_new_svg();
  */
 CairoRenderer *cairo_renderer_new_pdf();
 
+/**
+ * @brief Draw a cell into a Cairo context in the current process
+ *
+ * The cell hierarchy is drawn the same way as into the PDF and SVG output. The upper left corner of the
+ * bounding box of the rendered layers is placed at the origin of \p cr.
+ *
+ * @note Cairo leaks memory while rendering (see issue #16). The renderer itself therefore draws its output
+ * in a separate process.
+ *
+ * @param cell Cell to draw
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param cr Cairo context to draw into
+ * @param scale Scale the output image down by \p scale
+ * @return 0 if successful. -1 if a parameter is invalid. -3 if a layer number is too high or the cell is affected
+ *	   by a reference loop
+ */
+int cairo_renderer_draw_cell(struct gds_cell *cell, GList *layer_infos, cairo_t *cr, double scale);
+
+/**
+ * @brief Main loop of a render worker process
+ *
+ * The Cairo renderer starts this executable with @ref CAIRO_RENDERER_WORKER_ARG to render its jobs
+ * in a separate process. The worker renders the jobs received on \p fd one after another and
+ * returns when the socket is closed.
+ *
+ * @param fd Socket connected to the parent process
+ * @return Exit status of the worker
+ */
+int cairo_renderer_worker_main(int fd);
+
 /** @} */
 
 G_END_DECLS
@@ -38,6 +38,8 @@
 
 G_BEGIN_DECLS
 
+struct flat_scene;
+
 #define GDS_RENDER_TYPE_OUTPUT_RENDERER (gds_output_renderer_get_type())
 
 G_DECLARE_DERIVABLE_TYPE(GdsOutputRenderer, gds_output_renderer, GDS_RENDER, OUTPUT_RENDERER, GObject);
@@ -55,7 +57,11 @@ struct _GdsOutputRendererClass {
 	int (*render_output)(GdsOutputRenderer *renderer,
 				struct gds_cell *cell,
 	                        double scale);
-	gpointer padding[4];
+	/**
+	 * @brief The renderer uses a scene set by gds_output_renderer_set_shared_scene() instead of traversing the cell
+	 */
+	gboolean supports_shared_scene;
+	gpointer padding[3];
 };
 
 enum {
@@ -129,6 +135,128 @@ LayerSettings *gds_output_renderer_get_and_ref_layer_settings(GdsOutputRenderer
  */
 void gds_output_renderer_set_layer_settings(GdsOutputRenderer *renderer, LayerSettings *settings);
 
+/**
+ * @brief Convenience function for setting the "merge-shapes" property
+ *
+ * If set, the renderer flattens the cell hierarchy and merges overlapping
+ * rectilinear shapes of each layer before writing the output.
+ *
+ * @param renderer Renderer
+ * @param merge TRUE: Merge shapes
+ */
+void gds_output_renderer_set_merge_shapes(GdsOutputRenderer *renderer, gboolean merge);
+
+/**
+ * @brief Convenience function for getting the "merge-shapes" property
+ * @param renderer Renderer
+ * @return TRUE if shapes are merged before rendering
+ */
+gboolean gds_output_renderer_get_merge_shapes(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Convenience function for setting the "simplify-tolerance" property
+ *
+ * Polygons and paths are simplified before they are written to the output, as long
+ * as the result does not deviate more than \p tolerance from the original shape.
+ *
+ * @param renderer Renderer
+ * @param tolerance Maximum deviation in output units, i.e. database units divided by the render scale.
+ *		    0 disables the simplification
+ */
+void gds_output_renderer_set_simplify_tolerance(GdsOutputRenderer *renderer, double tolerance);
+
+/**
+ * @brief Convenience function for getting the "simplify-tolerance" property
+ * @param renderer Renderer
+ * @return Maximum deviation in output units
+ */
+double gds_output_renderer_get_simplify_tolerance(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Convenience function for getting the "removed-vertices" property
+ * @param renderer Renderer
+ * @return Number of vertices removed by the last simplification inside this process
+ */
+guint64 gds_output_renderer_get_removed_vertices(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Check if the renderer has to render a flattened scene
+ *
+ * This is the case if shapes are merged or simplified.
+ *
+ * @param renderer Renderer
+ * @return TRUE if the cell has to be flattened using gds_output_renderer_flatten_cell()
+ */
+gboolean gds_output_renderer_requires_flat_scene(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Flatten a cell for rendering
+ *
+ * Only layers marked for rendering in \p layer_infos are included.
+ * If the "merge-shapes" property is set, overlapping shapes of each layer are merged.
+ * If the "simplify-tolerance" property is set, the shapes are simplified afterwards.
+ *
+ * @param renderer Renderer
+ * @param cell Cell to flatten
+ * @param layer_infos List of #layer_info structs
+ * @param scale Render scale. The output is scaled *down* by this value
+ * @return Flattened scene or NULL if the cell contains a reference loop. Free with flat_scene_free()
+ */
+struct flat_scene *gds_output_renderer_flatten_cell(GdsOutputRenderer *renderer, struct gds_cell *cell,
+						    GList *layer_infos, double scale);
+
+/**
+ * @brief Set a flattened scene prepared for several renderers
+ *
+ * If the renderer class supports shared scenes, the next rendering draws \p scene instead of
+ * traversing the cell hierarchy. The scene must have been flattened with at least the rendered layers,
+ * the "merge-shapes" and the "simplify-tolerance" properties of this renderer. Other layers of the scene
+ * are skipped. The output extent is the extent of the whole scene.
+ * The renderer only reads the scene. It is not freed by the renderer and has to stay valid until
+ * the rendering has finished.
+ *
+ * @param renderer Renderer
+ * @param scene Scene or NULL to traverse the cell again
+ */
+void gds_output_renderer_set_shared_scene(GdsOutputRenderer *renderer, const struct flat_scene *scene);
+
+/**
+ * @brief Get the scene set by gds_output_renderer_set_shared_scene()
+ * @param renderer Renderer
+ * @return Scene or NULL
+ */
+const struct flat_scene *gds_output_renderer_get_shared_scene(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Get a memory file containing the shared scene
+ *
+ * The file holds all layers of the scene serialized with flat_scene_serialize(). It is only available
+ * while gds_output_renderer_render_output_list() runs. The first call creates the file. All renderers
+ * sharing the scene get the same file, so the scene is serialized only once. The file must not be
+ * modified or closed.
+ *
+ * @param renderer Renderer
+ * @return File descriptor or -1 if the scene was not set by gds_output_renderer_render_output_list()
+ *	   or the file could not be created
+ */
+int gds_output_renderer_get_shared_scene_file(GdsOutputRenderer *renderer);
+
+/**
+ * @brief Render a cell with several renderers at once
+ *
+ * If at least two of the renderers support shared scenes and use the same shape merging and simplification,
+ * the cell is flattened only once for all layers rendered by these renderers. The scene is shared by them.
+ * Renderers that would not flatten the cell on their own only share a scene if the size estimated by
+ * gds_statistics_calculate() is small enough. Otherwise they traverse the cell hierarchy.
+ * The renderers run concurrently in a pool of threads, at most one per processor.
+ *
+ * @param renderers List of GdsOutputRenderer objects
+ * @param cell Cell to render
+ * @param scale scale value. The output is scaled *down* by this value
+ * @return 0 if all renderers were successful. Otherwise the first error of a renderer
+ */
+int gds_output_renderer_render_output_list(GList *renderers, struct gds_cell *cell, double scale);
+
 /**
  * @brief Render output asynchronously
  *
@@ -0,0 +1,62 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file native-pdf-renderer.h
+ * @brief Header File for the native PDF output renderer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Native-PDF-Renderer
+ * @{
+ */
+
+#ifndef _NATIVE_PDF_RENDERER_H_
+#define _NATIVE_PDF_RENDERER_H_
+
+#include <gds-render/output-renderers/gds-output-renderer.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(NativePdfRenderer, native_pdf_renderer, GDS_RENDER, NATIVE_PDF_RENDERER, GdsOutputRenderer)
+
+#define GDS_RENDER_TYPE_NATIVE_PDF_RENDERER (native_pdf_renderer_get_type())
+
+#define NATIVE_PDF_DEFAULT_COMPRESSION (6) /**< @brief Default zlib compression level of the content streams */
+
+/**
+ * @brief Create new NativePdfRenderer
+ * @return New object
+ */
+NativePdfRenderer *native_pdf_renderer_new(void);
+
+/**
+ * @brief Create new NativePdfRenderer with a compression level
+ * @param compression_level zlib compression level of the content streams (1 to 9). 0 writes uncompressed streams
+ * @return New object
+ */
+NativePdfRenderer *native_pdf_renderer_new_with_options(int compression_level);
+
+G_END_DECLS
+
+#endif /* _NATIVE_PDF_RENDERER_H_ */
+
+/** @} */
@@ -0,0 +1,125 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pdf-writer.h
+ * @brief Helpers to write the objects of a PDF file
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Native-PDF-Renderer
+ * @{
+ */
+
+#ifndef _PDF_WRITER_H_
+#define _PDF_WRITER_H_
+
+#include <stdio.h>
+#include <glib.h>
+#include <gds-render/geometric/vector-operations.h>
+#include <gds-render/geometric/bounding-box.h>
+
+/**
+ * @brief Output file with the offsets of the written objects
+ */
+struct pdf_writer {
+	FILE *file; /**< @brief Output file */
+	guint64 offset; /**< @brief Number of bytes written so far */
+	guint64 *offsets; /**< @brief File offset of each object */
+	gboolean failed; /**< @brief A write has failed */
+};
+
+/**
+ * @brief Append a number to a PDF string
+ *
+ * PDF does not allow exponents. The number is written with up to 6 decimal places
+ * independent of the locale.
+ *
+ * @param str String
+ * @param value Number
+ */
+void pdf_append_number(GString *str, double value);
+
+/**
+ * @brief Append a literal string to a PDF string
+ * @param str String
+ * @param text Text to append. Parentheses, backslashes and non printable characters are escaped
+ */
+void pdf_append_literal(GString *str, const char *text);
+
+/**
+ * @brief Append a transformation matrix and the cm operator to a content stream
+ * @param str Content stream
+ * @param matrix Transformation
+ */
+void pdf_append_matrix(GString *str, const struct affine_2d *matrix);
+
+/**
+ * @brief Append a box as PDF rectangle array
+ * @param str String
+ * @param box Box
+ */
+void pdf_append_box(GString *str, const union bounding_box *box);
+
+/**
+ * @brief Turn a content stream into stream data
+ * @param content Content stream. Freed by this function
+ * @param level Compression level. 0 does not compress the stream
+ * @param dict Stream dictionary. The filter is added if the stream is compressed
+ * @return Stream data or NULL in case of an error
+ */
+GBytes *pdf_finish_stream(GString *content, int level, GString *dict);
+
+/**
+ * @brief Write data to the output file
+ * @param writer Writer
+ * @param data Data
+ * @param length Length of \p data in bytes
+ */
+void pdf_write(struct pdf_writer *writer, const void *data, gsize length);
+
+/**
+ * @brief Write an object that is not a stream
+ * @param writer Writer
+ * @param object Object number
+ * @param body Object
+ */
+void pdf_write_object(struct pdf_writer *writer, guint object, const char *body);
+
+/**
+ * @brief Write a stream object
+ * @param writer Writer
+ * @param object Object number
+ * @param dict Stream dictionary without the length and the closing brackets
+ * @param stream Stream data
+ */
+void pdf_write_stream(struct pdf_writer *writer, guint object, const GString *dict, GBytes *stream);
+
+/**
+ * @brief Write the cross reference table and the trailer
+ * @param writer Writer
+ * @param object_count Number of objects including the free object 0
+ * @param root Object number of the document catalog
+ */
+void pdf_write_trailer(struct pdf_writer *writer, guint object_count, guint root);
+
+#endif /* _PDF_WRITER_H_ */
+
+/** @} */
@@ -0,0 +1,73 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file raster-renderer.h
+ * @brief Header File for the tiled raster (PNG) output renderer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Raster-Renderer
+ * @{
+ */
+
+#ifndef _RASTER_RENDERER_H_
+#define _RASTER_RENDERER_H_
+
+#include <gds-render/output-renderers/gds-output-renderer.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(RasterRenderer, raster_renderer, GDS_RENDER, RASTER_RENDERER, GdsOutputRenderer)
+
+#define GDS_RENDER_TYPE_RASTER_RENDERER (raster_renderer_get_type())
+
+#define RASTER_RENDERER_DEFAULT_DPI (72.0) /**< @brief Default resolution. One pixel per point of the PDF output */
+#define RASTER_RENDERER_MIN_DPI (1.0) /**< @brief Minimum resolution */
+#define RASTER_RENDERER_MAX_DPI (100000.0) /**< @brief Maximum resolution */
+#define RASTER_RENDERER_TILE_SIZE (256) /**< @brief Width and height of the tiles rendered by one thread in pixels */
+#define RASTER_PYRAMID_MAX_LEVEL (24) /**< @brief Maximum zoom level of a tile pyramid */
+#define RASTER_PYRAMID_DETAIL_PIXELS (0.5) /**< @brief Instances smaller than this are not drawn on coarse pyramid levels */
+#define RASTER_PYRAMID_MANIFEST "tiles.sha256" /**< @brief File in the tile pyramid storing the hashes of all tiles */
+
+/**
+ * @brief Create new RasterRenderer for PNG output
+ * @param dpi Resolution in pixels per inch. The output unit of the scale value is one point (1/72 inch)
+ * @return New object
+ */
+RasterRenderer *raster_renderer_new_png(double dpi);
+
+/**
+ * @brief Create new RasterRenderer writing an XYZ tile pyramid
+ *
+ * The output file is a directory. Each zoom level z is stored as <tt>z/x/y.png</tt>.
+ * Re-exports into the same directory only render the tiles whose geometry has changed.
+ *
+ * @param dpi Resolution of the deepest zoom level in pixels per inch
+ * @return New object
+ */
+RasterRenderer *raster_renderer_new_tile_pyramid(double dpi);
+
+G_END_DECLS
+
+#endif /* _RASTER_RENDERER_H_ */
+
+/** @} */
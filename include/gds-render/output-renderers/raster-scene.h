@@ -0,0 +1,110 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file raster-scene.h
+ * @brief Cell hierarchy prepared for rasterizing arbitrary areas (Header)
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Raster-Renderer
+ * @{
+ */
+
+#ifndef _RASTER_SCENE_H_
+#define _RASTER_SCENE_H_
+
+#include <glib.h>
+#include <cairo.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/bounding-box.h>
+
+/**
+ * @brief Cell hierarchy with the bounding box and the used layers of each cell
+ *
+ * The scene is read-only after its creation. Any number of threads may render areas of the
+ * same scene concurrently.
+ */
+struct raster_scene;
+
+/**
+ * @brief Prepare a cell for rasterizing
+ * @param cell Toplevel cell
+ * @param layer_infos List of #layer_info. Only layers marked for rendering are drawn, in list order
+ * @return Scene or NULL if \p cell is affected by a reference loop. Free with raster_scene_free()
+ */
+struct raster_scene *raster_scene_new(struct gds_cell *cell, GList *layer_infos);
+
+/**
+ * @brief Free a scene
+ * @param scene Scene. May be NULL
+ */
+void raster_scene_free(struct raster_scene *scene);
+
+/**
+ * @brief Get the bounding box of the toplevel cell
+ * @param scene Scene
+ * @param[out] box Box in database units
+ */
+void raster_scene_get_extent(const struct raster_scene *scene, union bounding_box *box);
+
+/**
+ * @brief Draw an area of the scene
+ *
+ * Each layer is drawn with its color and composited with its alpha value onto the target.
+ * Instances and shapes not overlapping \p area are skipped. Instances and shapes smaller than
+ * \p min_size in both directions are skipped as well (level of detail).
+ *
+ * @param scene Scene
+ * @param cr Target. Its current transformation maps database units to the device
+ * @param area Area to draw in database units
+ * @param min_size Minimum size of drawn instances and shapes in database units. 0 draws everything
+ */
+void raster_scene_render(const struct raster_scene *scene, cairo_t *cr, const union bounding_box *area,
+			 double min_size);
+
+/**
+ * @brief Calculate the content hashes of all cells of the scene
+ *
+ * This has to be called once before raster_scene_hash_area() is used.
+ *
+ * @param scene Scene
+ */
+void raster_scene_prepare_hashes(struct raster_scene *scene);
+
+/**
+ * @brief Hash the geometry that is drawn into an area
+ *
+ * The hash only depends on the contents of the cells, not on their addresses. It is stable across
+ * program runs. The same instances are culled as by raster_scene_render(). The hash may change
+ * although the drawn result does not, but never the other way round.
+ *
+ * @param scene Scene. raster_scene_prepare_hashes() must have been called
+ * @param area Area in database units
+ * @param min_size Minimum size of drawn instances and shapes in database units
+ * @param checksum The geometry and the layers are added to this checksum
+ * @return Number of hashed elements. 0 if the area is empty
+ */
+guint raster_scene_hash_area(const struct raster_scene *scene, const union bounding_box *area, double min_size,
+			     GChecksum *checksum);
+
+#endif /* _RASTER_SCENE_H_ */
+
+/** @} */
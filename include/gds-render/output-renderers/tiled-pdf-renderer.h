@@ -0,0 +1,63 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tiled-pdf-renderer.h
+ * @brief Header File for the multi-page (tiled) PDF output renderer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Tiled-PDF-Renderer
+ * @{
+ */
+
+#ifndef _TILED_PDF_RENDERER_H_
+#define _TILED_PDF_RENDERER_H_
+
+#include <gds-render/output-renderers/gds-output-renderer.h>
+#include <gds-render/gds-utils/gds-types.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(TiledPdfRenderer, tiled_pdf_renderer, GDS_RENDER, TILED_PDF_RENDERER, GdsOutputRenderer)
+
+#define GDS_RENDER_TYPE_TILED_PDF_RENDERER (tiled_pdf_renderer_get_type())
+
+#define TILED_PDF_DEFAULT_PAGE_WIDTH (210.0) /**< @brief Default page width in mm (A4 portrait) */
+#define TILED_PDF_DEFAULT_PAGE_HEIGHT (297.0) /**< @brief Default page height in mm (A4 portrait) */
+#define TILED_PDF_MIN_PAGE_SIZE (1.0) /**< @brief Minimum page width and height in mm */
+#define TILED_PDF_MAX_PAGE_SIZE (100000.0) /**< @brief Maximum page width and height in mm */
+#define TILED_PDF_MAX_PAGES (10000) /**< @brief Maximum number of pages of a single output file */
+
+/**
+ * @brief Create new TiledPdfRenderer
+ * @param page_width Page width in mm
+ * @param page_height Page height in mm
+ * @param plot_scale Length on paper per length in the layout, e.g. 1000 prints 1 um as 1 mm.
+ *		     0 uses the render scale instead. One output unit of the render scale is one point
+ * @return New object
+ */
+TiledPdfRenderer *tiled_pdf_renderer_new(double page_width, double page_height, double plot_scale);
+
+G_END_DECLS
+
+#endif /* _TILED_PDF_RENDERER_H_ */
+
+/** @} */
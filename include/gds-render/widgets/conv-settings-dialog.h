@@ -33,6 +33,7 @@
 #define __CONV_SETTINGS_DIALOG_H__
 
 #include <gtk/gtk.h>
+#include <gds-render/gds-utils/gds-statistics.h>
 
 G_BEGIN_DECLS
 
@@ -97,6 +98,13 @@ void renderer_settings_dialog_set_cell_height(RendererSettingsDialog *dialog, un
  */
 void renderer_settings_dialog_set_database_unit_scale(RendererSettingsDialog *dialog, double unit_in_meters);
 
+/**
+ * @brief renderer_settings_dialog_set_statistics Show the estimated rendering cost of the cell
+ * @param dialog dialog element
+ * @param stats Flattened cell statistics. NULL clears the estimate
+ */
+void renderer_settings_dialog_set_statistics(RendererSettingsDialog *dialog, const struct gds_cell_statistics *stats);
+
 #endif /* __CONV_SETTINGS_DIALOG_H__ */
 
 /** @} */
@@ -24,6 +24,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <gtk/gtk.h>
 #include <glib.h>
 #include <glib/gi18n.h>
@@ -32,6 +33,9 @@
 #include <gds-render/gds-render-gui.h>
 #include <gds-render/command-line.h>
 #include <gds-render/output-renderers/external-renderer.h>
+#include <gds-render/output-renderers/cairo-renderer.h>
+#include <gds-render/output-renderers/raster-renderer.h>
+#include <gds-render/output-renderers/tiled-pdf-renderer.h>
 #include <gds-render/version.h>
 
 /**
@@ -261,13 +265,27 @@ int main(int argc, char **argv)
 	gchar *mappingname = NULL;
 	gchar *cellname = NULL;
 	gchar **renderer_args = NULL;
-	gboolean version = FALSE, pdf_standalone = FALSE, pdf_layers = FALSE;
+	gboolean version = FALSE, pdf_standalone = FALSE, pdf_layers = FALSE, estimate = FALSE;
+	gboolean merge_shapes = FALSE;
+	double simplify_tolerance = 0.0;
+	double dpi = RASTER_RENDERER_DEFAULT_DPI;
+	gchar *density_size = NULL;
+	gchar *page_size = NULL;
+	struct tiled_pdf_params page_params;
+	unsigned int density_columns, density_rows;
 	int scale = 1000;
 	int app_status = 0;
 	struct external_renderer_params so_render_params;
 
+	/* Render worker of the Cairo renderer. Does not need any other setup */
+	if (argc == 2 && !strcmp(argv[1], CAIRO_RENDERER_WORKER_ARG))
+		return cairo_renderer_worker_main(CAIRO_RENDERER_WORKER_FD);
+
 	so_render_params.so_path = NULL;
 	so_render_params.cli_params = NULL;
+	page_params.page_width = TILED_PDF_DEFAULT_PAGE_WIDTH;
+	page_params.page_height = TILED_PDF_DEFAULT_PAGE_HEIGHT;
+	page_params.plot_scale = 0.0;
 
 	bindtextdomain(GETTEXT_PACKAGE, LOCALEDATADIR "/locale");
 	bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
@@ -276,10 +294,10 @@ int main(int argc, char **argv)
 	GOptionEntry entries[] = {
 		{"version", 'v', 0, G_OPTION_ARG_NONE, &version, _("Print version"), NULL},
 		{"renderer", 'r', 0, G_OPTION_ARG_STRING_ARRAY, &renderer_args,
-			_("Renderer to use. Can be used multiple times."), "pdf|svg|tikz|ext"},
+			_("Renderer to use. Can be used multiple times."), "pdf|pdf-native|svg|png|tiles|pdf-tiled|tikz|ext"},
 		{"scale", 's', 0, G_OPTION_ARG_INT, &scale, _("Divide output coordinates by <SCALE>"), "<SCALE>" },
 		{"output-file", 'o', 0, G_OPTION_ARG_FILENAME_ARRAY, &output_paths,
-			_("Output file path. Can be used multiple times."), "PATH" },
+			_("Output file path. Can be used multiple times. %L or %N write one file per layer (pdf, svg, tikz)"), "PATH" },
 		{"mapping", 'm', 0, G_OPTION_ARG_FILENAME, &mappingname, _("Path for Layer Mapping File"), "PATH" },
 		{"cell", 'c', 0, G_OPTION_ARG_STRING, &cellname, _("Cell to render"), "NAME" },
 		{"tex-standalone", 'a', 0, G_OPTION_ARG_NONE, &pdf_standalone, _("Create standalone TeX"), NULL },
@@ -288,6 +306,21 @@ int main(int argc, char **argv)
 			_("Path to a custom shared object, that implements the necessary rendering functions"), "PATH"},
 		{"render-lib-params", 'W', 0, G_OPTION_ARG_STRING, &so_render_params.cli_params,
 			_("Argument string passed to render lib"), NULL},
+		{"estimate", 'e', 0, G_OPTION_ARG_NONE, &estimate,
+			_("Print the flattened primitive, vertex and instance counts of the cell and exit"), NULL},
+		{"merge-shapes", 'M', 0, G_OPTION_ARG_NONE, &merge_shapes,
+			_("Flatten the cell and merge overlapping shapes of each layer"), NULL},
+		{"simplify", 'T', 0, G_OPTION_ARG_DOUBLE, &simplify_tolerance,
+			_("Simplify shapes with a maximum deviation of <TOL> output units"), "<TOL>"},
+		{"dpi", 'd', 0, G_OPTION_ARG_DOUBLE, &dpi,
+			_("Resolution of PNG output and of the deepest tile level in pixels per inch. One output unit is one point"), "<DPI>"},
+		{"page-size", 'p', 0, G_OPTION_ARG_STRING, &page_size,
+			_("Page size of tiled PDF output in mm. Default: A4 portrait"), "<W>x<H>"},
+		{"plot-scale", 'S', 0, G_OPTION_ARG_DOUBLE, &page_params.plot_scale,
+			_("Length on paper per length in the layout for tiled PDF output. Replaces the scale"), "<FACTOR>"},
+		{"density-map", 'D', 0, G_OPTION_ARG_STRING, &density_size,
+			_("Write the per layer coverage on a raster of tiles to the output file (CSV or PNG) and exit"),
+			"<COLS>x<ROWS>"},
 		{NULL, 0, 0, 0, NULL, NULL, NULL}
 	};
 
@@ -313,6 +346,32 @@ int main(int argc, char **argv)
 			scale = 1;
 		}
 
+		if (simplify_tolerance < 0.0) {
+			printf(_("Negative simplification tolerance not allowed. Disabling simplification\n"));
+			simplify_tolerance = 0.0;
+		}
+
+		if (dpi < RASTER_RENDERER_MIN_DPI || dpi > RASTER_RENDERER_MAX_DPI) {
+			printf(_("Resolution must be between %.0lf and %.0lf DPI. Setting to %.0lf DPI\n"),
+			       RASTER_RENDERER_MIN_DPI, RASTER_RENDERER_MAX_DPI, RASTER_RENDERER_DEFAULT_DPI);
+			dpi = RASTER_RENDERER_DEFAULT_DPI;
+		}
+
+		if (page_size && (sscanf(page_size, "%lfx%lf", &page_params.page_width, &page_params.page_height) != 2 ||
+				  page_params.page_width < TILED_PDF_MIN_PAGE_SIZE ||
+				  page_params.page_width > TILED_PDF_MAX_PAGE_SIZE ||
+				  page_params.page_height < TILED_PDF_MIN_PAGE_SIZE ||
+				  page_params.page_height > TILED_PDF_MAX_PAGE_SIZE)) {
+			printf(_("Invalid page size %s. Using A4 portrait\n"), page_size);
+			page_params.page_width = TILED_PDF_DEFAULT_PAGE_WIDTH;
+			page_params.page_height = TILED_PDF_DEFAULT_PAGE_HEIGHT;
+		}
+
+		if (page_params.plot_scale < 0.0) {
+			printf(_("Negative plot scale not allowed. Using the scale instead\n"));
+			page_params.plot_scale = 0.0;
+		}
+
 		/* Get gds name */
 		gds_name = argv[1];
 
@@ -320,9 +379,24 @@ int main(int argc, char **argv)
 		for (i = 2; i < argc; i++)
 			printf(_("Ignored argument: %s"), argv[i]);
 
-		app_status =
-			command_line_convert_gds(gds_name, cellname, renderer_args, output_paths, mappingname,
-						 &so_render_params, pdf_standalone, pdf_layers, scale);
+		if (estimate) {
+			app_status = command_line_estimate_gds(gds_name, cellname);
+		} else if (density_size) {
+			if (sscanf(density_size, "%ux%u", &density_columns, &density_rows) != 2 ||
+			    density_columns == 0 || density_rows == 0) {
+				printf(_("Invalid density map size %s. Expected <COLS>x<ROWS>\n"), density_size);
+				app_status = -2;
+			} else {
+				app_status = command_line_density_map(gds_name, cellname,
+								      (output_paths ? output_paths[0] : NULL),
+								      density_columns, density_rows);
+			}
+		} else {
+			app_status =
+				command_line_convert_gds(gds_name, cellname, renderer_args, output_paths, mappingname,
+							 &so_render_params, pdf_standalone, pdf_layers, merge_shapes,
+							 simplify_tolerance, dpi, &page_params, scale);
+		}
 
 	} else {
 		app_status = start_gui(argc, argv);
@@ -339,6 +413,10 @@ ret_status:
 		g_strfreev(renderer_args);
 	if (mappingname)
 		g_free(mappingname);
+	if (density_size)
+		g_free(density_size);
+	if (page_size)
+		g_free(page_size);
 	if (cellname)
 		free(cellname);
 	if (so_render_params.so_path)
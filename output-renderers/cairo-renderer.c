@@ -26,14 +26,35 @@
  *  @{
  */
 
+/* memfd_create() */
+#define _GNU_SOURCE
+
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <cairo.h>
 #include <cairo-pdf.h>
 #include <cairo-svg.h>
 #include <glib/gi18n.h>
 
 #include <gds-render/output-renderers/cairo-renderer.h>
+#include <gds-render/geometric/cell-geometrics.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+#include <gds-render/geometric/rectangle-decomposition.h>
+#include <gds-render/gds-utils/gds-topology.h>
+#include <gds-render/gds-utils/gds-tree-checker.h>
+#include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-serialize.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -52,122 +73,479 @@ struct cairo_layer {
 	cairo_t *cr; /**< @brief cairo context for layer*/
 	cairo_surface_t *rec; /**< @brief Recording surface to hold the layer */
 	struct layer_info *linfo; /**< @brief Reference to layer information */
+	guint64 matrix_serial; /**< @brief Serial of the #render_transform currently set on cairo_layer::cr */
+};
+
+/**
+ * @brief Minimum number of placements of a cell to render it once and replay it
+ *
+ * Each replay is a paint operation on every layer the cell uses. Cells placed less often are
+ * rendered into their parents directly.
+ */
+#define CAIRO_RENDERER_REPLAY_MIN_INSTANCES (8)
+
+/**
+ * @brief Prerendered layer of a cell
+ */
+struct cairo_replay_layer {
+	int layer; /**< @brief Layer number */
+	cairo_surface_t *rec; /**< @brief Recording surface holding the layer of the cell */
+};
+
+/**
+ * @brief Layers of a cell that is rendered once and replayed for each placement
+ */
+struct cairo_cell_replay {
+	GArray *layers; /**< @brief Array of #cairo_replay_layer. Only layers used by the cell */
+	gsize primitives; /**< @brief Number of flattened primitives drawn into the layers */
+};
+
+/**
+ * @brief Phase of a rendering
+ */
+enum cairo_render_phase {
+	CAIRO_PHASE_STARTING = 0, /**< @brief Rendering has not started yet */
+	CAIRO_PHASE_FLATTENING, /**< @brief The cell is flattened */
+	CAIRO_PHASE_OUTLINES, /**< @brief Path outlines are calculated */
+	CAIRO_PHASE_RENDERING, /**< @brief Primitives are drawn into the layers */
+	CAIRO_PHASE_EXPORTING, /**< @brief The layers are written to the output files */
+	CAIRO_PHASE_FINISHED, /**< @brief Rendering is finished */
+};
+
+/**
+ * @brief Progress of a rendering
+ *
+ * The block is shared between the rendering process and the process displaying the progress.
+ * It is only accessed with atomic operations. The displaying process polls it at a fixed rate.
+ */
+struct cairo_render_progress {
+	gint phase; /**< @brief #cairo_render_phase */
+	gint layer; /**< @brief Layer currently exported */
+	gsize primitives_done; /**< @brief Flattened primitives drawn so far */
+	gsize primitives_total; /**< @brief Flattened primitives to draw. 0 if unknown */
+	gsize bytes_written; /**< @brief Bytes written to the output files */
+	gint message_serial; /**< @brief Incremented before and after cairo_render_progress::message is written */
+	char message[128]; /**< @brief Last status message of the rendering */
 };
 
 /**
- * @brief Revert the last transformation on all layers
- * @param layers Pointer to #cairo_layer structures
+ * @brief Number of primitives a render context counts before it updates the shared progress
+ */
+#define CAIRO_PROGRESS_BATCH (4096)
+
+/**
+ * @brief Interval in ms between progress updates of the GUI
+ */
+#define CAIRO_PROGRESS_INTERVAL_MS (200)
+
+/**
+ * @brief Report a status message of a rendering
+ *
+ * The message is displayed by the process waiting for the rendering. The serial is odd while the message
+ * is written, so the reader can detect a torn copy.
+ *
+ * @param progress Shared progress. If NULL, the message is printed instead
+ * @param message Message
  */
-static void revert_inherited_transform(struct cairo_layer *layers)
+static void set_progress_message(struct cairo_render_progress *progress, const char *message)
 {
-	int i;
+	if (!progress) {
+		printf("%s\n", message);
+		return;
+	}
 
-	for (i = 0; i < MAX_LAYERS; i++) {
-		if (layers[i].cr == NULL)
-			continue;
-		cairo_restore(layers[i].cr);
+	g_atomic_int_inc(&progress->message_serial);
+	g_strlcpy(progress->message, message, sizeof(progress->message));
+	g_atomic_int_inc(&progress->message_serial);
+}
+
+/**
+ * @brief Read a new status message of a rendering
+ * @param progress Shared progress
+ * @param[in,out] serial Serial of the last message read
+ * @param[out] buff Buffer for the message
+ * @param buff_size Buffer size
+ * @return TRUE if a new message has been copied to \p buff
+ */
+static gboolean get_progress_message(struct cairo_render_progress *progress, gint *serial, char *buff,
+				     size_t buff_size)
+{
+	gint before = g_atomic_int_get(&progress->message_serial);
+
+	if (before == *serial || (before & 1))
+		return FALSE;
+
+	g_strlcpy(buff, progress->message, MIN(buff_size, sizeof(progress->message)));
+	if (g_atomic_int_get(&progress->message_serial) != before)
+		return FALSE;
+
+	*serial = before;
+	return TRUE;
+}
+
+/**
+ * @brief Transformation from the coordinates of the currently rendered cell to layer coordinates
+ *
+ * The transformations of the instance hierarchy are multiplied in software. The matrix is only set
+ * on a cairo context when something is drawn to it.
+ */
+struct render_transform {
+	cairo_matrix_t matrix; /**< @brief Transformation matrix */
+	guint64 serial; /**< @brief Unique number of this transformation. 0 is the initial matrix of the layers */
+};
+
+/**
+ * @brief State shared by the whole traversal of a cell hierarchy
+ */
+struct cairo_render_context {
+	struct cairo_layer *layers; /**< @brief Layers to render into */
+	struct path_outline_cache *outlines; /**< @brief Cache of path outlines */
+	GHashTable *replays; /**< @brief Prerendered cells. Maps #gds_cell to #cairo_cell_replay. May be NULL */
+	GHashTable *unused_cells; /**< @brief Set of cells that do not use any of the layers. May be NULL */
+	GHashTable *layer_runs; /**< @brief Graphics of each cell sorted by layer. Maps #gds_cell to GPtrArray */
+	GHashTable *decompositions; /**< @brief Maps #gds_graphics to a GArray of #bounding_box. NULL: no rectangles */
+	guint64 last_serial; /**< @brief Last serial assigned to a #render_transform */
+	double scale; /**< @brief Scale image down by this factor */
+	struct cairo_render_progress *progress; /**< @brief Shared progress. May be NULL */
+	gsize primitives; /**< @brief Flattened primitives drawn by this context */
+	gsize primitives_reported; /**< @brief Part of cairo_render_context::primitives added to the progress */
+};
+
+/**
+ * @brief Count drawn primitives
+ *
+ * The shared progress is updated in batches of @ref CAIRO_PROGRESS_BATCH primitives.
+ *
+ * @param ctx Render context
+ * @param count Number of flattened primitives drawn
+ * @param flush Update the shared progress regardless of the batch size
+ */
+static void count_primitives(struct cairo_render_context *ctx, gsize count, gboolean flush)
+{
+	gsize pending;
+
+	ctx->primitives += count;
+	if (!ctx->progress)
+		return;
+
+	pending = ctx->primitives - ctx->primitives_reported;
+	if (pending >= CAIRO_PROGRESS_BATCH || (flush && pending > 0)) {
+		g_atomic_pointer_add(&ctx->progress->primitives_done, pending);
+		ctx->primitives_reported = ctx->primitives;
+	}
+}
+
+/**
+ * @brief Set the phase of a rendering
+ * @param progress Shared progress. May be NULL
+ * @param phase New phase
+ */
+static void set_progress_phase(struct cairo_render_progress *progress, enum cairo_render_phase phase)
+{
+	if (progress)
+		g_atomic_int_set(&progress->phase, (gint)phase);
+}
+
+/**
+ * @brief Calculate the transformation of a cell instance
+ *
+ * Manhattan instances result in a matrix consisting only of 0 and +/-1 entries.
+ * This avoids rounding errors of sine and cosine for multiples of 90 degrees.
+ *
+ * @param ctx Render context
+ * @param parent Transformation of the cell containing the instance
+ * @param trans Transformation of the cell instance
+ * @param[out] child Transformation of the instantiated cell
+ */
+static void push_instance_transform(struct cairo_render_context *ctx, const struct render_transform *parent,
+				    const struct cell_transform *trans, struct render_transform *child)
+{
+	cairo_matrix_t matrix;
+
+	cairo_matrix_init(&matrix, trans->matrix.xx, trans->matrix.yx, trans->matrix.xy, trans->matrix.yy,
+			  trans->matrix.x0 / ctx->scale, trans->matrix.y0 / ctx->scale);
+	cairo_matrix_multiply(&child->matrix, &matrix, &parent->matrix);
+	child->serial = ++ctx->last_serial;
+}
+
+/**
+ * @brief Get the cairo context of a layer with \p transform applied
+ * @param ctx Render context
+ * @param layer Layer number
+ * @param transform Current transformation
+ * @return Cairo context or NULL if the layer is not rendered
+ */
+static cairo_t *select_layer(struct cairo_render_context *ctx, int layer, const struct render_transform *transform)
+{
+	struct cairo_layer *lay;
+
+	if (layer < 0 || layer >= MAX_LAYERS)
+		return NULL;
+
+	lay = &ctx->layers[layer];
+	if (lay->cr == NULL)
+		return NULL;
+
+	if (lay->matrix_serial != transform->serial) {
+		cairo_set_matrix(lay->cr, &transform->matrix);
+		lay->matrix_serial = transform->serial;
+	}
+
+	return lay->cr;
+}
+
+/**
+ * @brief Fill the outline of a path
+ *
+ * Paths without width are stroked along their center line with a line width of 1, like it has been done before
+ * path outlines existed.
+ *
+ * @param cr Cairo context
+ * @param outline Outline. Array of #vector_2d
+ * @param hairline Outline is the open center line of a path without width (see @ref PATH_OUTLINE_HAIRLINE)
+ * @param scale Scale image down by this factor
+ */
+static void fill_path_outline(cairo_t *cr, const GArray *outline, gboolean hairline, double scale)
+{
+	const struct vector_2d *pt;
+	guint i;
+
+	if (!outline || outline->len == 0)
+		return;
+
+	pt = &g_array_index(outline, struct vector_2d, 0);
+	cairo_move_to(cr, pt->x/scale, pt->y/scale);
+	for (i = 1; i < outline->len; i++) {
+		pt = &g_array_index(outline, struct vector_2d, i);
+		cairo_line_to(cr, pt->x/scale, pt->y/scale);
+	}
+
+	if (hairline) {
+		cairo_save(cr);
+		cairo_set_line_width(cr, 1.0);
+		cairo_stroke(cr);
+		cairo_restore(cr);
+		return;
+	}
+
+	cairo_close_path(cr);
+
+	/* Outlines may intersect themselves at sharp joins */
+	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+	cairo_fill(cr);
+}
+
+/**
+ * @brief Add rectangles to the current path
+ *
+ * Cairo handles paths consisting only of rectangles much faster than general polygons.
+ *
+ * @param cr Cairo context
+ * @param rects Array of #bounding_box
+ * @param scale Scale image down by this factor
+ */
+static void append_rectangles(cairo_t *cr, const GArray *rects, double scale)
+{
+	const union bounding_box *box;
+	guint i;
+
+	for (i = 0; i < rects->len; i++) {
+		box = &g_array_index(rects, union bounding_box, i);
+		cairo_rectangle(cr, box->vectors.lower_left.x/scale, box->vectors.lower_left.y/scale,
+				(box->vectors.upper_right.x - box->vectors.lower_left.x)/scale,
+				(box->vectors.upper_right.y - box->vectors.lower_left.y)/scale);
+	}
+}
+
+
+static gint compare_gfx_layer(gconstpointer a, gconstpointer b)
+{
+	const struct gds_graphics *gfx_a = *(const struct gds_graphics * const *)a;
+	const struct gds_graphics *gfx_b = *(const struct gds_graphics * const *)b;
+
+	return (int)gfx_a->layer - (int)gfx_b->layer;
+}
+
+/**
+ * @brief Get the graphics of a cell sorted by layer
+ *
+ * Each layer is selected once per run of graphics instead of once per graphics object.
+ * The order of the graphics within a layer is kept.
+ *
+ * @param ctx Render context
+ * @param cell Cell
+ * @return Array of #gds_graphics. Owned by \p ctx
+ */
+static const GPtrArray *get_layer_runs(struct cairo_render_context *ctx, struct gds_cell *cell)
+{
+	GPtrArray *runs;
+	GList *gfx_list;
+	struct gds_graphics *gfx;
+
+	runs = (GPtrArray *)g_hash_table_lookup(ctx->layer_runs, cell);
+	if (runs)
+		return runs;
+
+	runs = g_ptr_array_new();
+	for (gfx_list = cell->graphic_objs; gfx_list != NULL; gfx_list = gfx_list->next) {
+		gfx = (struct gds_graphics *)gfx_list->data;
+		if (gfx->layer >= 0 && gfx->layer < MAX_LAYERS)
+			g_ptr_array_add(runs, gfx);
+	}
+	/* Stable sort */
+	g_ptr_array_sort(runs, compare_gfx_layer);
+	g_hash_table_insert(ctx->layer_runs, cell, runs);
+
+	return runs;
+}
+
+static void decomposition_free(gpointer data)
+{
+	if (data)
+		g_array_free((GArray *)data, TRUE);
+}
+
+/**
+ * @brief Get the rectangle decomposition of a graphics object
+ *
+ * The decomposition is calculated on the first call and reused for every further placement of the object.
+ *
+ * @param ctx Render context
+ * @param gfx Graphics object
+ * @return Array of #bounding_box or NULL if \p gfx is no rectilinear polygon
+ */
+static const GArray *get_decomposition(struct cairo_render_context *ctx, const struct gds_graphics *gfx)
+{
+	gpointer value;
+	GArray *rects;
+
+	if (g_hash_table_lookup_extended(ctx->decompositions, gfx, NULL, &value))
+		return (const GArray *)value;
+
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+	if (rectangle_decomposition_calculate_from_gfx(gfx, rects) != 0) {
+		g_array_free(rects, TRUE);
+		rects = NULL;
 	}
+	g_hash_table_insert(ctx->decompositions, (gpointer)gfx, rects);
+
+	return rects;
 }
 
 /**
- * @brief Applies transformation to all layers
- * @param layers Array of layers
- * @param origin Origin translation
- * @param magnification Scaling
- * @param flipping Mirror image on x-axis before rotating
- * @param rotation Rotation in degrees
- * @param scale Scale the image down by. Only used for sclaing origin coordinates. Not applied to layer.
+ * @brief Paint the prerendered layers of a cell instance
+ * @param ctx Render context
+ * @param replay Prerendered layers of the instantiated cell
+ * @param transform Transformation of the instance
  */
-static void apply_inherited_transform_to_all_layers(struct cairo_layer *layers,
-						    const struct gds_point *origin,
-						    double magnification,
-						    gboolean flipping,
-						    double rotation,
-						    double scale)
+static void paint_cell_replay(struct cairo_render_context *ctx, const struct cairo_cell_replay *replay,
+			      const struct render_transform *transform)
 {
-	int i;
-	cairo_t *temp_layer_cr;
+	const struct cairo_replay_layer *entry;
+	cairo_t *cr;
+	guint i;
 
-	for (i = 0; i < MAX_LAYERS; i++) {
-		temp_layer_cr = layers[i].cr;
-		if (temp_layer_cr == NULL)
+	for (i = 0; i < replay->layers->len; i++) {
+		entry = &g_array_index(replay->layers, struct cairo_replay_layer, i);
+		cr = select_layer(ctx, entry->layer, transform);
+		if (cr == NULL)
 			continue;
 
-		/* Save the state and apply transformation */
-		cairo_save(temp_layer_cr);
-		cairo_translate(temp_layer_cr, (double)origin->x/scale, (double)origin->y/scale);
-		cairo_rotate(temp_layer_cr, M_PI*rotation/180.0);
-		cairo_scale(temp_layer_cr, magnification,
-			    (flipping == TRUE ? -magnification : magnification));
+		/* Keep the layer color */
+		cairo_save(cr);
+		cairo_set_source_surface(cr, entry->rec, 0, 0);
+		cairo_paint(cr);
+		cairo_restore(cr);
 	}
+
+	count_primitives(ctx, replay->primitives, FALSE);
 }
 
 /**
  * @brief render_cell Render a cell with its sub-cells
  * @param cell Cell to render
- * @param layers Cell will be rendered into these layers
- * @param scale sclae image down by this factor
+ * @param ctx Render context
+ * @param transform Transformation of \p cell
  */
-static void render_cell(struct gds_cell *cell, struct cairo_layer *layers, double scale)
+static void render_cell(struct gds_cell *cell, struct cairo_render_context *ctx,
+			const struct render_transform *transform)
 {
+	const struct cairo_cell_replay *replay;
+	const GPtrArray *runs;
 	GList *instance_list;
 	struct gds_cell *temp_cell;
 	struct gds_cell_instance *cell_instance;
-	GList *gfx_list;
 	struct gds_graphics *gfx;
-	GList *vertex_list;
-	struct gds_point *vertex;
-	cairo_t *cr;
+	const struct gds_point *vertex;
+	cairo_t *cr = NULL;
+	struct cell_transform trans;
+	struct render_transform child_transform;
+	const GArray *rects;
+	double scale = ctx->scale;
+	int current_layer = -1;
+	gsize drawn = 0;
+	guint i;
+	size_t j;
 
 	/* Render child cells */
 	for (instance_list = cell->child_cells; instance_list != NULL; instance_list = instance_list->next) {
 		cell_instance = (struct gds_cell_instance *)instance_list->data;
 		temp_cell = cell_instance->cell_ref;
-		if (temp_cell != NULL) {
-			apply_inherited_transform_to_all_layers(layers,
-								&cell_instance->origin,
-								cell_instance->magnification,
-								cell_instance->flipped,
-								cell_instance->angle,
-								scale);
-			render_cell(temp_cell, layers, scale);
-			revert_inherited_transform(layers);
-		}
+		if (temp_cell == NULL)
+			continue;
+
+		if (ctx->unused_cells && g_hash_table_contains(ctx->unused_cells, temp_cell))
+			continue;
+
+		cell_transform_init_from_instance(&trans, cell_instance);
+		push_instance_transform(ctx, transform, &trans, &child_transform);
+		replay = (ctx->replays ? g_hash_table_lookup(ctx->replays, temp_cell) : NULL);
+		if (replay)
+			paint_cell_replay(ctx, replay, &child_transform);
+		else
+			render_cell(temp_cell, ctx, &child_transform);
 	}
 
 	/* Render graphics */
-	for (gfx_list = cell->graphic_objs; gfx_list != NULL; gfx_list = gfx_list->next) {
-		gfx = (struct gds_graphics *)gfx_list->data;
-
-		/* Get layer renderer */
-		if (gfx->layer >= MAX_LAYERS)
-			continue;
+	runs = get_layer_runs(ctx, cell);
+	for (i = 0; i < runs->len; i++) {
+		gfx = (struct gds_graphics *)g_ptr_array_index(runs, i);
+
+		/* Get layer renderer at the start of each run */
+		if (gfx->layer != current_layer) {
+			current_layer = gfx->layer;
+			cr = select_layer(ctx, current_layer, transform);
+			if (cr)
+				cairo_set_line_width(cr, 0.1/scale);
+		}
 
-		cr = layers[gfx->layer].cr;
 		if (cr == NULL)
 			continue;
 
-		/* Apply settings */
-		cairo_set_line_width(cr, (gfx->width_absolute ? gfx->width_absolute/scale : 1));
+		drawn++;
 
-		switch (gfx->path_render_type) {
-		case PATH_FLUSH:
-			cairo_set_line_cap(cr, CAIRO_LINE_CAP_BUTT);
-			break;
-		case PATH_ROUNDED:
-			cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-			break;
-		case PATH_SQUARED:
-			cairo_set_line_cap(cr, CAIRO_LINE_CAP_SQUARE);
-			break;
+		/* Paths are filled as polygon outlines. Caps and joins are part of the outline */
+		if (gfx->gfx_type == GRAPHIC_PATH) {
+			fill_path_outline(cr, path_outline_cache_lookup(ctx->outlines, gfx), gfx->width_absolute == 0,
+					  scale);
+			continue;
+		}
+
+		/* Manhattan polygons are drawn as rectangles */
+		rects = get_decomposition(ctx, gfx);
+		if (rects) {
+			append_rectangles(cr, rects, scale);
+			cairo_stroke_preserve(cr); // Prevent graphic glitches
+			cairo_fill(cr);
+			continue;
 		}
 
 		/* Add vertices */
-		for (vertex_list = gfx->vertices; vertex_list != NULL; vertex_list = vertex_list->next) {
-			vertex = (struct gds_point *)vertex_list->data;
+		for (j = 0; j < gfx->vertex_count; j++) {
+			vertex = &gfx->vertex_array[j];
 
 			/* If first point -> move to, else line to */
-			if (vertex_list->prev == NULL)
+			if (j == 0)
 				cairo_move_to(cr, vertex->x/scale, vertex->y/scale);
 			else
 				cairo_line_to(cr, vertex->x/scale, vertex->y/scale);
@@ -175,267 +553,1682 @@ static void render_cell(struct gds_cell *cell, struct cairo_layer *layers, doubl
 
 		/* Create graphics object */
 		switch (gfx->gfx_type) {
-		case GRAPHIC_PATH:
-			cairo_stroke(cr);
-			break;
 		case GRAPHIC_BOX:
 			/* Expected fallthrough */
 		case GRAPHIC_POLYGON:
-			cairo_set_line_width(cr, 0.1/scale);
 			cairo_close_path(cr);
 			cairo_stroke_preserve(cr); // Prevent graphic glitches
 			cairo_fill(cr);
 			break;
+		default:
+			cairo_new_path(cr);
+			break;
 		}
-	} /* for gfx list */
+	} /* for graphics runs */
+
+	count_primitives(ctx, drawn, FALSE);
+}
+
+static void cell_replay_free(struct cairo_cell_replay *replay)
+{
+	guint i;
+
+	for (i = 0; i < replay->layers->len; i++)
+		cairo_surface_destroy(g_array_index(replay->layers, struct cairo_replay_layer, i).rec);
+	g_array_free(replay->layers, TRUE);
+	g_free(replay);
 }
 
 /**
- * @brief Read a line from a file descriptor
+ * @brief Render frequently placed cells once
  *
- * In case of a broken pipe / closed writing end, it will terminate
+ * The cells below \p cell are visited bottom-up. Each cell placed at least
+ * @ref CAIRO_RENDERER_REPLAY_MIN_INSTANCES times in \p cell is rendered into its own recording
+ * surfaces. Already prerendered sub-cells are replayed into them.
+ * Cells that are placed less often are rendered into their parents for every placement.
  *
- * @param fd File descriptor to read from
- * @param buff Buffer to write data in
- * @param buff_size Buffer size
- * @return length of read data
+ * The prerendered cells are stored in cairo_render_context::replays. Cells that do not use any
+ * layer of \p ctx are stored in cairo_render_context::unused_cells.
+ *
+ * @param ctx Render context. Only layers with a cairo context are prerendered
+ * @param cell Top cell
+ * @param cells Cells reachable from \p cell in bottom-up order. Placement counts must be up to date.
+ *		If NULL, nothing is prerendered
  */
-static int read_line_from_fd(int fd, char *buff, size_t buff_size)
+static void build_cell_replays(struct cairo_render_context *ctx, struct gds_cell *cell, const GPtrArray *cells)
 {
-	ssize_t cnt;
-	char c;
-	unsigned int buff_cnt = 0;
+	GHashTable *layer_usage;
+	GList *iter;
+	struct gds_cell *sub;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	struct cairo_layer *layers;
+	struct cairo_layer *sub_layers;
+	struct cairo_cell_replay *replay;
+	struct cairo_replay_layer entry;
+	struct render_transform identity;
+	struct cairo_render_progress *progress;
+	gsize primitives;
+	guint8 *used;
+	guint8 *child_used;
+	gboolean any_used;
+	guint i;
+	int l;
+
+	ctx->replays = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)cell_replay_free);
+	ctx->unused_cells = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	if (!cells)
+		return;
+
+	/* Layers used by each cell including its sub-cells. Prevents painting empty surfaces */
+	layer_usage = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	layers = ctx->layers;
+	sub_layers = (struct cairo_layer *)calloc(MAX_LAYERS, sizeof(struct cairo_layer));
+
+	/* The recording surfaces of a cell start with the initial matrix */
+	cairo_matrix_init_identity(&identity.matrix);
+	identity.serial = 0;
+
+	for (i = 0; i < cells->len; i++) {
+		sub = (struct gds_cell *)g_ptr_array_index(cells, i);
+
+		used = g_new0(guint8, MAX_LAYERS);
+		for (iter = sub->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+			gfx = (struct gds_graphics *)iter->data;
+			if (gfx->layer >= 0 && gfx->layer < MAX_LAYERS)
+				used[gfx->layer] = 1;
+		}
+		for (iter = sub->child_cells; iter != NULL; iter = g_list_next(iter)) {
+			inst = (struct gds_cell_instance *)iter->data;
+			child_used = (inst->cell_ref ? g_hash_table_lookup(layer_usage, inst->cell_ref) : NULL);
+			for (l = 0; child_used && l < MAX_LAYERS; l++)
+				used[l] |= child_used[l];
+		}
+		g_hash_table_insert(layer_usage, sub, used);
 
-	while ((cnt = read(fd, &c, 1)) == 1) {
-		if (buff_cnt < (buff_size-1)) {
-			buff[buff_cnt++] = c;
-			if (c == '\n')
-				break;
-		} else {
-			break;
+		any_used = FALSE;
+		for (l = 0; l < MAX_LAYERS && !any_used; l++)
+			any_used = (layers[l].cr && used[l]);
+
+		if (!any_used) {
+			g_hash_table_add(ctx->unused_cells, sub);
+			continue;
+		}
+
+		if (sub == cell || sub->checks.instance_count < CAIRO_RENDERER_REPLAY_MIN_INSTANCES)
+			continue;
+
+		for (l = 0; l < MAX_LAYERS; l++) {
+			if (!layers[l].cr || !used[l])
+				continue;
+
+			sub_layers[l].linfo = layers[l].linfo;
+			sub_layers[l].rec = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+			sub_layers[l].cr = cairo_create(sub_layers[l].rec);
+			sub_layers[l].matrix_serial = 0;
+			/* The layers of the top cell carry the color */
+			cairo_set_source(sub_layers[l].cr, cairo_get_source(layers[l].cr));
 		}
+
+		/* Prerendering is not counted. Each replay counts the primitives of the cell instead */
+		primitives = ctx->primitives;
+		progress = ctx->progress;
+		ctx->progress = NULL;
+		ctx->layers = sub_layers;
+		render_cell(sub, ctx, &identity);
+		ctx->layers = layers;
+		ctx->progress = progress;
+
+		replay = g_new(struct cairo_cell_replay, 1);
+		replay->layers = g_array_new(FALSE, FALSE, sizeof(struct cairo_replay_layer));
+		replay->primitives = ctx->primitives - primitives;
+		ctx->primitives = primitives;
+		for (l = 0; l < MAX_LAYERS; l++) {
+			if (!sub_layers[l].cr)
+				continue;
+			cairo_destroy(sub_layers[l].cr);
+			entry.layer = l;
+			entry.rec = sub_layers[l].rec;
+			g_array_append_val(replay->layers, entry);
+			sub_layers[l].cr = NULL;
+			sub_layers[l].rec = NULL;
+		}
+		g_hash_table_insert(ctx->replays, sub, replay);
 	}
 
-	buff[buff_cnt] = 0;
-	return (int)buff_cnt;
+	free(sub_layers);
+	g_hash_table_destroy(layer_usage);
 }
 
 /**
- * @brief Render \p cell to a PDF file specified by \p pdf_file
- * @param renderer The current renderer this function is running from
- * @param cell Toplevel cell to @ref Cairo-Renderer
- * @param layer_infos List of layer information. Specifies color and layer stacking
- * @param pdf_file PDF output file. Set to NULL if no PDF file has to be generated
- * @param svg_file SVG output file. Set to NULL if no SVG file has to be generated
- * @param scale Scale the output image down by \p scale
- * @return Error
+ * @brief Rendering of a subset of the layers on a worker thread
  */
-static int cairo_renderer_render_cell_to_vector_file(GdsOutputRenderer *renderer,
-						     struct gds_cell *cell,
-						     GList *layer_infos,
-						     const char *pdf_file,
-						     const char *svg_file,
-						     double scale)
+struct cairo_render_job {
+	struct cairo_render_context ctx; /**< @brief Render context of the worker */
+	struct gds_cell *cell; /**< @brief Cell to render */
+	const GPtrArray *cells; /**< @brief Cells reachable from cairo_render_job::cell in bottom-up order. May be NULL */
+};
+
+static void render_job_run(gpointer data, gpointer user_data)
 {
-	cairo_surface_t *pdf_surface = NULL, *svg_surface = NULL;
-	cairo_t *pdf_cr = NULL, *svg_cr = NULL;
-	struct layer_info *linfo;
-	struct cairo_layer *layers;
-	struct cairo_layer *lay;
-	GList *info_list;
-	int i;
-	double rec_x0, rec_y0, rec_width, rec_height;
-	double xmin = INT32_MAX, xmax = INT32_MIN, ymin = INT32_MAX, ymax = INT32_MIN;
-	pid_t process_id;
-	int comm_pipe[2];
-	char receive_message[200];
+	struct cairo_render_job *job = (struct cairo_render_job *)data;
+	struct render_transform root;
 
-	if (pdf_file == NULL && svg_file == NULL) {
-		/* No output specified */
-		return -1;
-	}
+	(void)user_data;
 
-	/* Generate communication pipe for status updates */
-	if (pipe(comm_pipe) == -1)
-		return -2;
+	build_cell_replays(&job->ctx, job->cell, job->cells);
 
-	/* Fork to a new child process. This ensures the memory leaks (see issue #16) in Cairo don't
-	 * brick everything.
-	 *
-	 * And by the way: This now bricks all Windows compatibility. Deal with it.
-	 */
-	process_id = fork();
-	//process_id = -1;
-	if (process_id < 0) {
-		/* This should not happen */
-		fprintf(stderr, _("Fatal error: Cairo Renderer: Could not spawn child process!"));
-		exit(-2);
-	} else if (process_id > 0) {
-		/* Woohoo... Successfully dumped the shitty code to an unknowing victim */
-		goto ret_parent;
-	}
-
-	/* We are now in a separate process just for rendering the output image.
-     * You may print a log message to the activity bar of the gui by writing a line
-     * teminated with '\n' to comm_pipe[1]. This will be handled by the parent process.
-     * Directly calling the update function 
-     *     gds_output_renderer_update_async_progress()
-     * does not have any effect because this is a separate process.
-     */
-  
-	/*
-     * Close stdin and (stdout and stderr may live on)
-     */
-	close(0);
-	close(comm_pipe[0]);
+	/* Initial matrix of the layers. See cairo_renderer_render_cell_to_vector_file() */
+	cairo_matrix_init_scale(&root.matrix, 1, -1);
+	root.serial = 0;
+	render_cell(job->cell, &job->ctx, &root);
+	count_primitives(&job->ctx, 0, TRUE);
 
-	layers = (struct cairo_layer *)calloc(MAX_LAYERS, sizeof(struct cairo_layer));
+	g_hash_table_destroy(job->ctx.unused_cells);
+	job->ctx.unused_cells = NULL;
+	g_hash_table_destroy(job->ctx.layer_runs);
+	job->ctx.layer_runs = NULL;
+	g_hash_table_destroy(job->ctx.decompositions);
+	job->ctx.decompositions = NULL;
+}
 
-	/* Clear layers */
-	for (i = 0; i < MAX_LAYERS; i++) {
-		layers[i].cr = NULL;
-		layers[i].rec = NULL;
+/**
+ * @brief Render a cell hierarchy into its layers on multiple threads
+ *
+ * The active layers are distributed over the workers. Each worker walks the hierarchy and renders
+ * only its own layers. Cairo contexts of different surfaces may be used from different threads.
+ *
+ * @param cell Cell to render
+ * @param layers Layers to render into
+ * @param outlines Cache of path outlines
+ * @param scale Scale image down by this factor
+ * @param progress Shared progress. May be NULL
+ * @param[out] jobs Jobs. Their replays are referenced by the layers. Free with free_render_jobs()
+ * @return Number of jobs
+ */
+static guint render_cell_parallel(struct gds_cell *cell, struct cairo_layer *layers,
+				  struct path_outline_cache *outlines, double scale,
+				  struct cairo_render_progress *progress, struct cairo_render_job **jobs)
+{
+	struct cairo_render_job *job;
+	GPtrArray *cells = NULL;
+	GThreadPool *pool;
+	GList *iter;
+	struct gds_cell *sub;
+	struct gds_graphics *gfx;
+	gsize total = 0;
+	gsize drawn;
+	guint active = 0;
+	guint job_count;
+	guint i;
+	int l;
+
+	for (l = 0; l < MAX_LAYERS; l++) {
+		if (layers[l].cr)
+			active++;
 	}
 
-	/* Create recording surface for each layer */
-	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
-		linfo = (struct layer_info *)info_list->data;
-		if (linfo->layer < MAX_LAYERS) {
-			/* Layer shall not be rendered */
-			if (!linfo->render)
-				continue;
-
-			lay = &(layers[(unsigned int)linfo->layer]);
-			lay->linfo = linfo;
-			lay->rec = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA,
-								  NULL);
-			lay->cr = cairo_create(layers[(unsigned int)linfo->layer].rec);
-			cairo_scale(lay->cr, 1, -1); // Fix coordinate system
-			cairo_set_source_rgb(lay->cr, linfo->color.red, linfo->color.green, linfo->color.blue);
-		} else {
-			printf("Layer number (%d) too high!\n", linfo->layer);
-			goto ret_clear_layers;
+	job_count = MIN(g_get_num_processors(), active);
+	*jobs = g_new0(struct cairo_render_job, job_count + 1);
+	if (job_count == 0)
+		return 0;
+
+	/* Placement counts and the cell order are shared by all workers */
+	if (cell->parent_library && !gds_tree_check_instance_counts(cell->parent_library, cell))
+		cells = gds_topology_get_reachable_cells(cell->parent_library, cell);
+
+	/* Total number of flattened primitives on the rendered layers */
+	for (i = 0; cells && i < cells->len; i++) {
+		sub = (struct gds_cell *)g_ptr_array_index(cells, i);
+		drawn = 0;
+		for (iter = sub->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+			gfx = (struct gds_graphics *)iter->data;
+			if (gfx->layer >= 0 && gfx->layer < MAX_LAYERS && layers[gfx->layer].cr)
+				drawn++;
 		}
+		total += drawn * (gsize)sub->checks.instance_count;
+	}
+	if (progress)
+		g_atomic_pointer_add(&progress->primitives_total, total);
+
+	for (i = 0; i < job_count; i++) {
+		job = &(*jobs)[i];
+		job->cell = cell;
+		job->cells = cells;
+		job->ctx.layers = (struct cairo_layer *)calloc(MAX_LAYERS, sizeof(struct cairo_layer));
+		job->ctx.outlines = outlines;
+		job->ctx.layer_runs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+							    (GDestroyNotify)g_ptr_array_unref);
+		job->ctx.decompositions = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+								decomposition_free);
+		job->ctx.scale = scale;
+		job->ctx.progress = progress;
 	}
 
-	dprintf(comm_pipe[1], "Rendering layers\n");
-	render_cell(cell, layers, scale);
-
-	/* get size of image and top left coordinate */
-	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
-		linfo = (struct layer_info *)info_list->data;
-
-		if (linfo->layer >= MAX_LAYERS) {
-			printf(_("Layer number too high / outside of spec.\n"));
+	/* Round robin. Each layer is owned by exactly one worker */
+	for (l = 0, i = 0; l < MAX_LAYERS; l++) {
+		if (!layers[l].cr)
 			continue;
-		}
+		(*jobs)[i % job_count].ctx.layers[l] = layers[l];
+		i++;
+	}
 
-		if (!linfo->render)
-			continue;
+	pool = g_thread_pool_new(render_job_run, NULL, (gint)job_count, FALSE, NULL);
+	for (i = 0; i < job_count; i++)
+		g_thread_pool_push(pool, &(*jobs)[i], NULL);
+	g_thread_pool_free(pool, FALSE, TRUE);
 
-		/* Print size */
-		cairo_recording_surface_ink_extents(layers[linfo->layer].rec, &rec_x0, &rec_y0,
-				&rec_width, &rec_height);
-		dprintf(comm_pipe[1], _("Size of layer %d%s%s%s: <%lf x %lf> @ (%lf | %lf)\n"),
-			linfo->layer,
-			(linfo->name && linfo->name[0] ? " (" : ""),
-			(linfo->name && linfo->name[0] ? linfo->name : ""),
-			(linfo->name && linfo->name[0] ? ")" : ""),
-			rec_width, rec_height, rec_x0, rec_y0);
+	if (cells)
+		g_ptr_array_free(cells, TRUE);
 
-		/* update bounding box */
-		xmin = MIN(xmin, rec_x0);
-		xmax = MAX(xmax, rec_x0);
-		ymin = MIN(ymin, rec_y0);
-		ymax = MAX(ymax, rec_y0);
-		xmin = MIN(xmin, rec_x0+rec_width);
-		xmax = MAX(xmax, rec_x0+rec_width);
-		ymin = MIN(ymin, rec_y0+rec_height);
-		ymax = MAX(ymax, rec_y0+rec_height);
+	return job_count;
+}
 
+/**
+ * @brief Free the jobs of render_cell_parallel()
+ * @param jobs Jobs
+ * @param job_count Number of jobs
+ */
+static void free_render_jobs(struct cairo_render_job *jobs, guint job_count)
+{
+	guint i;
+
+	for (i = 0; i < job_count; i++) {
+		if (jobs[i].ctx.replays)
+			g_hash_table_destroy(jobs[i].ctx.replays);
+		free(jobs[i].ctx.layers);
 	}
+	g_free(jobs);
+}
 
-	/* printf("Cell bounding box: (%lf | %lf) -- (%lf | %lf)\n", xmin, ymin, xmax, ymax); */
+/**
+ * @brief Draw the primitives of a flattened layer
+ * @param cr Cairo context with the layer color set as source
+ * @param lay Layer
+ * @param scale Scale image down by this factor
+ * @param outline Scratch array of #vector_2d
+ * @param rects Scratch array of #bounding_box
+ */
+static void render_flat_layer(cairo_t *cr, const struct flat_layer *lay, double scale, GArray *outline,
+			      GArray *rects)
+{
+	const struct flat_primitive *prim;
+	const struct vector_2d *v;
+	guint j;
+	int ret;
+	size_t k;
 
-	if (pdf_file) {
-		pdf_surface = cairo_pdf_surface_create(pdf_file, xmax-xmin, ymax-ymin);
-		pdf_cr = cairo_create(pdf_surface);
+	/* Merged polygons may contain zero width cuts to holes */
+	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+
+	for (j = 0; j < lay->primitives->len; j++) {
+		prim = &g_array_index(lay->primitives, struct flat_primitive, j);
+		v = &g_array_index(lay->vertices, struct vector_2d, prim->first_vertex);
+
+		if (prim->gfx_type == GRAPHIC_PATH) {
+			g_array_set_size(outline, 0);
+			ret = path_outline_calculate_from_vectors(v, prim->vertex_count, prim->width,
+								  prim->path_render_type, outline);
+			if (ret >= 0)
+				fill_path_outline(cr, outline, ret == PATH_OUTLINE_HAIRLINE, scale);
+			continue;
+		}
+
+		if (prim->vertex_count == 0)
+			continue;
+
+		g_array_set_size(rects, 0);
+		if (rectangle_decomposition_calculate(v, prim->vertex_count, rects) == 0) {
+			append_rectangles(cr, rects, scale);
+			cairo_fill(cr);
+			continue;
+		}
+
+		cairo_move_to(cr, v[0].x/scale, v[0].y/scale);
+		for (k = 1; k < prim->vertex_count; k++)
+			cairo_line_to(cr, v[k].x/scale, v[k].y/scale);
+		cairo_close_path(cr);
+		cairo_fill(cr);
 	}
+}
 
-	if (svg_file) {
-		svg_surface = cairo_svg_surface_create(svg_file, xmax-xmin, ymax-ymin);
-		svg_cr = cairo_create(svg_surface);
+/**
+ * @brief Render a flattened scene straight into an output surface
+ *
+ * The layers are drawn in stacking order. Each layer is drawn into a group on the output and painted
+ * with the layer's alpha. No intermediate recording of the layer is kept.
+ *
+ * @param scene Scene
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param cr Cairo context of the output surface
+ * @param extent Extent of the output
+ * @param scale Scale image down by this factor
+ * @param progress Shared progress. May be NULL
+ */
+static void render_flat_scene(const struct flat_scene *scene, GList *layer_infos, cairo_t *cr,
+			      const cairo_rectangle_t *extent, double scale, struct cairo_render_progress *progress)
+{
+	const struct flat_layer *by_layer[MAX_LAYERS] = {NULL};
+	const struct flat_layer *lay;
+	const struct layer_info *linfo;
+	GList *info_list;
+	GArray *outline;
+	GArray *rects;
+	guint i;
+
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		if (lay->layer >= 0 && lay->layer < MAX_LAYERS)
+			by_layer[lay->layer] = lay;
+	}
+
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+
+	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
+		linfo = (const struct layer_info *)info_list->data;
+		if (!linfo->render || linfo->layer < 0 || linfo->layer >= MAX_LAYERS)
+			continue;
+
+		lay = by_layer[linfo->layer];
+		if (!lay)
+			continue;
+
+		if (progress)
+			g_atomic_int_set(&progress->layer, linfo->layer);
+
+		cairo_push_group(cr);
+		cairo_translate(cr, -extent->x, -extent->y);
+		cairo_scale(cr, 1, -1); // Fix coordinate system
+		cairo_set_source_rgb(cr, linfo->color.red, linfo->color.green, linfo->color.blue);
+		render_flat_layer(cr, lay, scale, outline, rects);
+		cairo_pop_group_to_source(cr);
+		cairo_paint_with_alpha(cr, linfo->color.alpha);
+
+		if (progress)
+			g_atomic_pointer_add(&progress->primitives_done, lay->primitives->len);
+	}
+
+	g_array_free(rects, TRUE);
+	g_array_free(outline, TRUE);
+}
+
+/**
+ * @brief Describe the state of a rendering
+ * @param progress Shared progress
+ * @param[out] buff Buffer to write the description to
+ * @param buff_size Buffer size
+ */
+static void format_progress(struct cairo_render_progress *progress, char *buff, size_t buff_size)
+{
+	gsize done = (gsize)g_atomic_pointer_get(&progress->primitives_done);
+	gsize total = (gsize)g_atomic_pointer_get(&progress->primitives_total);
+	gsize written_kb = (gsize)g_atomic_pointer_get(&progress->bytes_written) / 1024;
+	guint percent = 0;
+	char count[24];
+
+	if (total > 0)
+		percent = (guint)MIN(100, (guint64)done * 100 / total);
+
+	switch (g_atomic_int_get(&progress->phase)) {
+	case CAIRO_PHASE_FLATTENING:
+		g_snprintf(buff, buff_size, _("Flattening cell"));
+		break;
+	case CAIRO_PHASE_OUTLINES:
+		g_snprintf(buff, buff_size, _("Calculating path outlines"));
+		break;
+	case CAIRO_PHASE_RENDERING:
+		if (total > 0) {
+			g_snprintf(buff, buff_size, _("Rendering layers: %u %%"), percent);
+		} else {
+			g_snprintf(count, sizeof(count), "%" G_GSIZE_FORMAT, done);
+			g_snprintf(buff, buff_size, _("Rendering layers: %s shapes"), count);
+		}
+		break;
+	case CAIRO_PHASE_EXPORTING:
+		g_snprintf(count, sizeof(count), "%" G_GSIZE_FORMAT, written_kb);
+		g_snprintf(buff, buff_size, _("Exporting layer %d: %s kB written"),
+			   g_atomic_int_get(&progress->layer), count);
+		break;
+	case CAIRO_PHASE_FINISHED:
+		g_snprintf(count, sizeof(count), "%" G_GSIZE_FORMAT, written_kb);
+		g_snprintf(buff, buff_size, _("Export finished: %s kB written"), count);
+		break;
+	default:
+		g_snprintf(buff, buff_size, _("Starting renderer"));
+		break;
+	}
+}
+
+/**
+ * @brief Wait for a rendering in another process and display its progress
+ *
+ * The shared progress is polled every @ref CAIRO_PROGRESS_INTERVAL_MS milliseconds. The renderer's
+ * progress is only updated if the description changes.
+ *
+ * @param renderer Renderer to display the progress on
+ * @param fd The result of the rendering is read from this file descriptor
+ * @param progress Shared progress
+ * @param[out] result Buffer for the result. May be NULL if \p result_size is 0
+ * @param result_size Size of the result. If 0, wait until \p fd is closed
+ * @return 0 if the complete result is received, -1 otherwise
+ */
+static int wait_for_render(GdsOutputRenderer *renderer, int fd, struct cairo_render_progress *progress,
+			   void *result, size_t result_size)
+{
+	struct pollfd pfd;
+	char message[200];
+	char last_message[200] = "";
+	char scratch[256];
+	size_t received = 0;
+	ssize_t cnt;
+	gint message_serial = 0;
+	int ret = -1;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	while (1) {
+		if (poll(&pfd, 1, CAIRO_PROGRESS_INTERVAL_MS) < 0 && errno != EINTR)
+			break;
+
+		if (pfd.revents) {
+			cnt = read(fd, scratch, sizeof(scratch));
+			if (cnt < 0 && errno == EINTR)
+				continue;
+			if (cnt <= 0) {
+				/* Closed by the other side */
+				if (result_size == 0)
+					ret = 0;
+				break;
+			}
+
+			if (result_size) {
+				cnt = MIN((size_t)cnt, result_size - received);
+				memcpy(&((char *)result)[received], scratch, (size_t)cnt);
+				received += (size_t)cnt;
+				if (received == result_size) {
+					ret = 0;
+					break;
+				}
+			}
+		}
+
+		/* Status messages stay visible until the progress description changes */
+		if (get_progress_message(progress, &message_serial, message, sizeof(message)))
+			gds_output_renderer_update_async_progress(renderer, message);
+
+		format_progress(progress, message, sizeof(message));
+		if (strcmp(message, last_message)) {
+			gds_output_renderer_update_async_progress(renderer, message);
+			g_strlcpy(last_message, message, sizeof(last_message));
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Output file of a Cairo stream surface
+ */
+struct cairo_output_stream {
+	FILE *file; /**< @brief Output file */
+	struct cairo_render_progress *progress; /**< @brief Progress to count the written bytes in. May be NULL */
+};
+
+static cairo_status_t write_output_stream(void *closure, const unsigned char *data, unsigned int length)
+{
+	struct cairo_output_stream *stream = (struct cairo_output_stream *)closure;
+
+	if (fwrite(data, 1, length, stream->file) != length)
+		return CAIRO_STATUS_WRITE_ERROR;
+
+	if (stream->progress)
+		g_atomic_pointer_add(&stream->progress->bytes_written, length);
+
+	return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Calculate the extent of the output from the geometry
+ *
+ * The extent is derived from the bounding boxes of the cells, which are calculated once bottom-up.
+ * Only layers marked for rendering are included. Contrary to measuring the ink extents of the
+ * rendered layers, nothing has to be replayed.
+ *
+ * @param cell Toplevel cell. Unused if \p scene is given
+ * @param scene Flattened scene. May be NULL
+ * @param layer_infos List of layer information
+ * @param scale Scale the output image down by \p scale
+ * @param[out] extent Extent in the coordinates of the layers. Empty if nothing is rendered
+ * @return 0 if successful. -1 if \p cell is affected by a reference loop
+ */
+static int calculate_output_extent(struct gds_cell *cell, const struct flat_scene *scene, GList *layer_infos,
+				   double scale, cairo_rectangle_t *extent)
+{
+	GArray *layer_numbers;
+	GHashTable *boxes;
+	GList *info_list;
+	struct layer_info *linfo;
+	union bounding_box box;
+
+	memset(extent, 0, sizeof(*extent));
+
+	if (scene) {
+		box = scene->box;
+	} else {
+		layer_numbers = g_array_new(FALSE, FALSE, sizeof(int));
+		for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
+			linfo = (struct layer_info *)info_list->data;
+			if (linfo->render)
+				g_array_append_val(layer_numbers, linfo->layer);
+		}
+
+		boxes = calculate_cell_bounding_boxes_for_layers(cell, (const int *)layer_numbers->data,
+								 layer_numbers->len);
+		g_array_free(layer_numbers, TRUE);
+		if (!boxes)
+			return -1;
+
+		box = *(union bounding_box *)g_hash_table_lookup(boxes, cell);
+		g_hash_table_destroy(boxes);
 	}
 
-	/* Write layers to PDF */
+	if (box.vectors.lower_left.x > box.vectors.upper_right.x ||
+	    box.vectors.lower_left.y > box.vectors.upper_right.y)
+		return 0;
+
+	/* The layers are drawn with an inverted y axis */
+	extent->x = box.vectors.lower_left.x / scale;
+	extent->y = -box.vectors.upper_right.y / scale;
+	extent->width = (box.vectors.upper_right.x - box.vectors.lower_left.x) / scale;
+	extent->height = (box.vectors.upper_right.y - box.vectors.lower_left.y) / scale;
+
+	return 0;
+}
+
+/**
+ * @brief Assign the layers marked for rendering to the Cairo layers
+ * @param[out] layers Array of @ref MAX_LAYERS cleared layers
+ * @param layer_infos List of layer information
+ * @return 0 if successful, -3 if a layer number is too high
+ */
+static int assign_layers(struct cairo_layer *layers, GList *layer_infos)
+{
+	struct layer_info *linfo;
+	GList *info_list;
+
 	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
 		linfo = (struct layer_info *)info_list->data;
+		if (linfo->layer >= MAX_LAYERS) {
+			printf("Layer number (%d) too high!\n", linfo->layer);
+			return -3;
+		}
 
-		dprintf(comm_pipe[1], _("Exporting layer %d to file\n"), linfo->layer);
+		/* Layer shall not be rendered */
+		if (!linfo->render)
+			continue;
+
+		layers[(unsigned int)linfo->layer].linfo = linfo;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Render a cell hierarchy and paint it into the outputs
+ *
+ * The hierarchy is rendered on multiple threads. A cairo context must not be used by more than one thread,
+ * so each layer is recorded on its own surface. The recordings are painted into the outputs in stacking order.
+ * Each recording is freed right after it has been painted.
+ *
+ * @param cell Cell to render
+ * @param layers Layers set up by assign_layers()
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param outputs Cairo contexts of the outputs
+ * @param output_count Number of \p outputs
+ * @param extent Extent of the output
+ * @param scale Scale image down by this factor
+ * @param progress Shared progress. May be NULL
+ */
+static void render_hierarchy(struct gds_cell *cell, struct cairo_layer *layers, GList *layer_infos,
+			     cairo_t **outputs, guint output_count, const cairo_rectangle_t *extent, double scale,
+			     struct cairo_render_progress *progress)
+{
+	struct layer_info *linfo;
+	struct cairo_layer *lay;
+	struct path_outline_cache *outlines;
+	struct cairo_render_job *jobs = NULL;
+	GList *info_list;
+	guint job_count;
+	guint i;
+	int l;
+
+	for (l = 0; l < MAX_LAYERS; l++) {
+		lay = &layers[l];
+		if (!lay->linfo)
+			continue;
+
+		lay->rec = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+		lay->cr = cairo_create(lay->rec);
+		cairo_scale(lay->cr, 1, -1); // Fix coordinate system
+		cairo_set_source_rgb(lay->cr, lay->linfo->color.red, lay->linfo->color.green, lay->linfo->color.blue);
+	}
+
+	set_progress_phase(progress, CAIRO_PHASE_OUTLINES);
+	outlines = path_outline_cache_new();
+	path_outline_cache_build_for_cell(outlines, cell, 0);
+
+	set_progress_phase(progress, CAIRO_PHASE_RENDERING);
+	job_count = render_cell_parallel(cell, layers, outlines, scale, progress, &jobs);
+	path_outline_cache_free(outlines);
+
+	set_progress_phase(progress, CAIRO_PHASE_EXPORTING);
+
+	/* Write layers to the output in stacking order */
+	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
+		linfo = (struct layer_info *)info_list->data;
+
+		if (progress)
+			g_atomic_int_set(&progress->layer, linfo->layer);
 
 		if (linfo->layer >= MAX_LAYERS) {
 			printf(_("Layer outside of spec.\n"));
 			continue;
 		}
 
-		if (!linfo->render)
+		lay = &layers[linfo->layer];
+		if (!linfo->render || !lay->cr)
 			continue;
 
-		if (pdf_file && pdf_cr) {
-			cairo_set_source_surface(pdf_cr, layers[linfo->layer].rec, -xmin, -ymin);
-			cairo_paint_with_alpha(pdf_cr, linfo->color.alpha);
+		for (i = 0; i < output_count; i++) {
+			cairo_set_source_surface(outputs[i], lay->rec, -extent->x, -extent->y);
+			cairo_paint_with_alpha(outputs[i], linfo->color.alpha);
 		}
 
-		if (svg_file && svg_cr) {
-			cairo_set_source_surface(svg_cr, layers[linfo->layer].rec, -xmin, -ymin);
-			cairo_paint_with_alpha(svg_cr, linfo->color.alpha);
-		}
+		/* The layer is not needed anymore */
+		cairo_destroy(lay->cr);
+		cairo_surface_destroy(lay->rec);
+		lay->cr = NULL;
+		lay->rec = NULL;
+	}
+
+	free_render_jobs(jobs, job_count);
+}
+
+/**
+ * @brief Render \p cell to the output files in the current process
+ *
+ * This function leaks memory inside Cairo (see issue #16). It is only called in a separate process.
+ * The progress is reported in \p progress, which is shared with the parent process. Directly calling
+ * gds_output_renderer_update_async_progress() does not have any effect because this is a separate process.
+ *
+ * The size of the output is calculated from the geometry before rendering. Flattened scenes are drawn straight
+ * into the output files layer by layer. A cell hierarchy is rendered on multiple threads into one recording per
+ * layer. After rendering, the recordings are written to the output files in stacking order. Each recording is
+ * freed right after it has been written.
+ *
+ * @param renderer The current renderer this function is running from
+ * @param cell Toplevel cell to @ref Cairo-Renderer. Unused if \p shared_scene is given
+ * @param shared_scene Flattened scene to draw instead of \p cell. May be NULL
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param pdf_file PDF output file. Set to NULL if no PDF file has to be generated
+ * @param svg_file SVG output file. Set to NULL if no SVG file has to be generated
+ * @param scale Scale the output image down by \p scale
+ * @param progress Shared progress. May be NULL
+ * @return 0 if successful
+ */
+static int cairo_renderer_render_layers(GdsOutputRenderer *renderer, struct gds_cell *cell,
+					const struct flat_scene *shared_scene, GList *layer_infos,
+					const char *pdf_file, const char *svg_file, double scale,
+					struct cairo_render_progress *progress)
+{
+	cairo_surface_t *pdf_surface = NULL, *svg_surface = NULL;
+	cairo_t *pdf_cr = NULL, *svg_cr = NULL;
+	cairo_t *outputs[2];
+	guint output_count = 0;
+	struct cairo_layer *layers;
+	cairo_rectangle_t extent;
+	struct flat_scene *scene = NULL;
+	const struct flat_scene *flat;
+	char message[128];
+	char count[24];
+	struct cairo_output_stream pdf_stream = {NULL, progress};
+	struct cairo_output_stream svg_stream = {NULL, progress};
+	int ret;
+
+	layers = (struct cairo_layer *)calloc(MAX_LAYERS, sizeof(struct cairo_layer));
+
+	ret = assign_layers(layers, layer_infos);
+	if (ret)
+		goto ret_clear_layers;
+
+	if (!shared_scene && gds_output_renderer_requires_flat_scene(renderer)) {
+		set_progress_phase(progress, CAIRO_PHASE_FLATTENING);
+		scene = gds_output_renderer_flatten_cell(renderer, cell, layer_infos, scale);
+	}
+
+	/* Size the output before anything is rendered */
+	if (calculate_output_extent(cell, (shared_scene ? shared_scene : scene), layer_infos, scale, &extent)) {
+		printf(_("Cell is affected by reference loop. Cannot calculate its size\n"));
+		ret = -3;
+		goto ret_clear_layers;
 	}
+	g_snprintf(message, sizeof(message), _("Size of output: <%lf x %lf> @ (%lf | %lf)"), extent.width,
+		   extent.height, extent.x, extent.y);
+	set_progress_message(progress, message);
 
+	/* Stream the output to count the written bytes */
 	if (pdf_file) {
+		pdf_stream.file = fopen(pdf_file, "wb");
+		if (pdf_stream.file) {
+			pdf_surface = cairo_pdf_surface_create_for_stream(write_output_stream, &pdf_stream,
+									  extent.width, extent.height);
+			pdf_cr = cairo_create(pdf_surface);
+		} else {
+			printf(_("Could not open %s\n"), pdf_file);
+			ret = -4;
+		}
+	}
+
+	if (svg_file) {
+		svg_stream.file = fopen(svg_file, "wb");
+		if (svg_stream.file) {
+			svg_surface = cairo_svg_surface_create_for_stream(write_output_stream, &svg_stream,
+									  extent.width, extent.height);
+			svg_cr = cairo_create(svg_surface);
+		} else {
+			printf(_("Could not open %s\n"), svg_file);
+			ret = -4;
+		}
+	}
+
+	if (!pdf_cr && !svg_cr)
+		goto ret_clear_layers;
+
+	if (shared_scene || scene) {
+		flat = (shared_scene ? shared_scene : scene);
+		if (scene && gds_output_renderer_get_simplify_tolerance(renderer) > 0.0) {
+			g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT,
+				   gds_output_renderer_get_removed_vertices(renderer));
+			g_snprintf(message, sizeof(message), _("Simplification removed %s vertices"), count);
+			set_progress_message(progress, message);
+		}
+
+		/* The layers are drawn straight into the output surfaces */
+		set_progress_phase(progress, CAIRO_PHASE_RENDERING);
+		if (pdf_cr) {
+			if (progress)
+				g_atomic_pointer_add(&progress->primitives_total, flat->primitive_count);
+			render_flat_scene(flat, layer_infos, pdf_cr, &extent, scale, progress);
+		}
+		if (svg_cr) {
+			if (progress)
+				g_atomic_pointer_add(&progress->primitives_total, flat->primitive_count);
+			render_flat_scene(flat, layer_infos, svg_cr, &extent, scale, progress);
+		}
+
+		goto ret_clear_layers;
+	}
+
+	if (pdf_cr)
+		outputs[output_count++] = pdf_cr;
+	if (svg_cr)
+		outputs[output_count++] = svg_cr;
+	render_hierarchy(cell, layers, layer_infos, outputs, output_count, &extent, scale, progress);
+
+ret_clear_layers:
+	if (pdf_cr) {
 		cairo_show_page(pdf_cr);
 		cairo_destroy(pdf_cr);
 		cairo_surface_destroy(pdf_surface);
 	}
 
-	if (svg_file) {
+	if (svg_cr) {
 		cairo_show_page(svg_cr);
 		cairo_destroy(svg_cr);
 		cairo_surface_destroy(svg_surface);
 	}
 
-ret_clear_layers:
-	for (i = 0; i < MAX_LAYERS; i++) {
-		lay = &layers[i];
-		if (lay->cr) {
-			cairo_destroy(lay->cr);
-			cairo_surface_destroy(lay->rec);
-		}
-	}
+	/* The surfaces are finished. All data is written */
+	if (pdf_stream.file)
+		fclose(pdf_stream.file);
+	if (svg_stream.file)
+		fclose(svg_stream.file);
+
+	flat_scene_free(scene);
 	free(layers);
 
+	set_progress_phase(progress, CAIRO_PHASE_FINISHED);
 	printf(_("Cairo export finished. It might still be buggy!\n"));
 
-	/* Suspend child process */
-	exit(0);
+	return ret;
+}
 
-ret_parent:
-	close(comm_pipe[1]);
+int cairo_renderer_draw_cell(struct gds_cell *cell, GList *layer_infos, cairo_t *cr, double scale)
+{
+	struct cairo_layer *layers;
+	cairo_rectangle_t extent;
+	int ret;
+
+	if (!cell || !cr || scale <= 0.0)
+		return -1;
+
+	layers = (struct cairo_layer *)calloc(MAX_LAYERS, sizeof(struct cairo_layer));
+
+	ret = assign_layers(layers, layer_infos);
+	if (!ret && calculate_output_extent(cell, NULL, layer_infos, scale, &extent))
+		ret = -3;
+	if (!ret)
+		render_hierarchy(cell, layers, layer_infos, &cr, 1, &extent, scale, NULL);
+
+	free(layers);
+
+	return ret;
+}
+
+/**
+ * @brief Number of jobs after which the render worker is replaced by a new process
+ */
+#define CAIRO_WORKER_MAX_JOBS (32)
+
+/**
+ * @brief Resident memory in kB above which the render worker is replaced after its current job
+ */
+#define CAIRO_WORKER_MAX_RSS_KB (2UL * 1024UL * 1024UL)
+
+/**
+ * @brief Maximum number of render worker processes
+ *
+ * Jobs of concurrently running renderers, e.g. the per layer files, are distributed to the workers.
+ * Each worker renders with several threads itself. The number is limited to the processor count.
+ */
+#define CAIRO_WORKER_MAX_PROCESSES (4)
+
+/** @brief Magic number of a job */
+#define CAIRO_WORKER_JOB_MAGIC (0x424f4a43U)
+
+/** @brief Length of the layer names passed to the worker */
+#define CAIRO_WORKER_LAYER_NAME_MAX (64)
+
+/** @brief Return value if no worker process could be used */
+#define CAIRO_WORKER_UNAVAILABLE (-100)
+
+/**
+ * @brief Header of a render job
+ *
+ * A job is passed to the worker as memory file. The header is followed by the PDF file name,
+ * the SVG file name, the layer information (#cairo_worker_layer) and the serialized cell.
+ * If the renderer has a shared scene, the scene is passed instead of the cell. The worker then only draws it.
+ * If the scene is available as file (see gds_output_renderer_get_shared_scene_file()), it is not copied into
+ * the job. The scene file is sent to the worker right after the job file instead.
+ * The worker maps the file shared and reports its progress in cairo_worker_job::progress.
+ */
+struct cairo_worker_job {
+	struct cairo_render_progress progress; /**< @brief Progress. Written by the worker */
+	guint32 magic; /**< @brief Must be @ref CAIRO_WORKER_JOB_MAGIC */
+	guint32 layer_count; /**< @brief Number of #cairo_worker_layer elements */
+	guint32 pdf_file_length; /**< @brief Length of the PDF file name including the terminating 0. 0 if no PDF */
+	guint32 svg_file_length; /**< @brief Length of the SVG file name including the terminating 0. 0 if no SVG */
+	gint32 merge_shapes; /**< @brief Value of the "merge-shapes" property */
+	gint32 flat_scene; /**< @brief The job contains a serialized #flat_scene instead of a cell */
+	gint32 scene_file; /**< @brief The scene is sent as separate file. cairo_worker_job::cell_length is 0 */
+	guint32 reserved; /**< @brief Unused */
+	double simplify_tolerance; /**< @brief Value of the "simplify-tolerance" property */
+	double scale; /**< @brief Scale the output image down by this factor */
+	guint64 cell_length; /**< @brief Length of the serialized cell or scene */
+};
+
+/**
+ * @brief Result the worker sends after a job
+ */
+struct cairo_worker_result {
+	gint32 ret; /**< @brief Return value of the rendering */
+	guint32 reserved; /**< @brief Unused */
+	guint64 rss_kb; /**< @brief Resident memory of the worker in kB */
+};
+
+/**
+ * @brief Layer information of a render job
+ */
+struct cairo_worker_layer {
+	gint32 layer; /**< @brief Layer number */
+	gint32 render; /**< @brief Render the layer */
+	double red; /**< @brief Color */
+	double green; /**< @brief Color */
+	double blue; /**< @brief Color */
+	double alpha; /**< @brief Color */
+	char name[CAIRO_WORKER_LAYER_NAME_MAX]; /**< @brief Layer name. Truncated */
+};
+
+/**
+ * @brief A render worker process
+ *
+ * The worker is started on first use and serves jobs one after another.
+ */
+struct cairo_render_worker {
+	gboolean busy; /**< @brief Worker is reserved for a job */
+	pid_t pid; /**< @brief Process id of the worker */
+	int socket; /**< @brief Socket connected to the worker. -1 if no worker is running */
+	guint jobs; /**< @brief Jobs served by the running worker */
+};
+
+/**
+ * @brief The render worker processes of this process
+ */
+static struct {
+	GMutex lock; /**< @brief Protects cairo_render_worker::busy */
+	GCond idle; /**< @brief Signalled if a worker is released */
+	guint count; /**< @brief Number of usable workers. 0 until the first job */
+	struct cairo_render_worker workers[CAIRO_WORKER_MAX_PROCESSES]; /**< @brief Workers */
+} render_workers;
 
-	while (read_line_from_fd(comm_pipe[0], receive_message, sizeof(receive_message)) > 0) {
-		/* Strip \n from string and replace with ' ' */
-		for (i = 0; receive_message[i] != '\0'; i++) {
-			if (receive_message[i] == '\n')
-				receive_message[i] = ' ';
+/**
+ * @brief Reserve a render worker for a job
+ *
+ * Blocks until a worker is idle.
+ *
+ * @return Reserved worker
+ */
+static struct cairo_render_worker *render_worker_acquire(void)
+{
+	struct cairo_render_worker *worker = NULL;
+	guint i;
+
+	g_mutex_lock(&render_workers.lock);
+	if (!render_workers.count) {
+		render_workers.count = MAX(1U, MIN(g_get_num_processors(), CAIRO_WORKER_MAX_PROCESSES));
+		for (i = 0; i < CAIRO_WORKER_MAX_PROCESSES; i++)
+			render_workers.workers[i].socket = -1;
+	}
+
+	while (!worker) {
+		for (i = 0; i < render_workers.count; i++) {
+			if (!render_workers.workers[i].busy) {
+				worker = &render_workers.workers[i];
+				worker->busy = TRUE;
+				break;
+			}
 		}
+		if (!worker)
+			g_cond_wait(&render_workers.idle, &render_workers.lock);
+	}
+	g_mutex_unlock(&render_workers.lock);
+
+	return worker;
+}
+
+/**
+ * @brief Release a worker reserved by render_worker_acquire()
+ * @param worker Worker
+ */
+static void render_worker_release(struct cairo_render_worker *worker)
+{
+	g_mutex_lock(&render_workers.lock);
+	worker->busy = FALSE;
+	g_cond_signal(&render_workers.idle);
+	g_mutex_unlock(&render_workers.lock);
+}
+
+/**
+ * @brief Stop a render worker
+ *
+ * Closing the socket terminates the worker after its current job.
+ *
+ * @param worker Worker
+ */
+static void render_worker_stop(struct cairo_render_worker *worker)
+{
+	if (worker->socket < 0)
+		return;
+
+	close(worker->socket);
+	waitpid(worker->pid, NULL, 0);
+	worker->socket = -1;
+	worker->jobs = 0;
+}
+
+/**
+ * @brief Start the render worker if it is not running
+ *
+ * The worker is a fresh instance of this executable started with @ref CAIRO_RENDERER_WORKER_ARG.
+ * Contrary to a fork, this does not copy the address space of this process.
+ *
+ * @param worker Worker
+ * @return 0 if the worker is running
+ */
+static int render_worker_start(struct cairo_render_worker *worker)
+{
+	int sockets[2];
+	int fd;
+	int ret;
+	pid_t pid;
+	posix_spawn_file_actions_t actions;
+	char *argv[] = {"gds-render", CAIRO_RENDERER_WORKER_ARG, NULL};
+
+	if (worker->socket >= 0)
+		return 0;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets))
+		return -1;
+
+	/* dup2() to the same descriptor would keep the close-on-exec flag */
+	if (sockets[1] == CAIRO_RENDERER_WORKER_FD) {
+		fd = fcntl(sockets[1], F_DUPFD_CLOEXEC, CAIRO_RENDERER_WORKER_FD + 1);
+		close(sockets[1]);
+		sockets[1] = fd;
+	}
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, sockets[1], CAIRO_RENDERER_WORKER_FD);
+	ret = posix_spawn(&pid, "/proc/self/exe", &actions, NULL, argv, environ);
+	posix_spawn_file_actions_destroy(&actions);
+	close(sockets[1]);
+
+	if (ret) {
+		close(sockets[0]);
+		return -1;
+	}
+
+	worker->pid = pid;
+	worker->socket = sockets[0];
+	worker->jobs = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Send a file descriptor over a unix socket
+ * @param sock Socket
+ * @param fd File descriptor to send
+ * @return 0 if successful
+ */
+static int send_fd(int sock, int fd)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char data = 'J';
+	char control[CMSG_SPACE(sizeof(int))];
+
+	memset(&msg, 0, sizeof(msg));
+	memset(control, 0, sizeof(control));
+	iov.iov_base = &data;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+	return (sendmsg(sock, &msg, MSG_NOSIGNAL) == 1 ? 0 : -1);
+}
+
+/**
+ * @brief Receive a file descriptor sent by send_fd()
+ * @param sock Socket
+ * @return File descriptor or -1 if the socket was closed
+ */
+static int receive_fd(int sock)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char data;
+	char control[CMSG_SPACE(sizeof(int))];
+	int fd;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &data;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1)
+		return -1;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+		return -1;
+
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+	return fd;
+}
+
+/**
+ * @brief Send a job to a worker
+ * @param sock Socket of the worker
+ * @param job_fd Job file
+ * @param scene_fd Scene file sent after the job. -1 if the scene is part of the job
+ * @return 0 if successful
+ */
+static int send_job(int sock, int job_fd, int scene_fd)
+{
+	if (send_fd(sock, job_fd))
+		return -1;
+
+	return (scene_fd >= 0 ? send_fd(sock, scene_fd) : 0);
+}
+
+/**
+ * @brief Write a complete buffer to a file descriptor
+ * @param fd File descriptor
+ * @param data Data
+ * @param length Length of \p data
+ * @return 0 if successful
+ */
+static int write_all(int fd, const void *data, size_t length)
+{
+	const char *ptr = (const char *)data;
+	ssize_t cnt;
+
+	while (length > 0) {
+		cnt = write(fd, ptr, length);
+		if (cnt < 0)
+			return -1;
+		ptr += cnt;
+		length -= (size_t)cnt;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Write a render job to a new memory file
+ * @param renderer Renderer
+ * @param cell Cell to render
+ * @param shared_scene Flattened scene to render instead of \p cell. May be NULL
+ * @param layer_infos Layer information
+ * @param pdf_file PDF output file. May be NULL
+ * @param svg_file SVG output file. May be NULL
+ * @param scale Scale the output image down by \p scale
+ * @param scene_fd File containing \p shared_scene. -1 to copy the scene into the job
+ * @return File descriptor of the memory file or -1 in case of an error
+ */
+static int create_job_file(GdsOutputRenderer *renderer, struct gds_cell *cell,
+			   const struct flat_scene *shared_scene, GList *layer_infos,
+			   const char *pdf_file, const char *svg_file, double scale, int scene_fd)
+{
+	GByteArray *image;
+	GList *info_list;
+	struct layer_info *linfo;
+	struct cairo_worker_job job;
+	struct cairo_worker_layer wlayer;
+	gboolean merge_shapes = FALSE;
+	GArray *rendered_layers;
+	guint cell_start;
+	int fd;
+	int ret;
+
+	memset(&job, 0, sizeof(job));
+	job.magic = CAIRO_WORKER_JOB_MAGIC;
+	job.layer_count = g_list_length(layer_infos);
+	job.pdf_file_length = (pdf_file ? strlen(pdf_file) + 1 : 0);
+	job.svg_file_length = (svg_file ? strlen(svg_file) + 1 : 0);
+	g_object_get(renderer, "merge-shapes", &merge_shapes, NULL);
+	job.merge_shapes = merge_shapes;
+	job.flat_scene = (shared_scene ? 1 : 0);
+	job.scene_file = (shared_scene && scene_fd >= 0 ? 1 : 0);
+	job.simplify_tolerance = gds_output_renderer_get_simplify_tolerance(renderer);
+	job.scale = scale;
+
+	image = g_byte_array_new();
+	g_byte_array_append(image, (const guint8 *)&job, sizeof(job));
+	if (pdf_file)
+		g_byte_array_append(image, (const guint8 *)pdf_file, job.pdf_file_length);
+	if (svg_file)
+		g_byte_array_append(image, (const guint8 *)svg_file, job.svg_file_length);
+
+	rendered_layers = g_array_new(FALSE, FALSE, sizeof(int));
+	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list)) {
+		linfo = (struct layer_info *)info_list->data;
+		if (linfo->render)
+			g_array_append_val(rendered_layers, linfo->layer);
+		memset(&wlayer, 0, sizeof(wlayer));
+		wlayer.layer = linfo->layer;
+		wlayer.render = linfo->render;
+		wlayer.red = linfo->color.red;
+		wlayer.green = linfo->color.green;
+		wlayer.blue = linfo->color.blue;
+		wlayer.alpha = linfo->color.alpha;
+		if (linfo->name)
+			strncpy(wlayer.name, linfo->name, CAIRO_WORKER_LAYER_NAME_MAX - 1);
+		g_byte_array_append(image, (const guint8 *)&wlayer, sizeof(wlayer));
+	}
+
+	/* The shared scene contains the layers of all renderers. Only copy the ones drawn by this job */
+	cell_start = image->len;
+	if (job.scene_file)
+		ret = 0;
+	else if (shared_scene)
+		ret = flat_scene_serialize(shared_scene, (const int *)rendered_layers->data, rendered_layers->len,
+					   image);
+	else
+		ret = gds_serialize_cell(cell, image);
+	g_array_free(rendered_layers, TRUE);
+	if (ret) {
+		g_byte_array_free(image, TRUE);
+		return -1;
+	}
+
+	/* Patch the length of the cell into the header */
+	job.cell_length = image->len - cell_start;
+	memcpy(image->data, &job, sizeof(job));
+
+	fd = memfd_create("gds-render-job", MFD_CLOEXEC);
+	if (fd >= 0 && write_all(fd, image->data, image->len)) {
+		close(fd);
+		fd = -1;
+	}
+	g_byte_array_free(image, TRUE);
+
+	return fd;
+}
+
+/**
+ * @brief Render \p cell in a render worker process
+ *
+ * Concurrent jobs are distributed to up to @ref CAIRO_WORKER_MAX_PROCESSES workers.
+ * The progress of the worker is read from the job file. A worker is replaced after
+ * @ref CAIRO_WORKER_MAX_JOBS jobs or if its resident memory exceeds @ref CAIRO_WORKER_MAX_RSS_KB.
+ *
+ * @param renderer Renderer
+ * @param cell Cell to render
+ * @param shared_scene Flattened scene to render instead of \p cell. May be NULL
+ * @param layer_infos Layer information
+ * @param pdf_file PDF output file. May be NULL
+ * @param svg_file SVG output file. May be NULL
+ * @param scale Scale the output image down by \p scale
+ * @return Result of the job or @ref CAIRO_WORKER_UNAVAILABLE if the worker could not be used
+ */
+static int render_in_worker(GdsOutputRenderer *renderer, struct gds_cell *cell,
+			    const struct flat_scene *shared_scene, GList *layer_infos,
+			    const char *pdf_file, const char *svg_file, double scale)
+{
+	struct cairo_worker_job *job;
+	struct cairo_worker_result result;
+	struct cairo_render_worker *worker;
+	int job_fd;
+	int scene_fd = -1;
+	int ret = CAIRO_WORKER_UNAVAILABLE;
+
+	/* All renderers sharing the scene pass the same file to their workers */
+	if (shared_scene)
+		scene_fd = gds_output_renderer_get_shared_scene_file(renderer);
+
+	job_fd = create_job_file(renderer, cell, shared_scene, layer_infos, pdf_file, svg_file, scale, scene_fd);
+	if (job_fd < 0)
+		return CAIRO_WORKER_UNAVAILABLE;
+
+	job = (struct cairo_worker_job *)mmap(NULL, sizeof(*job), PROT_READ, MAP_SHARED, job_fd, 0);
+	if (job == MAP_FAILED) {
+		close(job_fd);
+		return CAIRO_WORKER_UNAVAILABLE;
+	}
+
+	worker = render_worker_acquire();
+
+	if (render_worker_start(worker))
+		goto ret_release;
+
+	if (send_job(worker->socket, job_fd, scene_fd)) {
+		/* The worker might have died after its last job. Try a new one */
+		render_worker_stop(worker);
+		if (render_worker_start(worker) || send_job(worker->socket, job_fd, scene_fd))
+			goto ret_release;
+	}
 
-		/* Update asyc progress*/
-		gds_output_renderer_update_async_progress(renderer, receive_message);
+	if (wait_for_render(renderer, worker->socket, &job->progress, &result, sizeof(result))) {
+		/* The worker crashed during the job. The job is not repeated */
+		ret = -5;
+		render_worker_stop(worker);
+	} else {
+		ret = result.ret;
+		/* A job the worker could not read (-10, -11) may leave the scene file on the socket */
+		if (++worker->jobs >= CAIRO_WORKER_MAX_JOBS || result.rss_kb > CAIRO_WORKER_MAX_RSS_KB ||
+		    result.ret == -10 || result.ret == -11)
+			render_worker_stop(worker);
 	}
 
-	waitpid(process_id, NULL, 0);
+ret_release:
+	render_worker_release(worker);
+	munmap(job, sizeof(*job));
+	close(job_fd);
+
+	return ret;
+}
+
+/**
+ * @brief Check if other threads are running in this process
+ *
+ * fork() only duplicates the calling thread. Locks held by other threads stay locked in the child.
+ *
+ * @return TRUE if the process has more than one thread or the thread count is unknown
+ */
+static gboolean process_is_threaded(void)
+{
+	FILE *status;
+	char line[128];
+	unsigned long threads = 0;
+
+	status = fopen("/proc/self/status", "r");
+	if (!status)
+		return TRUE;
+	while (fgets(line, sizeof(line), status)) {
+		if (sscanf(line, "Threads: %lu", &threads) == 1)
+			break;
+	}
+	fclose(status);
+
+	return threads != 1;
+}
+
+/**
+ * @brief Render \p cell in a forked child process
+ *
+ * Fallback if no render worker can be started. Must only be used if the process is not threaded.
+ *
+ * @param renderer Renderer
+ * @param cell Cell to render
+ * @param shared_scene Flattened scene to render instead of \p cell. May be NULL
+ * @param layer_infos Layer information
+ * @param pdf_file PDF output file. May be NULL
+ * @param svg_file SVG output file. May be NULL
+ * @param scale Scale the output image down by \p scale
+ * @return Result of the rendering in the child process. -2 if the child could not be started,
+ *	   -5 if it crashed
+ */
+static int render_in_child_process(GdsOutputRenderer *renderer, struct gds_cell *cell,
+				   const struct flat_scene *shared_scene, GList *layer_infos,
+				   const char *pdf_file, const char *svg_file, double scale)
+{
+	pid_t process_id;
+	int comm_pipe[2];
+	int status;
+	int ret;
+	struct cairo_render_progress *progress;
+
+	/* Shared progress. The pipe only signals the end of the child process */
+	progress = (struct cairo_render_progress *)mmap(NULL, sizeof(*progress), PROT_READ | PROT_WRITE,
+							MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (progress == MAP_FAILED)
+		return -2;
+	memset(progress, 0, sizeof(*progress));
+
+	if (pipe(comm_pipe) == -1) {
+		munmap(progress, sizeof(*progress));
+		return -2;
+	}
+
+	/* Fork to a new child process. This ensures the memory leaks (see issue #16) in Cairo don't
+	 * brick everything.
+	 *
+	 * And by the way: This now bricks all Windows compatibility. Deal with it.
+	 */
+	process_id = fork();
+	if (process_id < 0) {
+		fprintf(stderr, _("Fatal error: Cairo Renderer: Could not spawn child process!"));
+		close(comm_pipe[0]);
+		close(comm_pipe[1]);
+		munmap(progress, sizeof(*progress));
+		return -2;
+	} else if (process_id == 0) {
+		/* Close stdin (stdout and stderr may live on) */
+		close(0);
+		close(comm_pipe[0]);
+		ret = cairo_renderer_render_layers(renderer, cell, shared_scene, layer_infos, pdf_file, svg_file,
+						   scale, progress);
+
+		/* The low byte of the result is the exit status */
+		exit(ret & 0xFF);
+	}
+
+	close(comm_pipe[1]);
+
+	wait_for_render(renderer, comm_pipe[0], progress, NULL, 0);
+
+	if (waitpid(process_id, &status, 0) < 0 || !WIFEXITED(status))
+		ret = -5;
+	else
+		ret = (gint8)WEXITSTATUS(status);
 
 	close(comm_pipe[0]);
+	munmap(progress, sizeof(*progress));
+	return ret;
+}
+
+/**
+ * @brief Render \p cell to a PDF file specified by \p pdf_file
+ *
+ * Rendering takes place in a separate process, because Cairo leaks memory (see issue #16).
+ * If no render worker can be started, a child process is forked. Threaded processes render
+ * in the calling thread instead.
+ *
+ * @param renderer The current renderer this function is running from
+ * @param cell Toplevel cell to @ref Cairo-Renderer
+ * @param shared_scene Flattened scene to render instead of \p cell. May be NULL
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param pdf_file PDF output file. Set to NULL if no PDF file has to be generated
+ * @param svg_file SVG output file. Set to NULL if no SVG file has to be generated
+ * @param scale Scale the output image down by \p scale
+ * @return Error
+ */
+static int cairo_renderer_render_cell_to_vector_file(GdsOutputRenderer *renderer,
+						     struct gds_cell *cell,
+						     const struct flat_scene *shared_scene,
+						     GList *layer_infos,
+						     const char *pdf_file,
+						     const char *svg_file,
+						     double scale)
+{
+	int ret;
+
+	if (pdf_file == NULL && svg_file == NULL) {
+		/* No output specified */
+		return -1;
+	}
+
+	ret = render_in_worker(renderer, cell, shared_scene, layer_infos, pdf_file, svg_file, scale);
+	if (ret != CAIRO_WORKER_UNAVAILABLE)
+		return ret;
+
+	/* Renderers run on threads of a pool or a GTask. Forking these is unsafe.
+	 * Render in this process instead and accept the leaks of issue #16.
+	 */
+	if (process_is_threaded())
+		return cairo_renderer_render_layers(renderer, cell, shared_scene, layer_infos, pdf_file, svg_file,
+						    scale, NULL);
+
+	return render_in_child_process(renderer, cell, shared_scene, layer_infos, pdf_file, svg_file, scale);
+}
+
+/**
+ * @brief Get the resident memory of this process
+ * @return Resident memory in kB
+ */
+static unsigned long get_resident_memory_kb(void)
+{
+	FILE *statm;
+	unsigned long size = 0;
+	unsigned long resident = 0;
+
+	statm = fopen("/proc/self/statm", "r");
+	if (!statm)
+		return 0;
+	if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+		resident = 0;
+	fclose(statm);
+
+	return resident * (unsigned long)sysconf(_SC_PAGESIZE) / 1024UL;
+}
+
+/**
+ * @brief Load a scene from a file sent after the job
+ * @param sock Socket connected to the renderer
+ * @return Scene or NULL in case of an error
+ */
+static struct flat_scene *receive_scene_file(int sock)
+{
+	struct stat scene_stat;
+	struct flat_scene *scene = NULL;
+	void *data;
+	int scene_fd;
+
+	scene_fd = receive_fd(sock);
+	if (scene_fd < 0)
+		return NULL;
+
+	if (!fstat(scene_fd, &scene_stat) && scene_stat.st_size > 0) {
+		data = mmap(NULL, (size_t)scene_stat.st_size, PROT_READ, MAP_PRIVATE, scene_fd, 0);
+		if (data != MAP_FAILED) {
+			scene = flat_scene_deserialize((const guint8 *)data, (size_t)scene_stat.st_size);
+			munmap(data, (size_t)scene_stat.st_size);
+		}
+	}
+	close(scene_fd);
+
+	return scene;
+}
+
+/**
+ * @brief Execute a single render job in the worker
+ * @param job_fd Memory file containing the job
+ * @param sock Socket connected to the renderer. Used to receive the scene file
+ * @return Result of the rendering
+ */
+static int run_worker_job(int job_fd, int sock)
+{
+	struct stat job_stat;
+	guint8 *data;
+	struct cairo_worker_job job;
+	const struct cairo_worker_layer *wlayer;
+	struct cairo_worker_layer wlayer_copy;
+	struct layer_info *linfo;
+	GList *layer_infos = NULL;
+	GList *info_list;
+	struct gds_library *lib = NULL;
+	struct gds_cell *cell = NULL;
+	struct flat_scene *scene = NULL;
+	GList *lib_list;
+	CairoRenderer *renderer;
+	const char *pdf_file = NULL;
+	const char *svg_file = NULL;
+	size_t offset;
+	size_t length;
+	guint32 i;
+	int ret;
+
+	if (fstat(job_fd, &job_stat) || job_stat.st_size < (off_t)sizeof(job))
+		return -10;
+
+	length = (size_t)job_stat.st_size;
+	data = (guint8 *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, job_fd, 0);
+	if (data == MAP_FAILED)
+		return -10;
+
+	memcpy(&job, data, sizeof(job));
+	offset = sizeof(job);
+
+	/* Receive the scene file even if the job is rejected. Otherwise it is taken for the next job */
+	if (job.magic == CAIRO_WORKER_JOB_MAGIC && job.scene_file)
+		scene = receive_scene_file(sock);
+	if (job.magic != CAIRO_WORKER_JOB_MAGIC ||
+	    (guint64)job.pdf_file_length + job.svg_file_length +
+	    (guint64)job.layer_count * sizeof(struct cairo_worker_layer) + job.cell_length > length - offset) {
+		ret = -11;
+		goto ret_unmap;
+	}
+
+	if (job.pdf_file_length) {
+		pdf_file = (const char *)&data[offset];
+		offset += job.pdf_file_length;
+	}
+	if (job.svg_file_length) {
+		svg_file = (const char *)&data[offset];
+		offset += job.svg_file_length;
+	}
+	if ((pdf_file && pdf_file[job.pdf_file_length - 1]) || (svg_file && svg_file[job.svg_file_length - 1])) {
+		ret = -11;
+		goto ret_unmap;
+	}
+
+	for (i = 0; i < job.layer_count; i++) {
+		wlayer = (const struct cairo_worker_layer *)&data[offset];
+		memcpy(&wlayer_copy, wlayer, sizeof(wlayer_copy));
+		offset += sizeof(struct cairo_worker_layer);
+
+		linfo = (struct layer_info *)g_malloc0(sizeof(struct layer_info));
+		linfo->layer = wlayer_copy.layer;
+		linfo->render = wlayer_copy.render;
+		linfo->color.red = wlayer_copy.red;
+		linfo->color.green = wlayer_copy.green;
+		linfo->color.blue = wlayer_copy.blue;
+		linfo->color.alpha = wlayer_copy.alpha;
+		linfo->name = g_strndup(wlayer_copy.name, CAIRO_WORKER_LAYER_NAME_MAX);
+		layer_infos = g_list_append(layer_infos, linfo);
+	}
+
+	if (job.flat_scene && !job.scene_file)
+		scene = flat_scene_deserialize(&data[offset], (size_t)job.cell_length);
+	else if (!job.flat_scene)
+		lib = gds_deserialize_library(&data[offset], (size_t)job.cell_length, &cell);
+	if (!lib && !scene) {
+		ret = -12;
+		goto ret_free_infos;
+	}
+
+	renderer = (svg_file ? cairo_renderer_new_svg() : cairo_renderer_new_pdf());
+	g_object_set(renderer, "merge-shapes", (gboolean)job.merge_shapes,
+		     "simplify-tolerance", job.simplify_tolerance, NULL);
+
+	ret = cairo_renderer_render_layers(GDS_RENDER_OUTPUT_RENDERER(renderer), cell, scene, layer_infos,
+					   pdf_file, svg_file, job.scale,
+					   &((struct cairo_worker_job *)data)->progress);
+
+	g_object_unref(renderer);
+	if (lib) {
+		lib_list = g_list_append(NULL, lib);
+		clear_lib_list(&lib_list);
+	}
+
+ret_free_infos:
+	for (info_list = layer_infos; info_list != NULL; info_list = g_list_next(info_list))
+		g_free(((struct layer_info *)info_list->data)->name);
+	g_list_free_full(layer_infos, g_free);
+ret_unmap:
+	flat_scene_free(scene);
+	munmap(data, length);
+
+	return ret;
+}
+
+int cairo_renderer_worker_main(int fd)
+{
+	struct cairo_worker_result result;
+	int job_fd;
+
+	close(0);
+
+	/* Each job is answered with its result */
+	while ((job_fd = receive_fd(fd)) >= 0) {
+		memset(&result, 0, sizeof(result));
+		result.ret = run_worker_job(job_fd, fd);
+		close(job_fd);
+		result.rss_kb = get_resident_memory_kb();
+		if (write_all(fd, &result, sizeof(result)))
+			break;
+	}
+
+	close(fd);
+
 	return 0;
 }
 
@@ -473,7 +2266,8 @@ static int cairo_renderer_render_output(GdsOutputRenderer *renderer,
 		pdf_file = output_file;
 
 	gds_output_renderer_update_async_progress(renderer, _("Rendering Cairo Output..."));
-	ret = cairo_renderer_render_cell_to_vector_file(renderer, cell, layer_infos, pdf_file, svg_file, scale);
+	ret = cairo_renderer_render_cell_to_vector_file(renderer, cell, gds_output_renderer_get_shared_scene(renderer),
+							layer_infos, pdf_file, svg_file, scale);
 
 	if (settings)
 		g_object_unref(settings);
@@ -486,6 +2280,7 @@ static void cairo_renderer_class_init(CairoRendererClass *klass)
 	GdsOutputRendererClass *renderer_class = GDS_RENDER_OUTPUT_RENDERER_CLASS(klass);
 
 	renderer_class->render_output = cairo_renderer_render_output;
+	renderer_class->supports_shared_scene = TRUE;
 }
 
 CairoRenderer *cairo_renderer_new_pdf()
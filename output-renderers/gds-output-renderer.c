@@ -27,14 +27,43 @@
  *  @{
  */
 
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <gds-render/output-renderers/gds-output-renderer.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+#include <gds-render/geometric/polygon-union.h>
+#include <gds-render/geometric/polygon-simplify.h>
+#include <gds-render/gds-utils/gds-statistics.h>
 #include <glib/gi18n.h>
 
+/**
+ * @brief Estimated size of a shared scene above which the renderers traverse the cell on their own
+ *
+ * Renderers that flatten the cell anyway always share the scene.
+ */
+#define SHARED_SCENE_MAX_BYTES (512ULL * 1024ULL * 1024ULL)
+
 struct renderer_params {
 		struct gds_cell *cell;
 		double scale;
 };
 
+/**
+ * @brief Serialized image of a shared scene in a memory file
+ *
+ * The file is created on first use and shared by all consumers of the scene.
+ */
+struct shared_scene_file {
+	const struct flat_scene *scene; /**< @brief Scene */
+	GMutex lock; /**< @brief Protects shared_scene_file::fd and shared_scene_file::failed */
+	int fd; /**< @brief Memory file. -1 if not created yet */
+	gboolean failed; /**< @brief Creating the file failed. It is not tried again */
+};
+
 struct idle_function_params {
 	GMutex message_lock;
 	char *status_message;
@@ -43,18 +72,26 @@ struct idle_function_params {
 typedef struct {
 	gchar *output_file;
 	LayerSettings *layer_settings;
+	gboolean merge_shapes;
+	double simplify_tolerance;
+	guint64 removed_vertices;
+	const struct flat_scene *shared_scene;
+	struct shared_scene_file *shared_file;
 	GMutex settings_lock;
 	gboolean mutex_init_status;
 	GTask *task;
 	GMainContext *main_context;
 	struct renderer_params async_params;
 	struct idle_function_params idle_function_parameters;
-	gpointer padding[11];
+	gpointer padding[10];
 } GdsOutputRendererPrivate;
 
 enum {
 	PROP_OUTPUT_FILE = 1,
 	PROP_LAYER_SETTINGS,
+	PROP_MERGE_SHAPES,
+	PROP_SIMPLIFY_TOLERANCE,
+	PROP_REMOVED_VERTICES,
 	N_PROPERTIES
 };
 
@@ -125,6 +162,17 @@ static void gds_output_renderer_get_property(GObject *obj, guint property_id, GV
 	case PROP_LAYER_SETTINGS:
 		g_value_set_object(value, priv->layer_settings);
 		break;
+	case PROP_MERGE_SHAPES:
+		g_value_set_boolean(value, priv->merge_shapes);
+		break;
+	case PROP_SIMPLIFY_TOLERANCE:
+		g_value_set_double(value, priv->simplify_tolerance);
+		break;
+	case PROP_REMOVED_VERTICES:
+		g_mutex_lock(&priv->settings_lock);
+		g_value_set_uint64(value, priv->removed_vertices);
+		g_mutex_unlock(&priv->settings_lock);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
 		break;
@@ -153,6 +201,12 @@ static void gds_output_renderer_set_property(GObject *obj, guint property_id, co
 		g_object_ref(priv->layer_settings);
 		g_mutex_unlock(&priv->settings_lock);
 		break;
+	case PROP_MERGE_SHAPES:
+		priv->merge_shapes = g_value_get_boolean(value);
+		break;
+	case PROP_SIMPLIFY_TOLERANCE:
+		priv->simplify_tolerance = g_value_get_double(value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
 		break;
@@ -180,6 +234,18 @@ static void gds_output_renderer_class_init(GdsOutputRendererClass *klass)
 			g_param_spec_object(N_("layer-settings"), N_("Layer Settings object"),
 					    N_("Object containing the layer rendering information"),
 					    GDS_RENDER_TYPE_LAYER_SETTINGS, G_PARAM_READWRITE);
+	gds_output_renderer_properties[PROP_MERGE_SHAPES] =
+			g_param_spec_boolean(N_("merge-shapes"), N_("Merge shapes"),
+					     N_("Flatten the cell and merge overlapping shapes of each layer before rendering"),
+					     FALSE, G_PARAM_READWRITE);
+	gds_output_renderer_properties[PROP_SIMPLIFY_TOLERANCE] =
+			g_param_spec_double(N_("simplify-tolerance"), N_("Simplification tolerance"),
+					    N_("Maximum deviation of simplified polygons in output units. 0 disables simplification"),
+					    0.0, G_MAXDOUBLE, 0.0, G_PARAM_READWRITE);
+	gds_output_renderer_properties[PROP_REMOVED_VERTICES] =
+			g_param_spec_uint64(N_("removed-vertices"), N_("Removed vertices"),
+					    N_("Number of vertices removed by the last simplification"),
+					    0, G_MAXUINT64, 0, G_PARAM_READABLE);
 	g_object_class_install_properties(oclass, N_PROPERTIES, gds_output_renderer_properties);
 
 	/* Setup output signals */
@@ -213,6 +279,11 @@ void gds_output_renderer_init(GdsOutputRenderer *self)
 
 	priv->layer_settings = NULL;
 	priv->output_file = NULL;
+	priv->merge_shapes = FALSE;
+	priv->simplify_tolerance = 0.0;
+	priv->removed_vertices = 0ULL;
+	priv->shared_scene = NULL;
+	priv->shared_file = NULL;
 	priv->task = NULL;
 	priv->mutex_init_status = TRUE;
 	priv->main_context = NULL;
@@ -278,6 +349,98 @@ void gds_output_renderer_set_layer_settings(GdsOutputRenderer *renderer, LayerSe
 	g_object_set(renderer, N_("layer-settings"), settings, NULL);
 }
 
+void gds_output_renderer_set_merge_shapes(GdsOutputRenderer *renderer, gboolean merge)
+{
+	g_return_if_fail(GDS_RENDER_IS_OUTPUT_RENDERER(renderer));
+
+	g_object_set(renderer, N_("merge-shapes"), merge, NULL);
+}
+
+gboolean gds_output_renderer_get_merge_shapes(GdsOutputRenderer *renderer)
+{
+	gboolean merge = FALSE;
+
+	g_object_get(renderer, N_("merge-shapes"), &merge, NULL);
+	return merge;
+}
+
+void gds_output_renderer_set_simplify_tolerance(GdsOutputRenderer *renderer, double tolerance)
+{
+	g_return_if_fail(GDS_RENDER_IS_OUTPUT_RENDERER(renderer));
+
+	g_object_set(renderer, N_("simplify-tolerance"), tolerance, NULL);
+}
+
+double gds_output_renderer_get_simplify_tolerance(GdsOutputRenderer *renderer)
+{
+	double tolerance = 0.0;
+
+	g_object_get(renderer, N_("simplify-tolerance"), &tolerance, NULL);
+	return tolerance;
+}
+
+guint64 gds_output_renderer_get_removed_vertices(GdsOutputRenderer *renderer)
+{
+	guint64 removed = 0ULL;
+
+	g_object_get(renderer, N_("removed-vertices"), &removed, NULL);
+	return removed;
+}
+
+gboolean gds_output_renderer_requires_flat_scene(GdsOutputRenderer *renderer)
+{
+	return gds_output_renderer_get_merge_shapes(renderer) ||
+		gds_output_renderer_get_simplify_tolerance(renderer) > 0.0;
+}
+
+/**
+ * @brief Store the number of vertices removed by the simplification and notify the "removed-vertices" property
+ * @param renderer Renderer
+ * @param removed Number of removed vertices
+ */
+static void set_removed_vertices(GdsOutputRenderer *renderer, guint64 removed)
+{
+	GdsOutputRendererPrivate *priv = gds_output_renderer_get_instance_private(renderer);
+
+	g_mutex_lock(&priv->settings_lock);
+	priv->removed_vertices = removed;
+	g_mutex_unlock(&priv->settings_lock);
+	g_object_notify_by_pspec(G_OBJECT(renderer), gds_output_renderer_properties[PROP_REMOVED_VERTICES]);
+}
+
+struct flat_scene *gds_output_renderer_flatten_cell(GdsOutputRenderer *renderer, struct gds_cell *cell,
+						    GList *layer_infos, double scale)
+{
+	GArray *layer_numbers;
+	GList *iter;
+	struct layer_info *linfo;
+	struct flat_scene *scene;
+	double tolerance;
+	guint64 removed;
+
+	layer_numbers = g_array_new(FALSE, FALSE, sizeof(int));
+	for (iter = layer_infos; iter != NULL; iter = g_list_next(iter)) {
+		linfo = (struct layer_info *)iter->data;
+		if (linfo->render)
+			g_array_append_val(layer_numbers, linfo->layer);
+	}
+
+	scene = hierarchy_flatten_cell(cell, (const int *)layer_numbers->data, layer_numbers->len, 0);
+	g_array_free(layer_numbers, TRUE);
+
+	if (scene && gds_output_renderer_get_merge_shapes(renderer))
+		polygon_union_merge_scene(scene, 0);
+
+	/* The tolerance is given in output units. Convert it to database units */
+	tolerance = gds_output_renderer_get_simplify_tolerance(renderer) * scale;
+	if (scene && tolerance > 0.0) {
+		removed = polygon_simplify_scene(scene, tolerance, 0);
+		set_removed_vertices(renderer, removed);
+	}
+
+	return scene;
+}
+
 int gds_output_renderer_render_output(GdsOutputRenderer *renderer, struct gds_cell *cell, double scale)
 {
 	int ret;
@@ -315,6 +478,316 @@ int gds_output_renderer_render_output(GdsOutputRenderer *renderer, struct gds_ce
 	return ret;
 }
 
+void gds_output_renderer_set_shared_scene(GdsOutputRenderer *renderer, const struct flat_scene *scene)
+{
+	GdsOutputRendererPrivate *priv;
+
+	g_return_if_fail(GDS_RENDER_IS_OUTPUT_RENDERER(renderer));
+
+	priv = gds_output_renderer_get_instance_private(renderer);
+	g_mutex_lock(&priv->settings_lock);
+	priv->shared_scene = scene;
+	priv->shared_file = NULL;
+	g_mutex_unlock(&priv->settings_lock);
+}
+
+/**
+ * @brief Set the shared scene of a renderer together with its memory file
+ * @param renderer Renderer
+ * @param file Shared file. NULL to traverse the cell again
+ */
+static void set_shared_scene_file(GdsOutputRenderer *renderer, struct shared_scene_file *file)
+{
+	GdsOutputRendererPrivate *priv = gds_output_renderer_get_instance_private(renderer);
+
+	g_mutex_lock(&priv->settings_lock);
+	priv->shared_scene = (file ? file->scene : NULL);
+	priv->shared_file = file;
+	g_mutex_unlock(&priv->settings_lock);
+}
+
+/**
+ * @brief Write a serialized image of a scene to a new memory file
+ * @param scene Scene
+ * @return File descriptor or -1 in case of an error
+ */
+static int create_scene_file(const struct flat_scene *scene)
+{
+	GByteArray *image;
+	void *map;
+	int fd = -1;
+
+	image = g_byte_array_new();
+	if (flat_scene_serialize(scene, NULL, 0, image))
+		goto ret_free_image;
+
+	fd = memfd_create("gds-render-scene", MFD_CLOEXEC);
+	if (fd < 0)
+		goto ret_free_image;
+
+	if (ftruncate(fd, (off_t)image->len)) {
+		close(fd);
+		fd = -1;
+		goto ret_free_image;
+	}
+
+	map = mmap(NULL, image->len, PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		close(fd);
+		fd = -1;
+		goto ret_free_image;
+	}
+	memcpy(map, image->data, image->len);
+	munmap(map, image->len);
+
+ret_free_image:
+	g_byte_array_free(image, TRUE);
+
+	return fd;
+}
+
+int gds_output_renderer_get_shared_scene_file(GdsOutputRenderer *renderer)
+{
+	GdsOutputRendererPrivate *priv;
+	struct shared_scene_file *file;
+	int fd;
+
+	g_return_val_if_fail(GDS_RENDER_IS_OUTPUT_RENDERER(renderer), -1);
+
+	priv = gds_output_renderer_get_instance_private(renderer);
+	g_mutex_lock(&priv->settings_lock);
+	file = priv->shared_file;
+	g_mutex_unlock(&priv->settings_lock);
+	if (!file)
+		return -1;
+
+	/* The first consumer serializes the scene. All others wait for it */
+	g_mutex_lock(&file->lock);
+	if (file->fd < 0 && !file->failed) {
+		file->fd = create_scene_file(file->scene);
+		file->failed = (file->fd < 0);
+	}
+	fd = file->fd;
+	g_mutex_unlock(&file->lock);
+
+	return fd;
+}
+
+const struct flat_scene *gds_output_renderer_get_shared_scene(GdsOutputRenderer *renderer)
+{
+	GdsOutputRendererPrivate *priv;
+	const struct flat_scene *scene;
+
+	g_return_val_if_fail(GDS_RENDER_IS_OUTPUT_RENDERER(renderer), NULL);
+
+	priv = gds_output_renderer_get_instance_private(renderer);
+	g_mutex_lock(&priv->settings_lock);
+	scene = priv->shared_scene;
+	g_mutex_unlock(&priv->settings_lock);
+
+	return scene;
+}
+
+/**
+ * @brief Check if two renderers can draw the same flattened scene
+ *
+ * The layer settings do not have to match. Every renderer only draws its own layers of the scene.
+ *
+ * @param a Renderer
+ * @param b Renderer
+ * @return TRUE if both use the same shape merging and simplification
+ */
+static gboolean renderers_share_scene(GdsOutputRenderer *a, GdsOutputRenderer *b)
+{
+	GdsOutputRendererPrivate *priv_a = gds_output_renderer_get_instance_private(a);
+	GdsOutputRendererPrivate *priv_b = gds_output_renderer_get_instance_private(b);
+
+	return priv_a->merge_shapes == priv_b->merge_shapes &&
+		priv_a->simplify_tolerance == priv_b->simplify_tolerance;
+}
+
+/**
+ * @brief Check if the flattened scene of the given layers is small enough to be shared
+ * @param cell Cell to flatten
+ * @param layers Set of layer numbers
+ * @return TRUE if the estimated scene size is below @ref SHARED_SCENE_MAX_BYTES
+ */
+static gboolean shared_scene_fits(struct gds_cell *cell, GHashTable *layers)
+{
+	struct gds_cell_statistics stats;
+	const struct gds_layer_statistics *lstat;
+	guint64 bytes = 0ULL;
+	guint i;
+
+	if (gds_statistics_calculate(cell, &stats))
+		return FALSE;
+
+	for (i = 0; i < stats.layers->len; i++) {
+		lstat = &g_array_index(stats.layers, struct gds_layer_statistics, i);
+		if (!g_hash_table_contains(layers, GINT_TO_POINTER(lstat->layer)))
+			continue;
+		/* The counts saturate. Check them before multiplying */
+		if (lstat->primitive_count > SHARED_SCENE_MAX_BYTES || lstat->vertex_count > SHARED_SCENE_MAX_BYTES)
+			break;
+		bytes += lstat->primitive_count * sizeof(struct flat_primitive) +
+			 lstat->vertex_count * sizeof(struct vector_2d);
+		if (bytes > SHARED_SCENE_MAX_BYTES)
+			break;
+	}
+	gds_statistics_free(&stats);
+
+	return i == stats.layers->len;
+}
+
+/**
+ * @brief Flatten a cell for all layers rendered by at least one of the \p consumers
+ *
+ * Renderers that do not flatten the cell on their own only get a scene if its estimated size
+ * is below @ref SHARED_SCENE_MAX_BYTES.
+ *
+ * @param consumers Array of GdsOutputRenderer objects sharing the scene
+ * @param cell Cell to flatten
+ * @param scale Render scale
+ * @return Flattened scene or NULL
+ */
+static struct flat_scene *flatten_cell_for_consumers(GPtrArray *consumers, struct gds_cell *cell, double scale)
+{
+	GPtrArray *settings;
+	GHashTable *layers;
+	GList *union_infos = NULL;
+	GList *iter;
+	LayerSettings *sett;
+	struct layer_info *linfo;
+	struct flat_scene *scene;
+	GdsOutputRenderer *first;
+	guint64 removed;
+	guint i;
+
+	settings = g_ptr_array_new_with_free_func(g_object_unref);
+	layers = g_hash_table_new(NULL, NULL);
+
+	for (i = 0; i < consumers->len; i++) {
+		sett = gds_output_renderer_get_and_ref_layer_settings(GDS_RENDER_OUTPUT_RENDERER(consumers->pdata[i]));
+		if (!sett)
+			continue;
+		g_ptr_array_add(settings, sett);
+
+		for (iter = layer_settings_get_layer_info_list(sett); iter != NULL; iter = g_list_next(iter)) {
+			linfo = (struct layer_info *)iter->data;
+			if (!linfo->render || g_hash_table_contains(layers, GINT_TO_POINTER(linfo->layer)))
+				continue;
+			g_hash_table_add(layers, GINT_TO_POINTER(linfo->layer));
+			union_infos = g_list_append(union_infos, linfo);
+		}
+	}
+
+	first = GDS_RENDER_OUTPUT_RENDERER(consumers->pdata[0]);
+	if (gds_output_renderer_requires_flat_scene(first) || shared_scene_fits(cell, layers))
+		scene = gds_output_renderer_flatten_cell(first, cell, union_infos, scale);
+	else
+		scene = NULL;
+
+	/* The scene was simplified by the first consumer. Report the result on all of them */
+	if (scene && gds_output_renderer_get_simplify_tolerance(first) > 0.0) {
+		removed = gds_output_renderer_get_removed_vertices(first);
+		for (i = 1; i < consumers->len; i++)
+			set_removed_vertices(GDS_RENDER_OUTPUT_RENDERER(consumers->pdata[i]), removed);
+	}
+
+	g_list_free(union_infos);
+	g_hash_table_destroy(layers);
+	g_ptr_array_free(settings, TRUE);
+
+	return scene;
+}
+
+/**
+ * @brief Parameters of a renderer thread started by gds_output_renderer_render_output_list()
+ */
+struct render_list_job {
+	GdsOutputRenderer *renderer; /**< @brief Renderer */
+	struct gds_cell *cell; /**< @brief Cell to render */
+	double scale; /**< @brief Scale */
+	int ret; /**< @brief Result of the renderer */
+};
+
+static void render_list_job_run(gpointer data, gpointer user_data)
+{
+	struct render_list_job *job = (struct render_list_job *)data;
+	(void)user_data;
+
+	job->ret = gds_output_renderer_render_output(job->renderer, job->cell, job->scale);
+}
+
+int gds_output_renderer_render_output_list(GList *renderers, struct gds_cell *cell, double scale)
+{
+	GList *iter;
+	GdsOutputRenderer *renderer;
+	GdsOutputRenderer *first_consumer = NULL;
+	GPtrArray *consumers;
+	struct flat_scene *scene = NULL;
+	struct shared_scene_file file;
+	struct render_list_job *jobs;
+	GThreadPool *pool;
+	guint count;
+	guint i;
+	int ret = 0;
+
+	count = g_list_length(renderers);
+	if (count == 0)
+		return 0;
+
+	/* Collect the renderers that can draw the scene of the first capable renderer */
+	consumers = g_ptr_array_new();
+	for (iter = renderers; iter != NULL; iter = g_list_next(iter)) {
+		renderer = GDS_RENDER_OUTPUT_RENDERER(iter->data);
+		if (!GDS_RENDER_OUTPUT_RENDERER_GET_CLASS(renderer)->supports_shared_scene)
+			continue;
+		if (!first_consumer)
+			first_consumer = renderer;
+		if (renderers_share_scene(first_consumer, renderer))
+			g_ptr_array_add(consumers, renderer);
+	}
+
+	/* A single renderer is better off with its own traversal */
+	if (consumers->len > 1)
+		scene = flatten_cell_for_consumers(consumers, cell, scale);
+
+	file.scene = scene;
+	g_mutex_init(&file.lock);
+	file.fd = -1;
+	file.failed = FALSE;
+	for (i = 0; scene && i < consumers->len; i++)
+		set_shared_scene_file(GDS_RENDER_OUTPUT_RENDERER(consumers->pdata[i]), &file);
+
+	/* Per layer outputs may create many renderers. Limit the number of concurrent ones */
+	jobs = g_new(struct render_list_job, count);
+	pool = g_thread_pool_new(render_list_job_run, NULL, MIN(count, g_get_num_processors()), FALSE, NULL);
+	for (iter = renderers, i = 0; iter != NULL; iter = g_list_next(iter), i++) {
+		jobs[i].renderer = GDS_RENDER_OUTPUT_RENDERER(iter->data);
+		jobs[i].cell = cell;
+		jobs[i].scale = scale;
+		jobs[i].ret = 0;
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	for (i = 0; i < count && !ret; i++)
+		ret = jobs[i].ret;
+
+	for (i = 0; scene && i < consumers->len; i++)
+		set_shared_scene_file(GDS_RENDER_OUTPUT_RENDERER(consumers->pdata[i]), NULL);
+	if (file.fd >= 0)
+		close(file.fd);
+	g_mutex_clear(&file.lock);
+	flat_scene_free(scene);
+
+	g_free(jobs);
+	g_ptr_array_free(consumers, TRUE);
+
+	return ret;
+}
+
 static void gds_output_renderer_async_wrapper(GTask *task,
 					     gpointer source_object,
 					     gpointer task_data,
@@ -26,6 +26,10 @@
 #include <math.h>
 #include <stdio.h>
 #include <gds-render/output-renderers/latex-renderer.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+#include <gds-render/geometric/rectangle-decomposition.h>
 #include <gdk/gdk.h>
 #include <glib/gi18n.h>
 
@@ -152,6 +156,94 @@ static gboolean write_layer_env(FILE *tex_file, GdkRGBA *color, int layer, GList
 	return FALSE;
 }
 
+/**
+ * @brief Writes a closed, filled polygon to the specified tex_file
+ * @param tex_file File to write to
+ * @param v Vertices
+ * @param count Vertex count
+ * @param layer Layer number
+ * @param alpha Fill opacity
+ * @param buffer Working buffer
+ * @param scale Scale abject down by this value
+ */
+static void write_filled_polygon(FILE *tex_file, const struct vector_2d *v, size_t count, int layer, double alpha,
+				 GString *buffer, double scale)
+{
+	size_t i;
+
+	g_string_printf(buffer,
+			"\\draw[line width=0.00001 pt, draw={c%d}, fill={c%d}, fill opacity={%lf}, nonzero rule] ",
+			layer, layer, alpha);
+	WRITEOUT_BUFFER(buffer);
+	for (i = 0; i < count; i++) {
+		g_string_printf(buffer, "(%lf pt, %lf pt) -- ", v[i].x/scale, v[i].y/scale);
+		WRITEOUT_BUFFER(buffer);
+	}
+	g_string_printf(buffer, "cycle;\n");
+	WRITEOUT_BUFFER(buffer);
+}
+
+/**
+ * @brief Writes an open polyline with the thinnest line width to the specified tex_file
+ *
+ * Used for paths with a width of 0.
+ *
+ * @param tex_file File to write to
+ * @param v Vertices
+ * @param count Vertex count
+ * @param layer Layer number
+ * @param alpha Line opacity
+ * @param buffer Working buffer
+ * @param scale Scale abject down by this value
+ */
+static void write_hairline(FILE *tex_file, const struct vector_2d *v, size_t count, int layer, double alpha,
+			   GString *buffer, double scale)
+{
+	size_t i;
+
+	g_string_printf(buffer, "\\draw[line width=0 pt, draw={c%d}, draw opacity={%lf}] ", layer, alpha);
+	WRITEOUT_BUFFER(buffer);
+	for (i = 0; i < count; i++) {
+		g_string_printf(buffer, "%s(%lf pt, %lf pt)", (i ? " -- " : ""), v[i].x/scale, v[i].y/scale);
+		WRITEOUT_BUFFER(buffer);
+	}
+	g_string_printf(buffer, ";\n");
+	WRITEOUT_BUFFER(buffer);
+}
+
+/**
+ * @brief Write rectangles as a single filled TikZ path
+ *
+ * TikZ rectangle operations are processed much faster than long polygon paths.
+ *
+ * @param tex_file File to write to
+ * @param rects Array of #bounding_box
+ * @param layer Layer number
+ * @param alpha Fill opacity
+ * @param buffer Working buffer
+ * @param scale Scale abject down by this value
+ */
+static void write_filled_rectangles(FILE *tex_file, const GArray *rects, int layer, double alpha,
+				    GString *buffer, double scale)
+{
+	const union bounding_box *box;
+	guint i;
+
+	g_string_printf(buffer,
+			"\\draw[line width=0.00001 pt, draw={c%d}, fill={c%d}, fill opacity={%lf}, nonzero rule]",
+			layer, layer, alpha);
+	WRITEOUT_BUFFER(buffer);
+	for (i = 0; i < rects->len; i++) {
+		box = &g_array_index(rects, union bounding_box, i);
+		g_string_printf(buffer, " (%lf pt, %lf pt) rectangle (%lf pt, %lf pt)",
+				box->vectors.lower_left.x/scale, box->vectors.lower_left.y/scale,
+				box->vectors.upper_right.x/scale, box->vectors.upper_right.y/scale);
+		WRITEOUT_BUFFER(buffer);
+	}
+	g_string_printf(buffer, ";\n");
+	WRITEOUT_BUFFER(buffer);
+}
+
 /**
  * @brief Writes a graphics object to the specified tex_file
  *
@@ -161,32 +253,39 @@ static gboolean write_layer_env(FILE *tex_file, GdkRGBA *color, int layer, GList
  * @param graphics Object to render
  * @param linfo Layer information
  * @param buffer Working buffer
+ * @param outlines Cache of path outlines
  * @param scale Scale abject down by this value
  */
-static void generate_graphics(FILE *tex_file, GList *graphics, GList *linfo, GString *buffer, double scale)
+static void generate_graphics(FILE *tex_file, GList *graphics, GList *linfo, GString *buffer,
+			      struct path_outline_cache *outlines, double scale)
 {
 	GList *temp;
-	GList *temp_vertex;
 	struct gds_graphics *gfx;
-	struct gds_point *pt;
+	const struct gds_point *pt;
 	GdkRGBA color;
-	static const char * const line_caps[] = {"butt", "round", "rect"};
+	const GArray *outline;
+	GArray *rects;
+	size_t i;
+
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
 
 	for (temp = graphics; temp != NULL; temp = temp->next) {
 		gfx = (struct gds_graphics *)temp->data;
 		if (write_layer_env(tex_file, &color, (int)gfx->layer, linfo, buffer) == TRUE) {
 
 			/* Layer is defined => create graphics */
-			if (gfx->gfx_type == GRAPHIC_POLYGON || gfx->gfx_type == GRAPHIC_BOX) {
+			g_array_set_size(rects, 0);
+			if (rectangle_decomposition_calculate_from_gfx(gfx, rects) == 0) {
+				/* Manhattan polygons are written as rectangles */
+				write_filled_rectangles(tex_file, rects, gfx->layer, color.alpha, buffer, scale);
+			} else if (gfx->gfx_type == GRAPHIC_POLYGON || gfx->gfx_type == GRAPHIC_BOX) {
 				g_string_printf(buffer,
 						"\\draw[line width=0.00001 pt, draw={c%d}, fill={c%d}, fill opacity={%lf}] ",
 						gfx->layer, gfx->layer, color.alpha);
 				WRITEOUT_BUFFER(buffer);
 				/* Append vertices */
-				for (temp_vertex = gfx->vertices;
-				     temp_vertex != NULL;
-				     temp_vertex = temp_vertex->next) {
-					pt = (struct gds_point *)temp_vertex->data;
+				for (i = 0; i < gfx->vertex_count; i++) {
+					pt = &gfx->vertex_array[i];
 					g_string_printf(buffer, "(%lf pt, %lf pt) -- ",
 							((double)pt->x)/scale,
 							((double)pt->y)/scale);
@@ -195,42 +294,88 @@ static void generate_graphics(FILE *tex_file, GList *graphics, GList *linfo, GSt
 				g_string_printf(buffer, "cycle;\n");
 				WRITEOUT_BUFFER(buffer);
 			} else if (gfx->gfx_type == GRAPHIC_PATH) {
+				/* Paths are written as filled outlines. Caps and joins are part of the outline */
+				outline = path_outline_cache_lookup(outlines, gfx);
+				if (outline && outline->len > 0 && gfx->width_absolute == 0)
+					write_hairline(tex_file, (const struct vector_2d *)outline->data, outline->len,
+						       gfx->layer, color.alpha, buffer, scale);
+				else if (outline && outline->len > 0)
+					write_filled_polygon(tex_file, (const struct vector_2d *)outline->data, outline->len,
+							     gfx->layer, color.alpha, buffer, scale);
+			}
 
-				if (g_list_length(gfx->vertices) < 2) {
-					printf("Cannot write path with less than 2 points\n");
-					break;
-				}
+			g_string_printf(buffer, "\\ifcreatepdflayers\n\\end{scope}\n\\fi\n\\end{pgfonlayer}\n");
+			WRITEOUT_BUFFER(buffer);
+		}
 
-				if (gfx->path_render_type < 0 || gfx->path_render_type > 2) {
-					printf("Path type unrecognized. Setting to 'flushed'\n");
-					gfx->path_render_type = PATH_FLUSH;
-				}
+	} /* For graphics */
 
-				g_string_printf(buffer, "\\draw[line width=%lf pt, draw={c%d}, opacity={%lf}, cap=%s] ",
-						gfx->width_absolute/scale, gfx->layer, color.alpha,
-						line_caps[gfx->path_render_type]);
-				WRITEOUT_BUFFER(buffer);
+	g_array_free(rects, TRUE);
+}
 
-				/* Append vertices */
-				for (temp_vertex = gfx->vertices;
-				     temp_vertex != NULL;
-				     temp_vertex = temp_vertex->next) {
-					pt = (struct gds_point *)temp_vertex->data;
-					g_string_printf(buffer, "(%lf pt, %lf pt)%s",
-							((double)pt->x)/scale,
-							((double)pt->y)/scale,
-							(temp_vertex->next ? " -- " : ""));
-					WRITEOUT_BUFFER(buffer);
+/**
+ * @brief Writes all graphics of a flattened scene to the specified tex_file
+ *
+ * Each layer is opened only once.
+ *
+ * @param tex_file File to write to
+ * @param scene Flattened scene
+ * @param linfo Layer information
+ * @param buffer Working buffer
+ * @param scale Scale abject down by this value
+ */
+static void generate_flat_graphics(FILE *tex_file, const struct flat_scene *scene, GList *linfo, GString *buffer,
+				   double scale)
+{
+	const struct flat_layer *lay;
+	const struct flat_primitive *prim;
+	const struct vector_2d *v;
+	GArray *outline;
+	GArray *rects;
+	GdkRGBA color;
+	guint i, j;
+	int ret;
+
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+
+	for (i = 0; i < scene->layers->len; i++) {
+		lay = &g_array_index(scene->layers, struct flat_layer, i);
+		if (write_layer_env(tex_file, &color, lay->layer, linfo, buffer) == FALSE)
+			continue;
+
+		for (j = 0; j < lay->primitives->len; j++) {
+			prim = &g_array_index(lay->primitives, struct flat_primitive, j);
+			v = &g_array_index(lay->vertices, struct vector_2d, prim->first_vertex);
+
+			if (prim->gfx_type == GRAPHIC_PATH) {
+				g_array_set_size(outline, 0);
+				ret = path_outline_calculate_from_vectors(v, prim->vertex_count, prim->width,
+									  prim->path_render_type, outline);
+				if (ret == PATH_OUTLINE_HAIRLINE)
+					write_hairline(tex_file, (const struct vector_2d *)outline->data, outline->len,
+						       lay->layer, color.alpha, buffer, scale);
+				else if (ret == 0)
+					write_filled_polygon(tex_file, (const struct vector_2d *)outline->data,
+							     outline->len, lay->layer, color.alpha, buffer, scale);
+			} else if (prim->vertex_count > 0) {
+				g_array_set_size(rects, 0);
+				if (rectangle_decomposition_calculate(v, prim->vertex_count, rects) == 0) {
+					write_filled_rectangles(tex_file, rects, lay->layer, color.alpha, buffer,
+								scale);
+					continue;
 				}
-				g_string_printf(buffer, ";\n");
-				WRITEOUT_BUFFER(buffer);
+				write_filled_polygon(tex_file, v, prim->vertex_count, lay->layer, color.alpha, buffer,
+						     scale);
 			}
-
-			g_string_printf(buffer, "\\ifcreatepdflayers\n\\end{scope}\n\\fi\n\\end{pgfonlayer}\n");
-			WRITEOUT_BUFFER(buffer);
 		}
 
-	} /* For graphics */
+		g_string_printf(buffer, "\\ifcreatepdflayers\n\\end{scope}\n\\fi\n\\end{pgfonlayer}\n");
+		WRITEOUT_BUFFER(buffer);
+	}
+
+	g_array_free(rects, TRUE);
+	g_array_free(outline, TRUE);
 }
 
 /**
@@ -239,15 +384,17 @@ static void generate_graphics(FILE *tex_file, GList *graphics, GList *linfo, GSt
  * @param layer_infos Layer information
  * @param tex_file File to write to
  * @param buffer Working buffer
+ * @param outlines Cache of path outlines
  * @param scale Scale output down by this value
  * @param renderer The current renderer as GdsOutputRenderer. This is used to emit the status updates to the GUI
  */
-static void render_cell(struct gds_cell *cell, GList *layer_infos, FILE *tex_file, GString *buffer, double scale,
-			GdsOutputRenderer *renderer)
+static void render_cell(struct gds_cell *cell, GList *layer_infos, FILE *tex_file, GString *buffer,
+			struct path_outline_cache *outlines, double scale, GdsOutputRenderer *renderer)
 {
 	GString *status;
 	GList *list_child;
 	struct gds_cell_instance *inst;
+	struct cell_transform trans;
 
 	status = g_string_new(NULL);
 	g_string_printf(status, _("Generating cell %s"), cell->name);
@@ -255,7 +402,7 @@ static void render_cell(struct gds_cell *cell, GList *layer_infos, FILE *tex_fil
 	g_string_free(status, TRUE);
 
 	/* Draw polygons of current cell */
-	generate_graphics(tex_file, cell->graphic_objs, layer_infos, buffer, scale);
+	generate_graphics(tex_file, cell->graphic_objs, layer_infos, buffer, outlines, scale);
 
 	/* Draw polygons of childs */
 	for (list_child = cell->child_cells; list_child != NULL; list_child = list_child->next) {
@@ -265,6 +412,23 @@ static void render_cell(struct gds_cell *cell, GList *layer_infos, FILE *tex_fil
 		if (!inst->cell_ref)
 			continue;
 
+		cell_transform_init_from_instance(&trans, inst);
+
+		if (trans.manhattan) {
+			/* Single scope with an exact integer matrix */
+			g_string_printf(buffer, "\\begin{scope}[cm={%d,%d,%d,%d,(%lf pt,%lf pt)}]\n",
+					(int)trans.matrix.xx, (int)trans.matrix.yx,
+					(int)trans.matrix.xy, (int)trans.matrix.yy,
+					((double)trans.mt.x0) / scale, ((double)trans.mt.y0) / scale);
+			WRITEOUT_BUFFER(buffer);
+
+			render_cell(inst->cell_ref, layer_infos, tex_file, buffer, outlines, scale, renderer);
+
+			g_string_printf(buffer, "\\end{scope}\n");
+			WRITEOUT_BUFFER(buffer);
+			continue;
+		}
+
 		/* generate translation scope */
 		g_string_printf(buffer, "\\begin{scope}[shift={(%lf pt,%lf pt)}]\n",
 				((double)inst->origin.x) / scale, ((double)inst->origin.y) / scale);
@@ -278,7 +442,7 @@ static void render_cell(struct gds_cell *cell, GList *layer_infos, FILE *tex_fil
 				inst->magnification);
 		WRITEOUT_BUFFER(buffer);
 
-		render_cell(inst->cell_ref, layer_infos, tex_file, buffer, scale, renderer);
+		render_cell(inst->cell_ref, layer_infos, tex_file, buffer, outlines, scale, renderer);
 
 		g_string_printf(buffer, "\\end{scope}\n");
 		WRITEOUT_BUFFER(buffer);
@@ -296,7 +460,11 @@ static int latex_render_cell_to_code(struct gds_cell *cell, GList *layer_infos,
 			       gboolean create_pdf_layers, gboolean standalone_document, GdsOutputRenderer *renderer)
 {
 	GString *working_line;
-
+	struct path_outline_cache *outlines;
+	struct flat_scene *scene = NULL;
+	const struct flat_scene *shared_scene;
+	gchar *status;
+	char count[24];
 
 	if (!tex_file || !layer_infos || !cell)
 		return -1;
@@ -327,8 +495,30 @@ static int latex_render_cell_to_code(struct gds_cell *cell, GList *layer_infos,
 	WRITEOUT_BUFFER(working_line);
 
 	/* Generate graphics output */
-	render_cell(cell, layer_infos, tex_file, working_line, scale, renderer);
+	shared_scene = gds_output_renderer_get_shared_scene(renderer);
+	if (!shared_scene && gds_output_renderer_requires_flat_scene(renderer)) {
+		gds_output_renderer_update_async_progress(renderer, _("Flattening cell"));
+		scene = gds_output_renderer_flatten_cell(renderer, cell, layer_infos, scale);
+	}
 
+	if (shared_scene) {
+		generate_flat_graphics(tex_file, shared_scene, layer_infos, working_line, scale);
+	} else if (scene) {
+		if (gds_output_renderer_get_simplify_tolerance(renderer) > 0.0) {
+			g_snprintf(count, sizeof(count), "%" G_GUINT64_FORMAT,
+				   gds_output_renderer_get_removed_vertices(renderer));
+			status = g_strdup_printf(_("Simplification removed %s vertices"), count);
+			gds_output_renderer_update_async_progress(renderer, status);
+			g_free(status);
+		}
+		generate_flat_graphics(tex_file, scene, layer_infos, working_line, scale);
+		flat_scene_free(scene);
+	} else {
+		outlines = path_outline_cache_new();
+		path_outline_cache_build_for_cell(outlines, cell, 0);
+		render_cell(cell, layer_infos, tex_file, working_line, outlines, scale, renderer);
+		path_outline_cache_free(outlines);
+	}
 
 	g_string_printf(working_line, "\\end{tikzpicture}\n");
 	WRITEOUT_BUFFER(working_line);
@@ -428,6 +618,7 @@ static void latex_renderer_class_init(LatexRendererClass *klass)
 
 	/* Overwrite virtual function */
 	render_class->render_output = latex_renderer_render_output;
+	render_class->supports_shared_scene = TRUE;
 
 	/* Property stuff */
 	oclass->get_property = latex_renderer_get_property;
@@ -0,0 +1,808 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file native-pdf-renderer.c
+ * @brief PDF output renderer writing the cell hierarchy as Form XObjects
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * Each cell is written once per layer it draws on. Instances reference the form of their cell with
+ * a transformation matrix. The content streams of a batch of forms are generated and compressed
+ * in parallel and written to the file in order afterwards.
+ */
+
+/**
+ * @addtogroup Native-PDF-Renderer
+ * @{
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glib/gi18n.h>
+
+#include <gds-render/output-renderers/native-pdf-renderer.h>
+#include <gds-render/output-renderers/pdf-writer.h>
+#include <gds-render/geometric/cell-geometrics.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/layer/layer-settings.h>
+
+/** @brief Object number of the document catalog */
+#define PDF_OBJ_CATALOG (1)
+/** @brief Object number of the page tree */
+#define PDF_OBJ_PAGES (2)
+/** @brief Object number of the page */
+#define PDF_OBJ_PAGE (3)
+/** @brief Object number of the content stream of the page */
+#define PDF_OBJ_PAGE_CONTENT (4)
+/** @brief First free object number */
+#define PDF_OBJ_FIRST_FREE (5)
+
+/**
+ * @brief Struct representing the native PDF renderer object
+ */
+struct _NativePdfRenderer {
+	GdsOutputRenderer parent;
+	int compression_level; /**< @brief zlib compression level of the content streams. 0: Uncompressed */
+};
+
+G_DEFINE_TYPE(NativePdfRenderer, native_pdf_renderer, GDS_RENDER_TYPE_OUTPUT_RENDERER)
+
+enum {
+	PROP_COMPRESSION_LEVEL = 1,
+	N_PROPERTIES
+};
+
+/**
+ * @brief Layer written to the PDF
+ */
+struct native_pdf_layer {
+	int layer; /**< @brief Layer number */
+	const char *name; /**< @brief Layer name. Owned by the layer settings */
+	double red; /**< @brief Red component of the layer color */
+	double green; /**< @brief Green component of the layer color */
+	double blue; /**< @brief Blue component of the layer color */
+	double alpha; /**< @brief Opacity of the layer */
+	guint ocg_object; /**< @brief Object number of the optional content group. 0 if the layer is empty */
+	guint gstate_object; /**< @brief Object number of the graphics state setting the opacity */
+	guint group_object; /**< @brief Object number of the transparency group drawing the layer */
+};
+
+/**
+ * @brief Cell written to the PDF
+ */
+struct native_pdf_cell {
+	struct gds_cell *cell; /**< @brief Cell */
+	guint *forms; /**< @brief Object number of the form of each layer. 0 if the cell does not draw the layer */
+};
+
+/**
+ * @brief Everything needed to write the forms of a cell hierarchy
+ *
+ * The document is read-only while the forms are generated.
+ */
+struct native_pdf_document {
+	GArray *layers; /**< @brief Array of #native_pdf_layer in stacking order */
+	GHashTable *layer_index; /**< @brief Maps a layer number to its index in native_pdf_document::layers plus 1 */
+	GHashTable *cells; /**< @brief Maps each #gds_cell to its #native_pdf_cell */
+	GPtrArray *cell_order; /**< @brief All #native_pdf_cell. Sub cells come before their parents */
+	GHashTable *boxes; /**< @brief Maps each #gds_cell to its #bounding_box on the rendered layers */
+	struct path_outline_cache *outlines; /**< @brief Outlines of all paths */
+	guint object_count; /**< @brief Number of objects including the free object 0 */
+	int compression_level; /**< @brief zlib compression level. 0: Uncompressed */
+};
+
+/**
+ * @brief Form XObject generated by a single thread
+ */
+struct native_pdf_form {
+	const struct native_pdf_document *doc; /**< @brief Document */
+	const struct native_pdf_cell *pcell; /**< @brief Cell drawn by the form */
+	guint layer_idx; /**< @brief Index of the drawn layer in native_pdf_document::layers */
+	guint object; /**< @brief Object number of the form */
+	GString *dict; /**< @brief Stream dictionary without the length */
+	GBytes *stream; /**< @brief Stream data. NULL if the generation failed */
+};
+
+/**
+ * @brief Check if a graphics object adds a subpath to the content stream
+ * @param doc Document
+ * @param gfx Graphics object
+ * @return TRUE if append_graphics() draws \p gfx
+ */
+static gboolean graphics_is_drawn(const struct native_pdf_document *doc, const struct gds_graphics *gfx)
+{
+	const GArray *outline;
+
+	switch (gfx->gfx_type) {
+	case GRAPHIC_PATH:
+		outline = path_outline_cache_lookup(doc->outlines, gfx);
+		return (outline && outline->len > 0);
+	case GRAPHIC_BOX:
+		/* Expected fallthrough */
+	case GRAPHIC_POLYGON:
+		return (gfx->vertex_count > 0);
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * @brief Append a graphics object as closed subpath to a content stream
+ * @param doc Document
+ * @param str Content stream
+ * @param gfx Graphics object
+ * @return TRUE if a subpath has been added. Paths without width are added as open center line
+ */
+static gboolean append_graphics(const struct native_pdf_document *doc, GString *str, const struct gds_graphics *gfx)
+{
+	const GArray *outline;
+	const struct vector_2d *pt;
+	guint i;
+
+	if (!graphics_is_drawn(doc, gfx))
+		return FALSE;
+
+	switch (gfx->gfx_type) {
+	case GRAPHIC_PATH:
+		/* Paths are filled as polygon outlines. Caps and joins are part of the outline */
+		outline = path_outline_cache_lookup(doc->outlines, gfx);
+		for (i = 0; i < outline->len; i++) {
+			pt = &g_array_index(outline, struct vector_2d, i);
+			pdf_append_number(str, pt->x);
+			g_string_append_c(str, ' ');
+			pdf_append_number(str, pt->y);
+			g_string_append(str, (i == 0 ? " m\n" : " l\n"));
+		}
+		/* Paths without width are stroked along their open center line */
+		if (gfx->width_absolute == 0)
+			return TRUE;
+		break;
+	case GRAPHIC_BOX:
+		/* Expected fallthrough */
+	case GRAPHIC_POLYGON:
+		for (i = 0; i < gfx->vertex_count; i++)
+			g_string_append_printf(str, "%d %d %s\n", gfx->vertex_array[i].x, gfx->vertex_array[i].y,
+					       (i == 0 ? "m" : "l"));
+		break;
+	default:
+		return FALSE;
+	}
+
+	g_string_append(str, "h\n");
+
+	return TRUE;
+}
+
+/**
+ * @brief Generate the Form XObject of a cell on a layer
+ * @param data Form
+ * @param user_data Unused
+ */
+static void native_pdf_form_run(gpointer data, gpointer user_data)
+{
+	struct native_pdf_form *form = (struct native_pdf_form *)data;
+	const struct native_pdf_document *doc = form->doc;
+	const struct native_pdf_layer *layer = &g_array_index(doc->layers, struct native_pdf_layer, form->layer_idx);
+	const struct native_pdf_cell *child;
+	struct cell_transform trans;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	GHashTable *referenced;
+	GString *resources;
+	GString *content;
+	GList *iter;
+	guint object;
+	(void)user_data;
+
+	content = g_string_sized_new(1024);
+	resources = g_string_new(NULL);
+	referenced = g_hash_table_new(NULL, NULL);
+
+	for (iter = form->pcell->cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+
+		child = (const struct native_pdf_cell *)g_hash_table_lookup(doc->cells, inst->cell_ref);
+		object = (child ? child->forms[form->layer_idx] : 0U);
+		if (!object)
+			continue;
+
+		cell_transform_init_from_instance(&trans, inst);
+		g_string_append(content, "q ");
+		pdf_append_matrix(content, &trans.matrix);
+		g_string_append_printf(content, " /X%u Do Q\n", object);
+
+		if (!g_hash_table_contains(referenced, GUINT_TO_POINTER(object))) {
+			g_hash_table_add(referenced, GUINT_TO_POINTER(object));
+			g_string_append_printf(resources, " /X%u %u 0 R", object, object);
+		}
+	}
+
+	/* Each shape is filled on its own. Overlapping shapes with opposite orientation would cancel out */
+	for (iter = form->pcell->cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		if (gfx->layer != layer->layer)
+			continue;
+		if (!append_graphics(doc, content, gfx))
+			continue;
+		if (gfx->gfx_type == GRAPHIC_PATH && gfx->width_absolute == 0)
+			g_string_append(content, "S\n");
+		else
+			g_string_append(content, "f\n");
+	}
+
+	form->dict = g_string_new("<< /Type /XObject /Subtype /Form /BBox ");
+	pdf_append_box(form->dict, (const union bounding_box *)g_hash_table_lookup(doc->boxes, form->pcell->cell));
+	if (resources->len)
+		g_string_append_printf(form->dict, " /Resources << /XObject <<%s >> >>", resources->str);
+	else
+		g_string_append(form->dict, " /Resources << >>");
+	form->stream = pdf_finish_stream(content, doc->compression_level, form->dict);
+
+	g_hash_table_destroy(referenced);
+	g_string_free(resources, TRUE);
+}
+
+/**
+ * @brief Collect a cell and its sub cells and the layers they draw on
+ *
+ * Each cell is visited only once. native_pdf_cell::forms is set to 1 for each layer the cell or
+ * one of its sub cells draws on. Graphics that do not add a subpath are ignored. Cells with an empty
+ * bounding box get no forms at all.
+ *
+ * @param doc Document
+ * @param cell Cell
+ * @return Cell of the document
+ */
+static struct native_pdf_cell *collect_cells(struct native_pdf_document *doc, struct gds_cell *cell)
+{
+	struct native_pdf_cell *pcell;
+	const struct native_pdf_cell *child;
+	const union bounding_box *box;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+	GList *iter;
+	gpointer index;
+	guint i;
+
+	pcell = (struct native_pdf_cell *)g_hash_table_lookup(doc->cells, cell);
+	if (pcell)
+		return pcell;
+
+	pcell = g_new(struct native_pdf_cell, 1);
+	pcell->cell = cell;
+	/* One additional element. This keeps the array valid if no layer is rendered */
+	pcell->forms = g_new0(guint, doc->layers->len + 1);
+	g_hash_table_insert(doc->cells, cell, pcell);
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		index = g_hash_table_lookup(doc->layer_index, GINT_TO_POINTER((int)gfx->layer));
+		if (index && graphics_is_drawn(doc, gfx))
+			pcell->forms[GPOINTER_TO_UINT(index) - 1] = 1;
+	}
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+		child = collect_cells(doc, inst->cell_ref);
+		for (i = 0; i < doc->layers->len; i++)
+			pcell->forms[i] |= child->forms[i];
+	}
+
+	/* A form needs a valid /BBox */
+	box = (const union bounding_box *)g_hash_table_lookup(doc->boxes, cell);
+	if (!box || box->vectors.lower_left.x > box->vectors.upper_right.x ||
+	    box->vectors.lower_left.y > box->vectors.upper_right.y)
+		memset(pcell->forms, 0, sizeof(guint) * doc->layers->len);
+
+	g_ptr_array_add(doc->cell_order, pcell);
+
+	return pcell;
+}
+
+/**
+ * @brief Free a cell of the document
+ * @param data Cell
+ */
+static void native_pdf_cell_free(gpointer data)
+{
+	struct native_pdf_cell *pcell = (struct native_pdf_cell *)data;
+
+	g_free(pcell->forms);
+	g_free(pcell);
+}
+
+/**
+ * @brief Prepare the document and number all objects
+ * @param doc Document to fill
+ * @param cell Toplevel cell
+ * @param layer_infos List of #layer_info. Only layers marked for rendering are written, in list order
+ * @param compression_level zlib compression level
+ * @return 0 if successful. -1 if \p cell is affected by a reference loop
+ */
+static int native_pdf_document_init(struct native_pdf_document *doc, struct gds_cell *cell, GList *layer_infos,
+				     int compression_level)
+{
+	struct native_pdf_layer layer;
+	struct native_pdf_layer *lay;
+	struct native_pdf_cell *pcell;
+	struct native_pdf_cell *top;
+	struct layer_info *linfo;
+	GArray *layer_numbers;
+	GList *iter;
+	guint i, j;
+
+	memset(doc, 0, sizeof(*doc));
+	doc->compression_level = compression_level;
+	doc->layers = g_array_new(FALSE, FALSE, sizeof(struct native_pdf_layer));
+	doc->layer_index = g_hash_table_new(NULL, NULL);
+	doc->cells = g_hash_table_new_full(NULL, NULL, NULL, native_pdf_cell_free);
+	doc->cell_order = g_ptr_array_new();
+	layer_numbers = g_array_new(FALSE, FALSE, sizeof(int));
+
+	for (iter = layer_infos; iter != NULL; iter = g_list_next(iter)) {
+		linfo = (struct layer_info *)iter->data;
+		if (!linfo->render || g_hash_table_contains(doc->layer_index, GINT_TO_POINTER(linfo->layer)))
+			continue;
+
+		memset(&layer, 0, sizeof(layer));
+		layer.layer = linfo->layer;
+		layer.name = linfo->name;
+		layer.red = linfo->color.red;
+		layer.green = linfo->color.green;
+		layer.blue = linfo->color.blue;
+		layer.alpha = linfo->color.alpha;
+		g_array_append_val(doc->layers, layer);
+		g_array_append_val(layer_numbers, linfo->layer);
+		g_hash_table_insert(doc->layer_index, GINT_TO_POINTER(linfo->layer),
+				    GUINT_TO_POINTER(doc->layers->len));
+	}
+
+	doc->boxes = calculate_cell_bounding_boxes_for_layers(cell, (const int *)layer_numbers->data,
+							      layer_numbers->len);
+	g_array_free(layer_numbers, TRUE);
+	if (!doc->boxes)
+		return -1;
+
+	/* The outlines decide which paths are drawn */
+	doc->outlines = path_outline_cache_new();
+	path_outline_cache_build_for_cell(doc->outlines, cell, 0);
+
+	top = collect_cells(doc, cell);
+
+	/* Number the objects. Only layers drawn by the toplevel cell get a group */
+	doc->object_count = PDF_OBJ_FIRST_FREE;
+	for (i = 0; i < doc->layers->len; i++) {
+		lay = &g_array_index(doc->layers, struct native_pdf_layer, i);
+		if (!top->forms[i])
+			continue;
+		lay->ocg_object = doc->object_count++;
+		lay->gstate_object = doc->object_count++;
+		lay->group_object = doc->object_count++;
+	}
+
+	for (j = 0; j < doc->cell_order->len; j++) {
+		pcell = (struct native_pdf_cell *)doc->cell_order->pdata[j];
+		for (i = 0; i < doc->layers->len; i++) {
+			if (pcell->forms[i])
+				pcell->forms[i] = doc->object_count++;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Free the contents of a document
+ * @param doc Document
+ */
+static void native_pdf_document_clear(struct native_pdf_document *doc)
+{
+	path_outline_cache_free(doc->outlines);
+	if (doc->boxes)
+		g_hash_table_destroy(doc->boxes);
+	g_ptr_array_free(doc->cell_order, TRUE);
+	g_hash_table_destroy(doc->cells);
+	g_hash_table_destroy(doc->layer_index);
+	g_array_free(doc->layers, TRUE);
+}
+
+/**
+ * @brief Write the forms of all cells
+ *
+ * A batch of forms is generated in parallel. Afterwards, the batch is written in order.
+ *
+ * @param renderer Renderer used for progress reports
+ * @param doc Document
+ * @param writer Writer
+ * @return 0 if successful
+ */
+static int write_cell_forms(GdsOutputRenderer *renderer, const struct native_pdf_document *doc,
+			    struct pdf_writer *writer)
+{
+	const struct native_pdf_cell *pcell;
+	struct native_pdf_form form;
+	struct native_pdf_form *forms;
+	GArray *todo;
+	GThreadPool *pool;
+	gchar *status;
+	guint batch, first, i, j;
+	int ret = 0;
+
+	todo = g_array_new(FALSE, TRUE, sizeof(struct native_pdf_form));
+	for (j = 0; j < doc->cell_order->len; j++) {
+		pcell = (const struct native_pdf_cell *)doc->cell_order->pdata[j];
+		for (i = 0; i < doc->layers->len; i++) {
+			if (!pcell->forms[i])
+				continue;
+			memset(&form, 0, sizeof(form));
+			form.doc = doc;
+			form.pcell = pcell;
+			form.layer_idx = i;
+			form.object = pcell->forms[i];
+			g_array_append_val(todo, form);
+		}
+	}
+
+	forms = (struct native_pdf_form *)todo->data;
+	batch = MAX(1U, 4U * g_get_num_processors());
+
+	for (first = 0; first < todo->len; first += batch) {
+		status = g_strdup_printf(_("Writing form %u of %u"), first + 1, todo->len);
+		gds_output_renderer_update_async_progress(renderer, status);
+		g_free(status);
+
+		pool = g_thread_pool_new(native_pdf_form_run, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+		for (i = first; i < first + batch && i < todo->len; i++)
+			g_thread_pool_push(pool, &forms[i], NULL);
+		g_thread_pool_free(pool, FALSE, TRUE);
+
+		for (i = first; i < first + batch && i < todo->len; i++) {
+			if (forms[i].stream)
+				pdf_write_stream(writer, forms[i].object, forms[i].dict, forms[i].stream);
+			else
+				ret = -1;
+			g_string_free(forms[i].dict, TRUE);
+			if (forms[i].stream)
+				g_bytes_unref(forms[i].stream);
+		}
+
+		if (ret)
+			break;
+	}
+
+	g_array_free(todo, TRUE);
+
+	return ret;
+}
+
+/**
+ * @brief Write the page, the layer groups and the document structure
+ * @param doc Document
+ * @param writer Writer
+ * @param top Toplevel cell of the document
+ * @param scale Scale the output down by \p scale. One output unit is one point
+ * @return 0 if successful
+ */
+static int write_page(const struct native_pdf_document *doc, struct pdf_writer *writer,
+		      const struct native_pdf_cell *top, double scale)
+{
+	const struct native_pdf_layer *lay;
+	const union bounding_box *box;
+	union bounding_box media;
+	struct affine_2d device;
+	GString *content;
+	GString *dict;
+	GString *str;
+	GString *ocgs;
+	GString *xobjects;
+	GString *gstates;
+	GString *properties;
+	GBytes *stream;
+	guint i, j;
+	int ret = 0;
+
+	box = (const union bounding_box *)g_hash_table_lookup(doc->boxes, top->cell);
+	media.vectors.lower_left.x = 0.0;
+	media.vectors.lower_left.y = 0.0;
+	media.vectors.upper_right.x = (box->vectors.upper_right.x - box->vectors.lower_left.x) / scale;
+	media.vectors.upper_right.y = (box->vectors.upper_right.y - box->vectors.lower_left.y) / scale;
+
+	/* Database units to points. PDF and GDS both have an upward y axis */
+	device.xx = 1.0 / scale;
+	device.yx = 0.0;
+	device.xy = 0.0;
+	device.yy = 1.0 / scale;
+	device.x0 = -box->vectors.lower_left.x / scale;
+	device.y0 = -box->vectors.lower_left.y / scale;
+
+	content = g_string_new(NULL);
+	ocgs = g_string_new(NULL);
+	xobjects = g_string_new(NULL);
+	gstates = g_string_new(NULL);
+	properties = g_string_new(NULL);
+	str = g_string_new(NULL);
+
+	for (i = 0; i < doc->layers->len && !ret; i++) {
+		lay = &g_array_index(doc->layers, struct native_pdf_layer, i);
+		if (!lay->group_object)
+			continue;
+
+		/* Optional content group */
+		g_string_assign(str, "<< /Type /OCG /Name ");
+		if (lay->name && lay->name[0]) {
+			pdf_append_literal(str, lay->name);
+		} else {
+			g_string_append_printf(str, "(Layer %d)", lay->layer);
+		}
+		g_string_append(str, " >>");
+		pdf_write_object(writer, lay->ocg_object, str->str);
+
+		/* Opacity. The transparency group is composited as a whole with it */
+		g_string_assign(str, "<< /Type /ExtGState /ca ");
+		pdf_append_number(str, lay->alpha);
+		g_string_append(str, " /CA ");
+		pdf_append_number(str, lay->alpha);
+		g_string_append(str, " >>");
+		pdf_write_object(writer, lay->gstate_object, str->str);
+
+		/* Transparency group drawing the layer of the toplevel cell in its color */
+		dict = g_string_new("<< /Type /XObject /Subtype /Form /BBox ");
+		pdf_append_box(dict, &media);
+		g_string_append_printf(dict, " /Group << /S /Transparency >> /Resources << /XObject << /X%u %u 0 R >> >>",
+				       top->forms[i], top->forms[i]);
+		g_string_truncate(str, 0);
+		for (j = 0; j < 2; j++) {
+			pdf_append_number(str, lay->red);
+			g_string_append_c(str, ' ');
+			pdf_append_number(str, lay->green);
+			g_string_append_c(str, ' ');
+			pdf_append_number(str, lay->blue);
+			g_string_append(str, (j == 0 ? " rg\n" : " RG\n"));
+		}
+		/* Paths without width are stroked with the thinnest line of the device */
+		g_string_append(str, "0 w\n");
+		pdf_append_matrix(str, &device);
+		g_string_append_printf(str, "\n/X%u Do\n", top->forms[i]);
+		stream = pdf_finish_stream(g_string_new_len(str->str, (gssize)str->len), doc->compression_level, dict);
+		if (stream) {
+			pdf_write_stream(writer, lay->group_object, dict, stream);
+			g_bytes_unref(stream);
+		} else {
+			ret = -1;
+		}
+		g_string_free(dict, TRUE);
+
+		g_string_append_printf(content, "/OC /L%u BDC\n/GS%u gs\n/G%u Do\nEMC\n", i, i, i);
+		g_string_append_printf(ocgs, " %u 0 R", lay->ocg_object);
+		g_string_append_printf(xobjects, " /G%u %u 0 R", i, lay->group_object);
+		g_string_append_printf(gstates, " /GS%u %u 0 R", i, lay->gstate_object);
+		g_string_append_printf(properties, " /L%u %u 0 R", i, lay->ocg_object);
+	}
+
+	if (!ret) {
+		dict = g_string_new("<<");
+		stream = pdf_finish_stream(g_string_new_len(content->str, (gssize)content->len),
+					   doc->compression_level, dict);
+		if (stream) {
+			pdf_write_stream(writer, PDF_OBJ_PAGE_CONTENT, dict, stream);
+			g_bytes_unref(stream);
+		} else {
+			ret = -1;
+		}
+		g_string_free(dict, TRUE);
+	}
+
+	g_string_assign(str, "<< /Type /Page /Parent 2 0 R /MediaBox ");
+	pdf_append_box(str, &media);
+	g_string_append_printf(str, " /Contents %u 0 R /Resources << /XObject <<%s >> /ExtGState <<%s >> "
+			       "/Properties <<%s >> >> >>", PDF_OBJ_PAGE_CONTENT, xobjects->str, gstates->str,
+			       properties->str);
+	pdf_write_object(writer, PDF_OBJ_PAGE, str->str);
+
+	g_string_printf(str, "<< /Type /Pages /Kids [%u 0 R] /Count 1 >>", PDF_OBJ_PAGE);
+	pdf_write_object(writer, PDF_OBJ_PAGES, str->str);
+
+	g_string_printf(str, "<< /Type /Catalog /Pages %u 0 R /OCProperties << /OCGs [%s ] "
+			"/D << /Order [%s ] /ON [%s ] >> >> >>", PDF_OBJ_PAGES, ocgs->str, ocgs->str, ocgs->str);
+	pdf_write_object(writer, PDF_OBJ_CATALOG, str->str);
+
+	g_string_free(str, TRUE);
+	g_string_free(properties, TRUE);
+	g_string_free(gstates, TRUE);
+	g_string_free(xobjects, TRUE);
+	g_string_free(ocgs, TRUE);
+	g_string_free(content, TRUE);
+
+	return ret;
+}
+
+/**
+ * @brief Render \p cell to a PDF file keeping the cell hierarchy
+ * @param renderer Renderer
+ * @param cell Toplevel cell
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param pdf_file Output file
+ * @param scale Scale the output down by \p scale. One output unit is one point
+ * @param compression_level zlib compression level. 0 writes uncompressed streams
+ * @return 0 if successful
+ */
+static int native_pdf_render_cell(GdsOutputRenderer *renderer, struct gds_cell *cell, GList *layer_infos,
+				  const char *pdf_file, double scale, int compression_level)
+{
+	static const char pdf_header[] = "%PDF-1.5\n%\xE2\xE3\xCF\xD3\n";
+	struct native_pdf_document doc;
+	struct pdf_writer writer;
+	const struct native_pdf_cell *top;
+	const union bounding_box *box;
+	int ret = 0;
+
+	if (!pdf_file || scale <= 0.0)
+		return -1;
+
+	if (native_pdf_document_init(&doc, cell, layer_infos, compression_level)) {
+		fprintf(stderr, _("Cell is affected by a reference loop. Cannot render PDF\n"));
+		ret = -2;
+		goto ret_clear_doc;
+	}
+
+	top = (const struct native_pdf_cell *)g_hash_table_lookup(doc.cells, cell);
+	box = (const union bounding_box *)g_hash_table_lookup(doc.boxes, cell);
+	if (box->vectors.upper_right.x < box->vectors.lower_left.x ||
+	    box->vectors.upper_right.y < box->vectors.lower_left.y) {
+		fprintf(stderr, _("Cell is empty. Nothing to render\n"));
+		ret = -3;
+		goto ret_clear_doc;
+	}
+
+	memset(&writer, 0, sizeof(writer));
+	writer.file = fopen(pdf_file, "wb");
+	if (!writer.file) {
+		fprintf(stderr, _("Could not open %s\n"), pdf_file);
+		ret = -4;
+		goto ret_clear_doc;
+	}
+	writer.offsets = g_new0(guint64, doc.object_count);
+
+	pdf_write(&writer, pdf_header, sizeof(pdf_header) - 1);
+	if (write_cell_forms(renderer, &doc, &writer) || write_page(&doc, &writer, top, scale)) {
+		fprintf(stderr, _("Could not compress PDF content\n"));
+		ret = -5;
+	} else {
+		pdf_write_trailer(&writer, doc.object_count, PDF_OBJ_CATALOG);
+	}
+
+	if (fclose(writer.file) || writer.failed) {
+		fprintf(stderr, _("Could not write %s\n"), pdf_file);
+		ret = -6;
+	}
+	g_free(writer.offsets);
+
+ret_clear_doc:
+	native_pdf_document_clear(&doc);
+
+	return ret;
+}
+
+static int native_pdf_renderer_render_output(GdsOutputRenderer *renderer, struct gds_cell *cell, double scale)
+{
+	NativePdfRenderer *n_renderer = GDS_RENDER_NATIVE_PDF_RENDERER(renderer);
+	LayerSettings *settings;
+	GList *layer_infos = NULL;
+	int ret;
+
+	if (!n_renderer)
+		return -2000;
+
+	if (gds_output_renderer_requires_flat_scene(renderer))
+		fprintf(stderr, _("Native PDF output keeps the cell hierarchy. Shapes are not merged or simplified\n"));
+
+	settings = gds_output_renderer_get_and_ref_layer_settings(renderer);
+
+	/* Set layer info list. In case of failure it remains NULL */
+	if (settings)
+		layer_infos = layer_settings_get_layer_info_list(settings);
+
+	gds_output_renderer_update_async_progress(renderer, _("Writing PDF..."));
+	ret = native_pdf_render_cell(renderer, cell, layer_infos, gds_output_renderer_get_output_file(renderer),
+				     scale, n_renderer->compression_level);
+
+	if (settings)
+		g_object_unref(settings);
+
+	return ret;
+}
+
+static void native_pdf_renderer_init(NativePdfRenderer *self)
+{
+	self->compression_level = NATIVE_PDF_DEFAULT_COMPRESSION;
+}
+
+static void native_pdf_renderer_get_property(GObject *obj, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	NativePdfRenderer *self = GDS_RENDER_NATIVE_PDF_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_COMPRESSION_LEVEL:
+		g_value_set_int(value, self->compression_level);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static void native_pdf_renderer_set_property(GObject *obj, guint property_id, const GValue *value,
+					     GParamSpec *pspec)
+{
+	NativePdfRenderer *self = GDS_RENDER_NATIVE_PDF_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_COMPRESSION_LEVEL:
+		self->compression_level = g_value_get_int(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static GParamSpec *native_pdf_renderer_properties[N_PROPERTIES] = {NULL};
+
+static void native_pdf_renderer_class_init(NativePdfRendererClass *klass)
+{
+	GdsOutputRendererClass *render_class = GDS_RENDER_OUTPUT_RENDERER_CLASS(klass);
+	GObjectClass *oclass = G_OBJECT_CLASS(klass);
+
+	render_class->render_output = native_pdf_renderer_render_output;
+
+	oclass->get_property = native_pdf_renderer_get_property;
+	oclass->set_property = native_pdf_renderer_set_property;
+
+	native_pdf_renderer_properties[PROP_COMPRESSION_LEVEL] =
+			g_param_spec_int("compression-level",
+					 N_("Compression level"),
+					 N_("zlib compression level of the content streams. 0 writes uncompressed streams"),
+					 0, 9, NATIVE_PDF_DEFAULT_COMPRESSION,
+					 G_PARAM_READWRITE);
+
+	g_object_class_install_properties(oclass, N_PROPERTIES, native_pdf_renderer_properties);
+}
+
+NativePdfRenderer *native_pdf_renderer_new(void)
+{
+	GObject *obj;
+
+	obj = g_object_new(GDS_RENDER_TYPE_NATIVE_PDF_RENDERER, NULL);
+	return GDS_RENDER_NATIVE_PDF_RENDERER(obj);
+}
+
+NativePdfRenderer *native_pdf_renderer_new_with_options(int compression_level)
+{
+	GObject *obj;
+
+	obj = g_object_new(GDS_RENDER_TYPE_NATIVE_PDF_RENDERER, "compression-level", compression_level, NULL);
+	return GDS_RENDER_NATIVE_PDF_RENDERER(obj);
+}
+
+/** @} */
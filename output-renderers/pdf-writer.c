@@ -0,0 +1,214 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pdf-writer.c
+ * @brief Helpers to write the objects of a PDF file
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ */
+
+/**
+ * @addtogroup Native-PDF-Renderer
+ * @{
+ */
+
+#include <string.h>
+#include <float.h>
+#include <gio/gio.h>
+
+#include <gds-render/output-renderers/pdf-writer.h>
+
+void pdf_append_number(GString *str, double value)
+{
+	/* Large enough for all integer digits of any finite double */
+	char buffer[G_ASCII_DTOSTR_BUF_SIZE + DBL_MAX_10_EXP];
+	size_t len;
+
+	g_ascii_formatd(buffer, sizeof(buffer), "%.6f", value);
+
+	/* Strip trailing zeros and the decimal point */
+	len = strlen(buffer);
+	while (len > 0 && buffer[len - 1] == '0')
+		len--;
+	if (len > 0 && buffer[len - 1] == '.')
+		len--;
+	buffer[len] = '\0';
+
+	if (!strcmp(buffer, "-0") || len == 0)
+		g_string_append_c(str, '0');
+	else
+		g_string_append(str, buffer);
+}
+
+void pdf_append_literal(GString *str, const char *text)
+{
+	const unsigned char *c;
+
+	g_string_append_c(str, '(');
+	for (c = (const unsigned char *)text; *c; c++) {
+		if (*c == '(' || *c == ')' || *c == '\\')
+			g_string_append_printf(str, "\\%c", *c);
+		else if (*c < 32 || *c > 126)
+			g_string_append_printf(str, "\\%03o", *c);
+		else
+			g_string_append_c(str, (char)*c);
+	}
+	g_string_append_c(str, ')');
+}
+
+void pdf_append_matrix(GString *str, const struct affine_2d *matrix)
+{
+	pdf_append_number(str, matrix->xx);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, matrix->yx);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, matrix->xy);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, matrix->yy);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, matrix->x0);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, matrix->y0);
+	g_string_append(str, " cm");
+}
+
+void pdf_append_box(GString *str, const union bounding_box *box)
+{
+	g_string_append_c(str, '[');
+	pdf_append_number(str, box->vectors.lower_left.x);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, box->vectors.lower_left.y);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, box->vectors.upper_right.x);
+	g_string_append_c(str, ' ');
+	pdf_append_number(str, box->vectors.upper_right.y);
+	g_string_append_c(str, ']');
+}
+
+/**
+ * @brief Compress a content stream with the zlib format expected by the FlateDecode filter
+ * @param content Content stream
+ * @param level Compression level
+ * @return Compressed data or NULL in case of an error
+ */
+static GBytes *pdf_compress(const GString *content, int level)
+{
+	GZlibCompressor *compressor;
+	GConverterResult res;
+	GByteArray *out;
+	GError *error = NULL;
+	guint8 buffer[16384];
+	gsize total_read = 0;
+	gsize bytes_read, bytes_written;
+
+	compressor = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, level);
+	out = g_byte_array_sized_new((guint)(content->len / 4 + 64));
+
+	do {
+		res = g_converter_convert(G_CONVERTER(compressor), content->str + total_read,
+					  content->len - total_read, buffer, sizeof(buffer),
+					  G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+		if (res == G_CONVERTER_ERROR) {
+			g_error_free(error);
+			g_byte_array_free(out, TRUE);
+			g_object_unref(compressor);
+			return NULL;
+		}
+		total_read += bytes_read;
+		g_byte_array_append(out, buffer, (guint)bytes_written);
+	} while (res != G_CONVERTER_FINISHED);
+
+	g_object_unref(compressor);
+
+	return g_byte_array_free_to_bytes(out);
+}
+
+GBytes *pdf_finish_stream(GString *content, int level, GString *dict)
+{
+	GBytes *data;
+	gsize len;
+
+	if (level <= 0) {
+		len = content->len;
+		return g_bytes_new_take(g_string_free(content, FALSE), len);
+	}
+
+	data = pdf_compress(content, level);
+	g_string_free(content, TRUE);
+	g_string_append(dict, " /Filter /FlateDecode");
+
+	return data;
+}
+
+void pdf_write(struct pdf_writer *writer, const void *data, gsize length)
+{
+	if (writer->failed)
+		return;
+
+	if (length && fwrite(data, 1, length, writer->file) != length)
+		writer->failed = TRUE;
+	writer->offset += length;
+}
+
+void pdf_write_object(struct pdf_writer *writer, guint object, const char *body)
+{
+	gchar *header;
+
+	writer->offsets[object] = writer->offset;
+	header = g_strdup_printf("%u 0 obj\n", object);
+	pdf_write(writer, header, strlen(header));
+	pdf_write(writer, body, strlen(body));
+	pdf_write(writer, "\nendobj\n", 8);
+	g_free(header);
+}
+
+void pdf_write_stream(struct pdf_writer *writer, guint object, const GString *dict, GBytes *stream)
+{
+	gchar *header;
+	gconstpointer data;
+	gsize length;
+
+	data = g_bytes_get_data(stream, &length);
+
+	writer->offsets[object] = writer->offset;
+	header = g_strdup_printf("%u 0 obj\n%s /Length %" G_GSIZE_FORMAT " >>\nstream\n", object, dict->str, length);
+	pdf_write(writer, header, strlen(header));
+	pdf_write(writer, data, length);
+	pdf_write(writer, "\nendstream\nendobj\n", 18);
+	g_free(header);
+}
+
+void pdf_write_trailer(struct pdf_writer *writer, guint object_count, guint root)
+{
+	GString *str;
+	guint64 xref_offset;
+	guint i;
+
+	xref_offset = writer->offset;
+	str = g_string_new(NULL);
+	g_string_printf(str, "xref\n0 %u\n0000000000 65535 f \n", object_count);
+	for (i = 1; i < object_count; i++)
+		g_string_append_printf(str, "%010" G_GUINT64_FORMAT " 00000 n \n", writer->offsets[i]);
+	g_string_append_printf(str, "trailer\n<< /Size %u /Root %u 0 R >>\nstartxref\n%" G_GUINT64_FORMAT "\n%%%%EOF\n",
+			       object_count, root, xref_offset);
+	pdf_write(writer, str->str, str->len);
+	g_string_free(str, TRUE);
+}
+
+/** @} */
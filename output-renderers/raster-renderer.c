@@ -0,0 +1,902 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file raster-renderer.c
+ * @brief Tiled raster (PNG) output renderer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The image is rendered in bands of @ref RASTER_RENDERER_TILE_SIZE rows. The tiles of a band are
+ * rendered in parallel. Afterwards, the band is compressed and appended to the PNG file.
+ * Only a single band of the image is kept in memory.
+ *
+ * In tile pyramid mode, the output is a directory of PNG tiles for web viewers instead.
+ */
+
+/**
+ * @addtogroup Raster-Renderer
+ * @{
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <cairo.h>
+#include <gio/gio.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#include <gds-render/output-renderers/raster-renderer.h>
+#include <gds-render/output-renderers/raster-scene.h>
+
+/**
+ * @brief Struct representing the raster renderer object
+ */
+struct _RasterRenderer {
+	GdsOutputRenderer parent;
+	double dpi; /**< @brief Resolution in pixels per inch */
+	gboolean tile_pyramid; /**< @brief Write a directory of tiles instead of a single image */
+};
+
+G_DEFINE_TYPE(RasterRenderer, raster_renderer, GDS_RENDER_TYPE_OUTPUT_RENDERER)
+
+enum {
+	PROP_DPI = 1,
+	PROP_TILE_PYRAMID,
+	N_PROPERTIES
+};
+
+/** @brief Maximum size of the compressed data in a single IDAT chunk */
+#define PNG_IDAT_SIZE (65536)
+
+/** @brief Maximum width and height of a PNG image */
+#define PNG_MAX_DIMENSION (0x7FFFFFFFU)
+
+/**
+ * @brief PNG file written row by row
+ */
+struct png_stream {
+	FILE *file; /**< @brief Output file */
+	GConverter *compressor; /**< @brief zlib compressor for the image data */
+	gsize fill; /**< @brief Number of bytes in png_stream::buffer */
+	guint8 buffer[PNG_IDAT_SIZE]; /**< @brief Compressed data of the next IDAT chunk */
+};
+
+/**
+ * @brief Tile rendered by a single thread
+ */
+struct raster_tile {
+	const struct raster_scene *scene; /**< @brief Scene to render */
+	cairo_matrix_t device; /**< @brief Transformation from database units to pixels of the tile */
+	union bounding_box area; /**< @brief Area of the tile in database units */
+	guint x; /**< @brief First column of the tile */
+	guint width; /**< @brief Width of the tile in pixels */
+	guint height; /**< @brief Height of the tile in pixels */
+	guint8 *band; /**< @brief Rows of the PNG image the tile is part of */
+	gsize stride; /**< @brief Length of a row in raster_tile::band including the filter type */
+};
+
+/**
+ * @brief Tile of a tile pyramid
+ */
+struct raster_pyramid_tile {
+	const struct raster_scene *scene; /**< @brief Scene to render */
+	const char *directory; /**< @brief Output directory */
+	GHashTable *old_hashes; /**< @brief Hashes of the previous export. Maps "z/x/y" to the hash. May be NULL */
+	cairo_matrix_t device; /**< @brief Transformation from database units to pixels of the tile */
+	union bounding_box area; /**< @brief Area of the tile in database units */
+	double min_size; /**< @brief Level of detail in database units */
+	guint level; /**< @brief Zoom level */
+	guint x; /**< @brief Column */
+	guint y; /**< @brief Row. 0 is the top row */
+	gchar *hash; /**< @brief Hash of the tile contents. NULL if the tile is empty */
+	gboolean reused; /**< @brief The tile of the previous export has been kept */
+	gboolean failed; /**< @brief The tile could not be written */
+};
+
+static guint32 png_crc_table[256];
+
+static void png_crc_init(void)
+{
+	static gsize initialized = 0;
+	guint32 crc;
+	guint n, k;
+
+	if (!g_once_init_enter(&initialized))
+		return;
+
+	for (n = 0; n < 256; n++) {
+		crc = n;
+		for (k = 0; k < 8; k++)
+			crc = (crc & 1U) ? (0xEDB88320U ^ (crc >> 1)) : (crc >> 1);
+		png_crc_table[n] = crc;
+	}
+
+	g_once_init_leave(&initialized, 1);
+}
+
+static guint32 png_crc_update(guint32 crc, const guint8 *data, gsize length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++)
+		crc = png_crc_table[(crc ^ data[i]) & 0xFFU] ^ (crc >> 8);
+
+	return crc;
+}
+
+static void png_put_uint32(guint8 *dest, guint32 value)
+{
+	dest[0] = (guint8)(value >> 24);
+	dest[1] = (guint8)(value >> 16);
+	dest[2] = (guint8)(value >> 8);
+	dest[3] = (guint8)value;
+}
+
+/**
+ * @brief Write a chunk to a PNG file
+ * @param file File
+ * @param type Chunk type. 4 characters
+ * @param data Chunk data
+ * @param length Length of \p data
+ * @return 0 if successful
+ */
+static int png_write_chunk(FILE *file, const char *type, const guint8 *data, guint32 length)
+{
+	guint8 header[8];
+	guint8 crc_bytes[4];
+	guint32 crc;
+
+	png_put_uint32(header, length);
+	memcpy(&header[4], type, 4);
+	crc = png_crc_update(0xFFFFFFFFU, &header[4], 4);
+	crc = png_crc_update(crc, data, length);
+	png_put_uint32(crc_bytes, crc ^ 0xFFFFFFFFU);
+
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+	    (length && fwrite(data, 1, length, file) != length) ||
+	    fwrite(crc_bytes, 1, sizeof(crc_bytes), file) != sizeof(crc_bytes))
+		return -1;
+
+	return 0;
+}
+
+/**
+ * @brief Create a PNG file with 8 bit RGBA pixels
+ * @param file_name File name
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @return Stream or NULL in case of an error
+ */
+static struct png_stream *png_stream_open(const char *file_name, guint32 width, guint32 height)
+{
+	static const guint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	struct png_stream *png;
+	guint8 ihdr[13];
+
+	png_crc_init();
+
+	png = g_new(struct png_stream, 1);
+	png->fill = 0;
+	png->file = fopen(file_name, "wb");
+	if (!png->file) {
+		g_free(png);
+		return NULL;
+	}
+
+	png_put_uint32(&ihdr[0], width);
+	png_put_uint32(&ihdr[4], height);
+	ihdr[8] = 8; /* Bit depth */
+	ihdr[9] = 6; /* RGBA */
+	ihdr[10] = 0; /* Deflate */
+	ihdr[11] = 0; /* Adaptive filtering */
+	ihdr[12] = 0; /* No interlacing */
+
+	if (fwrite(signature, 1, sizeof(signature), png->file) != sizeof(signature) ||
+	    png_write_chunk(png->file, "IHDR", ihdr, sizeof(ihdr))) {
+		fclose(png->file);
+		g_free(png);
+		return NULL;
+	}
+
+	png->compressor = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, 6));
+
+	return png;
+}
+
+static int png_stream_flush(struct png_stream *png)
+{
+	int ret = 0;
+
+	if (png->fill)
+		ret = png_write_chunk(png->file, "IDAT", png->buffer, (guint32)png->fill);
+	png->fill = 0;
+
+	return ret;
+}
+
+/**
+ * @brief Compress image rows and append them to the file
+ * @param png Stream
+ * @param data Rows. Each row starts with its filter type
+ * @param length Length of \p data in bytes
+ * @param last Set if these are the last rows of the image
+ * @return 0 if successful
+ */
+static int png_stream_write(struct png_stream *png, const guint8 *data, gsize length, gboolean last)
+{
+	GConverterResult res;
+	GError *error = NULL;
+	gsize bytes_read;
+	gsize bytes_written;
+
+	do {
+		if (png->fill == sizeof(png->buffer) && png_stream_flush(png))
+			return -1;
+
+		res = g_converter_convert(png->compressor, data, length, &png->buffer[png->fill],
+					  sizeof(png->buffer) - png->fill,
+					  (last ? G_CONVERTER_INPUT_AT_END : G_CONVERTER_NO_FLAGS),
+					  &bytes_read, &bytes_written, &error);
+		if (res == G_CONVERTER_ERROR) {
+			/* Not enough space for the next compressed block */
+			if (png->fill && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+				g_clear_error(&error);
+				if (png_stream_flush(png))
+					return -1;
+				continue;
+			}
+			g_error_free(error);
+			return -1;
+		}
+
+		data += bytes_read;
+		length -= bytes_read;
+		png->fill += bytes_written;
+	} while (length > 0 || (last && res != G_CONVERTER_FINISHED));
+
+	return 0;
+}
+
+/**
+ * @brief Finish the image data and close the file
+ * @param png Stream. Freed by this function
+ * @return 0 if successful
+ */
+static int png_stream_close(struct png_stream *png)
+{
+	int ret;
+
+	ret = png_stream_write(png, NULL, 0, TRUE);
+	if (!ret)
+		ret = png_stream_flush(png);
+	if (!ret)
+		ret = png_write_chunk(png->file, "IEND", NULL, 0);
+	if (fclose(png->file))
+		ret = -1;
+
+	g_object_unref(png->compressor);
+	g_free(png);
+
+	return ret;
+}
+
+/**
+ * @brief Calculate the position of a tile
+ *
+ * Pixel (0|0) is the upper left corner of \p extent.
+ *
+ * @param[out] device Transformation from database units to pixels of the tile
+ * @param[out] area Area of the tile in database units including a margin of one pixel for antialiasing
+ * @param extent Extent of the whole image in database units
+ * @param pixel_size Size of a pixel in database units
+ * @param x Column of the first pixel of the tile
+ * @param y Row of the first pixel of the tile
+ * @param width Width of the tile
+ * @param height Height of the tile
+ */
+static void calculate_tile_position(cairo_matrix_t *device, union bounding_box *area, const union bounding_box *extent,
+				    double pixel_size, guint x, guint y, guint width, guint height)
+{
+	cairo_matrix_init(device, 1.0 / pixel_size, 0.0, 0.0, -1.0 / pixel_size,
+			  -extent->vectors.lower_left.x / pixel_size - (double)x,
+			  extent->vectors.upper_right.y / pixel_size - (double)y);
+
+	area->vectors.lower_left.x = extent->vectors.lower_left.x + ((double)x - 1.0) * pixel_size;
+	area->vectors.upper_right.x = extent->vectors.lower_left.x + ((double)(x + width) + 1.0) * pixel_size;
+	area->vectors.upper_right.y = extent->vectors.upper_right.y - ((double)y - 1.0) * pixel_size;
+	area->vectors.lower_left.y = extent->vectors.upper_right.y - ((double)(y + height) + 1.0) * pixel_size;
+}
+
+/**
+ * @brief Render a tile and copy it to its band
+ *
+ * Cairo stores premultiplied pixels in native byte order. PNG expects straight RGBA.
+ *
+ * @param data Tile
+ * @param user_data Unused
+ */
+static void raster_tile_run(gpointer data, gpointer user_data)
+{
+	struct raster_tile *tile = (struct raster_tile *)data;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	const guint8 *pixels;
+	const guint32 *src;
+	guint8 *dest;
+	guint32 pixel;
+	guint32 alpha;
+	int pixel_stride;
+	guint row, col;
+	(void)user_data;
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)tile->width, (int)tile->height);
+	cr = cairo_create(surface);
+	cairo_set_matrix(cr, &tile->device);
+	raster_scene_render(tile->scene, cr, &tile->area, 0.0);
+	cairo_destroy(cr);
+
+	cairo_surface_flush(surface);
+	pixels = cairo_image_surface_get_data(surface);
+	pixel_stride = cairo_image_surface_get_stride(surface);
+
+	for (row = 0; pixels && row < tile->height; row++) {
+		src = (const guint32 *)&pixels[row * pixel_stride];
+		dest = &tile->band[row * tile->stride + 1 + tile->x * 4];
+		for (col = 0; col < tile->width; col++, dest += 4) {
+			pixel = src[col];
+			alpha = pixel >> 24;
+			if (alpha == 0) {
+				memset(dest, 0, 4);
+				continue;
+			}
+			dest[0] = (guint8)((((pixel >> 16) & 0xFFU) * 255U + alpha / 2) / alpha);
+			dest[1] = (guint8)((((pixel >> 8) & 0xFFU) * 255U + alpha / 2) / alpha);
+			dest[2] = (guint8)(((pixel & 0xFFU) * 255U + alpha / 2) / alpha);
+			dest[3] = (guint8)alpha;
+		}
+	}
+
+	cairo_surface_destroy(surface);
+}
+
+/**
+ * @brief Render \p cell to a PNG file
+ * @param renderer Renderer
+ * @param cell Toplevel cell
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param png_file Output file
+ * @param scale Scale the output image down by \p scale. The output unit is one point
+ * @param dpi Resolution in pixels per inch
+ * @return 0 if successful
+ */
+static int raster_render_cell_to_png(GdsOutputRenderer *renderer, struct gds_cell *cell, GList *layer_infos,
+				     const char *png_file, double scale, double dpi)
+{
+	struct raster_scene *scene;
+	struct raster_tile *tiles;
+	struct raster_tile *tile;
+	struct png_stream *png;
+	union bounding_box extent;
+	GThreadPool *pool;
+	guint8 *band;
+	gchar *status;
+	double pixel_size;
+	double width_px, height_px;
+	guint width, height;
+	guint tiles_x;
+	guint band_height;
+	gsize stride;
+	guint x, y, i;
+	int ret = 0;
+
+	if (!png_file || dpi <= 0.0)
+		return -1;
+
+	scene = raster_scene_new(cell, layer_infos);
+	if (!scene) {
+		fprintf(stderr, _("Cell is affected by a reference loop. Cannot render PNG\n"));
+		return -2;
+	}
+
+	raster_scene_get_extent(scene, &extent);
+	if (extent.vectors.upper_right.x < extent.vectors.lower_left.x ||
+	    extent.vectors.upper_right.y < extent.vectors.lower_left.y) {
+		fprintf(stderr, _("Cell is empty. Nothing to render\n"));
+		ret = -3;
+		goto ret_free_scene;
+	}
+
+	/* Database units per pixel */
+	pixel_size = scale * 72.0 / dpi;
+	width_px = MAX(1.0, ceil((extent.vectors.upper_right.x - extent.vectors.lower_left.x) / pixel_size));
+	height_px = MAX(1.0, ceil((extent.vectors.upper_right.y - extent.vectors.lower_left.y) / pixel_size));
+	if (width_px > PNG_MAX_DIMENSION || height_px > PNG_MAX_DIMENSION) {
+		fprintf(stderr, _("PNG image of %.0lf x %.0lf pixels is too large. Reduce the resolution\n"),
+			width_px, height_px);
+		ret = -4;
+		goto ret_free_scene;
+	}
+	width = (guint)width_px;
+	height = (guint)height_px;
+	printf(_("Rendering PNG image of %u x %u pixels\n"), width, height);
+
+	stride = 1 + (gsize)width * 4;
+	band = (guint8 *)g_try_malloc(stride * RASTER_RENDERER_TILE_SIZE);
+	if (!band) {
+		fprintf(stderr, _("Not enough memory for a row of tiles\n"));
+		ret = -5;
+		goto ret_free_scene;
+	}
+
+	png = png_stream_open(png_file, width, height);
+	if (!png) {
+		fprintf(stderr, _("Could not open PNG output file %s\n"), png_file);
+		ret = -6;
+		goto ret_free_band;
+	}
+
+	tiles_x = (width + RASTER_RENDERER_TILE_SIZE - 1) / RASTER_RENDERER_TILE_SIZE;
+	tiles = g_new(struct raster_tile, tiles_x);
+
+	for (y = 0; y < height && !ret; y += RASTER_RENDERER_TILE_SIZE) {
+		band_height = MIN(RASTER_RENDERER_TILE_SIZE, height - y);
+
+		status = g_strdup_printf(_("Rendering PNG rows %u to %u of %u"), y + 1, y + band_height, height);
+		gds_output_renderer_update_async_progress(renderer, status);
+		g_free(status);
+
+		/* Each row starts with its filter type: None */
+		for (i = 0; i < band_height; i++)
+			band[i * stride] = 0;
+
+		pool = g_thread_pool_new(raster_tile_run, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+		for (i = 0, x = 0; i < tiles_x; i++, x += RASTER_RENDERER_TILE_SIZE) {
+			tile = &tiles[i];
+			tile->scene = scene;
+			tile->x = x;
+			tile->width = MIN(RASTER_RENDERER_TILE_SIZE, width - x);
+			tile->height = band_height;
+			tile->band = band;
+			tile->stride = stride;
+			calculate_tile_position(&tile->device, &tile->area, &extent, pixel_size, x, y,
+						tile->width, tile->height);
+
+			g_thread_pool_push(pool, tile, NULL);
+		}
+		g_thread_pool_free(pool, FALSE, TRUE);
+
+		if (png_stream_write(png, band, stride * band_height, FALSE))
+			ret = -7;
+	}
+
+	g_free(tiles);
+
+	if (png_stream_close(png) && !ret)
+		ret = -7;
+	if (ret == -7)
+		fprintf(stderr, _("Could not write PNG output file %s\n"), png_file);
+
+ret_free_band:
+	g_free(band);
+ret_free_scene:
+	raster_scene_free(scene);
+
+	return ret;
+}
+
+/**
+ * @brief Render a tile of a tile pyramid
+ *
+ * The tile is skipped if the hash of its geometry matches the previous export and the file still exists.
+ * Files of tiles that became empty are removed.
+ *
+ * @param data Tile
+ * @param user_data Unused
+ */
+static void raster_pyramid_tile_run(gpointer data, gpointer user_data)
+{
+	struct raster_pyramid_tile *tile = (struct raster_pyramid_tile *)data;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	GChecksum *checksum;
+	gchar *key;
+	gchar *file_name;
+	gchar *column_dir;
+	const gchar *old_hash;
+	(void)user_data;
+
+	column_dir = g_strdup_printf("%s/%u/%u", tile->directory, tile->level, tile->x);
+	file_name = g_strdup_printf("%s/%u.png", column_dir, tile->y);
+
+	/* The position and the level of detail are part of the hash */
+	checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(checksum, (const guchar *)&tile->device, sizeof(tile->device));
+	g_checksum_update(checksum, (const guchar *)&tile->min_size, sizeof(tile->min_size));
+	if (raster_scene_hash_area(tile->scene, &tile->area, tile->min_size, checksum) == 0) {
+		g_remove(file_name);
+		goto ret_free;
+	}
+	tile->hash = g_strdup(g_checksum_get_string(checksum));
+
+	key = g_strdup_printf("%u/%u/%u", tile->level, tile->x, tile->y);
+	old_hash = (tile->old_hashes ? g_hash_table_lookup(tile->old_hashes, key) : NULL);
+	g_free(key);
+	if (old_hash && !strcmp(old_hash, tile->hash) && g_file_test(file_name, G_FILE_TEST_EXISTS)) {
+		tile->reused = TRUE;
+		goto ret_free;
+	}
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, RASTER_RENDERER_TILE_SIZE,
+					     RASTER_RENDERER_TILE_SIZE);
+	cr = cairo_create(surface);
+	cairo_set_matrix(cr, &tile->device);
+	raster_scene_render(tile->scene, cr, &tile->area, tile->min_size);
+	cairo_destroy(cr);
+
+	if (g_mkdir_with_parents(column_dir, 0755) ||
+	    cairo_surface_write_to_png(surface, file_name) != CAIRO_STATUS_SUCCESS)
+		tile->failed = TRUE;
+	cairo_surface_destroy(surface);
+
+ret_free:
+	g_checksum_free(checksum);
+	g_free(file_name);
+	g_free(column_dir);
+}
+
+/**
+ * @brief Load the tile hashes of a previous export
+ * @param manifest_file Manifest of the previous export
+ * @return Hash table mapping "z/x/y" to the hash. NULL if there is no previous export
+ */
+static GHashTable *load_pyramid_manifest(const char *manifest_file)
+{
+	GHashTable *hashes;
+	gchar *contents;
+	gchar **lines;
+	gchar **line;
+	gchar key[64];
+	gchar hash[65];
+
+	if (!g_file_get_contents(manifest_file, &contents, NULL, NULL))
+		return NULL;
+
+	hashes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	lines = g_strsplit(contents, "\n", -1);
+	for (line = lines; *line; line++) {
+		if (sscanf(*line, "%63s %64s", key, hash) == 2)
+			g_hash_table_insert(hashes, g_strdup(key), g_strdup(hash));
+	}
+
+	g_strfreev(lines);
+	g_free(contents);
+
+	return hashes;
+}
+
+/**
+ * @brief Remove the tiles of a previous export that are outside of the current pyramid
+ *
+ * This covers tiles of a larger extent and of deeper levels. Emptied column and level directories are removed.
+ *
+ * @param directory Output directory
+ * @param stale_hashes Hashes of the previous export that have not been visited by the current one
+ */
+static void remove_stale_tiles(const char *directory, GHashTable *stale_hashes)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gchar *path;
+	guint level, x, y;
+
+	g_hash_table_iter_init(&iter, stale_hashes);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		/* The path is rebuilt from the numbers. The manifest is not trusted */
+		if (sscanf((const char *)key, "%u/%u/%u", &level, &x, &y) != 3)
+			continue;
+
+		path = g_strdup_printf("%s/%u/%u/%u.png", directory, level, x, y);
+		g_remove(path);
+		g_free(path);
+
+		/* Only succeeds if the directories are empty */
+		path = g_strdup_printf("%s/%u/%u", directory, level, x);
+		g_rmdir(path);
+		g_free(path);
+		path = g_strdup_printf("%s/%u", directory, level);
+		g_rmdir(path);
+		g_free(path);
+	}
+}
+
+/**
+ * @brief Render \p cell to a directory of PNG tiles
+ *
+ * The tiles are stored as <tt>z/x/y.png</tt> with @ref RASTER_RENDERER_TILE_SIZE pixels. Level 0 is a single tile
+ * containing the whole cell. The deepest level has the resolution \p dpi. Each level halves the resolution
+ * of the next level. The tiles of a level are rendered in parallel. Instances and shapes smaller than
+ * @ref RASTER_PYRAMID_DETAIL_PIXELS pixels are not drawn on the coarser levels.
+ *
+ * The hashes of the tiles are stored in the manifest file @ref RASTER_PYRAMID_MANIFEST. A tile whose geometry
+ * has not changed since the last export is not rendered again. Empty tiles are not written. Tiles of the previous
+ * export that are not part of the current pyramid are removed.
+ *
+ * @param renderer Renderer
+ * @param cell Toplevel cell
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param directory Output directory
+ * @param scale Scale the output image down by \p scale. The output unit is one point
+ * @param dpi Resolution of the deepest level in pixels per inch
+ * @return 0 if successful
+ */
+static int raster_render_cell_to_pyramid(GdsOutputRenderer *renderer, struct gds_cell *cell, GList *layer_infos,
+					 const char *directory, double scale, double dpi)
+{
+	struct raster_scene *scene;
+	struct raster_pyramid_tile *tiles;
+	struct raster_pyramid_tile *tile;
+	union bounding_box extent;
+	GHashTable *old_hashes;
+	GThreadPool *pool;
+	GString *manifest;
+	gchar *manifest_file;
+	gchar *status;
+	gchar *key;
+	double pixel_size;
+	double level_pixel_size;
+	double size_px;
+	guint max_level;
+	guint level;
+	guint tiles_x, tiles_y;
+	guint x, y, i;
+	guint rendered = 0, reused = 0;
+	int ret = 0;
+
+	if (!directory || dpi <= 0.0)
+		return -1;
+
+	scene = raster_scene_new(cell, layer_infos);
+	if (!scene) {
+		fprintf(stderr, _("Cell is affected by a reference loop. Cannot render tiles\n"));
+		return -2;
+	}
+
+	raster_scene_get_extent(scene, &extent);
+	if (extent.vectors.upper_right.x < extent.vectors.lower_left.x ||
+	    extent.vectors.upper_right.y < extent.vectors.lower_left.y) {
+		fprintf(stderr, _("Cell is empty. Nothing to render\n"));
+		ret = -3;
+		goto ret_free_scene;
+	}
+
+	if (g_mkdir_with_parents(directory, 0755)) {
+		fprintf(stderr, _("Could not create output directory %s\n"), directory);
+		ret = -6;
+		goto ret_free_scene;
+	}
+
+	raster_scene_prepare_hashes(scene);
+
+	/* Level 0 is a single tile */
+	pixel_size = scale * 72.0 / dpi;
+	size_px = MAX(extent.vectors.upper_right.x - extent.vectors.lower_left.x,
+		      extent.vectors.upper_right.y - extent.vectors.lower_left.y) / pixel_size;
+	for (max_level = 0; max_level < RASTER_PYRAMID_MAX_LEVEL; max_level++) {
+		if ((double)RASTER_RENDERER_TILE_SIZE * (double)(1U << max_level) >= size_px)
+			break;
+	}
+
+	manifest_file = g_build_filename(directory, RASTER_PYRAMID_MANIFEST, NULL);
+	old_hashes = load_pyramid_manifest(manifest_file);
+	manifest = g_string_new(NULL);
+
+	for (level = 0; level <= max_level; level++) {
+		level_pixel_size = pixel_size * (double)(1U << (max_level - level));
+		tiles_x = (guint)MAX(1.0, ceil((extent.vectors.upper_right.x - extent.vectors.lower_left.x) /
+					       (level_pixel_size * RASTER_RENDERER_TILE_SIZE)));
+		tiles_y = (guint)MAX(1.0, ceil((extent.vectors.upper_right.y - extent.vectors.lower_left.y) /
+					       (level_pixel_size * RASTER_RENDERER_TILE_SIZE)));
+
+		status = g_strdup_printf(_("Rendering tile level %u of %u: %u x %u tiles"), level, max_level,
+					 tiles_x, tiles_y);
+		gds_output_renderer_update_async_progress(renderer, status);
+		g_free(status);
+
+		tiles = g_new0(struct raster_pyramid_tile, (gsize)tiles_x * tiles_y);
+		pool = g_thread_pool_new(raster_pyramid_tile_run, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+		for (y = 0, i = 0; y < tiles_y; y++) {
+			for (x = 0; x < tiles_x; x++, i++) {
+				tile = &tiles[i];
+				tile->scene = scene;
+				tile->directory = directory;
+				tile->old_hashes = old_hashes;
+				tile->level = level;
+				tile->x = x;
+				tile->y = y;
+				tile->min_size = (level == max_level ? 0.0 :
+						  RASTER_PYRAMID_DETAIL_PIXELS * level_pixel_size);
+				calculate_tile_position(&tile->device, &tile->area, &extent, level_pixel_size,
+							x * RASTER_RENDERER_TILE_SIZE, y * RASTER_RENDERER_TILE_SIZE,
+							RASTER_RENDERER_TILE_SIZE, RASTER_RENDERER_TILE_SIZE);
+				g_thread_pool_push(pool, tile, NULL);
+			}
+		}
+		g_thread_pool_free(pool, FALSE, TRUE);
+
+		for (i = 0; i < tiles_x * tiles_y; i++) {
+			tile = &tiles[i];
+			if (old_hashes) {
+				key = g_strdup_printf("%u/%u/%u", tile->level, tile->x, tile->y);
+				g_hash_table_remove(old_hashes, key);
+				g_free(key);
+			}
+			if (tile->failed) {
+				fprintf(stderr, _("Could not write tile %u/%u/%u\n"), tile->level, tile->x, tile->y);
+				ret = -7;
+			} else if (tile->hash) {
+				g_string_append_printf(manifest, "%u/%u/%u %s\n", tile->level, tile->x, tile->y,
+						       tile->hash);
+				if (tile->reused)
+					reused++;
+				else
+					rendered++;
+			}
+			g_free(tile->hash);
+		}
+		g_free(tiles);
+	}
+
+	/* Everything left of the previous export is outside of the current pyramid */
+	if (old_hashes)
+		remove_stale_tiles(directory, old_hashes);
+
+	if (!g_file_set_contents(manifest_file, manifest->str, (gssize)manifest->len, NULL)) {
+		fprintf(stderr, _("Could not write %s\n"), manifest_file);
+		ret = -7;
+	}
+	printf(_("Tile pyramid with %u levels: %u tiles rendered, %u tiles unchanged\n"), max_level + 1,
+	       rendered, reused);
+
+	g_string_free(manifest, TRUE);
+	if (old_hashes)
+		g_hash_table_destroy(old_hashes);
+	g_free(manifest_file);
+ret_free_scene:
+	raster_scene_free(scene);
+
+	return ret;
+}
+
+static int raster_renderer_render_output(GdsOutputRenderer *renderer, struct gds_cell *cell, double scale)
+{
+	RasterRenderer *r_renderer = GDS_RENDER_RASTER_RENDERER(renderer);
+	LayerSettings *settings;
+	GList *layer_infos = NULL;
+	int ret;
+
+	if (!r_renderer)
+		return -2000;
+
+	settings = gds_output_renderer_get_and_ref_layer_settings(renderer);
+
+	/* Set layer info list. In case of failure it remains NULL */
+	if (settings)
+		layer_infos = layer_settings_get_layer_info_list(settings);
+
+	gds_output_renderer_update_async_progress(renderer, _("Rendering PNG Output..."));
+	if (r_renderer->tile_pyramid)
+		ret = raster_render_cell_to_pyramid(renderer, cell, layer_infos,
+						    gds_output_renderer_get_output_file(renderer), scale, r_renderer->dpi);
+	else
+		ret = raster_render_cell_to_png(renderer, cell, layer_infos,
+						gds_output_renderer_get_output_file(renderer), scale, r_renderer->dpi);
+
+	if (settings)
+		g_object_unref(settings);
+
+	return ret;
+}
+
+static void raster_renderer_init(RasterRenderer *self)
+{
+	self->dpi = RASTER_RENDERER_DEFAULT_DPI;
+	self->tile_pyramid = FALSE;
+}
+
+static void raster_renderer_get_property(GObject *obj, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	RasterRenderer *self = GDS_RENDER_RASTER_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_DPI:
+		g_value_set_double(value, self->dpi);
+		break;
+	case PROP_TILE_PYRAMID:
+		g_value_set_boolean(value, self->tile_pyramid);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static void raster_renderer_set_property(GObject *obj, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	RasterRenderer *self = GDS_RENDER_RASTER_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_DPI:
+		self->dpi = g_value_get_double(value);
+		break;
+	case PROP_TILE_PYRAMID:
+		self->tile_pyramid = g_value_get_boolean(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static GParamSpec *raster_renderer_properties[N_PROPERTIES] = {NULL};
+
+static void raster_renderer_class_init(RasterRendererClass *klass)
+{
+	GdsOutputRendererClass *render_class = GDS_RENDER_OUTPUT_RENDERER_CLASS(klass);
+	GObjectClass *oclass = G_OBJECT_CLASS(klass);
+
+	render_class->render_output = raster_renderer_render_output;
+
+	oclass->get_property = raster_renderer_get_property;
+	oclass->set_property = raster_renderer_set_property;
+
+	raster_renderer_properties[PROP_DPI] =
+			g_param_spec_double("dpi",
+					    N_("Resolution"),
+					    N_("Resolution of the output image in pixels per inch"),
+					    RASTER_RENDERER_MIN_DPI, RASTER_RENDERER_MAX_DPI,
+					    RASTER_RENDERER_DEFAULT_DPI,
+					    G_PARAM_READWRITE);
+	raster_renderer_properties[PROP_TILE_PYRAMID] =
+			g_param_spec_boolean("tile-pyramid",
+					     N_("Tile pyramid"),
+					     N_("Write a directory of tiles for all zoom levels instead of a single image"),
+					     FALSE,
+					     G_PARAM_READWRITE);
+
+	g_object_class_install_properties(oclass, N_PROPERTIES, raster_renderer_properties);
+}
+
+RasterRenderer *raster_renderer_new_png(double dpi)
+{
+	GObject *obj;
+
+	obj = g_object_new(GDS_RENDER_TYPE_RASTER_RENDERER, "dpi", dpi, NULL);
+	return GDS_RENDER_RASTER_RENDERER(obj);
+}
+
+RasterRenderer *raster_renderer_new_tile_pyramid(double dpi)
+{
+	GObject *obj;
+
+	obj = g_object_new(GDS_RENDER_TYPE_RASTER_RENDERER, "dpi", dpi, "tile-pyramid", TRUE, NULL);
+	return GDS_RENDER_RASTER_RENDERER(obj);
+}
+
+/** @} */
@@ -0,0 +1,677 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file raster-scene.c
+ * @brief Cell hierarchy prepared for rasterizing arbitrary areas
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The hierarchy is not flattened. Each drawn area walks the hierarchy and skips all instances whose
+ * transformed bounding box misses the area or whose cell does not use the current layer.
+ */
+
+/**
+ * @addtogroup Raster-Renderer
+ * @{
+ */
+
+#include <gds-render/output-renderers/raster-scene.h>
+#include <gds-render/geometric/cell-geometrics.h>
+#include <gds-render/geometric/cell-transform.h>
+#include <gds-render/geometric/path-outline.h>
+#include <gds-render/layer/layer-settings.h>
+
+/**
+ * @brief Layer drawn by a scene
+ */
+struct raster_layer {
+	int layer; /**< @brief Layer number */
+	double red; /**< @brief Red component of the layer color */
+	double green; /**< @brief Green component of the layer color */
+	double blue; /**< @brief Blue component of the layer color */
+	double alpha; /**< @brief Opacity of the layer */
+};
+
+/** @brief Length of a content hash of a cell */
+#define RASTER_HASH_LENGTH (32)
+
+/**
+ * @brief Content hash of a cell
+ */
+struct raster_cell_hash {
+	guint8 own[RASTER_HASH_LENGTH]; /**< @brief Hash of the graphics of the cell on the rendered layers */
+	guint8 all[RASTER_HASH_LENGTH]; /**< @brief Hash of the cell including all sub cells */
+	gboolean has_own; /**< @brief The cell has graphics on the rendered layers */
+	gboolean used; /**< @brief The cell or one of its sub cells uses one of the rendered layers */
+};
+
+struct raster_scene {
+	struct gds_cell *cell; /**< @brief Toplevel cell */
+	GArray *layers; /**< @brief Array of #raster_layer in stacking order */
+	GHashTable *layer_index; /**< @brief Maps a layer number to its index in raster_scene::layers plus 1 */
+	GHashTable *boxes; /**< @brief Maps each #gds_cell to its #bounding_box */
+	GHashTable *layer_usage; /**< @brief Maps each #gds_cell to a flag per layer set if the cell or a sub cell uses it */
+	struct path_outline_cache *outlines; /**< @brief Outlines of all paths */
+	GHashTable *hashes; /**< @brief Maps each #gds_cell to its #raster_cell_hash. NULL if not prepared */
+};
+
+/**
+ * @brief Get the layers used by a cell and its sub cells
+ *
+ * The results are stored in raster_scene::layer_usage. Each cell is calculated only once.
+ *
+ * @param scene Scene
+ * @param cell Cell
+ * @return Array with one flag per layer of the scene
+ */
+static const guint8 *calculate_layer_usage(struct raster_scene *scene, struct gds_cell *cell)
+{
+	guint8 *usage;
+	const guint8 *child_usage;
+	GList *iter;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+	gpointer index;
+	guint i;
+
+	usage = (guint8 *)g_hash_table_lookup(scene->layer_usage, cell);
+	if (usage)
+		return usage;
+
+	/* One additional element. This keeps the array valid if no layer is rendered */
+	usage = g_new0(guint8, scene->layers->len + 1);
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		index = g_hash_table_lookup(scene->layer_index, GINT_TO_POINTER((int)gfx->layer));
+		if (index)
+			usage[GPOINTER_TO_UINT(index) - 1] = 1;
+	}
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+		child_usage = calculate_layer_usage(scene, inst->cell_ref);
+		for (i = 0; i < scene->layers->len; i++)
+			usage[i] |= child_usage[i];
+	}
+
+	g_hash_table_insert(scene->layer_usage, cell, usage);
+
+	return usage;
+}
+
+struct raster_scene *raster_scene_new(struct gds_cell *cell, GList *layer_infos)
+{
+	struct raster_scene *scene;
+	struct layer_info *linfo;
+	struct raster_layer layer;
+	GList *iter;
+	GHashTable *boxes;
+
+	if (!cell)
+		return NULL;
+
+	boxes = calculate_cell_bounding_boxes(cell);
+	if (!boxes)
+		return NULL;
+
+	scene = g_new0(struct raster_scene, 1);
+	scene->cell = cell;
+	scene->boxes = boxes;
+	scene->layers = g_array_new(FALSE, FALSE, sizeof(struct raster_layer));
+	scene->layer_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+	scene->layer_usage = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	for (iter = layer_infos; iter != NULL; iter = g_list_next(iter)) {
+		linfo = (struct layer_info *)iter->data;
+		if (!linfo->render || g_hash_table_contains(scene->layer_index, GINT_TO_POINTER(linfo->layer)))
+			continue;
+
+		layer.layer = linfo->layer;
+		layer.red = linfo->color.red;
+		layer.green = linfo->color.green;
+		layer.blue = linfo->color.blue;
+		layer.alpha = linfo->color.alpha;
+		g_array_append_val(scene->layers, layer);
+		g_hash_table_insert(scene->layer_index, GINT_TO_POINTER(linfo->layer),
+				    GUINT_TO_POINTER(scene->layers->len));
+	}
+
+	calculate_layer_usage(scene, cell);
+
+	scene->outlines = path_outline_cache_new();
+	path_outline_cache_build_for_cell(scene->outlines, cell, 0);
+
+	return scene;
+}
+
+void raster_scene_free(struct raster_scene *scene)
+{
+	if (!scene)
+		return;
+
+	path_outline_cache_free(scene->outlines);
+	if (scene->hashes)
+		g_hash_table_destroy(scene->hashes);
+	g_hash_table_destroy(scene->layer_usage);
+	g_hash_table_destroy(scene->layer_index);
+	g_hash_table_destroy(scene->boxes);
+	g_array_free(scene->layers, TRUE);
+	g_free(scene);
+}
+
+void raster_scene_get_extent(const struct raster_scene *scene, union bounding_box *box)
+{
+	*box = *(const union bounding_box *)g_hash_table_lookup(scene->boxes, scene->cell);
+}
+
+/**
+ * @brief Check if a box is smaller than the level of detail
+ * @param box Box
+ * @param min_size Minimum size
+ * @return TRUE if the box is smaller than \p min_size in both directions
+ */
+static gboolean box_below_detail(const union bounding_box *box, double min_size)
+{
+	return box->vectors.upper_right.x - box->vectors.lower_left.x < min_size &&
+	       box->vectors.upper_right.y - box->vectors.lower_left.y < min_size;
+}
+
+/**
+ * @brief Check if two boxes overlap
+ * @param a Box
+ * @param b Box
+ * @return TRUE if the boxes overlap or touch
+ */
+static gboolean boxes_overlap(const union bounding_box *a, const union bounding_box *b)
+{
+	return a->vectors.lower_left.x <= b->vectors.upper_right.x &&
+	       b->vectors.lower_left.x <= a->vectors.upper_right.x &&
+	       a->vectors.lower_left.y <= b->vectors.upper_right.y &&
+	       b->vectors.lower_left.y <= a->vectors.upper_right.y;
+}
+
+/**
+ * @brief Check if a graphics object overlaps the drawn area and is not below the level of detail
+ *
+ * Paths are checked with the box of their outline including caps and joins.
+ *
+ * @param scene Scene
+ * @param gfx Graphics object
+ * @param trans Transformation of the cell to database units
+ * @param area Drawn area in database units
+ * @param min_size Minimum size of drawn shapes in database units
+ * @return TRUE if the graphics object has to be drawn
+ */
+static gboolean graphics_visible(const struct raster_scene *scene, const struct gds_graphics *gfx,
+				 const struct cell_transform *trans, const union bounding_box *area, double min_size)
+{
+	union bounding_box box;
+	const GArray *outline;
+
+	if (gfx->gfx_type == GRAPHIC_PATH) {
+		outline = path_outline_cache_lookup(scene->outlines, gfx);
+		if (!outline || outline->len == 0)
+			return FALSE;
+		vector_2d_array_min_max((const struct vector_2d *)outline->data, outline->len,
+					&box.vectors.lower_left, &box.vectors.upper_right);
+	} else if (gfx->vertex_count > 0) {
+		bounding_box_calculate_from_int_points(gfx->vertex_array, gfx->vertex_count, &box);
+	} else {
+		return FALSE;
+	}
+
+	cell_transform_apply_to_box(trans, &box);
+
+	return boxes_overlap(&box, area) && !box_below_detail(&box, min_size);
+}
+
+/**
+ * @brief Add a graphics object to the current path if it overlaps the drawn area
+ * @param scene Scene
+ * @param cr Cairo context. Its transformation maps the cell coordinates to the device
+ * @param gfx Graphics object
+ * @param trans Transformation of the cell to database units
+ * @param area Drawn area in database units
+ * @param min_size Minimum size of drawn shapes in database units
+ * @return TRUE if a shape has been added to the path. Paths without width are added as open center line
+ */
+static gboolean append_graphics(const struct raster_scene *scene, cairo_t *cr, const struct gds_graphics *gfx,
+				const struct cell_transform *trans, const union bounding_box *area, double min_size)
+{
+	const GArray *outline;
+	const struct vector_2d *pt;
+	guint i;
+
+	/* Skip shapes outside of the drawn area */
+	if (!graphics_visible(scene, gfx, trans, area, min_size))
+		return FALSE;
+
+	switch (gfx->gfx_type) {
+	case GRAPHIC_PATH:
+		/* Paths are filled as polygon outlines. Caps and joins are part of the outline */
+		outline = path_outline_cache_lookup(scene->outlines, gfx);
+		if (!outline || outline->len == 0)
+			return FALSE;
+		pt = &g_array_index(outline, struct vector_2d, 0);
+		cairo_move_to(cr, pt->x, pt->y);
+		for (i = 1; i < outline->len; i++) {
+			pt = &g_array_index(outline, struct vector_2d, i);
+			cairo_line_to(cr, pt->x, pt->y);
+		}
+		/* Paths without width are stroked along their open center line */
+		if (gfx->width_absolute == 0)
+			return TRUE;
+		break;
+	case GRAPHIC_BOX:
+		/* Expected fallthrough */
+	case GRAPHIC_POLYGON:
+		if (gfx->vertex_count == 0)
+			return FALSE;
+		cairo_move_to(cr, gfx->vertex_array[0].x, gfx->vertex_array[0].y);
+		for (i = 1; i < gfx->vertex_count; i++)
+			cairo_line_to(cr, gfx->vertex_array[i].x, gfx->vertex_array[i].y);
+		break;
+	default:
+		return FALSE;
+	}
+
+	cairo_close_path(cr);
+
+	return TRUE;
+}
+
+/**
+ * @brief Check if a cell instance has to be drawn on a layer
+ * @param scene Scene
+ * @param cell Cell
+ * @param trans Transformation of the cell to database units
+ * @param layer_idx Index of the layer in raster_scene::layers
+ * @param area Drawn area in database units
+ * @param min_size Minimum size of drawn instances in database units
+ * @return TRUE if the instance uses the layer, overlaps \p area and is not below the level of detail
+ */
+static gboolean instance_visible(const struct raster_scene *scene, struct gds_cell *cell,
+				 const struct cell_transform *trans, guint layer_idx, const union bounding_box *area,
+				 double min_size)
+{
+	const guint8 *usage;
+	union bounding_box box;
+
+	usage = (const guint8 *)g_hash_table_lookup(scene->layer_usage, cell);
+	if (!usage || !usage[layer_idx])
+		return FALSE;
+
+	box = *(const union bounding_box *)g_hash_table_lookup(scene->boxes, cell);
+	cell_transform_apply_to_box(trans, &box);
+
+	return boxes_overlap(&box, area) && !box_below_detail(&box, min_size);
+}
+
+/**
+ * @brief Draw a layer of a cell and its sub cells
+ * @param scene Scene
+ * @param cr Cairo context
+ * @param device Transformation from database units to the device
+ * @param cell Cell
+ * @param trans Transformation of the cell to database units
+ * @param layer_idx Index of the layer in raster_scene::layers
+ * @param area Drawn area in database units
+ * @param min_size Minimum size of drawn instances and shapes in database units
+ */
+static void render_cell_layer(const struct raster_scene *scene, cairo_t *cr, const cairo_matrix_t *device,
+			      struct gds_cell *cell, const struct cell_transform *trans, guint layer_idx,
+			      const union bounding_box *area, double min_size)
+{
+	const struct raster_layer *layer = &g_array_index(scene->layers, struct raster_layer, layer_idx);
+	struct cell_transform inst_trans;
+	struct cell_transform child_trans;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	cairo_matrix_t matrix;
+	gboolean matrix_set = FALSE;
+	GList *iter;
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+
+		cell_transform_init_from_instance(&inst_trans, inst);
+		cell_transform_compose(&child_trans, trans, &inst_trans);
+		if (instance_visible(scene, inst->cell_ref, &child_trans, layer_idx, area, min_size))
+			render_cell_layer(scene, cr, device, inst->cell_ref, &child_trans, layer_idx, area, min_size);
+	}
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		if (gfx->layer != layer->layer)
+			continue;
+
+		/* The transformation is only set for cells that draw on this layer */
+		if (!matrix_set) {
+			cairo_matrix_init(&matrix, trans->matrix.xx, trans->matrix.yx, trans->matrix.xy,
+					  trans->matrix.yy, trans->matrix.x0, trans->matrix.y0);
+			cairo_matrix_multiply(&matrix, &matrix, device);
+			cairo_set_matrix(cr, &matrix);
+			matrix_set = TRUE;
+		}
+
+		/* Each shape is filled on its own. Overlapping shapes with opposite orientation would cancel out */
+		if (!append_graphics(scene, cr, gfx, trans, area, min_size))
+			continue;
+
+		if (gfx->gfx_type == GRAPHIC_PATH && gfx->width_absolute == 0) {
+			/* Hairline: one device pixel wide, independent of the zoom level */
+			cairo_save(cr);
+			cairo_identity_matrix(cr);
+			cairo_set_line_width(cr, 1.0);
+			cairo_stroke(cr);
+			cairo_restore(cr);
+		} else {
+			cairo_fill(cr);
+		}
+	}
+}
+
+void raster_scene_render(const struct raster_scene *scene, cairo_t *cr, const union bounding_box *area,
+			 double min_size)
+{
+	const struct raster_layer *layer;
+	struct cell_transform identity;
+	cairo_matrix_t device;
+	guint i;
+
+	if (!scene || !cr || !area)
+		return;
+
+	cairo_get_matrix(cr, &device);
+	cell_transform_init_identity(&identity);
+	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+
+	for (i = 0; i < scene->layers->len; i++) {
+		layer = &g_array_index(scene->layers, struct raster_layer, i);
+		if (!instance_visible(scene, scene->cell, &identity, i, area, min_size))
+			continue;
+
+		/* Draw the layer opaque and composite it with its alpha value */
+		cairo_push_group(cr);
+		cairo_set_source_rgb(cr, layer->red, layer->green, layer->blue);
+		render_cell_layer(scene, cr, &device, scene->cell, &identity, i, area, min_size);
+		cairo_set_matrix(cr, &device);
+		cairo_pop_group_to_source(cr);
+		cairo_paint_with_alpha(cr, layer->alpha);
+	}
+
+	cairo_set_matrix(cr, &device);
+}
+
+/**
+ * @brief Add a graphics object to a checksum
+ * @param checksum Checksum
+ * @param gfx Graphics object
+ */
+static void hash_graphics(GChecksum *checksum, const struct gds_graphics *gfx)
+{
+	gint32 header[5];
+	gint32 coords[2];
+	size_t i;
+
+	header[0] = (gint32)gfx->gfx_type;
+	header[1] = (gint32)gfx->layer;
+	header[2] = (gint32)gfx->path_render_type;
+	header[3] = (gint32)gfx->width_absolute;
+	header[4] = (gint32)gfx->vertex_count;
+	g_checksum_update(checksum, (const guchar *)header, sizeof(header));
+
+	for (i = 0; i < gfx->vertex_count; i++) {
+		coords[0] = gfx->vertex_array[i].x;
+		coords[1] = gfx->vertex_array[i].y;
+		g_checksum_update(checksum, (const guchar *)coords, sizeof(coords));
+	}
+}
+
+/**
+ * @brief Add a cell instance to a checksum
+ * @param checksum Checksum
+ * @param inst Instance
+ */
+static void hash_instance(GChecksum *checksum, const struct gds_cell_instance *inst)
+{
+	gint32 ints[3];
+	double doubles[2];
+
+	ints[0] = inst->origin.x;
+	ints[1] = inst->origin.y;
+	ints[2] = inst->flipped;
+	doubles[0] = inst->angle;
+	doubles[1] = inst->magnification;
+	g_checksum_update(checksum, (const guchar *)ints, sizeof(ints));
+	g_checksum_update(checksum, (const guchar *)doubles, sizeof(doubles));
+}
+
+/**
+ * @brief Calculate the content hash of a cell and its sub cells
+ *
+ * The results are stored in raster_scene::hashes. Each cell is calculated only once.
+ *
+ * @param scene Scene
+ * @param cell Cell
+ * @return Hash
+ */
+static const struct raster_cell_hash *calculate_cell_hash(struct raster_scene *scene, struct gds_cell *cell)
+{
+	struct raster_cell_hash *hash;
+	const struct raster_cell_hash *child_hash;
+	struct gds_graphics *gfx;
+	struct gds_cell_instance *inst;
+	GChecksum *own;
+	GChecksum *all;
+	GList *iter;
+	gsize length;
+
+	hash = (struct raster_cell_hash *)g_hash_table_lookup(scene->hashes, cell);
+	if (hash)
+		return hash;
+
+	hash = g_new0(struct raster_cell_hash, 1);
+	own = g_checksum_new(G_CHECKSUM_SHA256);
+	all = g_checksum_new(G_CHECKSUM_SHA256);
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter)) {
+		gfx = (struct gds_graphics *)iter->data;
+		if (!g_hash_table_contains(scene->layer_index, GINT_TO_POINTER((int)gfx->layer)))
+			continue;
+		hash_graphics(own, gfx);
+		hash->has_own = TRUE;
+	}
+	length = sizeof(hash->own);
+	g_checksum_get_digest(own, hash->own, &length);
+	g_checksum_update(all, hash->own, sizeof(hash->own));
+	hash->used = hash->has_own;
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+		child_hash = calculate_cell_hash(scene, inst->cell_ref);
+		if (!child_hash->used)
+			continue;
+		g_checksum_update(all, child_hash->all, sizeof(child_hash->all));
+		hash_instance(all, inst);
+		hash->used = TRUE;
+	}
+	length = sizeof(hash->all);
+	g_checksum_get_digest(all, hash->all, &length);
+
+	g_checksum_free(own);
+	g_checksum_free(all);
+	g_hash_table_insert(scene->hashes, cell, hash);
+
+	return hash;
+}
+
+void raster_scene_prepare_hashes(struct raster_scene *scene)
+{
+	if (!scene || scene->hashes)
+		return;
+
+	scene->hashes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	calculate_cell_hash(scene, scene->cell);
+}
+
+/**
+ * @brief Add the transformation of a cell to a checksum
+ * @param checksum Checksum
+ * @param trans Transformation
+ */
+static void hash_transform(GChecksum *checksum, const struct cell_transform *trans)
+{
+	double matrix[6];
+
+	matrix[0] = trans->matrix.xx;
+	matrix[1] = trans->matrix.yx;
+	matrix[2] = trans->matrix.xy;
+	matrix[3] = trans->matrix.yy;
+	matrix[4] = trans->matrix.x0;
+	matrix[5] = trans->matrix.y0;
+	g_checksum_update(checksum, (const guchar *)matrix, sizeof(matrix));
+}
+
+/**
+ * @brief Hash the geometry of a cell instance drawn into an area
+ *
+ * Instances completely inside the area are hashed by their content hash. Only partially visible instances
+ * are descended into.
+ *
+ * @param scene Scene
+ * @param cell Cell. It overlaps \p area
+ * @param trans Transformation of the cell to database units
+ * @param area Area in database units
+ * @param min_size Minimum size of drawn instances and shapes in database units
+ * @param checksum Checksum
+ * @return Number of hashed elements
+ */
+static guint hash_cell_area(const struct raster_scene *scene, struct gds_cell *cell, const struct cell_transform *trans,
+			    const union bounding_box *area, double min_size, GChecksum *checksum)
+{
+	const struct raster_cell_hash *hash;
+	const struct raster_cell_hash *child_hash;
+	struct cell_transform inst_trans;
+	struct cell_transform child_trans;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	union bounding_box box;
+	gboolean own_hashed = FALSE;
+	guint32 index = 0;
+	guint count = 0;
+	GList *iter;
+
+	hash = (const struct raster_cell_hash *)g_hash_table_lookup(scene->hashes, cell);
+	box = *(const union bounding_box *)g_hash_table_lookup(scene->boxes, cell);
+	cell_transform_apply_to_box(trans, &box);
+
+	if (box.vectors.lower_left.x >= area->vectors.lower_left.x &&
+	    box.vectors.upper_right.x <= area->vectors.upper_right.x &&
+	    box.vectors.lower_left.y >= area->vectors.lower_left.y &&
+	    box.vectors.upper_right.y <= area->vectors.upper_right.y) {
+		g_checksum_update(checksum, hash->all, sizeof(hash->all));
+		hash_transform(checksum, trans);
+		return 1;
+	}
+
+	for (iter = cell->graphic_objs; iter != NULL; iter = g_list_next(iter), index++) {
+		gfx = (struct gds_graphics *)iter->data;
+		if (!g_hash_table_contains(scene->layer_index, GINT_TO_POINTER((int)gfx->layer)))
+			continue;
+
+		/* Same culling as append_graphics() */
+		if (!graphics_visible(scene, gfx, trans, area, min_size))
+			continue;
+
+		/* The graphics are identified by the content of the cell and their index */
+		if (!own_hashed) {
+			g_checksum_update(checksum, hash->own, sizeof(hash->own));
+			hash_transform(checksum, trans);
+			own_hashed = TRUE;
+		}
+		g_checksum_update(checksum, (const guchar *)&index, sizeof(index));
+		count++;
+	}
+
+	for (iter = cell->child_cells; iter != NULL; iter = g_list_next(iter)) {
+		inst = (struct gds_cell_instance *)iter->data;
+		if (!inst->cell_ref)
+			continue;
+		child_hash = (const struct raster_cell_hash *)g_hash_table_lookup(scene->hashes, inst->cell_ref);
+		if (!child_hash->used)
+			continue;
+
+		cell_transform_init_from_instance(&inst_trans, inst);
+		cell_transform_compose(&child_trans, trans, &inst_trans);
+		box = *(const union bounding_box *)g_hash_table_lookup(scene->boxes, inst->cell_ref);
+		cell_transform_apply_to_box(&child_trans, &box);
+		if (!boxes_overlap(&box, area) || box_below_detail(&box, min_size))
+			continue;
+
+		count += hash_cell_area(scene, inst->cell_ref, &child_trans, area, min_size, checksum);
+	}
+
+	return count;
+}
+
+guint raster_scene_hash_area(const struct raster_scene *scene, const union bounding_box *area, double min_size,
+			     GChecksum *checksum)
+{
+	const struct raster_cell_hash *hash;
+	const struct raster_layer *layer;
+	struct cell_transform identity;
+	union bounding_box box;
+	gint32 layer_number;
+	double color[4];
+	guint i;
+
+	if (!scene || !scene->hashes || !area || !checksum)
+		return 0;
+
+	/* The layers define the colors of the result */
+	for (i = 0; i < scene->layers->len; i++) {
+		layer = &g_array_index(scene->layers, struct raster_layer, i);
+		layer_number = layer->layer;
+		color[0] = layer->red;
+		color[1] = layer->green;
+		color[2] = layer->blue;
+		color[3] = layer->alpha;
+		g_checksum_update(checksum, (const guchar *)&layer_number, sizeof(layer_number));
+		g_checksum_update(checksum, (const guchar *)color, sizeof(color));
+	}
+
+	hash = (const struct raster_cell_hash *)g_hash_table_lookup(scene->hashes, scene->cell);
+	raster_scene_get_extent(scene, &box);
+	if (!hash->used || !boxes_overlap(&box, area) || box_below_detail(&box, min_size))
+		return 0;
+
+	cell_transform_init_identity(&identity);
+
+	return hash_cell_area(scene, scene->cell, &identity, area, min_size, checksum);
+}
+
+/** @} */
@@ -0,0 +1,363 @@
+/*
+ * GDSII-Converter
+ * Copyright (C) 2019  Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * This file is part of GDSII-Converter.
+ *
+ * GDSII-Converter is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * GDSII-Converter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GDSII-Converter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tiled-pdf-renderer.c
+ * @brief Multi-page (tiled) PDF output renderer
+ * @author Mario Hüttel <mario.huettel@gmx.net>
+ *
+ * The extent of the cell is split into a grid of pages. Each page is drawn from the raster scene,
+ * which only visits the instances overlapping the page. The pages are recorded in parallel in batches
+ * and appended to the PDF file in order afterwards.
+ */
+
+/**
+ * @addtogroup Tiled-PDF-Renderer
+ * @{
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <cairo.h>
+#include <cairo-pdf.h>
+#include <glib/gi18n.h>
+
+#include <gds-render/output-renderers/tiled-pdf-renderer.h>
+#include <gds-render/output-renderers/raster-scene.h>
+
+/** @brief Points per mm */
+#define POINTS_PER_MM (72.0 / 25.4)
+
+/** @brief Length of a point in meters */
+#define METERS_PER_POINT (0.0254 / 72.0)
+
+/**
+ * @brief Struct representing the tiled PDF renderer object
+ */
+struct _TiledPdfRenderer {
+	GdsOutputRenderer parent;
+	double page_width; /**< @brief Page width in mm */
+	double page_height; /**< @brief Page height in mm */
+	double plot_scale; /**< @brief Length on paper per length in the layout. 0: Use the render scale */
+};
+
+G_DEFINE_TYPE(TiledPdfRenderer, tiled_pdf_renderer, GDS_RENDER_TYPE_OUTPUT_RENDERER)
+
+enum {
+	PROP_PAGE_WIDTH = 1,
+	PROP_PAGE_HEIGHT,
+	PROP_PLOT_SCALE,
+	N_PROPERTIES
+};
+
+/**
+ * @brief Page recorded by a single thread
+ */
+struct tiled_pdf_page {
+	const struct raster_scene *scene; /**< @brief Scene to draw */
+	cairo_matrix_t device; /**< @brief Transformation from database units to points of the page */
+	union bounding_box area; /**< @brief Area of the page in database units */
+	double width; /**< @brief Page width in points */
+	double height; /**< @brief Page height in points */
+	cairo_surface_t *recording; /**< @brief Recorded page */
+};
+
+/**
+ * @brief Record a single page
+ * @param data Page
+ * @param user_data Unused
+ */
+static void tiled_pdf_page_run(gpointer data, gpointer user_data)
+{
+	struct tiled_pdf_page *page = (struct tiled_pdf_page *)data;
+	cairo_rectangle_t rect = {0.0, 0.0, page->width, page->height};
+	cairo_t *cr;
+	(void)user_data;
+
+	page->recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &rect);
+	cr = cairo_create(page->recording);
+	cairo_set_matrix(cr, &page->device);
+	raster_scene_render(page->scene, cr, &page->area, 0.0);
+	cairo_destroy(cr);
+}
+
+/**
+ * @brief Get the size of a database unit on paper
+ * @param cell Toplevel cell
+ * @param scale Render scale. Used if \p plot_scale is 0 or the cell has no library
+ * @param plot_scale Length on paper per length in the layout
+ * @return Points per database unit
+ */
+static double get_points_per_unit(struct gds_cell *cell, double scale, double plot_scale)
+{
+	if (plot_scale > 0.0 && cell->parent_library && cell->parent_library->unit_in_meters > 0.0)
+		return cell->parent_library->unit_in_meters * plot_scale / METERS_PER_POINT;
+
+	return 1.0 / scale;
+}
+
+/**
+ * @brief Render \p cell to a PDF file with a grid of pages
+ *
+ * Pages are numbered row by row, starting at the upper left corner of the cell.
+ *
+ * @param renderer Renderer
+ * @param cell Toplevel cell
+ * @param layer_infos List of layer information. Specifies color and layer stacking
+ * @param pdf_file Output file
+ * @param points_per_unit Size of a database unit on paper in points
+ * @param page_width Page width in points
+ * @param page_height Page height in points
+ * @return 0 if successful
+ */
+static int tiled_pdf_render_cell(GdsOutputRenderer *renderer, struct gds_cell *cell, GList *layer_infos,
+				 const char *pdf_file, double points_per_unit, double page_width, double page_height)
+{
+	struct raster_scene *scene;
+	struct tiled_pdf_page *pages;
+	struct tiled_pdf_page *page;
+	union bounding_box extent;
+	cairo_surface_t *pdf_surface;
+	cairo_t *pdf_cr;
+	GThreadPool *pool;
+	gchar *status;
+	double unit_width, unit_height;
+	guint columns, rows;
+	guint count, batch, first, i;
+	guint x, y;
+	int ret = 0;
+
+	if (!pdf_file || points_per_unit <= 0.0 || page_width <= 0.0 || page_height <= 0.0)
+		return -1;
+
+	scene = raster_scene_new(cell, layer_infos);
+	if (!scene) {
+		fprintf(stderr, _("Cell is affected by a reference loop. Cannot render PDF pages\n"));
+		return -2;
+	}
+
+	raster_scene_get_extent(scene, &extent);
+	if (extent.vectors.upper_right.x < extent.vectors.lower_left.x ||
+	    extent.vectors.upper_right.y < extent.vectors.lower_left.y) {
+		fprintf(stderr, _("Cell is empty. Nothing to render\n"));
+		ret = -3;
+		goto ret_free_scene;
+	}
+
+	/* Page size in database units */
+	unit_width = page_width / points_per_unit;
+	unit_height = page_height / points_per_unit;
+	columns = (guint)MAX(1.0, ceil((extent.vectors.upper_right.x - extent.vectors.lower_left.x) / unit_width));
+	rows = (guint)MAX(1.0, ceil((extent.vectors.upper_right.y - extent.vectors.lower_left.y) / unit_height));
+	if ((guint64)columns * rows > TILED_PDF_MAX_PAGES) {
+		fprintf(stderr, _("%u x %u pages exceed the limit of %d pages. Choose a smaller plot scale\n"),
+			columns, rows, TILED_PDF_MAX_PAGES);
+		ret = -4;
+		goto ret_free_scene;
+	}
+	count = columns * rows;
+	printf(_("Rendering %u x %u pages\n"), columns, rows);
+
+	pdf_surface = cairo_pdf_surface_create(pdf_file, page_width, page_height);
+	if (cairo_surface_status(pdf_surface) != CAIRO_STATUS_SUCCESS) {
+		fprintf(stderr, _("Could not open %s\n"), pdf_file);
+		cairo_surface_destroy(pdf_surface);
+		ret = -5;
+		goto ret_free_scene;
+	}
+	pdf_cr = cairo_create(pdf_surface);
+
+	/* Only a batch of pages is recorded at a time */
+	batch = MAX(1U, 2U * g_get_num_processors());
+	pages = g_new0(struct tiled_pdf_page, batch);
+
+	for (first = 0; first < count; first += batch) {
+		status = g_strdup_printf(_("Rendering page %u of %u"), first + 1, count);
+		gds_output_renderer_update_async_progress(renderer, status);
+		g_free(status);
+
+		pool = g_thread_pool_new(tiled_pdf_page_run, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+		for (i = 0; i < batch && first + i < count; i++) {
+			page = &pages[i];
+			x = (first + i) % columns;
+			y = (first + i) / columns;
+			page->scene = scene;
+			page->width = page_width;
+			page->height = page_height;
+
+			/* Point (0|0) of the page is its upper left corner */
+			cairo_matrix_init(&page->device, points_per_unit, 0.0, 0.0, -points_per_unit,
+					  -extent.vectors.lower_left.x * points_per_unit - (double)x * page_width,
+					  extent.vectors.upper_right.y * points_per_unit - (double)y * page_height);
+			page->area.vectors.lower_left.x = extent.vectors.lower_left.x + (double)x * unit_width;
+			page->area.vectors.upper_right.x = page->area.vectors.lower_left.x + unit_width;
+			page->area.vectors.upper_right.y = extent.vectors.upper_right.y - (double)y * unit_height;
+			page->area.vectors.lower_left.y = page->area.vectors.upper_right.y - unit_height;
+
+			g_thread_pool_push(pool, page, NULL);
+		}
+		g_thread_pool_free(pool, FALSE, TRUE);
+
+		/* Assemble the pages in order */
+		for (i = 0; i < batch && first + i < count; i++) {
+			page = &pages[i];
+			cairo_set_source_surface(pdf_cr, page->recording, 0.0, 0.0);
+			cairo_paint(pdf_cr);
+			cairo_show_page(pdf_cr);
+			cairo_surface_destroy(page->recording);
+			page->recording = NULL;
+		}
+	}
+
+	g_free(pages);
+	cairo_destroy(pdf_cr);
+	cairo_surface_finish(pdf_surface);
+	if (cairo_surface_status(pdf_surface) != CAIRO_STATUS_SUCCESS) {
+		fprintf(stderr, _("Could not write %s\n"), pdf_file);
+		ret = -6;
+	}
+	cairo_surface_destroy(pdf_surface);
+
+ret_free_scene:
+	raster_scene_free(scene);
+
+	return ret;
+}
+
+static int tiled_pdf_renderer_render_output(GdsOutputRenderer *renderer, struct gds_cell *cell, double scale)
+{
+	TiledPdfRenderer *t_renderer = GDS_RENDER_TILED_PDF_RENDERER(renderer);
+	LayerSettings *settings;
+	GList *layer_infos = NULL;
+	int ret;
+
+	if (!t_renderer)
+		return -2000;
+
+	settings = gds_output_renderer_get_and_ref_layer_settings(renderer);
+
+	/* Set layer info list. In case of failure it remains NULL */
+	if (settings)
+		layer_infos = layer_settings_get_layer_info_list(settings);
+
+	gds_output_renderer_update_async_progress(renderer, _("Rendering PDF Pages..."));
+	ret = tiled_pdf_render_cell(renderer, cell, layer_infos, gds_output_renderer_get_output_file(renderer),
+				    get_points_per_unit(cell, scale, t_renderer->plot_scale),
+				    t_renderer->page_width * POINTS_PER_MM, t_renderer->page_height * POINTS_PER_MM);
+
+	if (settings)
+		g_object_unref(settings);
+
+	return ret;
+}
+
+static void tiled_pdf_renderer_init(TiledPdfRenderer *self)
+{
+	self->page_width = TILED_PDF_DEFAULT_PAGE_WIDTH;
+	self->page_height = TILED_PDF_DEFAULT_PAGE_HEIGHT;
+	self->plot_scale = 0.0;
+}
+
+static void tiled_pdf_renderer_get_property(GObject *obj, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	TiledPdfRenderer *self = GDS_RENDER_TILED_PDF_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_PAGE_WIDTH:
+		g_value_set_double(value, self->page_width);
+		break;
+	case PROP_PAGE_HEIGHT:
+		g_value_set_double(value, self->page_height);
+		break;
+	case PROP_PLOT_SCALE:
+		g_value_set_double(value, self->plot_scale);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static void tiled_pdf_renderer_set_property(GObject *obj, guint property_id, const GValue *value,
+					    GParamSpec *pspec)
+{
+	TiledPdfRenderer *self = GDS_RENDER_TILED_PDF_RENDERER(obj);
+
+	switch (property_id) {
+	case PROP_PAGE_WIDTH:
+		self->page_width = g_value_get_double(value);
+		break;
+	case PROP_PAGE_HEIGHT:
+		self->page_height = g_value_get_double(value);
+		break;
+	case PROP_PLOT_SCALE:
+		self->plot_scale = g_value_get_double(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+		break;
+	}
+}
+
+static GParamSpec *tiled_pdf_renderer_properties[N_PROPERTIES] = {NULL};
+
+static void tiled_pdf_renderer_class_init(TiledPdfRendererClass *klass)
+{
+	GdsOutputRendererClass *render_class = GDS_RENDER_OUTPUT_RENDERER_CLASS(klass);
+	GObjectClass *oclass = G_OBJECT_CLASS(klass);
+
+	render_class->render_output = tiled_pdf_renderer_render_output;
+
+	oclass->get_property = tiled_pdf_renderer_get_property;
+	oclass->set_property = tiled_pdf_renderer_set_property;
+
+	tiled_pdf_renderer_properties[PROP_PAGE_WIDTH] =
+			g_param_spec_double("page-width",
+					    N_("Page width"),
+					    N_("Width of a page in mm"),
+					    TILED_PDF_MIN_PAGE_SIZE, TILED_PDF_MAX_PAGE_SIZE,
+					    TILED_PDF_DEFAULT_PAGE_WIDTH,
+					    G_PARAM_READWRITE);
+	tiled_pdf_renderer_properties[PROP_PAGE_HEIGHT] =
+			g_param_spec_double("page-height",
+					    N_("Page height"),
+					    N_("Height of a page in mm"),
+					    TILED_PDF_MIN_PAGE_SIZE, TILED_PDF_MAX_PAGE_SIZE,
+					    TILED_PDF_DEFAULT_PAGE_HEIGHT,
+					    G_PARAM_READWRITE);
+	tiled_pdf_renderer_properties[PROP_PLOT_SCALE] =
+			g_param_spec_double("plot-scale",
+					    N_("Plot scale"),
+					    N_("Length on paper per length in the layout. 0 uses the render scale"),
+					    0.0, G_MAXDOUBLE, 0.0,
+					    G_PARAM_READWRITE);
+
+	g_object_class_install_properties(oclass, N_PROPERTIES, tiled_pdf_renderer_properties);
+}
+
+TiledPdfRenderer *tiled_pdf_renderer_new(double page_width, double page_height, double plot_scale)
+{
+	GObject *obj;
+
+	obj = g_object_new(GDS_RENDER_TYPE_TILED_PDF_RENDERER, "page-width", page_width, "page-height", page_height,
+			   "plot-scale", plot_scale, NULL);
+	return GDS_RENDER_TILED_PDF_RENDERER(obj);
+}
+
+/** @} */
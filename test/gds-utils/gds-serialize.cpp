@@ -0,0 +1,102 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <string.h>
+#include <gds-render/gds-utils/gds-serialize.h>
+#include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-topology.h>
+}
+#include "test-fixtures.h"
+
+static struct gds_cell *find_cell(struct gds_library *lib, const char *name)
+{
+	GList *iter;
+
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter)) {
+		if (!strcmp(((struct gds_cell *)iter->data)->name, name))
+			return (struct gds_cell *)iter->data;
+	}
+
+	return NULL;
+}
+
+TEST_CASE("gds-utils/gds-serialize/round-trip", "[GDS-UTILS]")
+{
+	GList *libs = NULL;
+	GList *copy_list = NULL;
+	struct gds_library *lib;
+	struct gds_library *copy;
+	struct gds_cell *top, *leaf, *unused;
+	struct gds_cell *copy_top, *copy_leaf;
+	struct gds_cell_instance *inst;
+	struct gds_graphics *gfx;
+	GByteArray *data;
+
+	lib = (struct gds_library *)calloc(1, sizeof(struct gds_library));
+	strcpy(lib->name, "LIB");
+	lib->unit_in_meters = 1E-9;
+	libs = g_list_append(libs, lib);
+
+	leaf = add_cell(lib, "LEAF");
+	top = add_cell(lib, "TOP");
+	unused = add_cell(lib, "UNUSED");
+	add_box(leaf, 3, 10);
+	add_box(top, 5, 100);
+	add_box(unused, 7, 1);
+	add_reference(top, leaf, 20, 30)->angle = 90.0;
+	add_reference(top, leaf, -5, 0)->flipped = 1;
+
+	data = g_byte_array_new();
+	REQUIRE(gds_serialize_cell(top, data) == 0);
+
+	SECTION("Hierarchy is rebuilt") {
+		copy = gds_deserialize_library(data->data, data->len, &copy_top);
+		REQUIRE(copy != NULL);
+		copy_list = g_list_append(copy_list, copy);
+
+		REQUIRE(strcmp(copy->name, "LIB") == 0);
+		REQUIRE(copy->unit_in_meters == Approx(1E-9));
+		REQUIRE(g_list_length(copy->cells) == 2);
+		REQUIRE(find_cell(copy, "UNUSED") == NULL);
+		REQUIRE(strcmp(copy_top->name, "TOP") == 0);
+
+		copy_leaf = find_cell(copy, "LEAF");
+		REQUIRE(copy_leaf != NULL);
+		REQUIRE(copy_leaf->parent_library == copy);
+		REQUIRE(g_list_length(copy_top->child_cells) == 2);
+
+		inst = (struct gds_cell_instance *)g_list_nth_data(copy_top->child_cells, 0);
+		REQUIRE(inst->cell_ref == copy_leaf);
+		REQUIRE(inst->origin.x == 20);
+		REQUIRE(inst->origin.y == 30);
+		REQUIRE(inst->angle == Approx(90.0));
+		REQUIRE(strcmp(inst->ref_name, "LEAF") == 0);
+		inst = (struct gds_cell_instance *)g_list_nth_data(copy_top->child_cells, 1);
+		REQUIRE(inst->flipped == 1);
+		REQUIRE(inst->origin.x == -5);
+
+		gfx = (struct gds_graphics *)copy_top->graphic_objs->data;
+		REQUIRE(gfx->gfx_type == GRAPHIC_BOX);
+		REQUIRE(gfx->layer == 5);
+		REQUIRE(gfx->vertex_count == 4);
+		REQUIRE(gfx->vertex_array[2].x == 100);
+		REQUIRE(gfx->vertex_array[2].y == 100);
+
+		clear_lib_list(&copy_list);
+	}
+
+	SECTION("Truncated images are rejected") {
+		REQUIRE(gds_deserialize_library(data->data, data->len - 1, &copy_top) == NULL);
+		REQUIRE(gds_deserialize_library(data->data, 10, &copy_top) == NULL);
+	}
+
+	SECTION("Reference loops cannot be serialized") {
+		add_reference(leaf, top, 0, 0);
+		gds_topology_invalidate(lib);
+		g_byte_array_set_size(data, 0);
+		REQUIRE(gds_serialize_cell(top, data) == -2);
+	}
+
+	g_byte_array_free(data, TRUE);
+	clear_lib_list(&libs);
+}
@@ -0,0 +1,238 @@
+#include <catch.hpp>
+#include <vector>
+#include <string>
+
+extern "C" {
+#include <stdio.h>
+#include <unistd.h>
+#include <gds-render/gds-utils/gds-statistics.h>
+#include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-topology.h>
+}
+#include "test-fixtures.h"
+
+static const struct gds_layer_statistics *find_layer(const struct gds_cell_statistics *stats, int layer)
+{
+	guint i;
+
+	for (i = 0; i < stats->layers->len; i++) {
+		if (g_array_index(stats->layers, struct gds_layer_statistics, i).layer == layer)
+			return &g_array_index(stats->layers, struct gds_layer_statistics, i);
+	}
+
+	return NULL;
+}
+
+static void free_library(struct gds_library *lib)
+{
+	GList *iter;
+
+	gds_topology_invalidate(lib);
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter))
+		free_cell((struct gds_cell *)iter->data);
+	g_list_free(lib->cells);
+	g_free(lib);
+}
+
+TEST_CASE("gds-utils/gds-statistics/shared-sub-cell", "[GDS-UTILS]")
+{
+	struct gds_library *lib = (struct gds_library *)g_malloc0(sizeof(struct gds_library));
+	struct gds_cell *top = add_cell(lib, "TOP");
+	struct gds_cell *mid = add_cell(lib, "MID");
+	struct gds_cell *leaf = add_cell(lib, "LEAF");
+	struct gds_cell *orphan = add_cell(NULL, "ORPHAN");
+	struct gds_cell_statistics stats;
+	const struct gds_layer_statistics *lstat;
+
+	add_box(leaf, 1, 10);
+	add_box(mid, 2, 20);
+	add_reference(mid, leaf, 0, 0);
+	add_reference(mid, leaf, 10, 0);
+	add_reference(top, mid, 0, 0);
+	add_reference(top, mid, 0, 50);
+	add_reference(top, mid, 0, 100);
+	add_reference(top, leaf, 100, 0);
+	add_reference(top, NULL, 0, 0);
+
+	SECTION("The shared cell is counted per placement") {
+		REQUIRE(gds_statistics_calculate(top, &stats) == 0);
+		/* 3 * (1 + 2) + 1 */
+		REQUIRE(stats.primitive_count == 10);
+		REQUIRE(stats.vertex_count == 40);
+		/* 3 mid instances with 2 leaf instances each and one direct leaf instance */
+		REQUIRE(stats.instance_count == 10);
+
+		REQUIRE(stats.layers->len == 2);
+		REQUIRE(g_array_index(stats.layers, struct gds_layer_statistics, 0).layer == 1);
+		lstat = find_layer(&stats, 1);
+		REQUIRE(lstat->primitive_count == 7);
+		REQUIRE(lstat->vertex_count == 28);
+		lstat = find_layer(&stats, 2);
+		REQUIRE(lstat->primitive_count == 3);
+		REQUIRE(lstat->vertex_count == 12);
+		gds_statistics_free(&stats);
+	}
+
+	SECTION("Reference loops are rejected") {
+		add_reference(leaf, top, 0, 0);
+		gds_topology_invalidate(lib);
+		REQUIRE(gds_statistics_calculate(top, &stats) == -2);
+		gds_statistics_free(&stats);
+	}
+
+	REQUIRE(gds_statistics_calculate(NULL, &stats) == -1);
+	REQUIRE(gds_statistics_calculate(orphan, &stats) == -1);
+
+	free_cell(orphan);
+	free_library(lib);
+}
+
+TEST_CASE("gds-utils/gds-statistics/deep-chain", "[GDS-UTILS]")
+{
+	const size_t count = 1000000;
+	struct gds_library *lib = (struct gds_library *)g_malloc0(sizeof(struct gds_library));
+	std::vector<struct gds_cell *> cells(count);
+	struct gds_cell_statistics stats;
+	size_t i;
+
+	/* Each cell places the next one twice. Build the list backwards, appending is quadratic */
+	for (i = count; i > 0; i--) {
+		cells[i - 1] = (struct gds_cell *)g_malloc0(sizeof(struct gds_cell));
+		cells[i - 1]->parent_library = lib;
+		lib->cells = g_list_prepend(lib->cells, cells[i - 1]);
+		if (i < count) {
+			add_reference(cells[i - 1], cells[i], 0, 0);
+			add_reference(cells[i - 1], cells[i], 10, 0);
+		}
+	}
+	add_box(cells[count - 1], 1, 10);
+	add_box(cells[0], 2, 10);
+
+	REQUIRE(gds_statistics_calculate(cells[0], &stats) == 0);
+	/* 2^(count - 1) leaf placements saturate the counters */
+	REQUIRE(stats.primitive_count == G_MAXUINT64);
+	REQUIRE(stats.instance_count == G_MAXUINT64);
+	REQUIRE(stats.layers->len == 2);
+	REQUIRE(find_layer(&stats, 1)->primitive_count == G_MAXUINT64);
+	REQUIRE(find_layer(&stats, 2)->primitive_count == 1);
+	gds_statistics_free(&stats);
+
+	REQUIRE(gds_statistics_calculate(cells[count - 2], &stats) == 0);
+	REQUIRE(stats.primitive_count == 2);
+	REQUIRE(stats.vertex_count == 8);
+	REQUIRE(stats.instance_count == 2);
+	gds_statistics_free(&stats);
+
+	free_library(lib);
+}
+
+static void write_record(std::vector<unsigned char> &gds, unsigned int type,
+			 const std::vector<unsigned char> &payload = std::vector<unsigned char>())
+{
+	size_t length = payload.size() + 4;
+
+	gds.push_back((unsigned char)(length >> 8));
+	gds.push_back((unsigned char)length);
+	gds.push_back((unsigned char)(type >> 8));
+	gds.push_back((unsigned char)type);
+	gds.insert(gds.end(), payload.begin(), payload.end());
+}
+
+static void write_int_record(std::vector<unsigned char> &gds, unsigned int type, const std::vector<int> &values,
+			     int bytes)
+{
+	std::vector<unsigned char> payload;
+	int i;
+
+	for (int v : values) {
+		for (i = bytes - 1; i >= 0; i--)
+			payload.push_back((unsigned char)((v >> (8 * i)) & 0xFF));
+	}
+	write_record(gds, type, payload);
+}
+
+static void write_string_record(std::vector<unsigned char> &gds, unsigned int type, std::string str)
+{
+	if (str.size() % 2)
+		str.push_back('\0');
+	write_record(gds, type, std::vector<unsigned char>(str.begin(), str.end()));
+}
+
+TEST_CASE("gds-utils/gds-statistics/aref", "[GDS-UTILS]")
+{
+	std::vector<unsigned char> gds;
+	const std::vector<int> timestamp(12, 0);
+	GList *libs = NULL;
+	struct gds_library *lib;
+	struct gds_cell *top = NULL;
+	struct gds_cell *leaf = NULL;
+	struct gds_cell *cell;
+	struct gds_graphics *gfx;
+	struct gds_cell_statistics stats;
+	guint64 leaf_vertices;
+	GList *iter;
+	gchar *file_name;
+	int fd;
+
+	write_int_record(gds, 0x0002, {600}, 2);
+	write_int_record(gds, 0x0102, timestamp, 2);
+	write_string_record(gds, 0x0206, "LIB");
+
+	write_int_record(gds, 0x0502, timestamp, 2);
+	write_string_record(gds, 0x0606, "LEAF");
+	write_record(gds, 0x0800);
+	write_int_record(gds, 0x0D02, {4}, 2);
+	write_int_record(gds, 0x0E02, {0}, 2);
+	write_int_record(gds, 0x1003, {0, 0, 10, 0, 10, 10, 0, 10, 0, 0}, 4);
+	write_record(gds, 0x1100);
+	write_record(gds, 0x0700);
+
+	/* AREF with 3 columns and 2 rows */
+	write_int_record(gds, 0x0502, timestamp, 2);
+	write_string_record(gds, 0x0606, "TOP");
+	write_record(gds, 0x0B00);
+	write_string_record(gds, 0x1206, "LEAF");
+	write_int_record(gds, 0x1302, {3, 2}, 2);
+	write_int_record(gds, 0x1003, {0, 0, 60, 0, 0, 40}, 4);
+	write_record(gds, 0x1100);
+	write_record(gds, 0x0700);
+	write_record(gds, 0x0400);
+
+	fd = g_file_open_tmp("gds-statistics-XXXXXX.gds", &file_name, NULL);
+	REQUIRE(fd >= 0);
+	REQUIRE(write(fd, gds.data(), gds.size()) == (ssize_t)gds.size());
+	close(fd);
+
+	REQUIRE(parse_gds_from_file(file_name, &libs) == 0);
+	unlink(file_name);
+	g_free(file_name);
+
+	REQUIRE(libs != NULL);
+	lib = (struct gds_library *)libs->data;
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter)) {
+		cell = (struct gds_cell *)iter->data;
+		if (!strcmp(cell->name, "TOP"))
+			top = cell;
+		else if (!strcmp(cell->name, "LEAF"))
+			leaf = cell;
+	}
+	REQUIRE(top != NULL);
+	REQUIRE(leaf != NULL);
+	/* The parser expands the AREF into single instances */
+	REQUIRE(g_list_length(top->child_cells) == 6);
+
+	gfx = (struct gds_graphics *)leaf->graphic_objs->data;
+	leaf_vertices = gfx->vertex_count;
+	REQUIRE(leaf_vertices >= 4);
+
+	REQUIRE(gds_statistics_calculate(top, &stats) == 0);
+	REQUIRE(stats.instance_count == 6);
+	REQUIRE(stats.primitive_count == 6);
+	REQUIRE(stats.vertex_count == 6 * leaf_vertices);
+	REQUIRE(stats.layers->len == 1);
+	REQUIRE(find_layer(&stats, 4)->primitive_count == 6);
+	REQUIRE(find_layer(&stats, 4)->vertex_count == 6 * leaf_vertices);
+	gds_statistics_free(&stats);
+
+	clear_lib_list(&libs);
+}
@@ -0,0 +1,97 @@
+#include <catch.hpp>
+#include <vector>
+
+extern "C" {
+#include <gds-render/gds-utils/gds-topology.h>
+}
+#include "test-fixtures.h"
+
+static void free_library(struct gds_library *lib)
+{
+	GList *iter;
+
+	gds_topology_invalidate(lib);
+	for (iter = lib->cells; iter != NULL; iter = g_list_next(iter))
+		g_list_free_full(((struct gds_cell *)iter->data)->child_cells, g_free);
+	g_list_free_full(lib->cells, g_free);
+	g_free(lib);
+}
+
+static guint position(const GPtrArray *arr, const struct gds_cell *cell)
+{
+	guint i;
+
+	for (i = 0; i < arr->len; i++) {
+		if (g_ptr_array_index(arr, i) == cell)
+			return i;
+	}
+
+	return G_MAXUINT;
+}
+
+TEST_CASE("gds-utils/gds-topology/gds_topology_get", "[GDS-UTILS]")
+{
+	struct gds_library *lib;
+	const struct gds_library_topology *topo;
+	struct gds_cell *top, *mid, *leaf, *other;
+	GPtrArray *reachable;
+
+	lib = (struct gds_library *)g_malloc0(sizeof(struct gds_library));
+	leaf = add_cell(lib, NULL);
+	top = add_cell(lib, NULL);
+	mid = add_cell(lib, NULL);
+	other = add_cell(lib, NULL);
+
+	add_reference(top, mid, 0, 0);
+	add_reference(top, leaf, 0, 0);
+	add_reference(mid, leaf, 0, 0);
+	add_reference(mid, leaf, 0, 0);
+
+	SECTION("Cells are ordered bottom-up") {
+		topo = gds_topology_get(lib);
+		REQUIRE(topo != NULL);
+		REQUIRE(lib->topology == topo);
+		REQUIRE_FALSE(topo->has_loops);
+		REQUIRE(topo->bottom_up->len == 4);
+		REQUIRE(position(topo->bottom_up, leaf) < position(topo->bottom_up, mid));
+		REQUIRE(position(topo->bottom_up, mid) < position(topo->bottom_up, top));
+
+		REQUIRE(g_list_length(topo->top_cells) == 2);
+		REQUIRE(g_list_find(topo->top_cells, top) != NULL);
+		REQUIRE(g_list_find(topo->top_cells, other) != NULL);
+
+		REQUIRE(gds_topology_get_cell_depth(lib, top) == 0);
+		REQUIRE(gds_topology_get_cell_depth(lib, mid) == 1);
+		REQUIRE(gds_topology_get_cell_depth(lib, leaf) == 2);
+		REQUIRE(gds_topology_get_cell_depth(lib, other) == 0);
+	}
+
+	SECTION("Reachable cells") {
+		reachable = gds_topology_get_reachable_cells(lib, top);
+		REQUIRE(reachable != NULL);
+		REQUIRE(reachable->len == 3);
+		REQUIRE(g_ptr_array_index(reachable, 2) == top);
+		REQUIRE(position(reachable, leaf) < position(reachable, mid));
+		REQUIRE(position(reachable, other) == G_MAXUINT);
+		g_ptr_array_free(reachable, TRUE);
+	}
+
+	SECTION("Modifications require invalidation") {
+		topo = gds_topology_get(lib);
+		REQUIRE_FALSE(topo->has_loops);
+
+		/* Create a loop */
+		add_reference(leaf, top, 0, 0);
+		gds_topology_invalidate(lib);
+		REQUIRE(lib->topology == NULL);
+
+		topo = gds_topology_get(lib);
+		REQUIRE(topo->has_loops);
+		REQUIRE(topo->bottom_up->len == 1);
+		REQUIRE(gds_topology_get_cell_depth(lib, top) == -1);
+		REQUIRE(gds_topology_get_cell_depth(lib, other) == 0);
+		REQUIRE(gds_topology_get_reachable_cells(lib, top) == NULL);
+	}
+
+	free_library(lib);
+}
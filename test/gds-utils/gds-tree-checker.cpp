@@ -0,0 +1,157 @@
+#include <catch.hpp>
+#include <vector>
+
+extern "C" {
+#include <gds-render/gds-utils/gds-tree-checker.h>
+#include <gds-render/gds-utils/gds-topology.h>
+}
+
+class TestLibrary {
+public:
+	TestLibrary(size_t cell_count)
+	{
+		size_t i;
+
+		lib = (struct gds_library *)g_malloc0(sizeof(struct gds_library));
+		cells.resize(cell_count);
+		for (i = 0; i < cell_count; i++) {
+			cells[i] = (struct gds_cell *)g_malloc0(sizeof(struct gds_cell));
+			cells[i]->parent_library = lib;
+			cells[i]->checks.affected_by_reference_loop = GDS_CELL_CHECK_NOT_RUN;
+			lib->cells = g_list_prepend(lib->cells, cells[i]);
+		}
+		lib->cells = g_list_reverse(lib->cells);
+	}
+
+	~TestLibrary()
+	{
+		gds_topology_invalidate(lib);
+		for (auto cell : cells) {
+			g_list_free_full(cell->child_cells, g_free);
+			g_free(cell);
+		}
+		g_list_free(lib->cells);
+		g_free(lib);
+	}
+
+	void reference(size_t parent, size_t child)
+	{
+		struct gds_cell_instance *inst;
+
+		inst = (struct gds_cell_instance *)g_malloc0(sizeof(struct gds_cell_instance));
+		inst->cell_ref = cells[child];
+		cells[parent]->child_cells = g_list_prepend(cells[parent]->child_cells, inst);
+	}
+
+	int affected(size_t idx)
+	{
+		return cells[idx]->checks.affected_by_reference_loop;
+	}
+
+	struct gds_library *lib;
+	std::vector<struct gds_cell *> cells;
+};
+
+TEST_CASE("gds-utils/gds-tree-checker/gds_tree_check_reference_loops", "[GDS-UTILS]")
+{
+	SECTION("Shared sub cells are no loop") {
+		TestLibrary tl(4);
+
+		tl.reference(0, 1);
+		tl.reference(0, 2);
+		tl.reference(1, 3);
+		tl.reference(2, 3);
+
+		REQUIRE(gds_tree_check_reference_loops(tl.lib) == 0);
+		for (size_t i = 0; i < 4; i++)
+			REQUIRE(tl.affected(i) == 0);
+	}
+
+	SECTION("Self references are loops") {
+		TestLibrary tl(3);
+
+		tl.reference(0, 0);
+		tl.reference(1, 0);
+
+		REQUIRE(gds_tree_check_reference_loops(tl.lib) == 2);
+		REQUIRE(tl.affected(0) == 1);
+		REQUIRE(tl.affected(1) == 1);
+		REQUIRE(tl.affected(2) == 0);
+	}
+
+	SECTION("Cells reaching a loop are affected") {
+		TestLibrary tl(7);
+
+		/* Loop 0 -> 1 -> 2 -> 0 */
+		tl.reference(0, 1);
+		tl.reference(1, 2);
+		tl.reference(2, 0);
+		tl.reference(3, 1);
+		tl.reference(4, 3);
+		tl.reference(2, 6);
+
+		REQUIRE(gds_tree_check_reference_loops(tl.lib) == 5);
+		for (size_t i = 0; i < 5; i++)
+			REQUIRE(tl.affected(i) == 1);
+		REQUIRE(tl.affected(5) == 0);
+		REQUIRE(tl.affected(6) == 0);
+	}
+
+	SECTION("Deep hierarchies are handled") {
+		const size_t count = 1000000;
+		TestLibrary tl(count);
+		size_t i;
+
+		for (i = 0; i + 1 < count; i++)
+			tl.reference(i, i + 1);
+
+		REQUIRE(gds_tree_check_reference_loops(tl.lib) == 0);
+		REQUIRE(tl.affected(0) == 0);
+
+		/* Close a loop at the bottom of the chain */
+		tl.reference(count - 1, count - 2);
+		REQUIRE(gds_tree_check_reference_loops(tl.lib) == (int)count);
+		REQUIRE(tl.affected(0) == 1);
+		REQUIRE(tl.affected(count - 1) == 1);
+	}
+}
+
+TEST_CASE("gds-utils/gds-tree-checker/gds_tree_check_instance_counts", "[GDS-UTILS]")
+{
+	TestLibrary tl(5);
+	size_t i;
+
+	/* 0 -> 2x 1, 0 -> 2, 1 -> 3x 3, 2 -> 3, 4 unrelated */
+	tl.reference(0, 1);
+	tl.reference(0, 1);
+	tl.reference(0, 2);
+	for (i = 0; i < 3; i++)
+		tl.reference(1, 3);
+	tl.reference(2, 3);
+
+	SECTION("Counts from a chosen top cell") {
+		REQUIRE(gds_tree_check_instance_counts(tl.lib, tl.cells[0]) == 0);
+		REQUIRE(tl.cells[0]->checks.instance_count == 1);
+		REQUIRE(tl.cells[1]->checks.instance_count == 2);
+		REQUIRE(tl.cells[2]->checks.instance_count == 1);
+		REQUIRE(tl.cells[3]->checks.instance_count == 7);
+		REQUIRE(tl.cells[4]->checks.instance_count == 0);
+
+		REQUIRE(gds_tree_check_instance_counts(tl.lib, tl.cells[1]) == 0);
+		REQUIRE(tl.cells[0]->checks.instance_count == 0);
+		REQUIRE(tl.cells[3]->checks.instance_count == 3);
+	}
+
+	SECTION("Counts of all top cells") {
+		REQUIRE(gds_tree_check_instance_counts(tl.lib, NULL) == 0);
+		REQUIRE(tl.cells[0]->checks.instance_count == 1);
+		REQUIRE(tl.cells[3]->checks.instance_count == 7);
+		REQUIRE(tl.cells[4]->checks.instance_count == 1);
+	}
+
+	SECTION("Top cells affected by loops are rejected") {
+		tl.reference(3, 1);
+		gds_topology_invalidate(tl.lib);
+		REQUIRE(gds_tree_check_instance_counts(tl.lib, tl.cells[0]) < 0);
+	}
+}
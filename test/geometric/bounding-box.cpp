@@ -0,0 +1,48 @@
+#include <catch.hpp>
+#include <limits>
+#include <vector>
+
+extern "C" {
+#include <gds-render/geometric/bounding-box.h>
+#include <gds-render/gds-utils/gds-types.h>
+}
+
+TEST_CASE("geometric/bounding-box/bounding_box_calculate_from_int_points", "[GEOMETRIC]")
+{
+	std::vector<struct gds_point> points;
+	union bounding_box box;
+	size_t count;
+	size_t i;
+	int xmin, ymin, xmax, ymax;
+
+	for (i = 0; i < 100; i++) {
+		struct gds_point pt;
+
+		pt.x = (int)((i * 7919) % 1000) - 500;
+		pt.y = (int)((i * 104729) % 2000) - 700;
+		points.push_back(pt);
+	}
+	points[37].x = std::numeric_limits<int>::min();
+	points[62].y = std::numeric_limits<int>::max();
+
+	/* Check all tail lengths of the vectorized loops */
+	for (count = 1; count <= points.size(); count++) {
+		xmin = ymin = std::numeric_limits<int>::max();
+		xmax = ymax = std::numeric_limits<int>::min();
+		for (i = 0; i < count; i++) {
+			xmin = MIN(xmin, points[i].x);
+			ymin = MIN(ymin, points[i].y);
+			xmax = MAX(xmax, points[i].x);
+			ymax = MAX(ymax, points[i].y);
+		}
+
+		bounding_box_calculate_from_int_points(points.data(), count, &box);
+		REQUIRE(box.vectors.lower_left.x == (double)xmin);
+		REQUIRE(box.vectors.lower_left.y == (double)ymin);
+		REQUIRE(box.vectors.upper_right.x == (double)xmax);
+		REQUIRE(box.vectors.upper_right.y == (double)ymax);
+	}
+
+	bounding_box_calculate_from_int_points(points.data(), 0, &box);
+	REQUIRE(box.vectors.lower_left.x > box.vectors.upper_right.x);
+}
@@ -0,0 +1,97 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <string.h>
+#include <gds-render/geometric/cell-geometrics.h>
+#include <gds-render/gds-utils/gds-parser.h>
+#include <gds-render/gds-utils/gds-topology.h>
+}
+#include "test-fixtures.h"
+
+static void require_box(const union bounding_box *box, double llx, double lly, double urx, double ury)
+{
+	REQUIRE(box->vectors.lower_left.x == Approx(llx));
+	REQUIRE(box->vectors.lower_left.y == Approx(lly));
+	REQUIRE(box->vectors.upper_right.x == Approx(urx));
+	REQUIRE(box->vectors.upper_right.y == Approx(ury));
+}
+
+TEST_CASE("geometric/cell-geometrics/calculate_cell_bounding_boxes", "[GEOMETRIC]")
+{
+	GList *libs = NULL;
+	struct gds_library *lib;
+	struct gds_cell *top, *leaf;
+	GHashTable *boxes;
+	union bounding_box box;
+
+	lib = (struct gds_library *)calloc(1, sizeof(struct gds_library));
+	libs = g_list_append(libs, lib);
+	leaf = add_cell(lib, "LEAF");
+	top = add_cell(lib, "TOP");
+	add_box(leaf, 0, 10);
+	add_box(top, 0, 100);
+	add_reference(top, leaf, 200, 0)->angle = 90.0;
+
+	SECTION("Each cell has a box in its own coordinates") {
+		boxes = calculate_cell_bounding_boxes(top);
+		REQUIRE(boxes != NULL);
+		REQUIRE(g_hash_table_size(boxes) == 2);
+		require_box((union bounding_box *)g_hash_table_lookup(boxes, leaf), 0, 0, 10, 10);
+		require_box((union bounding_box *)g_hash_table_lookup(boxes, top), 0, 0, 200, 100);
+		g_hash_table_destroy(boxes);
+
+		bounding_box_prepare_empty(&box);
+		calculate_cell_bounding_box(&box, top);
+		require_box(&box, 0, 0, 200, 100);
+	}
+
+	SECTION("Only the requested layers are included") {
+		const int layers[] = {4};
+		struct gds_cell *other;
+
+		other = add_cell(lib, "OTHER");
+		add_box(other, 4, 5);
+		add_reference(top, other, -50, -60)->angle = 90.0;
+		gds_topology_invalidate(lib);
+
+		boxes = calculate_cell_bounding_boxes_for_layers(top, layers, 1);
+		REQUIRE(boxes != NULL);
+		require_box((union bounding_box *)g_hash_table_lookup(boxes, top), -55, -60, -50, -55);
+		box = *(union bounding_box *)g_hash_table_lookup(boxes, leaf);
+		REQUIRE(box.vectors.lower_left.x > box.vectors.upper_right.x);
+		g_hash_table_destroy(boxes);
+
+		boxes = calculate_cell_bounding_boxes_for_layers(top, NULL, 0);
+		require_box((union bounding_box *)g_hash_table_lookup(boxes, top), -55, -60, 200, 100);
+		g_hash_table_destroy(boxes);
+	}
+
+	SECTION("Reference loops have no boxes") {
+		add_reference(leaf, top, 0, 0);
+		gds_topology_invalidate(lib);
+		REQUIRE(calculate_cell_bounding_boxes(top) == NULL);
+	}
+
+	clear_lib_list(&libs);
+}
+
+TEST_CASE("geometric/cell-geometrics/calculate_cell_bounding_boxes-without-library", "[GEOMETRIC]")
+{
+	struct gds_cell *top, *leaf;
+	GHashTable *boxes;
+
+	leaf = add_cell(NULL, "LEAF");
+	top = add_cell(NULL, "TOP");
+	add_box(leaf, 0, 10);
+	add_reference(top, leaf, -20, 5);
+	add_reference(top, leaf, 30, 5)->flipped = 1;
+
+	boxes = calculate_cell_bounding_boxes(top);
+	REQUIRE(boxes != NULL);
+	require_box((union bounding_box *)g_hash_table_lookup(boxes, top), -20, -5, 40, 15);
+	g_hash_table_destroy(boxes);
+
+	/* Cells without library are not owned by a library. Free them manually */
+	free_cell(top);
+	free_cell(leaf);
+}
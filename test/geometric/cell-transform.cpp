@@ -0,0 +1,113 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <gds-render/geometric/cell-transform.h>
+}
+
+static void init_instance(struct gds_cell_instance *inst, int x, int y, double angle, double mag, int flipped)
+{
+	inst->origin.x = x;
+	inst->origin.y = y;
+	inst->angle = angle;
+	inst->magnification = mag;
+	inst->flipped = flipped;
+	inst->cell_ref = NULL;
+}
+
+TEST_CASE("geometric/cell-transform/cell_transform_init_from_instance", "[GEOMETRIC]")
+{
+	struct gds_cell_instance inst;
+	struct cell_transform trans;
+
+	init_instance(&inst, 10, -20, -90.0, 1.0, 1);
+	cell_transform_init_from_instance(&trans, &inst);
+	REQUIRE(trans.manhattan);
+	REQUIRE(trans.mt.quarter_turns == 3);
+	REQUIRE(trans.mt.flipped);
+	REQUIRE(trans.mt.x0 == 10);
+	REQUIRE(trans.mt.y0 == -20);
+
+	init_instance(&inst, 0, 0, 45.0, 1.0, 0);
+	cell_transform_init_from_instance(&trans, &inst);
+	REQUIRE_FALSE(trans.manhattan);
+
+	init_instance(&inst, 0, 0, 90.0, 2.0, 0);
+	cell_transform_init_from_instance(&trans, &inst);
+	REQUIRE_FALSE(trans.manhattan);
+}
+
+TEST_CASE("geometric/cell-transform/cell_transform_compose", "[GEOMETRIC]")
+{
+	struct gds_cell_instance outer_inst, inner_inst;
+	struct cell_transform outer, inner, res, res_float;
+	struct gds_point pt;
+	struct vector_2d exact, approx;
+	int angle_o, angle_i, flip_o, flip_i;
+
+	pt.x = 3;
+	pt.y = 7;
+
+	for (angle_o = -180; angle_o <= 270; angle_o += 90) {
+		for (angle_i = 0; angle_i <= 360; angle_i += 90) {
+			for (flip_o = 0; flip_o < 2; flip_o++) {
+				for (flip_i = 0; flip_i < 2; flip_i++) {
+					init_instance(&outer_inst, 100, -50, angle_o, 1.0, flip_o);
+					init_instance(&inner_inst, -11, 13, angle_i, 1.0, flip_i);
+					cell_transform_init_from_instance(&outer, &outer_inst);
+					cell_transform_init_from_instance(&inner, &inner_inst);
+					cell_transform_compose(&res, &outer, &inner);
+					REQUIRE(res.manhattan);
+
+					/* Compare against the double precision matrix product */
+					res_float = res;
+					res_float.manhattan = false;
+					affine_2d_multiply(&res_float.matrix, &outer.matrix, &inner.matrix);
+
+					cell_transform_apply_to_point(&res, &pt, &exact);
+					cell_transform_apply_to_point(&res_float, &pt, &approx);
+					REQUIRE(exact.x == Approx(approx.x));
+					REQUIRE(exact.y == Approx(approx.y));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("geometric/cell-transform/cell_transform_apply_to_box", "[GEOMETRIC]")
+{
+	struct gds_cell_instance inst;
+	struct cell_transform trans;
+	union bounding_box box;
+
+	box.vectors.lower_left.x = 0;
+	box.vectors.lower_left.y = 0;
+	box.vectors.upper_right.x = 10;
+	box.vectors.upper_right.y = 5;
+
+	init_instance(&inst, 100, 200, 90.0, 1.0, 0);
+	cell_transform_init_from_instance(&trans, &inst);
+	cell_transform_apply_to_box(&trans, &box);
+
+	REQUIRE(box.vectors.lower_left.x == 95.0);
+	REQUIRE(box.vectors.lower_left.y == 200.0);
+	REQUIRE(box.vectors.upper_right.x == 100.0);
+	REQUIRE(box.vectors.upper_right.y == 210.0);
+}
+
+TEST_CASE("geometric/cell-transform/manhattan_transform_apply_to_points", "[GEOMETRIC]")
+{
+	struct manhattan_transform trans;
+	struct gds_point pts[2] = {{1, 2}, {-3, 4}};
+
+	trans.x0 = 5;
+	trans.y0 = 6;
+	trans.quarter_turns = 2;
+	trans.flipped = true;
+
+	manhattan_transform_apply_to_points(&trans, pts, pts, 2);
+
+	REQUIRE(pts[0].x == 4);
+	REQUIRE(pts[0].y == 8);
+	REQUIRE(pts[1].x == 8);
+	REQUIRE(pts[1].y == 10);
+}
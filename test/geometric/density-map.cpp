@@ -0,0 +1,100 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <gds-render/geometric/density-map.h>
+}
+#include "test-fixtures.h"
+
+TEST_CASE("geometric/density-map/density_map_calculate_layer", "[GEOMETRIC]")
+{
+	struct flat_layer layer;
+	struct density_map *map = NULL;
+	union bounding_box extent;
+
+	layer.layer = 5;
+	layer.primitives = g_array_new(FALSE, FALSE, sizeof(struct flat_primitive));
+	layer.vertices = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	extent.vectors.lower_left.x = 0.0;
+	extent.vectors.lower_left.y = 0.0;
+	extent.vectors.upper_right.x = 20.0;
+	extent.vectors.upper_right.y = 20.0;
+
+	SECTION("Overlapping rectangles are counted once") {
+		const double a[] = {0, 0, 10, 0, 10, 10, 0, 10};
+		const double b[] = {5, 0, 15, 0, 15, 5, 5, 5};
+
+		add_shape(&layer, GRAPHIC_BOX, a, 4);
+		add_shape(&layer, GRAPHIC_POLYGON, b, 4);
+
+		map = density_map_calculate_layer(&layer, &extent, 2, 2);
+		REQUIRE(map != NULL);
+		REQUIRE(map->layer == 5);
+		/* Row 0 is the top row */
+		REQUIRE(map->coverage[0] == Approx(0.0));
+		REQUIRE(map->coverage[1] == Approx(0.0));
+		REQUIRE(map->coverage[2] == Approx(1.0));
+		REQUIRE(map->coverage[3] == Approx(0.25));
+	}
+
+	SECTION("Non-Manhattan polygons are clipped to the tiles") {
+		const double triangle[] = {0, 0, 20, 0, 0, 20};
+
+		add_shape(&layer, GRAPHIC_POLYGON, triangle, 3);
+
+		map = density_map_calculate_layer(&layer, &extent, 2, 2);
+		REQUIRE(map != NULL);
+		REQUIRE(map->coverage[0] == Approx(0.5));
+		REQUIRE(map->coverage[1] == Approx(0.0));
+		REQUIRE(map->coverage[2] == Approx(1.0));
+		REQUIRE(map->coverage[3] == Approx(0.5));
+	}
+
+	SECTION("Overlapping paths are counted once") {
+		const double horizontal[] = {0, 10, 20, 10};
+		const double vertical[] = {10, 0, 10, 20};
+
+		add_shape(&layer, GRAPHIC_PATH, horizontal, 2);
+		g_array_index(layer.primitives, struct flat_primitive, 0).width = 4.0;
+		add_shape(&layer, GRAPHIC_PATH, vertical, 2);
+		g_array_index(layer.primitives, struct flat_primitive, 1).width = 4.0;
+
+		map = density_map_calculate_layer(&layer, &extent, 1, 1);
+		REQUIRE(map != NULL);
+		/* 80 + 80 - 16 of 400 */
+		REQUIRE(map->coverage[0] == Approx(0.36));
+	}
+
+	SECTION("Overlapping polygons are counted once") {
+		const double triangle[] = {0, 0, 20, 0, 0, 20};
+		const double mirrored[] = {0, 0, 20, 0, 20, 20};
+		const double box[] = {0, 0, 10, 0, 10, 10, 0, 10};
+
+		/* Both triangles cover the lower quarter twice. The box lies inside both of them */
+		add_shape(&layer, GRAPHIC_POLYGON, triangle, 3);
+		add_shape(&layer, GRAPHIC_POLYGON, mirrored, 3);
+		add_shape(&layer, GRAPHIC_POLYGON, triangle, 3);
+		add_shape(&layer, GRAPHIC_BOX, box, 4);
+
+		map = density_map_calculate_layer(&layer, &extent, 1, 1);
+		REQUIRE(map != NULL);
+		REQUIRE(map->coverage[0] == Approx(0.75));
+
+		density_map_free(map);
+		map = density_map_calculate_layer(&layer, &extent, 2, 2);
+		REQUIRE(map != NULL);
+		REQUIRE(map->coverage[0] == Approx(0.5));
+		REQUIRE(map->coverage[1] == Approx(0.5));
+		REQUIRE(map->coverage[2] == Approx(1.0));
+		REQUIRE(map->coverage[3] == Approx(1.0));
+	}
+
+	SECTION("Invalid rasters are rejected") {
+		REQUIRE(density_map_calculate_layer(&layer, &extent, 0, 2) == NULL);
+		extent.vectors.upper_right.x = 0.0;
+		REQUIRE(density_map_calculate_layer(&layer, &extent, 2, 2) == NULL);
+	}
+
+	density_map_free(map);
+	g_array_free(layer.primitives, TRUE);
+	g_array_free(layer.vertices, TRUE);
+}
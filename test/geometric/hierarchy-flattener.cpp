@@ -0,0 +1,266 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <string.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+}
+#include "test-fixtures.h"
+
+static void require_vertex(const struct flat_layer *lay, size_t idx, double x, double y)
+{
+	const struct vector_2d *v = &g_array_index(lay->vertices, struct vector_2d, idx);
+
+	REQUIRE(v->x == Approx(x));
+	REQUIRE(v->y == Approx(y));
+}
+
+TEST_CASE("geometric/hierarchy-flattener/hierarchy_flatten_cell", "[GEOMETRIC]")
+{
+	struct gds_cell *top = add_cell(NULL, NULL);
+	struct gds_cell *leaf = add_cell(NULL, NULL);
+	struct gds_cell_instance *inst;
+	struct flat_scene *scene;
+	const struct flat_layer *lay;
+	const struct flat_primitive *prim;
+
+	add_box(leaf, 3, 10);
+	add_box(top, 5, 100);
+	add_reference(top, leaf, 20, 30)->angle = 90.0;
+	add_reference(top, leaf, -5, 0);
+
+	SECTION("Instances are transformed into the top cell") {
+		scene = hierarchy_flatten_cell(top, NULL, 0, 1);
+		REQUIRE(scene != NULL);
+		REQUIRE(scene->layers->len == 2);
+		REQUIRE(scene->primitive_count == 3);
+		REQUIRE(scene->vertex_count == 12);
+
+		/* Layers are sorted by their number */
+		REQUIRE(g_array_index(scene->layers, struct flat_layer, 0).layer == 3);
+		REQUIRE(g_array_index(scene->layers, struct flat_layer, 1).layer == 5);
+
+		lay = flat_scene_get_layer(scene, 3);
+		REQUIRE(lay->primitives->len == 2);
+		prim = &g_array_index(lay->primitives, struct flat_primitive, 0);
+		REQUIRE(prim->gfx_type == GRAPHIC_BOX);
+		REQUIRE(prim->first_vertex == 0);
+		REQUIRE(prim->vertex_count == 4);
+		/* Rotated instance */
+		require_vertex(lay, 1, 20.0, 40.0);
+		require_vertex(lay, 2, 10.0, 40.0);
+		/* Translated instance */
+		require_vertex(lay, 4, -5.0, 0.0);
+		require_vertex(lay, 6, 5.0, 10.0);
+
+		REQUIRE(scene->box.vectors.lower_left.x == Approx(-5.0));
+		REQUIRE(scene->box.vectors.lower_left.y == Approx(0.0));
+		REQUIRE(scene->box.vectors.upper_right.x == Approx(100.0));
+		REQUIRE(scene->box.vectors.upper_right.y == Approx(100.0));
+		REQUIRE(flat_scene_get_layer(scene, 4) == NULL);
+		flat_scene_free(scene);
+	}
+
+	SECTION("Only the requested layers are included") {
+		const int layers[] = {3};
+
+		scene = hierarchy_flatten_cell(top, layers, 1, 1);
+		REQUIRE(scene != NULL);
+		REQUIRE(scene->layers->len == 1);
+		REQUIRE(scene->primitive_count == 2);
+		REQUIRE(flat_scene_get_layer(scene, 5) == NULL);
+		REQUIRE(scene->box.vectors.upper_right.y == Approx(40.0));
+		flat_scene_free(scene);
+	}
+
+	SECTION("Path widths are scaled by the magnification") {
+		struct gds_graphics *path = add_box(leaf, 7, 10);
+
+		path->gfx_type = GRAPHIC_PATH;
+		path->width_absolute = 4;
+		inst = add_reference(top, leaf, 0, 200);
+		inst->magnification = 2.5;
+
+		scene = hierarchy_flatten_cell(top, NULL, 0, 1);
+		REQUIRE(scene != NULL);
+		lay = flat_scene_get_layer(scene, 7);
+		REQUIRE(lay != NULL);
+		REQUIRE(lay->primitives->len == 3);
+		prim = &g_array_index(lay->primitives, struct flat_primitive, 2);
+		REQUIRE(prim->gfx_type == GRAPHIC_PATH);
+		REQUIRE(prim->width == Approx(10.0));
+		require_vertex(lay, prim->first_vertex + 2, 25.0, 225.0);
+		/* The box is enlarged by half the path width */
+		REQUIRE(scene->box.vectors.upper_right.y == Approx(230.0));
+		flat_scene_free(scene);
+	}
+
+	SECTION("Unresolved references are skipped") {
+		add_reference(top, NULL, 1000, 1000);
+
+		scene = hierarchy_flatten_cell(top, NULL, 0, 1);
+		REQUIRE(scene != NULL);
+		REQUIRE(scene->primitive_count == 3);
+		REQUIRE(scene->box.vectors.upper_right.x == Approx(100.0));
+		flat_scene_free(scene);
+	}
+
+	SECTION("Reference loops are rejected") {
+		add_reference(leaf, top, 0, 0);
+		REQUIRE(hierarchy_flatten_cell(top, NULL, 0, 1) == NULL);
+		g_list_free_full(leaf->child_cells, g_free);
+		leaf->child_cells = NULL;
+	}
+
+	REQUIRE(hierarchy_flatten_cell(NULL, NULL, 0, 1) == NULL);
+
+	free_cell(top);
+	free_cell(leaf);
+}
+
+TEST_CASE("geometric/hierarchy-flattener/hierarchy_flatten_cell-parallel", "[GEOMETRIC]")
+{
+	struct gds_cell *top = add_cell(NULL, NULL);
+	struct gds_cell *mid = add_cell(NULL, NULL);
+	struct gds_cell *leaf = add_cell(NULL, NULL);
+	struct flat_scene *serial;
+	struct flat_scene *parallel;
+	const struct flat_layer *lay;
+	const struct flat_layer *parallel_lay;
+	guint i;
+	int x, y;
+
+	/* Large enough to split the instance tree into several tasks */
+	add_box(leaf, 1, 10);
+	add_box(leaf, 2, 5);
+	for (x = 0; x < 100; x++)
+		add_reference(mid, leaf, x * 20, 0);
+	for (y = 0; y < 100; y++)
+		add_reference(top, mid, 0, y * 20)->angle = (y % 2 ? 180.0 : 0.0);
+	add_box(top, 2, 7);
+
+	serial = hierarchy_flatten_cell(top, NULL, 0, 1);
+	parallel = hierarchy_flatten_cell(top, NULL, 0, 4);
+	REQUIRE(serial != NULL);
+	REQUIRE(parallel != NULL);
+	REQUIRE(serial->primitive_count == 20001);
+	REQUIRE(parallel->primitive_count == serial->primitive_count);
+	REQUIRE(parallel->layers->len == serial->layers->len);
+
+	/* The order of the primitives does not depend on the scheduling */
+	for (i = 0; i < serial->layers->len; i++) {
+		lay = &g_array_index(serial->layers, struct flat_layer, i);
+		parallel_lay = &g_array_index(parallel->layers, struct flat_layer, i);
+		REQUIRE(parallel_lay->layer == lay->layer);
+		REQUIRE(parallel_lay->vertices->len == lay->vertices->len);
+		REQUIRE(memcmp(parallel_lay->vertices->data, lay->vertices->data,
+			       lay->vertices->len * sizeof(struct vector_2d)) == 0);
+	}
+
+	flat_scene_free(serial);
+	flat_scene_free(parallel);
+	free_cell(top);
+	free_cell(mid);
+	free_cell(leaf);
+}
+
+TEST_CASE("geometric/hierarchy-flattener/flat_scene_serialize", "[GEOMETRIC]")
+{
+	struct gds_cell *top = add_cell(NULL, NULL);
+	struct gds_cell *leaf = add_cell(NULL, NULL);
+	struct flat_scene *scene;
+	struct flat_scene *copy;
+	const struct flat_layer *lay;
+	const struct flat_layer *copy_lay;
+	const struct flat_primitive *prim;
+	const struct vector_2d *v;
+	GByteArray *data;
+	guint i;
+
+	add_box(leaf, 3, 10);
+	add_box(top, 5, 100);
+	add_reference(top, leaf, 20, 30);
+	add_reference(top, leaf, -5, 0);
+
+	scene = hierarchy_flatten_cell(top, NULL, 0, 1);
+	REQUIRE(scene != NULL);
+	REQUIRE(scene->primitive_count == 3);
+
+	data = g_byte_array_new();
+	REQUIRE(flat_scene_serialize(scene, NULL, 0, data) == 0);
+
+	SECTION("Scene is rebuilt") {
+		copy = flat_scene_deserialize(data->data, data->len);
+		REQUIRE(copy != NULL);
+		REQUIRE(copy->layers->len == scene->layers->len);
+		REQUIRE(copy->primitive_count == scene->primitive_count);
+		REQUIRE(copy->vertex_count == scene->vertex_count);
+		REQUIRE(copy->box.vectors.lower_left.x == Approx(-5.0));
+		REQUIRE(copy->box.vectors.upper_right.y == Approx(100.0));
+
+		for (i = 0; i < scene->layers->len; i++) {
+			lay = &g_array_index(scene->layers, struct flat_layer, i);
+			copy_lay = flat_scene_get_layer(copy, lay->layer);
+			REQUIRE(copy_lay != NULL);
+			REQUIRE(copy_lay->primitives->len == lay->primitives->len);
+			REQUIRE(copy_lay->vertices->len == lay->vertices->len);
+			REQUIRE(memcmp(copy_lay->vertices->data, lay->vertices->data,
+				       lay->vertices->len * sizeof(struct vector_2d)) == 0);
+		}
+
+		copy_lay = flat_scene_get_layer(copy, 3);
+		REQUIRE(copy_lay->primitives->len == 2);
+		prim = &g_array_index(copy_lay->primitives, struct flat_primitive, 1);
+		REQUIRE(prim->gfx_type == GRAPHIC_BOX);
+		REQUIRE(prim->vertex_count == 4);
+		v = &g_array_index(copy_lay->vertices, struct vector_2d, prim->first_vertex);
+		REQUIRE(v[0].x == Approx(-5.0));
+
+		flat_scene_free(copy);
+	}
+
+	SECTION("Only selected layers are written") {
+		const int selected[] = {5};
+		GByteArray *partial = g_byte_array_new();
+
+		REQUIRE(flat_scene_serialize(scene, selected, 1, partial) == 0);
+		REQUIRE(partial->len < data->len);
+		copy = flat_scene_deserialize(partial->data, partial->len);
+		REQUIRE(copy != NULL);
+		REQUIRE(copy->layers->len == 1);
+		REQUIRE(copy->primitive_count == 1);
+		REQUIRE(copy->vertex_count == 4);
+		REQUIRE(flat_scene_get_layer(copy, 3) == NULL);
+		REQUIRE(flat_scene_get_layer(copy, 5) != NULL);
+		REQUIRE(copy->box.vectors.lower_left.x == Approx(-5.0));
+
+		flat_scene_free(copy);
+		g_byte_array_free(partial, TRUE);
+	}
+
+	SECTION("Truncated images are rejected") {
+		REQUIRE(flat_scene_deserialize(data->data, data->len - 1) == NULL);
+		REQUIRE(flat_scene_deserialize(data->data, 10) == NULL);
+	}
+
+	SECTION("Primitives outside of their layer are rejected") {
+		struct flat_primitive prim_copy;
+		size_t offset;
+
+		/* Locate the first primitive of the first layer in the image and break it */
+		lay = &g_array_index(scene->layers, struct flat_layer, 0);
+		for (offset = 0; offset + sizeof(prim_copy) <= data->len; offset += 8) {
+			if (!memcmp(&data->data[offset], lay->primitives->data, sizeof(prim_copy)))
+				break;
+		}
+		REQUIRE(offset + sizeof(prim_copy) <= data->len);
+		memcpy(&prim_copy, &data->data[offset], sizeof(prim_copy));
+		prim_copy.first_vertex = 1000;
+		memcpy(&data->data[offset], &prim_copy, sizeof(prim_copy));
+		REQUIRE(flat_scene_deserialize(data->data, data->len) == NULL);
+	}
+
+	g_byte_array_free(data, TRUE);
+	flat_scene_free(scene);
+	free_cell(top);
+	free_cell(leaf);
+}
@@ -0,0 +1,122 @@
+#include <catch.hpp>
+#include <cstring>
+
+extern "C" {
+#include <gds-render/geometric/path-outline.h>
+}
+
+static void require_point(GArray *outline, guint idx, double x, double y)
+{
+	struct vector_2d *pt;
+
+	REQUIRE(idx < outline->len);
+	pt = &g_array_index(outline, struct vector_2d, idx);
+	REQUIRE(pt->x == Approx(x));
+	REQUIRE(pt->y == Approx(y));
+}
+
+TEST_CASE("geometric/path-outline/path_outline_calculate", "[GEOMETRIC]")
+{
+	struct gds_point straight[] = {{0, 0}, {100, 0}, {100, 0}};
+	struct gds_point corner[] = {{0, 0}, {100, 0}, {100, 100}};
+	GArray *outline;
+	union bounding_box box;
+
+	outline = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+
+	SECTION("Flush caps result in a rectangle. Duplicate points are ignored") {
+		REQUIRE(path_outline_calculate(straight, 3, 10.0, PATH_FLUSH, outline) == 0);
+		REQUIRE(outline->len == 4);
+		require_point(outline, 0, 0.0, 5.0);
+		require_point(outline, 1, 100.0, 5.0);
+		require_point(outline, 2, 100.0, -5.0);
+		require_point(outline, 3, 0.0, -5.0);
+	}
+
+	SECTION("Squared caps extend the path by half the width") {
+		REQUIRE(path_outline_calculate(straight, 2, 10.0, PATH_SQUARED, outline) == 0);
+		REQUIRE(outline->len == 4);
+		require_point(outline, 0, -5.0, 5.0);
+		require_point(outline, 1, 105.0, 5.0);
+		require_point(outline, 2, 105.0, -5.0);
+		require_point(outline, 3, -5.0, -5.0);
+	}
+
+	SECTION("Outer join is mitered") {
+		REQUIRE(path_outline_calculate(corner, 3, 10.0, PATH_FLUSH, outline) == 0);
+		vector_2d_array_min_max((struct vector_2d *)outline->data, outline->len,
+					&box.vectors.lower_left, &box.vectors.upper_right);
+		REQUIRE(box.vectors.lower_left.x == Approx(0.0));
+		REQUIRE(box.vectors.lower_left.y == Approx(-5.0));
+		REQUIRE(box.vectors.upper_right.x == Approx(105.0));
+		REQUIRE(box.vectors.upper_right.y == Approx(100.0));
+	}
+
+	SECTION("Round caps stay inside the circle") {
+		guint i;
+		struct vector_2d *pt;
+
+		REQUIRE(path_outline_calculate(straight, 1, 10.0, PATH_ROUNDED, outline) == 0);
+		REQUIRE(outline->len >= 8);
+		for (i = 0; i < outline->len; i++) {
+			pt = &g_array_index(outline, struct vector_2d, i);
+			REQUIRE(vector_2d_abs(pt) == Approx(5.0));
+		}
+	}
+
+	SECTION("Paths without area") {
+		REQUIRE(path_outline_calculate(straight, 1, 10.0, PATH_FLUSH, outline) == -1);
+		REQUIRE(path_outline_calculate(straight, 1, 0.0, PATH_SQUARED, outline) == -1);
+		REQUIRE(outline->len == 0);
+	}
+
+	SECTION("Paths without width are hairlines") {
+		struct vector_2d *pt;
+
+		REQUIRE(path_outline_calculate(straight, 2, 0.0, PATH_SQUARED, outline) == PATH_OUTLINE_HAIRLINE);
+		REQUIRE(outline->len == 2);
+		pt = &g_array_index(outline, struct vector_2d, 1);
+		REQUIRE(pt->x == Approx(100.0));
+		REQUIRE(pt->y == Approx(0.0));
+	}
+
+	g_array_free(outline, TRUE);
+}
+
+TEST_CASE("geometric/path-outline/path_outline_cache", "[GEOMETRIC]")
+{
+	struct gds_point corner[] = {{0, 0}, {100, 0}, {100, 100}};
+	struct gds_graphics path;
+	struct gds_cell cell;
+	struct path_outline_cache *cache;
+	const GArray *outline;
+	union bounding_box box;
+
+	memset(&path, 0, sizeof(path));
+	path.gfx_type = GRAPHIC_PATH;
+	path.vertex_array = corner;
+	path.vertex_count = 3;
+	path.width_absolute = 10;
+	path.path_render_type = PATH_SQUARED;
+
+	memset(&cell, 0, sizeof(cell));
+	cell.graphic_objs = g_list_append(NULL, &path);
+
+	cache = path_outline_cache_new();
+	REQUIRE(path_outline_cache_build_for_cell(cache, &cell, 2) == 1);
+	/* Already cached */
+	REQUIRE(path_outline_cache_build_for_cell(cache, &cell, 2) == 0);
+
+	outline = path_outline_cache_lookup(cache, &path);
+	REQUIRE(outline != NULL);
+	REQUIRE(path_outline_cache_lookup(cache, &path) == outline);
+
+	path_outline_calculate_bounding_box(&path, &box);
+	REQUIRE(box.vectors.lower_left.x == Approx(-5.0));
+	REQUIRE(box.vectors.lower_left.y == Approx(-5.0));
+	REQUIRE(box.vectors.upper_right.x == Approx(105.0));
+	REQUIRE(box.vectors.upper_right.y == Approx(105.0));
+
+	path_outline_cache_free(cache);
+	g_list_free(cell.graphic_objs);
+}
@@ -0,0 +1,43 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <gds-render/geometric/polygon-simplify.h>
+}
+
+TEST_CASE("geometric/polygon-simplify/polygon_simplify", "[GEOMETRIC]")
+{
+	struct vector_2d out[8];
+	size_t count;
+
+	SECTION("Collinear vertices are removed") {
+		const struct vector_2d line[] = {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}};
+
+		count = polygon_simplify(line, 5, 0.01, FALSE, out);
+		REQUIRE(count == 2);
+		REQUIRE(out[0].x == Approx(0.0));
+		REQUIRE(out[1].x == Approx(4.0));
+	}
+
+	SECTION("Deviations above the tolerance are kept") {
+		const struct vector_2d line[] = {{0, 0}, {5, 0.5}, {10, 1.0}, {15, 2.0}, {20, 0}};
+
+		count = polygon_simplify(line, 5, 1.0, FALSE, out);
+		REQUIRE(count == 3);
+		REQUIRE(out[1].x == Approx(15.0));
+		REQUIRE(out[1].y == Approx(2.0));
+
+		count = polygon_simplify(line, 5, 0.0, FALSE, out);
+		REQUIRE(count == 5);
+	}
+
+	SECTION("Closed polygons drop the closing vertex and keep at least a triangle") {
+		const struct vector_2d square[] = {{0, 0}, {5, 0}, {10, 0}, {10, 10}, {0, 10}, {0, 0}};
+		const struct vector_2d thin[] = {{0, 0}, {10, 0.1}, {20, 0}, {0, 0}};
+
+		count = polygon_simplify(square, 6, 0.5, TRUE, out);
+		REQUIRE(count == 4);
+
+		count = polygon_simplify(thin, 4, 5.0, TRUE, out);
+		REQUIRE(count == 3);
+	}
+}
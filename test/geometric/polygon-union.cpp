@@ -0,0 +1,101 @@
+#include <catch.hpp>
+#include <cmath>
+
+extern "C" {
+#include <gds-render/geometric/polygon-union.h>
+}
+#include "test-fixtures.h"
+
+static void add_rect(struct flat_layer *layer, double x0, double y0, double x1, double y1)
+{
+	const double coords[] = {x0, y0, x1, y0, x1, y1, x0, y1, x0, y0};
+
+	add_shape(layer, GRAPHIC_BOX, coords, 5);
+}
+
+static double primitive_area(const struct flat_layer *layer, guint idx)
+{
+	const struct flat_primitive *prim = &g_array_index(layer->primitives, struct flat_primitive, idx);
+	const struct vector_2d *v = &g_array_index(layer->vertices, struct vector_2d, prim->first_vertex);
+	double area = 0.0;
+	size_t i;
+
+	for (i = 0; i < prim->vertex_count; i++)
+		area += v[i].x * v[(i + 1) % prim->vertex_count].y - v[(i + 1) % prim->vertex_count].x * v[i].y;
+
+	return area / 2.0;
+}
+
+TEST_CASE("geometric/polygon-union/polygon_union_merge_layer", "[GEOMETRIC]")
+{
+	struct flat_layer in;
+	struct flat_layer out;
+
+	in.layer = 3;
+	in.primitives = g_array_new(FALSE, FALSE, sizeof(struct flat_primitive));
+	in.vertices = g_array_new(FALSE, FALSE, sizeof(struct vector_2d));
+	out.primitives = NULL;
+	out.vertices = NULL;
+
+	SECTION("Overlapping and abutting rectangles are merged") {
+		const double clockwise[] = {20, 0, 20, 10, 30, 10, 30, 0};
+
+		add_rect(&in, 0, 0, 10, 10);
+		add_rect(&in, 5, 0, 15, 10);
+		add_rect(&in, 15, 0, 20, 10);
+		add_shape(&in, GRAPHIC_POLYGON, clockwise, 4);
+
+		REQUIRE(polygon_union_merge_layer(&in, &out) == 0);
+		REQUIRE(out.layer == 3);
+		REQUIRE(out.primitives->len == 1);
+		REQUIRE(out.vertices->len == 4);
+		REQUIRE(primitive_area(&out, 0) == Approx(300.0));
+	}
+
+	SECTION("Disjoint rectangles stay separate") {
+		add_rect(&in, 0, 0, 10, 10);
+		add_rect(&in, 20, 0, 30, 10);
+		add_rect(&in, 10, 10, 20, 20);
+
+		REQUIRE(polygon_union_merge_layer(&in, &out) == 0);
+		REQUIRE(out.primitives->len == 3);
+		REQUIRE(primitive_area(&out, 0) == Approx(100.0));
+		REQUIRE(primitive_area(&out, 1) == Approx(100.0));
+		REQUIRE(primitive_area(&out, 2) == Approx(100.0));
+	}
+
+	SECTION("Holes are connected to the outer contour") {
+		add_rect(&in, 0, 0, 30, 10);
+		add_rect(&in, 0, 20, 30, 30);
+		add_rect(&in, 0, 0, 10, 30);
+		add_rect(&in, 20, 0, 30, 30);
+		/* Island inside the hole */
+		add_rect(&in, 13, 13, 17, 17);
+
+		REQUIRE(polygon_union_merge_layer(&in, &out) == 0);
+		REQUIRE(out.primitives->len == 2);
+		REQUIRE(primitive_area(&out, 0) + primitive_area(&out, 1) == Approx(900.0 - 100.0 + 16.0));
+	}
+
+	SECTION("Paths and non rectilinear polygons are kept") {
+		const double triangle[] = {0, 0, 10, 0, 0, 10};
+		const double path[] = {0, 0, 100, 0};
+
+		add_shape(&in, GRAPHIC_POLYGON, triangle, 3);
+		add_shape(&in, GRAPHIC_PATH, path, 2);
+		add_rect(&in, 0, 0, 10, 10);
+
+		REQUIRE(polygon_union_merge_layer(&in, &out) == 0);
+		REQUIRE(out.primitives->len == 3);
+		REQUIRE(g_array_index(out.primitives, struct flat_primitive, 0).vertex_count == 3);
+		REQUIRE(g_array_index(out.primitives, struct flat_primitive, 1).gfx_type == GRAPHIC_PATH);
+		REQUIRE(primitive_area(&out, 2) == Approx(100.0));
+	}
+
+	if (out.primitives)
+		g_array_free(out.primitives, TRUE);
+	if (out.vertices)
+		g_array_free(out.vertices, TRUE);
+	g_array_free(in.primitives, TRUE);
+	g_array_free(in.vertices, TRUE);
+}
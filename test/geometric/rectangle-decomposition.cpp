@@ -0,0 +1,75 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <gds-render/geometric/rectangle-decomposition.h>
+}
+
+static double total_area(GArray *rects)
+{
+	union bounding_box *box;
+	double area = 0.0;
+	guint i;
+
+	for (i = 0; i < rects->len; i++) {
+		box = &g_array_index(rects, union bounding_box, i);
+		area += (box->vectors.upper_right.x - box->vectors.lower_left.x) *
+			(box->vectors.upper_right.y - box->vectors.lower_left.y);
+	}
+
+	return area;
+}
+
+TEST_CASE("geometric/rectangle-decomposition/rectangle_decomposition_calculate", "[GEOMETRIC]")
+{
+	GArray *rects;
+
+	rects = g_array_new(FALSE, FALSE, sizeof(union bounding_box));
+
+	SECTION("A box results in a single rectangle") {
+		const struct vector_2d box[] = {{0, 0}, {10, 0}, {10, 5}, {0, 5}, {0, 0}};
+		union bounding_box *r;
+
+		REQUIRE(rectangle_decomposition_calculate(box, 5, rects) == 0);
+		REQUIRE(rects->len == 1);
+		r = &g_array_index(rects, union bounding_box, 0);
+		REQUIRE(r->vectors.lower_left.x == Approx(0.0));
+		REQUIRE(r->vectors.lower_left.y == Approx(0.0));
+		REQUIRE(r->vectors.upper_right.x == Approx(10.0));
+		REQUIRE(r->vectors.upper_right.y == Approx(5.0));
+	}
+
+	SECTION("L and U shapes are split into a minimal set") {
+		const struct vector_2d l_shape[] = {{0, 0}, {10, 0}, {10, 2}, {2, 2}, {2, 10}, {0, 10}};
+		const struct vector_2d u_shape[] = {{0, 0}, {30, 0}, {30, 20}, {20, 20}, {20, 10}, {10, 10},
+						    {10, 20}, {0, 20}};
+
+		REQUIRE(rectangle_decomposition_calculate(l_shape, 6, rects) == 0);
+		REQUIRE(rects->len == 2);
+		REQUIRE(total_area(rects) == Approx(36.0));
+
+		g_array_set_size(rects, 0);
+		REQUIRE(rectangle_decomposition_calculate(u_shape, 8, rects) == 0);
+		REQUIRE(rects->len == 3);
+		REQUIRE(total_area(rects) == Approx(500.0));
+	}
+
+	SECTION("Zero width cuts to holes are removed") {
+		/* Square ring connected to its hole by a cut at x = 5 */
+		const struct vector_2d ring[] = {{0, 0}, {5, 0}, {5, 3}, {3, 3}, {3, 7}, {7, 7}, {7, 3}, {5, 3},
+						 {5, 0}, {10, 0}, {10, 10}, {0, 10}};
+
+		REQUIRE(rectangle_decomposition_calculate(ring, 12, rects) == 0);
+		REQUIRE(rects->len == 4);
+		REQUIRE(total_area(rects) == Approx(100.0 - 16.0));
+	}
+
+	SECTION("Non-Manhattan polygons are rejected") {
+		const struct vector_2d triangle[] = {{0, 0}, {10, 0}, {0, 10}};
+
+		REQUIRE_FALSE(rectangle_decomposition_is_rectilinear(triangle, 3));
+		REQUIRE(rectangle_decomposition_calculate(triangle, 3, rects) == -1);
+		REQUIRE(rects->len == 0);
+	}
+
+	g_array_free(rects, TRUE);
+}
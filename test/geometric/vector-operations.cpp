@@ -1,5 +1,6 @@
 #include <catch.hpp>
 #include <limits>
+#include <algorithm>
 
 extern "C" {
 #include <gds-render/geometric/vector-operations.h>
@@ -158,3 +159,137 @@ TEST_CASE("geometric/vector-operations/vector_2d_scale", "[GEOMETRIC]")
 	REQUIRE(a.x == Approx(0.5));
 	REQUIRE(a.y == Approx(-1.5));
 }
+
+static void fill_test_vectors(struct vector_2d *vecs, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		vecs[i].x = (double)((int)(i * 37 % 101) - 50) * 0.75;
+		vecs[i].y = (double)((int)(i * 53 % 97) - 48) * 1.25 + 0.5;
+	}
+}
+
+TEST_CASE("geometric/vector-operations/vector_2d_array_transform", "[GEOMETRIC]")
+{
+	const size_t count = 67;
+	struct vector_2d in[count];
+	struct vector_2d out[count];
+	struct vector_2d ref;
+	struct affine_2d mat;
+	size_t i;
+
+	fill_test_vectors(in, count);
+	affine_2d_init_transform(&mat, 2.5, 30.0, true, 10.0, -20.0);
+	vector_2d_array_transform(&mat, in, out, count);
+
+	for (i = 0; i < count; i++) {
+		/* Scalar reference: flip, rotate, scale, translate */
+		ref = in[i];
+		ref.y *= -1;
+		vector_2d_rotate(&ref, DEG2RAD(30.0));
+		vector_2d_scale(&ref, 2.5);
+		ref.x += 10.0;
+		ref.y -= 20.0;
+
+		REQUIRE(out[i].x == Approx(ref.x));
+		REQUIRE(out[i].y == Approx(ref.y));
+	}
+
+	/* In place operation */
+	vector_2d_array_transform(&mat, in, in, count);
+	for (i = 0; i < count; i++) {
+		REQUIRE(in[i].x == out[i].x);
+		REQUIRE(in[i].y == out[i].y);
+	}
+
+	/* Missing parameters leave the output untouched */
+	vector_2d_array_transform(NULL, in, out, count);
+	vector_2d_array_transform(&mat, NULL, out, count);
+	vector_2d_array_transform(&mat, in, NULL, count);
+	REQUIRE(in[0].x == out[0].x);
+}
+
+TEST_CASE("geometric/vector-operations/vector_2d_array_min_max", "[GEOMETRIC]")
+{
+	const size_t count = 33;
+	struct vector_2d vecs[count];
+	struct vector_2d min, max;
+	const double dbl_max = std::numeric_limits<double>::max();
+	double xmin = dbl_max, ymin = dbl_max, xmax = -dbl_max, ymax = -dbl_max;
+	size_t i;
+
+	fill_test_vectors(vecs, count);
+	for (i = 0; i < count; i++) {
+		xmin = std::min(xmin, vecs[i].x);
+		ymin = std::min(ymin, vecs[i].y);
+		xmax = std::max(xmax, vecs[i].x);
+		ymax = std::max(ymax, vecs[i].y);
+	}
+
+	vector_2d_array_min_max(vecs, count, &min, &max);
+	REQUIRE(min.x == xmin);
+	REQUIRE(min.y == ymin);
+	REQUIRE(max.x == xmax);
+	REQUIRE(max.y == ymax);
+
+	vector_2d_array_min_max(vecs, 0, &min, &max);
+	REQUIRE(min.x == dbl_max);
+	REQUIRE(max.y == -dbl_max);
+}
+
+TEST_CASE("geometric/vector-operations/vector_2d_array_normalize", "[GEOMETRIC]")
+{
+	const size_t count = 19;
+	struct vector_2d vecs[count];
+	struct vector_2d orig[count];
+	struct vector_2d ref;
+	size_t i;
+
+	fill_test_vectors(vecs, count);
+	vecs[3].x = 3.0;
+	vecs[3].y = 4.0;
+
+	for (i = 0; i < count; i++)
+		orig[i] = vecs[i];
+
+	vector_2d_array_normalize(vecs, count);
+
+	for (i = 0; i < count; i++) {
+		ref = orig[i];
+		vector_2d_normalize(&ref);
+		REQUIRE(vecs[i].x == Approx(ref.x));
+		REQUIRE(vecs[i].y == Approx(ref.y));
+	}
+
+	REQUIRE(vecs[3].x == Approx(0.6));
+	REQUIRE(vecs[3].y == Approx(0.8));
+}
+
+TEST_CASE("geometric/vector-operations/vector_2d_array_cross_product", "[GEOMETRIC]")
+{
+	const size_t count = 23;
+	struct vector_2d a[count];
+	struct vector_2d b[count];
+	double res[count];
+	struct vector_2d b_rot;
+	double dot;
+	size_t i;
+
+	fill_test_vectors(a, count);
+	fill_test_vectors(b, count);
+	for (i = 0; i < count; i++) {
+		b[i].x += 3.0;
+		b[i].y -= 1.0 * (double)i;
+	}
+
+	vector_2d_array_cross_product(a, b, res, count);
+
+	for (i = 0; i < count; i++) {
+		/* a x b = a . (b rotated by -90 degrees) */
+		b_rot = b[i];
+		vector_2d_rotate(&b_rot, -M_PI / 2);
+		dot = vector_2d_scalar_multipy(&a[i], &b_rot);
+		REQUIRE(res[i] == Approx(dot).margin(1E-9));
+	}
+}
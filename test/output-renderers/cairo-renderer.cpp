@@ -0,0 +1,146 @@
+#include <catch.hpp>
+
+extern "C" {
+#include <stdint.h>
+#include <cairo.h>
+#include <gds-render/output-renderers/cairo-renderer.h>
+#include <gds-render/layer/layer-settings.h>
+}
+#include "test-fixtures.h"
+
+static void add_polygon(struct gds_cell *cell, enum graphics_type type, const int *coords, size_t count)
+{
+	struct gds_graphics *gfx;
+	size_t i;
+
+	gfx = (struct gds_graphics *)g_malloc0(sizeof(struct gds_graphics));
+	gfx->gfx_type = type;
+	gfx->layer = 1;
+	gfx->vertex_array = (struct gds_point *)malloc(count * sizeof(struct gds_point));
+	gfx->vertex_count = count;
+	for (i = 0; i < count; i++) {
+		gfx->vertex_array[i].x = coords[2 * i];
+		gfx->vertex_array[i].y = coords[2 * i + 1];
+	}
+	cell->graphic_objs = g_list_append(cell->graphic_objs, gfx);
+}
+
+/**
+ * @brief Get the alpha value of a pixel of an ARGB32 image
+ */
+static unsigned int pixel_alpha(cairo_surface_t *surface, int x, int y)
+{
+	const unsigned char *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+
+	return *(const uint32_t *)&data[y * stride + 4 * x] >> 24;
+}
+
+TEST_CASE("output-renderers/cairo-renderer/cairo_renderer_draw_cell", "[OUTPUT-RENDERERS]")
+{
+	const int triangle[] = {0, 0, 40, 0, 0, 40};
+	const int box[] = {100, 0, 120, 0, 120, 20, 100, 20};
+	const int rotated[] = {150, 10, 160, 0, 170, 10, 160, 20};
+	const int rectangle[] = {200, 0, 220, 0, 220, 20, 200, 20};
+	struct gds_cell *top;
+	struct layer_info linfo;
+	GList *layer_infos;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+
+	linfo.layer = 1;
+	linfo.name = NULL;
+	linfo.stacked_position = 0;
+	linfo.color.red = 1.0;
+	linfo.color.green = 0.0;
+	linfo.color.blue = 0.0;
+	linfo.color.alpha = 1.0;
+	linfo.render = 1;
+	layer_infos = g_list_append(NULL, &linfo);
+
+	/* Polygons that are not rectangles followed by more shapes on the same layer */
+	top = add_cell(NULL, "TOP");
+	add_polygon(top, GRAPHIC_POLYGON, triangle, 3);
+	add_polygon(top, GRAPHIC_BOX, box, 4);
+	add_polygon(top, GRAPHIC_POLYGON, rotated, 4);
+	add_polygon(top, GRAPHIC_POLYGON, rectangle, 4);
+
+	/* The output covers x = 0 to 220 and y = 40 down to 0 */
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 220, 40);
+	cr = cairo_create(surface);
+	REQUIRE(cairo_renderer_draw_cell(top, layer_infos, cr, 1.0) == 0);
+	cairo_destroy(cr);
+	cairo_surface_flush(surface);
+
+	SECTION("Every shape is drawn") {
+		REQUIRE(pixel_alpha(surface, 10, 30) > 0);
+		REQUIRE(pixel_alpha(surface, 110, 30) > 0);
+		REQUIRE(pixel_alpha(surface, 160, 30) > 0);
+		REQUIRE(pixel_alpha(surface, 210, 30) > 0);
+	}
+
+	SECTION("Nothing is drawn outside of the shapes") {
+		REQUIRE(pixel_alpha(surface, 30, 5) == 0);
+		REQUIRE(pixel_alpha(surface, 60, 30) == 0);
+		REQUIRE(pixel_alpha(surface, 151, 21) == 0);
+		REQUIRE(pixel_alpha(surface, 110, 5) == 0);
+	}
+
+	REQUIRE(cairo_renderer_draw_cell(top, layer_infos, NULL, 1.0) < 0);
+
+	cairo_surface_destroy(surface);
+	g_list_free(layer_infos);
+	free_cell(top);
+}
+
+TEST_CASE("output-renderers/cairo-renderer/repeated-placements", "[OUTPUT-RENDERERS]")
+{
+	const int triangle[] = {0, 0, 20, 0, 0, 20};
+	const int l_shape[] = {30, 0, 50, 0, 50, 10, 40, 10, 40, 20, 30, 20};
+	struct gds_cell *top, *sub;
+	struct layer_info linfo;
+	GList *layer_infos;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+
+	linfo.layer = 1;
+	linfo.name = NULL;
+	linfo.stacked_position = 0;
+	linfo.color.red = 0.0;
+	linfo.color.green = 0.0;
+	linfo.color.blue = 1.0;
+	linfo.color.alpha = 1.0;
+	linfo.render = 1;
+	layer_infos = g_list_append(NULL, &linfo);
+
+	/* The decomposition of the sub cell's graphics is reused for the second placement */
+	sub = add_cell(NULL, "SUB");
+	add_polygon(sub, GRAPHIC_POLYGON, triangle, 3);
+	add_polygon(sub, GRAPHIC_POLYGON, l_shape, 6);
+	top = add_cell(NULL, "TOP");
+	add_reference(top, sub, 0, 0);
+	add_reference(top, sub, 60, 0);
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 110, 20);
+	cr = cairo_create(surface);
+	REQUIRE(cairo_renderer_draw_cell(top, layer_infos, cr, 1.0) == 0);
+	cairo_destroy(cr);
+	cairo_surface_flush(surface);
+
+	/* Image rows count from the top. y = 20 is the image row 0 */
+	REQUIRE(pixel_alpha(surface, 5, 15) > 0);
+	REQUIRE(pixel_alpha(surface, 65, 15) > 0);
+	REQUIRE(pixel_alpha(surface, 45, 15) > 0);
+	REQUIRE(pixel_alpha(surface, 105, 15) > 0);
+	REQUIRE(pixel_alpha(surface, 35, 5) > 0);
+	REQUIRE(pixel_alpha(surface, 95, 5) > 0);
+	REQUIRE(pixel_alpha(surface, 45, 5) == 0);
+	REQUIRE(pixel_alpha(surface, 105, 5) == 0);
+	REQUIRE(pixel_alpha(surface, 15, 5) == 0);
+	REQUIRE(pixel_alpha(surface, 75, 5) == 0);
+
+	cairo_surface_destroy(surface);
+	g_list_free(layer_infos);
+	free_cell(top);
+	free_cell(sub);
+}
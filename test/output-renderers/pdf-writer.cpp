@@ -0,0 +1,115 @@
+#include <catch.hpp>
+#include <string>
+#include <cstdlib>
+
+extern "C" {
+#include <stdio.h>
+#include <float.h>
+#include <gds-render/output-renderers/pdf-writer.h>
+}
+
+static std::string number(double value)
+{
+	GString *str = g_string_new(NULL);
+	std::string result;
+
+	pdf_append_number(str, value);
+	result = str->str;
+	g_string_free(str, TRUE);
+
+	return result;
+}
+
+TEST_CASE("output-renderers/pdf-writer/pdf_append_number", "[OUTPUT-RENDERERS]")
+{
+	REQUIRE(number(0.0) == "0");
+	REQUIRE(number(-0.0) == "0");
+	REQUIRE(number(-0.0000001) == "0");
+	REQUIRE(number(12.0) == "12");
+	REQUIRE(number(-2.25) == "-2.25");
+	REQUIRE(number(0.1234567) == "0.123457");
+	REQUIRE(number(1e7) == "10000000");
+	/* No exponents, even for huge numbers */
+	REQUIRE(number(1e30) == "1000000000000000019884624838656");
+	REQUIRE(number(-DBL_MAX).size() == 310);
+	REQUIRE(number(-DBL_MAX).find_first_not_of("-0123456789") == std::string::npos);
+}
+
+static std::string object_at(const std::string &pdf, unsigned long offset)
+{
+	REQUIRE(offset < pdf.size());
+	return pdf.substr(offset, pdf.find('\n', offset) - offset);
+}
+
+TEST_CASE("output-renderers/pdf-writer/xref", "[OUTPUT-RENDERERS]")
+{
+	struct pdf_writer writer = {};
+	GString *dict = NULL;
+	GString *content;
+	GBytes *stream = NULL;
+	std::string pdf;
+	std::string line;
+	char buffer[4096];
+	size_t len;
+	size_t pos;
+	guint i;
+
+	writer.file = tmpfile();
+	REQUIRE(writer.file != NULL);
+	writer.offsets = g_new0(guint64, 4);
+
+	pdf_write(&writer, "%PDF-1.5\n", 9);
+	pdf_write_object(&writer, 1, "<< /Type /Catalog /Pages 2 0 R >>");
+	pdf_write_object(&writer, 2, "<< /Type /Pages /Kids [] /Count 0 >>");
+
+	SECTION("Uncompressed stream") {
+		dict = g_string_new("<<");
+		content = g_string_new("0 0 m 10 10 l S");
+		stream = pdf_finish_stream(content, 0, dict);
+		REQUIRE(stream != NULL);
+		REQUIRE(std::string(dict->str).find("/Filter") == std::string::npos);
+	}
+
+	SECTION("Compressed stream") {
+		dict = g_string_new("<<");
+		content = g_string_new("0 0 m 10 10 l S");
+		stream = pdf_finish_stream(content, 6, dict);
+		REQUIRE(stream != NULL);
+		REQUIRE(std::string(dict->str).find("/Filter /FlateDecode") != std::string::npos);
+	}
+
+	pdf_write_stream(&writer, 3, dict, stream);
+	g_bytes_unref(stream);
+	g_string_free(dict, TRUE);
+	pdf_write_trailer(&writer, 4, 1);
+	REQUIRE(!writer.failed);
+
+	rewind(writer.file);
+	while ((len = fread(buffer, 1, sizeof(buffer), writer.file)) > 0)
+		pdf.append(buffer, len);
+	fclose(writer.file);
+	REQUIRE(pdf.size() == writer.offset);
+
+	/* startxref points to the cross reference table */
+	pos = pdf.rfind("startxref\n");
+	REQUIRE(pos != std::string::npos);
+	pos = strtoul(pdf.c_str() + pos + 10, NULL, 10);
+	REQUIRE(object_at(pdf, pos) == "xref");
+	REQUIRE(object_at(pdf, pos + 5) == "0 4");
+
+	/* Each entry is 20 bytes long and points to its object */
+	pos += 9;
+	REQUIRE(pdf.substr(pos, 20) == "0000000000 65535 f \n");
+	for (i = 1; i < 4; i++) {
+		line = pdf.substr(pos + 20 * i, 20);
+		REQUIRE(line.size() == 20);
+		REQUIRE(line.substr(10) == " 00000 n \n");
+		REQUIRE(strtoul(line.c_str(), NULL, 10) == writer.offsets[i]);
+		REQUIRE(object_at(pdf, writer.offsets[i]) == std::to_string(i) + " 0 obj");
+	}
+
+	REQUIRE(pdf.find("trailer\n<< /Size 4 /Root 1 0 R >>") != std::string::npos);
+	REQUIRE(pdf.substr(pdf.size() - 6) == "%%EOF\n");
+
+	g_free(writer.offsets);
+}
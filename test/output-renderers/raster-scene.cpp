@@ -0,0 +1,157 @@
+#include <catch.hpp>
+#include <string>
+
+extern "C" {
+#include <gds-render/output-renderers/raster-scene.h>
+#include <gds-render/layer/layer-settings.h>
+}
+#include "test-fixtures.h"
+
+/**
+ * @brief Cell hierarchy used by the tests
+ */
+struct test_design {
+	struct gds_cell *top;
+	struct gds_cell *leaf;
+	struct gds_cell_instance *moved;
+	struct layer_info linfo;
+	GList *layer_infos;
+};
+
+static struct gds_graphics *add_path(struct gds_cell *cell, int x0, int x1, int y, int width)
+{
+	struct gds_graphics *gfx;
+
+	gfx = (struct gds_graphics *)g_malloc0(sizeof(struct gds_graphics));
+	gfx->gfx_type = GRAPHIC_PATH;
+	gfx->path_render_type = PATH_SQUARED;
+	gfx->width_absolute = width;
+	gfx->layer = 1;
+	gfx->vertex_array = (struct gds_point *)malloc(2 * sizeof(struct gds_point));
+	gfx->vertex_count = 2;
+	gfx->vertex_array[0].x = x0;
+	gfx->vertex_array[0].y = y;
+	gfx->vertex_array[1].x = x1;
+	gfx->vertex_array[1].y = y;
+	cell->graphic_objs = g_list_append(cell->graphic_objs, gfx);
+
+	return gfx;
+}
+
+static void design_init(struct test_design *design)
+{
+	design->top = add_cell(NULL, "TOP");
+	design->leaf = add_cell(NULL, "LEAF");
+
+	add_box(design->leaf, 1, 10);
+	add_box(design->top, 1, 100);
+	add_reference(design->top, design->leaf, 200, 0);
+	design->moved = add_reference(design->top, design->leaf, 300, 0);
+	/* Center line outside of the test area, outline inside */
+	add_path(design->top, 160, 180, 50, 20);
+	add_path(design->top, 400, 420, 50, 20);
+
+	design->linfo.layer = 1;
+	design->linfo.name = NULL;
+	design->linfo.stacked_position = 0;
+	design->linfo.color.red = 1.0;
+	design->linfo.color.green = 0.0;
+	design->linfo.color.blue = 0.0;
+	design->linfo.color.alpha = 0.5;
+	design->linfo.render = 1;
+	design->layer_infos = g_list_append(NULL, &design->linfo);
+}
+
+static void design_free(struct test_design *design)
+{
+	g_list_free(design->layer_infos);
+	free_cell(design->top);
+	free_cell(design->leaf);
+}
+
+static void set_area(union bounding_box *area, double llx, double lly, double urx, double ury)
+{
+	area->vectors.lower_left.x = llx;
+	area->vectors.lower_left.y = lly;
+	area->vectors.upper_right.x = urx;
+	area->vectors.upper_right.y = ury;
+}
+
+static std::string hash_area(struct test_design *design, const union bounding_box *area, double min_size,
+			     guint *count)
+{
+	struct raster_scene *scene;
+	GChecksum *checksum;
+	std::string result;
+
+	scene = raster_scene_new(design->top, design->layer_infos);
+	REQUIRE(scene != NULL);
+	raster_scene_prepare_hashes(scene);
+
+	checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	*count = raster_scene_hash_area(scene, area, min_size, checksum);
+	result = g_checksum_get_string(checksum);
+	g_checksum_free(checksum);
+	raster_scene_free(scene);
+
+	return result;
+}
+
+TEST_CASE("output-renderers/raster-scene/raster_scene_hash_area", "[OUTPUT-RENDERERS]")
+{
+	struct test_design design;
+	struct test_design copy;
+	union bounding_box area;
+	std::string hash;
+	guint count;
+	guint changed_count;
+
+	design_init(&design);
+	set_area(&area, -10.0, -10.0, 305.0, 150.0);
+	hash = hash_area(&design, &area, 0.0, &count);
+	REQUIRE(count > 0);
+
+	SECTION("The hash is stable if nothing changes") {
+		REQUIRE(hash_area(&design, &area, 0.0, &changed_count) == hash);
+		REQUIRE(changed_count == count);
+
+		/* Same contents at different addresses */
+		design_init(&copy);
+		REQUIRE(hash_area(&copy, &area, 0.0, &changed_count) == hash);
+		design_free(&copy);
+	}
+
+	SECTION("Moving a child instance changes the hash") {
+		design.moved->origin.x += 2;
+		REQUIRE(hash_area(&design, &area, 0.0, &changed_count) != hash);
+	}
+
+	SECTION("Changing a layer color changes the hash") {
+		design.linfo.color.green = 1.0;
+		REQUIRE(hash_area(&design, &area, 0.0, &changed_count) != hash);
+		REQUIRE(changed_count == count);
+	}
+
+	SECTION("Culling follows the minimum size") {
+		/* Box, first path, leaf at 200 as a whole and the box of the leaf at 300 */
+		REQUIRE(count == 4);
+		/* The leaf instances are below the level of detail */
+		hash_area(&design, &area, 15.0, &changed_count);
+		REQUIRE(changed_count == 2);
+		/* Everything is below the level of detail */
+		hash_area(&design, &area, 1000.0, &changed_count);
+		REQUIRE(changed_count == 0);
+	}
+
+	SECTION("Paths are culled by their outline") {
+		set_area(&area, -10.0, -10.0, 155.0, 150.0);
+		hash_area(&design, &area, 0.0, &changed_count);
+		REQUIRE(changed_count == 2);
+
+		set_area(&area, -10.0, -10.0, 145.0, 150.0);
+		hash_area(&design, &area, 0.0, &changed_count);
+		REQUIRE(changed_count == 1);
+	}
+
+	design_free(&design);
+}
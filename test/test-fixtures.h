@@ -0,0 +1,123 @@
+#ifndef _TEST_FIXTURES_H_
+#define _TEST_FIXTURES_H_
+
+/*
+ * Helpers to build GDS cell hierarchies and flattened layers in the tests
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <gds-render/gds-utils/gds-types.h>
+#include <gds-render/geometric/hierarchy-flattener.h>
+}
+
+/**
+ * @brief Create a new, empty cell
+ * @param lib Library the cell is appended to. May be NULL
+ * @param name Cell name. May be NULL
+ * @return Cell. Cells without library have to be freed with free_cell()
+ */
+static inline struct gds_cell *add_cell(struct gds_library *lib, const char *name)
+{
+	struct gds_cell *cell;
+
+	cell = (struct gds_cell *)g_malloc0(sizeof(struct gds_cell));
+	if (name)
+		strncpy(cell->name, name, CELL_NAME_MAX - 1);
+	cell->parent_library = lib;
+	if (lib)
+		lib->cells = g_list_append(lib->cells, cell);
+
+	return cell;
+}
+
+/**
+ * @brief Place \p child inside \p parent
+ * @return Instance. Further fields can be set by the caller
+ */
+static inline struct gds_cell_instance *add_reference(struct gds_cell *parent, struct gds_cell *child, int x, int y)
+{
+	struct gds_cell_instance *inst;
+
+	inst = (struct gds_cell_instance *)g_malloc0(sizeof(struct gds_cell_instance));
+	inst->cell_ref = child;
+	inst->origin.x = x;
+	inst->origin.y = y;
+	inst->magnification = 1.0;
+	parent->child_cells = g_list_append(parent->child_cells, inst);
+
+	return inst;
+}
+
+/**
+ * @brief Add a square box with its lower left corner at the origin
+ */
+static inline struct gds_graphics *add_box(struct gds_cell *cell, int16_t layer, int size)
+{
+	struct gds_graphics *gfx;
+	const int xs[] = {0, size, size, 0};
+	const int ys[] = {0, 0, size, size};
+	int i;
+
+	gfx = (struct gds_graphics *)g_malloc0(sizeof(struct gds_graphics));
+	gfx->gfx_type = GRAPHIC_BOX;
+	gfx->layer = layer;
+	/* Freed with free() like the arrays of the parser */
+	gfx->vertex_array = (struct gds_point *)malloc(4 * sizeof(struct gds_point));
+	gfx->vertex_count = 4;
+	for (i = 0; i < 4; i++) {
+		gfx->vertex_array[i].x = xs[i];
+		gfx->vertex_array[i].y = ys[i];
+	}
+	cell->graphic_objs = g_list_append(cell->graphic_objs, gfx);
+
+	return gfx;
+}
+
+static inline void free_test_graphics(gpointer data)
+{
+	struct gds_graphics *gfx = (struct gds_graphics *)data;
+
+	free(gfx->vertex_array);
+	g_free(gfx);
+}
+
+/**
+ * @brief Free a cell that is not owned by a library
+ */
+static inline void free_cell(struct gds_cell *cell)
+{
+	g_list_free_full(cell->graphic_objs, free_test_graphics);
+	g_list_free_full(cell->child_cells, g_free);
+	g_free(cell);
+}
+
+/**
+ * @brief Append a primitive to a flattened layer
+ * @param layer Layer
+ * @param type Type of the primitive
+ * @param coords x and y coordinates of the vertices
+ * @param count Number of vertices
+ */
+static inline void add_shape(struct flat_layer *layer, enum graphics_type type, const double *coords, size_t count)
+{
+	struct flat_primitive prim;
+	struct vector_2d pt;
+	size_t i;
+
+	prim.gfx_type = type;
+	prim.path_render_type = PATH_FLUSH;
+	prim.width = 0.0;
+	prim.first_vertex = layer->vertices->len;
+	prim.vertex_count = count;
+	for (i = 0; i < count; i++) {
+		pt.x = coords[2 * i];
+		pt.y = coords[2 * i + 1];
+		g_array_append_val(layer->vertices, pt);
+	}
+	g_array_append_val(layer->primitives, prim);
+}
+
+#endif /* _TEST_FIXTURES_H_ */
@@ -47,6 +47,7 @@ struct  _RendererSettingsDialog {
 
 		GtkLabel *x_output_label;
 		GtkLabel *y_output_label;
+		GtkLabel *estimate_label;
 
 		unsigned int cell_height;
 		unsigned int cell_width;
@@ -287,6 +288,7 @@ static void renderer_settings_dialog_init(RendererSettingsDialog *self)
 	self->y_label = GTK_LABEL(gtk_builder_get_object(builder, "y-label"));
 	self->x_output_label = GTK_LABEL(gtk_builder_get_object(builder, "x-output-label"));
 	self->y_output_label = GTK_LABEL(gtk_builder_get_object(builder, "y-output-label"));
+	self->estimate_label = GTK_LABEL(gtk_builder_get_object(builder, "estimate-label"));
 
 	gtk_dialog_add_buttons(dialog, _("Cancel"), GTK_RESPONSE_CANCEL, _("OK"), GTK_RESPONSE_OK, NULL);
 	gtk_container_add(GTK_CONTAINER(gtk_dialog_get_content_area(dialog)), box);
@@ -398,4 +400,53 @@ void renderer_settings_dialog_set_database_unit_scale(RendererSettingsDialog *di
 	renderer_settings_dialog_update_labels(dialog);
 }
 
+void renderer_settings_dialog_set_statistics(RendererSettingsDialog *dialog, const struct gds_cell_statistics *stats)
+{
+	GString *text;
+	GString *tooltip;
+	const struct gds_layer_statistics *lstat;
+	gchar *primitives;
+	gchar *vertices;
+	gchar *instances;
+	guint i;
+
+	if (!dialog)
+		return;
+
+	if (!stats) {
+		gtk_label_set_text(dialog->estimate_label, "");
+		gtk_widget_set_tooltip_text(GTK_WIDGET(dialog->estimate_label), NULL);
+		return;
+	}
+
+	/* 64 bit format macros cannot be used inside translated strings */
+	primitives = g_strdup_printf("%" G_GUINT64_FORMAT, stats->primitive_count);
+	vertices = g_strdup_printf("%" G_GUINT64_FORMAT, stats->vertex_count);
+	instances = g_strdup_printf("%" G_GUINT64_FORMAT, stats->instance_count);
+	text = g_string_new(NULL);
+	g_string_printf(text, _("Estimate: %s primitives, %s vertices, %s instances on %u layers"),
+			primitives, vertices, instances, (stats->layers ? stats->layers->len : 0U));
+	gtk_label_set_text(dialog->estimate_label, text->str);
+	g_string_free(text, TRUE);
+	g_free(primitives);
+	g_free(vertices);
+	g_free(instances);
+
+	/* Per layer breakdown */
+	tooltip = g_string_new(NULL);
+	for (i = 0; stats->layers && i < stats->layers->len; i++) {
+		lstat = &g_array_index(stats->layers, struct gds_layer_statistics, i);
+		primitives = g_strdup_printf("%" G_GUINT64_FORMAT, lstat->primitive_count);
+		vertices = g_strdup_printf("%" G_GUINT64_FORMAT, lstat->vertex_count);
+		if (i)
+			g_string_append_c(tooltip, '\n');
+		g_string_append_printf(tooltip, _("Layer %d: %s primitives, %s vertices"), lstat->layer, primitives,
+				       vertices);
+		g_free(primitives);
+		g_free(vertices);
+	}
+	gtk_widget_set_tooltip_text(GTK_WIDGET(dialog->estimate_label), tooltip->str);
+	g_string_free(tooltip, TRUE);
+}
+
 /** @} */